@@ -0,0 +1,111 @@
+#ifndef ALARM_ENGINE_H
+#define ALARM_ENGINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SensorData.h"
+#include "SampleCodec.h"
+
+/**
+ * @enum AlarmLevel
+ * @brief Estado de la alarma de una magnitud.
+ */
+enum AlarmLevel
+{
+    ALARM_NONE,
+    ALARM_LOW,
+    ALARM_HIGH
+};
+
+/**
+ * @struct AlarmRule
+ * @brief Umbrales de alarma de una magnitud.
+ * @details Los valores están en el mismo punto fijo que el historial (ver
+ * `SampleField`: 0.01 °C, 0.01 %, 0.1 hPa, ppm). `low = INT32_MIN` o
+ * `high = INT32_MAX` desactivan ese umbral. Una alarma activa se apaga cuando
+ * la medida vuelve `hysteresis` unidades dentro del umbral. Tanto la entrada
+ * como la salida deben mantenerse `minDurationMs` para tenerse en cuenta. Una
+ * alarma `latched` no se apaga sola: además hace falta que el cliente la
+ * reconozca.
+ */
+struct AlarmRule
+{
+    int32_t low;
+    int32_t high;
+    int32_t hysteresis;
+    uint32_t minDurationMs;
+    bool latched;
+};
+
+/**
+ * @struct AlarmEvent
+ * @brief Transición de la alarma de una magnitud.
+ * @details `sequence`, `bootCount` y `uptimeS` los rellena AlarmLog al guardarla.
+ */
+struct AlarmEvent
+{
+    uint32_t sequence; // Número de evento, creciente y persistente
+    uint32_t uptimeS;  // Segundos desde el arranque
+    uint16_t bootCount;
+    uint8_t field;     // `SampleField`
+    uint8_t level;     // Nuevo `AlarmLevel`
+    int32_t value;     // Medida que provocó la transición, en punto fijo
+};
+
+/**
+ * @class AlarmEngine
+ * @brief Evalúa los umbrales de alarma en cada muestra.
+ * @details Por cada magnitud aplica histéresis, duración mínima (antirrebote)
+ * y el modo enclavado o de autoborrado, y deja cada transición en una cola
+ * para que se guarde y se entregue al cliente. Las muestras no válidas (-1)
+ * no cambian el estado. No depende de Arduino.
+ */
+class AlarmEngine
+{
+public:
+    // --- Constantes ---
+    static const uint8_t QUEUE_SIZE = 8;
+
+    // --- Métodos Públicos ---
+    AlarmEngine(); // Constructor
+    void setRule(uint8_t field, const AlarmRule &rule);
+    const AlarmRule &getRule(uint8_t field) const;
+    void evaluate(const SensorData &data, uint32_t nowMs); // Evalúa todas las magnitudes
+    bool acknowledge(uint8_t field); // Reconoce una alarma enclavada
+    bool popEvent(AlarmEvent &event); // Siguiente transición pendiente
+    AlarmLevel getLevel(uint8_t field) const;
+    size_t describe(char *out, size_t len) const; // Alarmas activas en texto
+
+    static AlarmRule disabledRule();
+    static const char *fieldName(uint8_t field);
+    static int fieldFromName(const char *name); // -1 si no existe
+    static const char *levelName(uint8_t level);
+
+private:
+    /**
+     * @struct FieldState
+     * @brief Estado de la alarma de una magnitud.
+     */
+    struct FieldState
+    {
+        uint8_t level;         // `AlarmLevel` publicado
+        uint8_t pending;       // Nivel candidato mientras corre el antirrebote
+        uint32_t pendingSince; // Momento en que apareció el candidato
+        bool acknowledged;     // Enclavada y ya reconocida
+        int32_t lastValue;
+    };
+
+    // --- Métodos Privados ---
+    void evaluateField(uint8_t field, int32_t value, uint32_t nowMs);
+    uint8_t condition(uint8_t field, int32_t value) const;
+    void transition(uint8_t field, uint8_t level, int32_t value);
+
+    // --- Variables de Estado ---
+    AlarmRule rules[SAMPLE_FIELD_COUNT];
+    FieldState states[SAMPLE_FIELD_COUNT];
+    AlarmEvent queue[QUEUE_SIZE];
+    uint8_t queue_head;
+    uint8_t queue_count;
+};
+
+#endif // ALARM_ENGINE_H
@@ -0,0 +1,40 @@
+#ifndef ALARM_LOG_H
+#define ALARM_LOG_H
+
+#include <Arduino.h>
+#include "AlarmEngine.h"
+
+/**
+ * @class AlarmLog
+ * @brief Historial persistente de transiciones de alarma en LittleFS.
+ * @details Cada transición recibe un número de secuencia creciente que se
+ * conserva entre reinicios. El cliente confirma la última transición recibida
+ * y esa confirmación también se guarda en NVS, de modo que al reconectar se le
+ * entregan las que se perdió aunque el equipo se haya reiniciado entretanto.
+ * Los archivos rotan como los del historial de calibraciones.
+ */
+class AlarmLog
+{
+public:
+    // --- Métodos Públicos ---
+    AlarmLog(); // Constructor
+    void init(uint16_t bootCount); // Requiere LittleFS montado
+    bool append(AlarmEvent &event); // Asigna secuencia y momento y la añade al final
+    bool findAfter(uint32_t sequence, AlarmEvent &event); // Primera transición posterior
+    bool acknowledge(uint32_t sequence); // El cliente recibió hasta `sequence`
+    uint32_t getLastSequence();          // 0 = ninguna
+    uint32_t getAcknowledged();
+
+    static size_t describe(const AlarmEvent &event, char *out, size_t len);
+
+private:
+    // --- Constantes ---
+    static const size_t MAX_FILE_SIZE = 4096; // 256 transiciones por archivo
+
+    // --- Variables de Estado ---
+    uint16_t boot_count;
+    uint32_t last_sequence;
+    uint32_t acknowledged;
+};
+
+#endif // ALARM_LOG_H
@@ -0,0 +1,48 @@
+#ifndef ALARM_MANAGER_H
+#define ALARM_MANAGER_H
+
+#include <Arduino.h>
+#include "AlarmEngine.h"
+#include "AlarmLog.h"
+
+/**
+ * @class AlarmManager
+ * @brief Alarmas por umbral evaluadas en el propio equipo.
+ * @details Evalúa cada muestra con AlarmEngine, guarda cada transición en
+ * AlarmLog y las entrega al cliente como indicaciones BLE, de una en una: la
+ * siguiente no se envía hasta que el cliente confirma la anterior escribiendo
+ * "ACK=<secuencia>", y sin confirmación se reenvía pasado `ACK_TIMEOUT_MS`.
+ * Así las alarmas se detectan aunque no haya nadie conectado y el cliente que
+ * reconecta recibe las que se perdió. Los umbrales se guardan en NVS.
+ */
+class AlarmManager
+{
+public:
+    // --- Métodos Públicos ---
+    AlarmManager(); // Constructor
+    void init(uint16_t bootCount); // Requiere LittleFS montado
+    bool handleCommand(const String &cmd); // Comandos de la característica de alarmas
+    void onSample(const SensorData &data);
+    bool nextIndication(bool connected, char *out, size_t len); // Transición a indicar ahora
+    bool hasStatusChanged(); // Si hay que volver a publicar el estado
+    size_t describeStatus(char *out, size_t len);
+
+private:
+    // --- Métodos Privados ---
+    void loadRules();
+    void saveRules();
+    bool parseRule(const String &args);
+
+    // --- Constantes ---
+    static const unsigned long ACK_TIMEOUT_MS = 5000UL; // Reenvío si el cliente no confirma
+
+    // --- Variables de Estado ---
+    AlarmEngine engine;
+    AlarmLog alarmLog;
+    bool was_connected;
+    uint32_t sent_sequence;   // Última transición indicada en esta conexión
+    unsigned long sent_time;
+    bool status_changed;
+};
+
+#endif // ALARM_MANAGER_H
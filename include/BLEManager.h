@@ -2,38 +2,99 @@
 #define BLE_MANAGER_H
 
 #include <Arduino.h>
-#include <BLEDevice.h>
-#include <BLEServer.h>
-#include <BLEUtils.h>
-#include <BLE2902.h>
+#include "GattServer.h"
+#include "EnvironmentalSensing.h"
+
+/**
+ * @enum ConnectionProfile
+ * @brief Perfiles de parámetros de conexión que el servidor solicita al cliente.
+ * @details `PROFILE_STEADY` usa un intervalo largo con latencia de esclavo para
+ * las actualizaciones periódicas (ahorro de energía); `PROFILE_BULK` usa el
+ * intervalo más corto posible para transferencias grandes como la descarga
+ * del historial.
+ */
+enum ConnectionProfile
+{
+    PROFILE_STEADY,
+    PROFILE_BULK
+};
+
+/**
+ * @enum CharacteristicId
+ * @brief Características del servicio principal, en el orden de registro.
+ * @details Indexa la tabla `CHARACTERISTICS` de BLEManager.cpp, que describe
+ * cada una (UUID, propiedades, callbacks y campo de origen).
+ */
+enum CharacteristicId
+{
+    CHARACTERISTIC_TEMPERATURE,
+    CHARACTERISTIC_PRESSURE,
+    CHARACTERISTIC_HUMIDITY,
+    CHARACTERISTIC_CO2,
+    CHARACTERISTIC_CALIBRATE,
+    CHARACTERISTIC_SYSTEM_STATE,
+    CHARACTERISTIC_COOLER_STATE,
+    CHARACTERISTIC_DIAGNOSTICS,
+    CHARACTERISTIC_HISTORY,
+    CHARACTERISTIC_I2C_INVENTORY,
+    CHARACTERISTIC_CONFIG,
+    CHARACTERISTIC_CAL_HISTORY,
+    CHARACTERISTIC_DERIVED,
+    CHARACTERISTIC_ALARMS,
+    CHARACTERISTIC_TIME_SYNC,
+    CHARACTERISTIC_COUNT
+};
 
 /**
  * @class BLEManager
  * @brief Gestiona toda la funcionalidad del servidor Bluetooth de Baja Energía (BLE).
  * * Esta clase encapsula la creación del servidor, servicios, características,
- * y la actualización de los valores de los sensores.
+ * y la actualización de los valores de los sensores. Solo usa la fachada
+ * GattServer, así que no depende de la pila BLE elegida al compilar.
  */
 class BLEManager
 {
 public:
     // --- Métodos Públicos ---
     BLEManager(); // Constructor
-    void init();
+    void init(const char *deviceName);
     void updateSensorValues(float temp, float hum, float pres, int co2, String systemStatus, String coolerStatus);
     bool isDeviceConnected();
     String getCalibrationCommand();
+    String getCoolerCommand();
+    void setConnectionProfile(ConnectionProfile profile); // Solicita nuevos parámetros de conexión
+    ConnectionProfile getConnectionProfile();
+    void setBroadcastEnabled(bool enabled); // Activa el modo de difusión sin conexión
+    void updateBroadcast(float temp, float hum, float pres, int co2, int state, bool fanOn);
+    bool getHistoryRequest();                          // Indica si el cliente pidió el historial
+    bool sendHistoryChunk(const uint8_t *data, size_t len); // Notifica un fragmento del historial
+    size_t getMaxNotifySize();                         // Tamaño máximo de una notificación
+    void setSensorFaults(uint8_t faultMask);           // Publica los sensores en fallo en el diagnóstico
+    void setI2CInventory(const String &inventory);     // Publica los dispositivos del bus I2C
+    void setBootMetrics(uint32_t ttfaMs, uint32_t ttfsMs); // Publica los tiempos de arranque en el diagnóstico
+    String getConfigCommand();                         // Último comando de configuración recibido
+    void setConfigValue(const char *config);           // Publica la configuración actual
+    int getCalibrationHistoryRequest();                // Registro pedido del historial de calibraciones (-1 = ninguno)
+    void setCalibrationHistory(const char *history);   // Publica una página del historial de calibraciones
+    void setDerivedMetrics(const char *derived);       // Publica punto de rocío, humedad absoluta, etc.
+    String getAlarmCommand();                          // Último comando de alarmas recibido
+    bool indicateAlarm(const char *event);             // Indica una transición de alarma
+    void setAlarmStatus(const char *status);           // Publica las alarmas activas
+    bool getTimeSync(uint64_t &localUs, int64_t &wallUs); // Último punto de sincronización de hora
+    void setTimeSyncStatus(const char *status);        // Publica el estado de la sincronización
+    static GattUuid characteristicUuid(CharacteristicId id); // UUID de una característica del servicio principal
 
 private:
     // --- Atributos ---
-    // --- Punteros a Objetos BLE ---
-    BLEServer *pServer;
-    BLECharacteristic *pCharacteristicTemp;
-    BLECharacteristic *pCharacteristicPres;
-    BLECharacteristic *pCharacteristicHum;
-    BLECharacteristic *pCharacteristicCO2;
-    BLECharacteristic *pCharacteristicCalibrate;
-    BLECharacteristic *pCharacteristicSystemState;
-    BLECharacteristic *pCharacteristicCoolerState;
+    // --- Servidor GATT y características ---
+    GattServer *gatt;
+    GattHandle handles[CHARACTERISTIC_COUNT]; // Indexado por `CharacteristicId`
+
+    // --- Servicio estándar Environmental Sensing ---
+    EnvironmentalSensing environmentalSensing;
+
+    // --- Métodos Privados ---
+    void updateDiagnostics(); // Refresca la característica de diagnóstico
 };
 
 // --- Variable Externa ---
@@ -0,0 +1,61 @@
+#ifndef BLUEDROID_GATT_SERVER_H
+#define BLUEDROID_GATT_SERVER_H
+
+#include "GattServer.h"
+
+#if defined(GATT_BACKEND_BLUEDROID) && !defined(NODE_SIMULATION)
+
+#include <Arduino.h>
+#include <BLEDevice.h>
+#include <BLEServer.h>
+#include <BLEUtils.h>
+#include <BLE2902.h>
+
+class BluedroidCharacteristicCallbacks;
+
+/**
+ * @class BluedroidGattServer
+ * @brief Servidor GATT sobre el wrapper Bluedroid del core Arduino (`BLEDevice`).
+ * @details Los parámetros de conexión acordados se obtienen de los eventos GAP,
+ * que el wrapper no expone, con un manejador GAP adicional.
+ */
+class BluedroidGattServer : public GattServer
+{
+public:
+    BluedroidGattServer(); // Constructor
+    bool begin(const char *deviceName, GattEventHandler onEvent) override;
+    void beginService(const GattUuid &uuid, uint16_t numHandles) override;
+    GattHandle addCharacteristic(const GattUuid &uuid, uint8_t properties,
+                                 GattWriteHandler onWrite = nullptr, void *context = nullptr) override;
+    void addDescriptor(GattHandle characteristic, const GattUuid &uuid, const uint8_t *value, size_t len,
+                       size_t maxLen, GattWriteHandler onWrite = nullptr, void *context = nullptr) override;
+    void endService() override;
+    void setReadHandler(GattHandle handle, GattReadHandler onRead, void *context = nullptr) override;
+    void setValue(GattHandle handle, const uint8_t *data, size_t len) override;
+    using GattServer::setValue;
+    void notify(GattHandle handle) override;
+    void indicate(GattHandle handle) override;
+    void setAdvertisingData(const char *name, const uint8_t *manufacturerData, size_t len) override;
+    void setScanResponseServices(const GattUuid *uuids, size_t count) override;
+    void startAdvertising(bool connectable) override;
+    bool isConnected() override;
+    uint16_t getPeerMtu() override;
+    void requestConnectionParams(const GattConnectionParams &params) override;
+    bool getConnectionParams(GattConnectionParams &params) override;
+    const char *name() const override { return "BLUEDROID"; }
+
+private:
+    static const uint8_t MAX_CHARACTERISTICS = 24;
+
+    BluedroidCharacteristicCallbacks *callbacksFor(GattHandle handle);
+
+    BLEServer *server;
+    BLEService *service; // Servicio en construcción
+    BLECharacteristic *characteristics[MAX_CHARACTERISTICS];
+    BluedroidCharacteristicCallbacks *callbacks[MAX_CHARACTERISTICS]; // Creados al añadir el primer callback
+    uint8_t characteristic_count;
+};
+
+#endif // GATT_BACKEND_BLUEDROID
+
+#endif // BLUEDROID_GATT_SERVER_H
@@ -0,0 +1,28 @@
+#ifndef BOARD_CONFIG_H
+#define BOARD_CONFIG_H
+
+#include "SensorDrivers.h"
+
+/**
+ * @file BoardConfig.h
+ * @brief Selección del conjunto de sensores según la variante de placa.
+ * @details La variante se elige con un flag de compilación en `platformio.ini`
+ * (ej. `-D BOARD_PCB1`). Cada variante declara `BoardSensors` con sus drivers y
+ * su cableado; SensorManager recorre esa lista sin saber qué sensores contiene.
+ * El resto de pines que dependen de la placa (como `BOARD_HD_PIN`) también se
+ * declaran aquí, y cada uno tiene un único módulo propietario.
+ */
+
+#if defined(BOARD_PCB1)
+
+/** @brief PCB1: DHT22 en el pin 25, BMP280 en 0x76 y MH-Z19C en Serial2 (RX 16, TX 17). */
+using BoardSensors = SensorSet<Dht22Driver<25>, Bmp280Driver<0x76>, MhZ19cDriver<16, 17>>;
+
+/** @brief Pin conectado a la entrada HD (calibración a cero) del MH-Z19C. */
+static const int BOARD_HD_PIN = 12;
+
+#else
+#error "Variante de placa no definida: añade -D BOARD_<NOMBRE> a build_flags en platformio.ini"
+#endif
+
+#endif // BOARD_CONFIG_H
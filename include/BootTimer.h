@@ -0,0 +1,45 @@
+#ifndef BOOT_TIMER_H
+#define BOOT_TIMER_H
+
+#include <Arduino.h>
+
+/**
+ * @enum BootPhase
+ * @brief Fases del arranque que se cronometran.
+ */
+enum BootPhase
+{
+    BOOT_PHASE_BLE,           // Pila BLE y publicidad (su fin es el time-to-first-advertisement)
+    BOOT_PHASE_I2C_INVENTORY, // Inventario del bus I2C
+    BOOT_PHASE_SENSORS,       // Inicialización de los drivers
+    BOOT_PHASE_STORAGE,       // Montaje de LittleFS y calibración
+    BOOT_PHASE_SETUP,         // setup() completo
+    BOOT_PHASE_FIRST_SAMPLE,  // Hasta la primera muestra válida (time-to-first-sample)
+    BOOT_PHASE_COUNT
+};
+
+/**
+ * @class BootTimer
+ * @brief Cronometra las fases del arranque.
+ * @details Cada fase guarda su inicio y su fin en microsegundos desde el
+ * arranque. Las fases pueden solaparse y marcarse desde tareas distintas: cada
+ * marca es una sola escritura de 32 bits.
+ */
+class BootTimer
+{
+public:
+    // --- Métodos Públicos ---
+    BootTimer(); // Constructor
+    void start(BootPhase phase);
+    void finish(BootPhase phase);      // Solo cuenta la primera vez
+    bool isFinished(BootPhase phase);
+    uint32_t getEndMs(BootPhase phase);  // Fin de la fase desde el arranque; 0 si no terminó
+    void report();                     // Imprime todas las fases por consola
+
+private:
+    // --- Variables de Estado ---
+    volatile uint32_t start_us[BOOT_PHASE_COUNT];
+    volatile uint32_t end_us[BOOT_PHASE_COUNT]; // 0 = fase no terminada
+};
+
+#endif // BOOT_TIMER_H
@@ -0,0 +1,251 @@
+#ifndef BROADCAST_PAYLOAD_H
+#define BROADCAST_PAYLOAD_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @file BroadcastPayload.h
+ * @brief Codificación de las lecturas en los datos de fabricante de la publicidad BLE.
+ * @details Este archivo no depende de Arduino: el firmware lo usa para codificar
+ * y los programas del lado del host (gateways, escáneres) lo incluyen para
+ * decodificar la publicidad sin conectarse al nodo.
+ *
+ * Formato (13 bytes, little-endian):
+ * | Offset | Tamaño | Campo                                         |
+ * |--------|--------|-----------------------------------------------|
+ * | 0      | 2      | Company ID (0xFFFF, reservado para pruebas)   |
+ * | 2      | 1      | Versión del formato                           |
+ * | 3      | 1      | Contador rodante, se incrementa en cada muestra |
+ * | 4      | 2      | Temperatura, int16 en 0.01 °C                 |
+ * | 6      | 2      | Humedad, uint16 en 0.01 %                     |
+ * | 8      | 2      | Presión, uint16 en 0.1 hPa                    |
+ * | 10     | 2      | CO2, uint16 en ppm                            |
+ * | 12     | 1      | Bits 0-1: estado del sensor, bit 2: ventilador |
+ *
+ * Un campo con valor `BROADCAST_INVALID_*` indica que la lectura falló.
+ *
+ * El paquete de publicidad completo (flags, nombre y datos de fabricante) lo
+ * arma `buildAdvertisingData()`, que recorta el nombre para no pasar de los
+ * 31 bytes de la publicidad legacy; `parseAdvertisingData()` hace el camino
+ * inverso en el escáner.
+ */
+
+/** @brief Company ID usado en los datos de fabricante. */
+static const uint16_t BROADCAST_COMPANY_ID = 0xFFFF;
+/** @brief Versión actual del formato del payload. */
+static const uint8_t BROADCAST_VERSION = 1;
+/** @brief Longitud total del payload de fabricante, en bytes. */
+static const size_t BROADCAST_PAYLOAD_LEN = 13;
+/** @brief Valor que marca una temperatura inválida. */
+static const int16_t BROADCAST_INVALID_TEMP = INT16_MIN;
+/** @brief Valor que marca un campo sin signo inválido. */
+static const uint16_t BROADCAST_INVALID_U16 = 0xFFFF;
+
+/** @brief Tamaño máximo de los datos de publicidad legacy, en bytes. */
+static const size_t ADV_DATA_MAX_LEN = 31;
+/** @brief Tipo AD de los flags. */
+static const uint8_t ADV_TYPE_FLAGS = 0x01;
+/** @brief Tipo AD del nombre recortado. */
+static const uint8_t ADV_TYPE_SHORT_NAME = 0x08;
+/** @brief Tipo AD del nombre completo. */
+static const uint8_t ADV_TYPE_COMPLETE_NAME = 0x09;
+/** @brief Tipo AD de los datos de fabricante. */
+static const uint8_t ADV_TYPE_MANUFACTURER = 0xFF;
+/** @brief Flags publicados: General Discoverable, sin BR/EDR. */
+static const uint8_t ADV_FLAGS = 0x06;
+
+/**
+ * @struct BroadcastReading
+ * @brief Lecturas transportadas en la publicidad, en unidades físicas.
+ */
+struct BroadcastReading
+{
+    uint8_t counter;   // Contador rodante de muestras
+    float temperature; // °C
+    float humidity;    // %
+    float pressure;    // hPa
+    int co2;           // ppm
+    uint8_t state;     // Valor de SensorState
+    bool fanOn;        // Estado del ventilador
+    bool tempValid;
+    bool humValid;
+    bool presValid;
+    bool co2Valid;
+};
+
+/** @brief Escribe un uint16 en little-endian. */
+static inline void broadcastPutU16(uint8_t *out, uint16_t value)
+{
+    out[0] = (uint8_t)(value & 0xFF);
+    out[1] = (uint8_t)(value >> 8);
+}
+
+/** @brief Lee un uint16 en little-endian. */
+static inline uint16_t broadcastGetU16(const uint8_t *in)
+{
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+/**
+ * @brief Convierte un valor físico a punto fijo sin signo, con redondeo.
+ * @param value Valor físico.
+ * @param scale Factor de escala (ej. 100 para centésimas).
+ * @return uint16_t El valor escalado, o `BROADCAST_INVALID_U16` si es negativo o no cabe.
+ */
+static inline uint16_t broadcastScaleU16(float value, float scale)
+{
+    float scaled = value * scale + 0.5f;
+    if (!(scaled >= 0.0f) || scaled >= (float)BROADCAST_INVALID_U16)
+    {
+        return BROADCAST_INVALID_U16;
+    }
+    return (uint16_t)scaled;
+}
+
+/**
+ * @brief Codifica las lecturas en el payload de fabricante.
+ * @details Los campos marcados como inválidos se codifican con su valor centinela.
+ * @param reading Lecturas a codificar.
+ * @param out Buffer de salida de al menos `BROADCAST_PAYLOAD_LEN` bytes.
+ * @return size_t Número de bytes escritos.
+ */
+static inline size_t encodeBroadcastPayload(const BroadcastReading &reading, uint8_t *out)
+{
+    broadcastPutU16(&out[0], BROADCAST_COMPANY_ID);
+    out[2] = BROADCAST_VERSION;
+    out[3] = reading.counter;
+
+    int16_t temp = BROADCAST_INVALID_TEMP;
+    if (reading.tempValid && reading.temperature > -327.0f && reading.temperature < 327.0f)
+    {
+        float scaled = reading.temperature * 100.0f;
+        temp = (int16_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+    }
+    broadcastPutU16(&out[4], (uint16_t)temp);
+    broadcastPutU16(&out[6], reading.humValid ? broadcastScaleU16(reading.humidity, 100.0f) : BROADCAST_INVALID_U16);
+    broadcastPutU16(&out[8], reading.presValid ? broadcastScaleU16(reading.pressure, 10.0f) : BROADCAST_INVALID_U16);
+    broadcastPutU16(&out[10], reading.co2Valid ? broadcastScaleU16((float)reading.co2, 1.0f) : BROADCAST_INVALID_U16);
+    out[12] = (uint8_t)((reading.state & 0x03) | (reading.fanOn ? 0x04 : 0x00));
+    return BROADCAST_PAYLOAD_LEN;
+}
+
+/**
+ * @brief Decodifica un payload de fabricante.
+ * @param data Bytes de los datos de fabricante (empezando por el Company ID).
+ * @param len Longitud de `data`.
+ * @param reading Estructura donde se escriben las lecturas decodificadas.
+ * @return bool `true` si el payload pertenece a este formato y versión.
+ */
+static inline bool decodeBroadcastPayload(const uint8_t *data, size_t len, BroadcastReading &reading)
+{
+    if (len < BROADCAST_PAYLOAD_LEN || broadcastGetU16(&data[0]) != BROADCAST_COMPANY_ID || data[2] != BROADCAST_VERSION)
+    {
+        return false;
+    }
+    reading.counter = data[3];
+
+    int16_t temp = (int16_t)broadcastGetU16(&data[4]);
+    uint16_t hum = broadcastGetU16(&data[6]);
+    uint16_t pres = broadcastGetU16(&data[8]);
+    uint16_t co2 = broadcastGetU16(&data[10]);
+
+    reading.tempValid = temp != BROADCAST_INVALID_TEMP;
+    reading.humValid = hum != BROADCAST_INVALID_U16;
+    reading.presValid = pres != BROADCAST_INVALID_U16;
+    reading.co2Valid = co2 != BROADCAST_INVALID_U16;
+    reading.temperature = temp / 100.0f;
+    reading.humidity = hum / 100.0f;
+    reading.pressure = pres / 10.0f;
+    reading.co2 = co2;
+    reading.state = data[12] & 0x03;
+    reading.fanOn = (data[12] & 0x04) != 0;
+    return true;
+}
+
+/**
+ * @brief Arma el paquete de publicidad: flags, nombre y datos de fabricante.
+ * @details Los datos de fabricante tienen prioridad: el nombre ocupa lo que
+ * queda hasta `ADV_DATA_MAX_LEN`. Si no cabe entero se recorta y se publica
+ * como nombre recortado (0x08); el nombre completo lo da el GATT al conectar.
+ * @param name Nombre del dispositivo (terminado en '\0'), o `nullptr`.
+ * @param manufacturerData Datos de fabricante, o `nullptr` si no hay.
+ * @param len Longitud de `manufacturerData`.
+ * @param out Buffer de salida de al menos `ADV_DATA_MAX_LEN` bytes.
+ * @return size_t Bytes escritos; 0 si los datos de fabricante no caben.
+ */
+static inline size_t buildAdvertisingData(const char *name, const uint8_t *manufacturerData, size_t len, uint8_t *out)
+{
+    if (manufacturerData == nullptr)
+    {
+        len = 0;
+    }
+    size_t manufacturerLen = len > 0 ? 2 + len : 0;
+    if (3 + manufacturerLen > ADV_DATA_MAX_LEN)
+    {
+        return 0;
+    }
+    size_t pos = 0;
+    out[pos++] = 2;
+    out[pos++] = ADV_TYPE_FLAGS;
+    out[pos++] = ADV_FLAGS;
+
+    size_t nameLen = 0;
+    while (name != nullptr && name[nameLen] != '\0')
+    {
+        nameLen++;
+    }
+    size_t room = ADV_DATA_MAX_LEN - pos - manufacturerLen;
+    if (nameLen > 0 && room > 2)
+    {
+        bool shortened = nameLen > room - 2;
+        size_t written = shortened ? room - 2 : nameLen;
+        out[pos++] = (uint8_t)(1 + written);
+        out[pos++] = shortened ? ADV_TYPE_SHORT_NAME : ADV_TYPE_COMPLETE_NAME;
+        for (size_t i = 0; i < written; i++)
+        {
+            out[pos++] = (uint8_t)name[i];
+        }
+    }
+    if (len > 0)
+    {
+        out[pos++] = (uint8_t)(1 + len);
+        out[pos++] = ADV_TYPE_MANUFACTURER;
+        for (size_t i = 0; i < len; i++)
+        {
+            out[pos++] = manufacturerData[i];
+        }
+    }
+    return pos;
+}
+
+/**
+ * @brief Busca y decodifica el payload en un paquete de publicidad recibido.
+ * @details Recorre las estructuras AD (longitud, tipo, datos) y decodifica los
+ * primeros datos de fabricante que sean de este formato. Una estructura que se
+ * sale del paquete termina el recorrido.
+ * @param data Datos de publicidad o de respuesta de escaneo.
+ * @param len Longitud de `data`.
+ * @param reading Estructura donde se escriben las lecturas decodificadas.
+ * @return bool `true` si el paquete trae un payload válido.
+ */
+static inline bool parseAdvertisingData(const uint8_t *data, size_t len, BroadcastReading &reading)
+{
+    size_t pos = 0;
+    while (pos < len)
+    {
+        size_t fieldLen = data[pos];
+        if (fieldLen == 0 || pos + 1 + fieldLen > len)
+        {
+            return false;
+        }
+        if (data[pos + 1] == ADV_TYPE_MANUFACTURER && decodeBroadcastPayload(&data[pos + 2], fieldLen - 1, reading))
+        {
+            return true;
+        }
+        pos += 1 + fieldLen;
+    }
+    return false;
+}
+
+#endif // BROADCAST_PAYLOAD_H
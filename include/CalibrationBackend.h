@@ -0,0 +1,82 @@
+#ifndef CALIBRATION_BACKEND_H
+#define CALIBRATION_BACKEND_H
+
+#include <Arduino.h>
+#include "Mhz19Link.h"
+#include "TimedOutput.h"
+
+/**
+ * @class CalibrationBackend
+ * @brief Forma de ordenar al MH-Z19C que calibre su punto cero.
+ * @details CalibrationManager decide cuándo calibrar (tras la estabilización);
+ * el backend decide cómo. Las operaciones de span, autocalibración y rango
+ * solo existen por UART: el backend del pin HD las rechaza.
+ */
+class CalibrationBackend
+{
+public:
+    virtual ~CalibrationBackend() {}
+    virtual void begin() = 0;                               // Deja su hardware en reposo
+    virtual void startZero() = 0;                           // Empieza la calibración a 400 ppm
+    virtual bool updateZero(unsigned long elapsedMs) = 0;   // `true` cuando ha terminado
+    virtual void abortZero() = 0;                           // Vuelve al reposo sin terminar
+    virtual bool setSpan(uint16_t) { return false; }
+    virtual bool setAutoCalibration(bool) { return false; }
+    virtual bool setDetectionRange(uint16_t) { return false; }
+    virtual const char *name() const = 0;
+};
+
+/**
+ * @class HdPinCalibration
+ * @brief Calibración a cero manteniendo el pin HD del sensor en BAJO.
+ * @details Es el único propietario del pin HD: nadie más lo configura. El
+ * final del pulso lo da un temporizador hardware (ver TimedOutput.h), así que
+ * su duración no depende de cuándo se ejecute el bucle principal.
+ */
+class HdPinCalibration : public CalibrationBackend
+{
+public:
+    HdPinCalibration(int pin, const uint32_t &pulseMs); // `pulseMs` se lee en cada paso
+    void begin() override;
+    void startZero() override;
+    bool updateZero(unsigned long elapsedMs) override;
+    void abortZero() override;
+    const char *name() const override { return "HD"; }
+    TimedOutput &getOutput() { return output; } // Para el registro de flancos
+
+private:
+    static void writePin(void *context, uint16_t level); // Escritura de `output`
+
+    int pin;
+    const uint32_t &pulse_ms; // Duración del pulso (configurable)
+    TimedOutput output;
+    bool hardware_timed;      // El pulso en curso lo termina el temporizador
+};
+
+/**
+ * @class UartCalibration
+ * @brief Calibración por comandos UART del MH-Z19C.
+ * @details Usa el mismo `Mhz19Link` que las lecturas, así que los comandos no
+ * bloquean el bucle ni interfieren con una lectura en curso.
+ */
+class UartCalibration : public CalibrationBackend
+{
+public:
+    explicit UartCalibration(Mhz19Link *link); // `nullptr` si la placa no tiene MH-Z19C
+    void begin() override {}
+    void startZero() override;
+    bool updateZero(unsigned long elapsedMs) override;
+    void abortZero() override {}
+    bool setSpan(uint16_t ppm) override;
+    bool setAutoCalibration(bool enabled) override;
+    bool setDetectionRange(uint16_t ppm) override;
+    const char *name() const override { return "UART"; }
+
+private:
+    static const unsigned long ZERO_SETTLE_MS = 1000; // Margen tras el comando antes de leer
+
+    Mhz19Link *link;
+    bool command_sent;
+};
+
+#endif // CALIBRATION_BACKEND_H
@@ -0,0 +1,66 @@
+#ifndef CALIBRATION_LOG_H
+#define CALIBRATION_LOG_H
+
+#include <Arduino.h>
+#include "SensorData.h"
+
+/**
+ * @enum CalibrationResult
+ * @brief Resultado de una calibración registrada.
+ */
+enum CalibrationResult
+{
+    CAL_RESULT_OK,          // Pulso completo y lectura posterior válida
+    CAL_RESULT_NO_READING,  // Pulso completo, pero sin lectura posterior
+    CAL_RESULT_ABORTED      // Reinicio durante el pulso, o la orden no terminó a tiempo
+};
+
+/**
+ * @struct CalibrationRecord
+ * @brief Entrada del historial de calibraciones.
+ * @details Sin reloj de tiempo real, el momento se identifica por el número de
+ * arranque y los segundos transcurridos desde ese arranque. Los offsets respecto
+ * a los 400 ppm de referencia son `co2Before - 400` y `co2After - 400`.
+ */
+struct CalibrationRecord
+{
+    uint16_t bootCount;  // Arranque en el que terminó la calibración
+    uint8_t result;      // CalibrationResult
+    uint8_t reserved;
+    uint32_t uptimeS;    // Segundos desde ese arranque al terminar el pulso
+    int16_t co2Before;   // ppm antes del pulso (-1 = sin lectura)
+    int16_t co2After;    // ppm tras el pulso (-1 = sin lectura)
+    int16_t temperature; // 0.01 °C antes del pulso
+    uint16_t humidity;   // 0.01 % antes del pulso
+    uint16_t pressure;   // 0.1 hPa antes del pulso
+};
+
+/**
+ * @class CalibrationLog
+ * @brief Historial persistente de calibraciones en LittleFS.
+ * @details Los registros se añaden al final de un archivo de tamaño fijo por
+ * registro; al llenarse se rota al archivo anterior, como el historial de
+ * muestras. Las consultas recorren ambos archivos del más reciente al más antiguo.
+ */
+class CalibrationLog
+{
+public:
+    // --- Métodos Públicos ---
+    CalibrationLog(); // Constructor
+    void init();      // Requiere LittleFS montado; incrementa el contador de arranques
+    bool append(CalibrationRecord &record); // Completa el momento y lo añade al final
+    uint32_t count();
+    bool read(uint32_t indexFromNewest, CalibrationRecord &record);
+    size_t describe(char *out, size_t len, uint32_t offset); // Varios registros en texto
+    uint16_t getBootCount();
+
+private:
+    // --- Constantes ---
+    static const size_t MAX_FILE_SIZE = 4096;     // ~200 calibraciones por archivo
+    static const uint8_t RECORDS_PER_QUERY = 6;   // Caben en una lectura BLE
+
+    // --- Variables de Estado ---
+    uint16_t boot_count;
+};
+
+#endif // CALIBRATION_LOG_H
@@ -1,40 +1,90 @@
 #ifndef CALIBRATION_MANAGER_H
 #define CALIBRATION_MANAGER_H
 
+#include "ConfigStore.h"
+#include "CalibrationLog.h"
+#include "CalibrationBackend.h"
+#include "Coroutine.h"
+
 /**
  * @class CalibrationManager
  * @brief Gestiona el proceso de calibración a cero (400 ppm) del sensor MH-Z19C.
  *
- * Esta clase maneja una máquina de estados para el calentamiento/estabilización
- * y la posterior activación del pulso de calibración en el pin HD.
+ * La estabilización y la posterior orden de calibración, que ejecuta el
+ * backend elegido en la configuración (pulso en el pin HD o comando UART),
+ * son un flujo lineal que corre como corrutina en el planificador del bucle
+ * principal (ver Coroutine.h). El estado se
+ * guarda en NVS en cada transición y periódicamente durante la estabilización,
+ * de modo que tras un reinicio la calibración se reanuda o se aborta limpiamente.
+ * Cada calibración terminada se añade al historial de calibraciones.
  */
 class CalibrationManager
 {
 public:
     // --- Métodos Públicos ---
     CalibrationManager(); // Constructor
-    void init();
+    void init(const DeviceConfig &config, CalibrationBackend &hdPin, CalibrationBackend &uart,
+              CoroutineScheduler &scheduler);
+    bool handleCommand(const String &cmd); // Comandos de la característica de calibración
     void startCalibration();
-    void run();           // Este método se llamará repetidamente en el loop() principal
     bool isCalibrating(); // Para saber si un proceso de calibración está activo
+    void onSample(const SensorData &data); // Última muestra, para las condiciones del historial
+    size_t describeHistory(char *out, size_t len, uint32_t offset); // Historial en texto
+    uint16_t getBootCount(); // Arranque actual, contado en NVS
 
 private:
-    // --- Definición de la Máquina de Estados ---
+    // --- Fases de la calibración (para el punto de control) ---
     enum CalibrationState
     {
         IDLE,
         STABILIZING,
         PULSING
     };
-    // --- Pines y Constantes ---
-    static const int HD_PIN = 12;
-    static const unsigned long STABILIZATION_TIME_MS = 20 * 60 * 1000UL; // 20 minutos
-    static const unsigned long PULSE_TIME_MS = 7000UL;                   // 7 segundos
+    /**
+     * @struct Checkpoint
+     * @brief Estado guardado en NVS para sobrevivir a un reinicio.
+     */
+    struct Checkpoint
+    {
+        uint8_t state;       // CalibrationState
+        uint32_t elapsedMs;  // Tiempo transcurrido en ese estado
+        SensorData before;   // Condiciones al iniciar la calibración
+    };
+
+    // --- Métodos Privados ---
+    static void flowBody(void *context);
+    void stepFlow();                        // Cuerpo del flujo de calibración
+    unsigned long stabilizationRemaining(); // Tiempo que falta de estabilización
+    bool zeroTimedOut();                    // La orden de calibración superó su plazo
+    void enterState(CalibrationState state);
+    void saveCheckpoint();
+    void clearCheckpoint();
+    void restoreCheckpoint();
+    void finishRecord(CalibrationResult result, int co2After);
+    CalibrationBackend &zeroBackend(); // Backend elegido en la configuración
+
+    // --- Constantes ---
+    static const unsigned long CHECKPOINT_INTERVAL_MS = 60 * 1000UL; // Durante la estabilización
+    static const unsigned long LOG_INTERVAL_MS = 10 * 1000UL;        // Mensajes de la estabilización
+    static const unsigned long POST_SETTLE_MS = 5000UL;    // Espera antes de la lectura posterior
+    static const unsigned long POST_TIMEOUT_MS = 60000UL;  // Tras esto se registra sin lectura
+    static const unsigned long ZERO_TIMEOUT_MARGIN_MS = 5000UL; // Sobre el pulso, antes de abortar la orden
 
     // --- Variables de Estado ---
-    CalibrationState currentState; // Variable que guarda el estado actual
-    unsigned long stateStartTime;  // Temporizador para los estados
-    unsigned long lastLogTime;     // Temporizador para los mensajes en consola
+    const DeviceConfig *config;    // Tiempos de estabilización y de pulso
+    CalibrationBackend *hd_backend;   // Pulso en el pin HD
+    CalibrationBackend *uart_backend; // Comandos UART (también span, ABC y rango)
+    CalibrationBackend *active_backend; // Backend de la calibración en curso
+    Coroutine flow;                // Flujo de calibración en curso
+    CalibrationState currentState; // Fase actual del flujo
+    unsigned long stateStartTime;  // Inicio de la fase actual
+    unsigned long lastCheckpointTime;
+    // -- Historial --
+    CalibrationLog calibrationLog;
+    SensorData last_sample;        // Última muestra recibida
+    SensorData before_sample;      // Condiciones al iniciar la calibración
+    bool awaiting_post_sample;     // Pulso terminado, falta la lectura posterior
+    unsigned long pulse_end_time;
 };
 
 #endif // CALIBRATION_MANAGER_H
\ No newline at end of file
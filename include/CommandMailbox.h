@@ -0,0 +1,99 @@
+#ifndef COMMAND_MAILBOX_H
+#define COMMAND_MAILBOX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * @file CommandMailbox.h
+ * @brief Buzón de un comando de texto entre la tarea de la pila BLE y el bucle principal.
+ * @details Los callbacks de escritura se ejecutan en la tarea de la pila BLE y
+ * el bucle recoge el comando después. Un `String` compartido no sirve: asignarlo
+ * reserva memoria y copia en varios pasos, así que el bucle podría leerlo a
+ * medias o liberarlo mientras la otra tarea lo escribe. El buzón guarda el
+ * comando en un buffer fijo y lo copia entero bajo un spinlock; un comando
+ * nuevo sustituye al pendiente, como antes.
+ *
+ * En el host (y con `-D NODE_SIMULATION`) el cliente virtual escribe en el
+ * mismo hilo que el bucle y no hace falta spinlock.
+ */
+
+#if defined(ARDUINO) && !defined(NODE_SIMULATION)
+#define COMMAND_MAILBOX_SPINLOCK
+#include <freertos/FreeRTOS.h>
+#endif
+
+/**
+ * @class CommandMailbox
+ * @brief Último comando recibido, de hasta `Capacity` bytes.
+ */
+template <size_t Capacity>
+class CommandMailbox
+{
+public:
+    /** @brief Buffer donde `take()` deja el comando con su terminador. */
+    typedef char Buffer[Capacity + 1];
+
+    CommandMailbox() : length(0), pending(false)
+    {
+#ifdef COMMAND_MAILBOX_SPINLOCK
+        portMUX_INITIALIZE(&spinlock);
+#endif
+    }
+
+    /**
+     * @brief Deja un comando en el buzón (desde la tarea de la pila BLE).
+     * @param data Bytes escritos por el cliente.
+     * @param len Longitud de `data`.
+     * @return bool `false` si el comando está vacío o no cabe; entonces se descarta.
+     */
+    bool post(const uint8_t *data, size_t len)
+    {
+        if (len == 0 || len > Capacity)
+        {
+            return false;
+        }
+        lock();
+        memcpy(text, data, len);
+        length = len;
+        pending = true;
+        unlock();
+        return true;
+    }
+
+    /**
+     * @brief Recoge el comando pendiente y vacía el buzón.
+     * @param out Buffer donde se copia el comando, terminado en '\0'.
+     * @return bool `false` si no había comando.
+     */
+    bool take(Buffer &out)
+    {
+        lock();
+        bool had = pending;
+        if (had)
+        {
+            memcpy(out, text, length);
+            out[length] = '\0';
+            pending = false;
+        }
+        unlock();
+        return had;
+    }
+
+private:
+#ifdef COMMAND_MAILBOX_SPINLOCK
+    void lock() { portENTER_CRITICAL(&spinlock); }
+    void unlock() { portEXIT_CRITICAL(&spinlock); }
+    portMUX_TYPE spinlock;
+#else
+    void lock() {}
+    void unlock() {}
+#endif
+
+    char text[Capacity];
+    size_t length;
+    bool pending;
+};
+
+#endif // COMMAND_MAILBOX_H
@@ -0,0 +1,85 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @file ConfigStore.h
+ * @brief Configuración persistente del dispositivo con esquema binario versionado.
+ * @details La configuración se guarda como un blob compacto: un byte de versión
+ * del esquema seguido de entradas `clave, longitud, valor`, con los números en
+ * varint. Las claves desconocidas se ignoran y las ausentes toman su valor por
+ * defecto, así que añadir campos no necesita migración; las migraciones solo
+ * hacen falta cuando cambia el significado de un campo existente.
+ *
+ * En el firmware el blob vive en NVS (Preferences); fuera de Arduino se guarda
+ * en un archivo, de modo que la lógica se puede ejercitar en el host.
+ */
+
+/** @brief Versión actual del esquema del blob. */
+static const uint8_t CONFIG_SCHEMA_VERSION = 1;
+/** @brief Longitud máxima del nombre del dispositivo (sin el terminador). */
+static const size_t CONFIG_NAME_MAX = 20;
+/** @brief Tamaño máximo del blob serializado. */
+static const size_t CONFIG_MAX_BLOB_SIZE = 96;
+/** @brief Longitud máxima de un comando de configuración (todas las claves caben de una vez). */
+static const size_t CONFIG_COMMAND_MAX_LEN = 192;
+
+/**
+ * @struct DeviceConfig
+ * @brief Valores de configuración en memoria.
+ * @details Es la caché que leen los caminos calientes: acceder a un campo no
+ * cuesta más que leer una variable.
+ */
+struct DeviceConfig
+{
+    uint32_t updateIntervalMs;   // Periodo de lectura de sensores y envío BLE
+    uint32_t historyIntervalMs;  // Periodo de las muestras del historial
+    uint32_t calStabilizationMs; // Estabilización previa al pulso de calibración
+    uint32_t calPulseMs;         // Duración del pulso en el pin HD
+    uint32_t calBackend;         // Calibración a cero: 0 = pulso en el pin HD, 1 = comando UART
+    uint32_t co2TimeoutMs;       // Espera máxima de la respuesta del MH-Z19C
+    uint32_t co2PreheatMs;       // Precalentamiento del MH-Z19C
+    uint32_t fanMode;            // Ventilador tras el precalentamiento: 0 = encendido, 1 = automático
+    char deviceName[CONFIG_NAME_MAX + 1]; // Nombre BLE (se aplica al reiniciar)
+};
+
+/**
+ * @class ConfigStore
+ * @brief Carga, valida, modifica y guarda la configuración del dispositivo.
+ */
+class ConfigStore
+{
+public:
+    // --- Métodos Públicos ---
+    ConfigStore(); // Constructor
+    bool begin();  // Carga la configuración guardada; `false` si se usan los valores por defecto
+    const DeviceConfig &get() const { return config; }
+    bool set(const char *key, const char *value); // Valida y cambia un campo en la caché
+    bool apply(const char *command);              // "CLAVE=valor;CLAVE=valor" o "RESET"
+    bool commit();                                // Guarda la caché en el almacenamiento
+    void resetDefaults();
+    size_t describe(char *out, size_t len) const; // "UPDATE_MS=500;...;NAME=SRV_NAME"
+#ifndef ARDUINO
+    void setFilePath(const char *path); // Archivo que hace de NVS en el host
+#endif
+
+    // --- Serialización (sin dependencias de la plataforma) ---
+    static size_t serialize(const DeviceConfig &config, uint8_t *out, size_t len);
+    static bool deserialize(const uint8_t *data, size_t len, DeviceConfig &config);
+    static void defaults(DeviceConfig &config);
+
+private:
+    // --- Métodos Privados ---
+    bool readBlob(uint8_t *out, size_t maxLen, size_t &len);
+    bool writeBlob(const uint8_t *data, size_t len);
+
+    // --- Variables de Estado ---
+    DeviceConfig config; // Caché en memoria
+#ifndef ARDUINO
+    const char *file_path;
+#endif
+};
+
+#endif // CONFIG_STORE_H
@@ -0,0 +1,152 @@
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "TimerWheel.h"
+
+/**
+ * @file Coroutine.h
+ * @brief Corrutinas sin pila ni memoria dinámica para los flujos temporizados.
+ * @details Un flujo de varios pasos (esperar, actuar, esperar a que algo
+ * termine...) se escribe de forma lineal en una función y se suspende en los
+ * `CO_*`. Al reanudarse, la función salta al punto donde se suspendió, al
+ * estilo de las protothreads: un `switch` sobre el número de línea guardado
+ * en el `Coroutine`.
+ *
+ * Las variables locales NO se conservan entre suspensiones: el estado del
+ * flujo (su "marco") son miembros del objeto que lo contiene, reservados en
+ * tiempo de compilación. Tampoco puede haber un `switch` propio que abarque un
+ * punto de suspensión, ni dos puntos de suspensión en la misma línea.
+ *
+ * Ejemplo:
+ * @code
+ * void Blink::step()
+ * {
+ *     CO_BEGIN(co);
+ *     while (true)
+ *     {
+ *         digitalWrite(pin, LOW);
+ *         CO_DELAY(co, 100);
+ *         digitalWrite(pin, HIGH);
+ *         CO_AWAIT(co, buttonPressed());
+ *     }
+ *     CO_END(co);
+ * }
+ * @endcode
+ *
+ * Los `CO_DELAY` se programan en la rueda de temporizadores del planificador,
+ * así que un flujo dormido no cuesta nada hasta que vence su plazo.
+ *
+ * No depende de Arduino: el tiempo lo pasa quien llama al planificador, así
+ * que los flujos se pueden ejecutar en el host con un reloj virtual.
+ */
+
+/** @brief Función que avanza un flujo hasta su siguiente suspensión. */
+typedef void (*CoroutineBody)(void *context);
+
+/**
+ * @class Coroutine
+ * @brief Punto de reanudación y temporización de un flujo.
+ */
+class Coroutine
+{
+public:
+    // --- Métodos Públicos ---
+    Coroutine(CoroutineBody body, void *context); // Constructor
+    void start(uint32_t nowMs); // (Re)inicia el flujo desde el principio
+    void stop();                // Abandona el flujo donde esté
+    bool isRunning() const { return running; }
+    bool isReady() const { return running && !sleeping; } // Se reanuda en la siguiente pasada
+
+    // --- Uso interno de las macros y del planificador ---
+    void attach(TimerWheel &wheel) { this->wheel = &wheel; }
+    void resume(uint32_t nowMs);
+    uint16_t resumePoint() const { return resume_point; }
+    void suspendAt(uint16_t line) { resume_point = line; }
+    void sleepFor(uint32_t ms);
+    void finish();
+    uint32_t now() const { return now_ms; }
+
+private:
+    static void onWake(void *context);
+
+    CoroutineBody body;
+    void *context;
+    uint16_t resume_point; // Línea donde se suspendió; 0 = principio
+    bool running;
+    bool sleeping;         // En `CO_DELAY`: lo despierta `wake_timer`
+    uint32_t now_ms;       // Instante de la reanudación en curso
+    TimerWheel *wheel;     // Rueda del planificador (`attach()`)
+    Timer wake_timer;
+};
+
+// --- Macros de los flujos ---
+
+/** @brief Primera línea del cuerpo del flujo. */
+#define CO_BEGIN(co) \
+    switch ((co).resumePoint()) \
+    {                           \
+    case 0:
+
+/** @brief Cede el control y continúa aquí en la siguiente pasada del planificador. */
+#define CO_YIELD(co)              \
+    do                            \
+    {                             \
+        (co).suspendAt(__LINE__); \
+        return;                   \
+    case __LINE__:;               \
+    } while (0)
+
+/** @brief Se suspende hasta que `condition` sea cierta (se evalúa en cada pasada). */
+#define CO_AWAIT(co, condition)   \
+    do                            \
+    {                             \
+        (co).suspendAt(__LINE__); \
+        [[fallthrough]];          \
+    case __LINE__:                \
+        if (!(condition))         \
+            return;               \
+    } while (0)
+
+/** @brief Se suspende durante `ms` milisegundos (al menos 1), sin consumir pasadas. */
+#define CO_DELAY(co, ms)     \
+    do                       \
+    {                        \
+        (co).sleepFor(ms);   \
+        CO_YIELD(co);        \
+    } while (0)
+
+/** @brief Última línea del cuerpo del flujo: el flujo termina. */
+#define CO_END(co) \
+    }              \
+    (co).finish()
+
+/**
+ * @class CoroutineScheduler
+ * @brief Reanuda los flujos registrados cuando les toca.
+ * @details Lista fija de flujos; un flujo dormido (`CO_DELAY`) no se reanuda
+ * hasta que lo despierta su temporizador en la rueda, y uno en `CO_AWAIT` se
+ * reanuda en cada pasada. La rueda la avanza quien la posee, antes de `run()`.
+ */
+class CoroutineScheduler
+{
+public:
+    // --- Métodos Públicos ---
+    CoroutineScheduler(TimerWheel &wheel); // Constructor
+    bool add(Coroutine &coroutine);  // `false` si la lista está llena
+    void run(uint32_t nowMs);        // Una pasada: reanuda los flujos que toca
+    bool hasReadyFlows() const;      // Algún flujo se reanuda en la siguiente pasada
+    uint32_t getResumeCount() const { return resume_count; }
+
+    // --- Constantes ---
+    static const uint8_t MAX_COROUTINES = 8;
+
+private:
+    TimerWheel &wheel;
+    Coroutine *coroutines[MAX_COROUTINES];
+    uint8_t count;
+    uint32_t resume_count; // Reanudaciones totales
+};
+
+#endif // COROUTINE_H
@@ -0,0 +1,77 @@
+#ifndef DERIVED_METRICS_H
+#define DERIVED_METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "SensorData.h"
+
+/**
+ * @enum DerivedField
+ * @brief Bits de `DerivedData::valid`, uno por magnitud derivada.
+ */
+enum DerivedField
+{
+    DERIVED_DEW_POINT = 1 << 0,
+    DERIVED_ABSOLUTE_HUMIDITY = 1 << 1,
+    DERIVED_CO2_COMPENSATED = 1 << 2,
+    DERIVED_ALTITUDE = 1 << 3
+};
+
+/**
+ * @struct DerivedData
+ * @brief Magnitudes calculadas a partir de una muestra de los sensores.
+ * @details Un campo solo es significativo si su bit de `valid` está activo
+ * (el punto de rocío o la altitud pueden ser negativos, así que no se usa -1).
+ */
+struct DerivedData
+{
+    float dewPoint;         // Punto de rocío, °C
+    float absoluteHumidity; // Humedad absoluta, g/m³
+    int co2Compensated;     // CO2 referido a la presión estándar, ppm
+    float altitude;         // Altitud barométrica, m
+    uint8_t valid;          // Máscara de `DerivedField`
+};
+
+/**
+ * @class DerivedMetrics
+ * @brief Calcula punto de rocío, humedad absoluta, CO2 compensado en presión
+ * y altitud a partir de cada muestra.
+ * @details Los logaritmos y exponenciales se aproximan descomponiendo el float
+ * en exponente y mantisa y evaluando un polinomio corto, sin llamar a `log` ni
+ * a `exp` (error relativo por debajo de 1e-6, muy inferior a la resolución de
+ * los sensores). Cada grupo de magnitudes solo se recalcula cuando cambian sus
+ * entradas: punto de rocío y humedad absoluta con temperatura o humedad, el
+ * CO2 con CO2 o presión, y la altitud con la presión. No depende de Arduino.
+ */
+class DerivedMetrics
+{
+public:
+    // --- Constantes ---
+    static constexpr float SEA_LEVEL_HPA = 1013.25f; // Presión de referencia
+
+    // --- Métodos Públicos ---
+    DerivedMetrics(); // Constructor
+    const DerivedData &update(const SensorData &data); // Recalcula lo que haya cambiado
+    const DerivedData &get() const;
+    uint32_t getComputeCount() const; // Grupos recalculados desde el arranque
+    size_t describe(char *out, size_t len) const;
+
+    static float fastLog2(float x); // x > 0
+    static float fastExp2(float x);
+
+private:
+    // --- Métodos Privados ---
+    void computeHumidity(float temperature, float humidity);
+    void computeCo2(int co2, float pressure);
+    void computeAltitude(float pressure);
+
+    // --- Variables de Estado ---
+    DerivedData derived;
+    float last_temperature;
+    float last_humidity;
+    float last_pressure;
+    int last_co2;
+    uint32_t compute_count;
+};
+
+#endif // DERIVED_METRICS_H
@@ -0,0 +1,58 @@
+#ifndef ENVIRONMENTAL_SENSING_H
+#define ENVIRONMENTAL_SENSING_H
+
+#include <Arduino.h>
+#include "GattServer.h"
+
+/**
+ * @struct EssTrigger
+ * @brief Configuración y estado de un descriptor ES Trigger Setting (0x290D).
+ * @details El operando se guarda ya convertido a las unidades de la característica
+ * (ej. 0.01 °C para la temperatura, segundos para las condiciones de tiempo).
+ */
+struct EssTrigger
+{
+    uint8_t quantity;             // Magnitud a la que pertenece el descriptor
+    uint8_t condition;            // Condición del disparador (ver EssTriggerCondition)
+    int32_t operand;              // Operando de la condición
+    bool hasLastValue;            // Si ya se notificó algún valor
+    int32_t lastValue;            // Último valor notificado
+    unsigned long lastNotifyTime; // Momento de la última notificación (ms)
+};
+
+/**
+ * @class EnvironmentalSensing
+ * @brief Implementa el servicio estándar Environmental Sensing (0x181A) del Bluetooth SIG.
+ * @details Expone temperatura, humedad y presión en formato binario estándar, cada una
+ * con sus descriptores ES Measurement (0x290C), ES Trigger Setting (0x290D) y CCCD.
+ * Las condiciones de los disparadores se evalúan en el dispositivo en cada muestra,
+ * de modo que solo se notifica cuando el cliente lo ha pedido.
+ */
+class EnvironmentalSensing
+{
+public:
+    // --- Métodos Públicos ---
+    EnvironmentalSensing(); // Constructor
+    void init(GattServer &server);
+    void update(float temp, float hum, float pres); // Evalúa disparadores y notifica
+
+private:
+    // --- Magnitudes del servicio ---
+    enum EssQuantity
+    {
+        ESS_TEMPERATURE,
+        ESS_HUMIDITY,
+        ESS_PRESSURE,
+        ESS_QUANTITY_COUNT
+    };
+
+    // --- Métodos Privados ---
+    void publish(EssQuantity quantity, int32_t value);
+
+    // --- Atributos ---
+    GattServer *gatt;
+    GattHandle handles[ESS_QUANTITY_COUNT];
+    EssTrigger triggers[ESS_QUANTITY_COUNT];
+};
+
+#endif // ENVIRONMENTAL_SENSING_H
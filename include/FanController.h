@@ -0,0 +1,71 @@
+#ifndef FAN_CONTROLLER_H
+#define FAN_CONTROLLER_H
+
+#include <stdint.h>
+
+/** @brief Ciclo de trabajo máximo (resolución PWM de 10 bits). */
+static const uint16_t FAN_DUTY_MAX = 1023;
+
+/**
+ * @struct FanControllerConfig
+ * @brief Parámetros de sintonía del controlador PI del ventilador.
+ * @details La consigna, la histéresis y la medida se expresan en las mismas
+ * unidades enteras (ej. 0.01 °C o ppm). Las ganancias están en Q16.16:
+ * `kp` en unidades de duty por unidad de error y `ki` en unidades de duty
+ * por unidad de error y por segundo.
+ */
+struct FanControllerConfig
+{
+    int32_t setpoint;    // Consigna
+    int32_t hysteresis;  // Banda por debajo de la consigna antes de apagar
+    int32_t kp;          // Ganancia proporcional, Q16.16
+    int32_t ki;          // Ganancia integral, Q16.16
+    uint16_t minDuty;    // Duty mínimo mientras el ventilador gira
+    uint16_t spinUpDuty; // Duty de arranque para vencer la inercia
+    uint32_t spinUpMs;   // Duración del arranque
+};
+
+/**
+ * @struct FanCommand
+ * @brief Comando manual del ventilador ya validado.
+ */
+struct FanCommand
+{
+    bool automatic; // `true` para volver al control automático
+    uint16_t duty;  // Duty manual, si no es automático
+};
+
+bool parseFanCommand(const char *text, FanCommand &command);
+
+/**
+ * @class FanController
+ * @brief Controlador PI en punto fijo para un ventilador de refrigeración.
+ * @details El ventilador se enciende cuando la medida supera la consigna y se
+ * apaga cuando cae por debajo de `setpoint - hysteresis`. Mientras gira, el
+ * duty es la salida PI limitada a [minDuty, FAN_DUTY_MAX], con un arranque a
+ * `spinUpDuty` y un integrador que deja de acumular al saturar (anti-windup).
+ * Todo el cálculo es entero y no depende de Arduino, de modo que es
+ * determinista y se puede reproducir en el host con un modelo térmico.
+ */
+class FanController
+{
+public:
+    FanController(); // Constructor
+    void configure(const FanControllerConfig &config);
+    void reset();
+    uint16_t update(int32_t measurement, uint32_t dtMs); // Calcula el nuevo duty
+    uint16_t getDuty() const;
+    uint16_t getRunDuty() const;          // Duty sin el mínimo de arranque
+    uint32_t getSpinUpRemainingMs() const; // Arranque que queda tras el último paso
+    bool isRunning() const;
+
+private:
+    FanControllerConfig cfg;
+    int64_t integral;          // Término integral acumulado, Q16.16 en unidades de duty
+    uint32_t spinUpRemainingMs; // Tiempo restante de arranque
+    uint16_t duty;
+    uint16_t run_duty;          // Salida PI limitada, antes del arranque
+    bool running;
+};
+
+#endif // FAN_CONTROLLER_H
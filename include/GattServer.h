@@ -0,0 +1,218 @@
+#ifndef GATT_SERVER_H
+#define GATT_SERVER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * @file GattServer.h
+ * @brief Fachada del servidor GATT, independiente de la pila BLE.
+ * @details BLEManager y EnvironmentalSensing solo usan esta interfaz. La pila
+ * se elige al compilar:
+ * - por defecto, NimBLE (menos RAM y flash, arranque más rápido);
+ * - con `-D GATT_BACKEND_BLUEDROID`, el wrapper Bluedroid de Arduino;
+ * - con `-D NODE_SIMULATION`, un servidor en memoria para el host, con la
+ *   interfaz de un cliente virtual (ver HostGattServer).
+ *
+ * Las características y descriptores se identifican por un `GattHandle`
+ * (índice en el orden de creación), no por punteros de la pila, y los UUID
+ * se pasan ya en binario (`GattUuid`), calculados al compilar.
+ */
+
+#if defined(NODE_SIMULATION)
+#define GATT_BACKEND_HOST
+#elif !defined(GATT_BACKEND_BLUEDROID)
+#define GATT_BACKEND_NIMBLE
+#endif
+
+/** @brief Identificador de una característica; `GATT_INVALID_HANDLE` si no existe. */
+typedef int16_t GattHandle;
+static const GattHandle GATT_INVALID_HANDLE = -1;
+
+/**
+ * @struct GattUuid
+ * @brief UUID de 16 o 128 bits en binario.
+ * @details Los bytes van en little-endian, el orden en que los transmite la
+ * pila; `len` 0 marca un UUID mal formado.
+ */
+struct GattUuid
+{
+    uint8_t len; // 2 (16 bits) o 16 (128 bits)
+    uint8_t bytes[16];
+};
+
+/**
+ * @brief UUID de 16 bits asignado por el Bluetooth SIG.
+ * @param uuid Valor, ej. 0x181A.
+ */
+constexpr GattUuid gattUuid16(uint16_t uuid)
+{
+    GattUuid result{};
+    result.len = 2;
+    result.bytes[0] = (uint8_t)(uuid & 0xFF);
+    result.bytes[1] = (uint8_t)(uuid >> 8);
+    return result;
+}
+
+/**
+ * @brief Valor de un dígito hexadecimal, o -1 si no lo es.
+ */
+constexpr int gattHexDigit(char c)
+{
+    return (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+}
+
+/**
+ * @brief UUID de 128 bits a partir de su forma textual.
+ * @details Pensado para inicializar tablas `constexpr`: la conversión se hace
+ * al compilar. El texto se escribe con el byte más significativo primero
+ * ("4fafc201-1fb5-459e-8fcc-c5c9c331914b"); si no tiene 32 dígitos
+ * hexadecimales se devuelve un UUID con `len` 0.
+ * @param text UUID con o sin guiones.
+ */
+constexpr GattUuid gattUuid128(const char *text)
+{
+    GattUuid result{};
+    int digits = 0;
+    for (const char *c = text; *c != '\0'; c++)
+    {
+        if (*c == '-')
+        {
+            continue;
+        }
+        int value = gattHexDigit(*c);
+        if (value < 0 || digits >= 32)
+        {
+            return GattUuid{};
+        }
+        uint8_t &byte = result.bytes[15 - digits / 2];
+        byte = (uint8_t)((digits % 2 == 0) ? value << 4 : byte | value);
+        digits++;
+    }
+    result.len = digits == 32 ? 16 : 0;
+    return result;
+}
+
+/**
+ * @brief Compara dos UUID.
+ */
+constexpr bool gattUuidEquals(const GattUuid &a, const GattUuid &b)
+{
+    if (a.len != b.len)
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < a.len; i++)
+    {
+        if (a.bytes[i] != b.bytes[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @enum GattProperty
+ * @brief Propiedades de una característica (se combinan con `|`).
+ * @details Las características con NOTIFY o INDICATE reciben su CCCD (0x2902)
+ * automáticamente.
+ */
+enum GattProperty
+{
+    GATT_PROP_READ = 1 << 0,
+    GATT_PROP_WRITE = 1 << 1,
+    GATT_PROP_NOTIFY = 1 << 2,
+    GATT_PROP_INDICATE = 1 << 3
+};
+
+/**
+ * @enum GattEvent
+ * @brief Eventos de conexión que el servidor comunica a su propietario.
+ */
+enum GattEvent
+{
+    GATT_EVENT_CONNECT,
+    GATT_EVENT_DISCONNECT
+};
+
+/**
+ * @struct GattConnectionParams
+ * @brief Parámetros de conexión, en las unidades de la especificación.
+ * @details Intervalos en unidades de 1.25 ms, timeout de supervisión en
+ * unidades de 10 ms. Un intervalo 0 significa desconocido.
+ */
+struct GattConnectionParams
+{
+    uint16_t minInterval;
+    uint16_t maxInterval;
+    uint16_t latency;
+    uint16_t timeout;
+};
+
+/**
+ * @brief Callback de escritura del cliente en una característica o descriptor.
+ * @details Se ejecuta en la tarea de la pila BLE: solo debe guardar el valor
+ * para que el bucle principal lo procese.
+ */
+typedef void (*GattWriteHandler)(void *context, const uint8_t *data, size_t len);
+/**
+ * @brief Callback de lectura: produce el valor de una característica cuando el cliente la lee.
+ * @details Se ejecuta en la tarea de la pila BLE y no debe bloquear.
+ * @return size_t Bytes escritos en `out` (como mucho `maxLen`).
+ */
+typedef size_t (*GattReadHandler)(void *context, uint8_t *out, size_t maxLen);
+/** @brief Tamaño máximo del valor que produce un `GattReadHandler`. */
+static const size_t GATT_READ_BUFFER_LEN = 64;
+/** @brief Callback de los eventos de conexión (también en la tarea de la pila BLE). */
+typedef void (*GattEventHandler)(GattEvent event);
+
+/**
+ * @class GattServer
+ * @brief Servidor GATT con un único cliente conectado a la vez.
+ * @details Uso: `begin()`, después cada servicio con `beginService()`,
+ * `addCharacteristic()`/`addDescriptor()` y `endService()`, y por último
+ * `startAdvertising()`.
+ */
+class GattServer
+{
+public:
+    virtual ~GattServer() {}
+
+    // --- Construcción del servidor ---
+    virtual bool begin(const char *deviceName, GattEventHandler onEvent) = 0;
+    virtual void beginService(const GattUuid &uuid, uint16_t numHandles) = 0;
+    virtual GattHandle addCharacteristic(const GattUuid &uuid, uint8_t properties,
+                                         GattWriteHandler onWrite = nullptr, void *context = nullptr) = 0;
+    virtual void addDescriptor(GattHandle characteristic, const GattUuid &uuid, const uint8_t *value, size_t len,
+                               size_t maxLen, GattWriteHandler onWrite = nullptr, void *context = nullptr) = 0;
+    virtual void endService() = 0;
+    virtual void setReadHandler(GattHandle handle, GattReadHandler onRead, void *context = nullptr) = 0; // Valor bajo demanda
+
+    // --- Valores ---
+    virtual void setValue(GattHandle handle, const uint8_t *data, size_t len) = 0;
+    virtual void notify(GattHandle handle) = 0;
+    virtual void indicate(GattHandle handle) = 0; // Espera la confirmación del cliente
+    void setValue(GattHandle handle, const char *text) { setValue(handle, (const uint8_t *)text, strlen(text)); }
+
+    // --- Publicidad ---
+    virtual void setAdvertisingData(const char *name, const uint8_t *manufacturerData, size_t len) = 0;
+    virtual void setScanResponseServices(const GattUuid *uuids, size_t count) = 0;
+    virtual void startAdvertising(bool connectable) = 0;
+
+    // --- Conexión ---
+    virtual bool isConnected() = 0;
+    virtual uint16_t getPeerMtu() = 0;
+    virtual void requestConnectionParams(const GattConnectionParams &params) = 0;
+    virtual bool getConnectionParams(GattConnectionParams &params) = 0; // Parámetros acordados
+    virtual const char *name() const = 0; // Nombre de la pila, para el diagnóstico
+};
+
+/**
+ * @brief Servidor GATT de la pila elegida al compilar.
+ * @details Lo define el único backend compilado.
+ */
+GattServer &gattServer();
+
+#endif // GATT_SERVER_H
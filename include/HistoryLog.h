@@ -0,0 +1,54 @@
+#ifndef HISTORY_LOG_H
+#define HISTORY_LOG_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "SensorData.h"
+#include "SampleCodec.h"
+
+/**
+ * @class HistoryLog
+ * @brief Registro persistente y comprimido de las muestras de los sensores.
+ * @details Las muestras se comprimen con `SampleBlockEncoder` y cada bloque
+ * completo se añade a un archivo en LittleFS. Cuando el archivo supera su
+ * tamaño máximo se rota, conservando el archivo anterior. La descarga del
+ * historial envía los bloques tal cual están guardados, más una copia del
+ * bloque todavía abierto, de modo que el cliente recibe el mismo formato
+ * comprimido que hay en flash.
+ */
+class HistoryLog
+{
+public:
+    // --- Métodos Públicos ---
+    HistoryLog(); // Constructor
+    void init();
+    void record(const SensorData &data); // Añade una muestra al historial
+    bool beginTransfer();                // Prepara una descarga completa
+    size_t readTransfer(uint8_t *out, size_t maxLen); // Siguiente fragmento; 0 al terminar
+    void cancelTransfer();
+    bool isTransferActive();
+
+private:
+    // --- Métodos Privados ---
+    void flushBlock(); // Escribe el bloque actual en flash y empieza otro
+    bool openNextTransferFile();
+
+    // --- Constantes ---
+    static const size_t MAX_FILE_SIZE = 128 * 1024UL; // Tamaño a partir del cual se rota
+
+    // --- Variables de estado ---
+    SampleBlockEncoder encoder; // Bloque en construcción
+    bool fs_ready;              // Si LittleFS se montó correctamente
+
+    // -- Descarga en curso --
+    bool transfer_active;
+    int transfer_file_index;                      // Archivo que se está enviando
+    File transfer_file;                           // Archivo abierto para lectura
+    size_t transfer_remaining;                    // Bytes del archivo pendientes de enviar
+    size_t transfer_file_sizes[2];                // Tamaños capturados al iniciar la descarga
+    uint8_t open_block[CODEC_MAX_BLOCK_SIZE];     // Copia del bloque abierto
+    size_t open_block_len;
+    size_t open_block_pos;
+};
+
+#endif // HISTORY_LOG_H
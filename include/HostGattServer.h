@@ -0,0 +1,103 @@
+#ifndef HOST_GATT_SERVER_H
+#define HOST_GATT_SERVER_H
+
+#include "GattServer.h"
+
+#if defined(GATT_BACKEND_HOST)
+
+#include <deque>
+#include <string>
+#include <vector>
+
+/**
+ * @struct HostGattNotification
+ * @brief Notificación o indicación enviada al cliente virtual.
+ */
+struct HostGattNotification
+{
+    GattUuid uuid;     // Característica que la envió
+    std::string value;
+    bool indication;
+};
+
+/**
+ * @class HostGattServer
+ * @brief Servidor GATT en memoria para ejecutar el firmware en el host.
+ * @details Además de la fachada, ofrece la interfaz de un cliente virtual que
+ * conecta, lee, escribe y recibe notificaciones, todo en el mismo hilo: las
+ * escrituras llaman a los callbacks de inmediato, como haría la tarea de la
+ * pila BLE. Las indicaciones se confirman solas. Solo se compila con
+ * `-D NODE_SIMULATION`.
+ */
+class HostGattServer : public GattServer
+{
+public:
+    // --- Fachada ---
+    HostGattServer(); // Constructor
+    bool begin(const char *deviceName, GattEventHandler onEvent) override;
+    void beginService(const GattUuid &uuid, uint16_t numHandles) override;
+    GattHandle addCharacteristic(const GattUuid &uuid, uint8_t properties,
+                                 GattWriteHandler onWrite = nullptr, void *context = nullptr) override;
+    void addDescriptor(GattHandle characteristic, const GattUuid &uuid, const uint8_t *value, size_t len,
+                       size_t maxLen, GattWriteHandler onWrite = nullptr, void *context = nullptr) override;
+    void endService() override {}
+    void setReadHandler(GattHandle handle, GattReadHandler onRead, void *context = nullptr) override;
+    void setValue(GattHandle handle, const uint8_t *data, size_t len) override;
+    using GattServer::setValue;
+    void notify(GattHandle handle) override;
+    void indicate(GattHandle handle) override;
+    void setAdvertisingData(const char *name, const uint8_t *manufacturerData, size_t len) override;
+    void setScanResponseServices(const GattUuid *uuids, size_t count) override {}
+    void startAdvertising(bool connectable) override;
+    bool isConnected() override { return connected; }
+    uint16_t getPeerMtu() override { return mtu; }
+    void requestConnectionParams(const GattConnectionParams &params) override;
+    bool getConnectionParams(GattConnectionParams &params) override;
+    const char *name() const override { return "HOST"; }
+
+    // --- Cliente virtual ---
+    bool clientConnect(uint16_t clientMtu = 247); // `false` si no se está publicitando como conectable
+    void clientDisconnect();
+    bool clientWrite(const GattUuid &uuid, const std::string &value);
+    bool clientWriteDescriptor(const GattUuid &uuid, const GattUuid &descriptorUuid, const std::string &value);
+    bool clientRead(const GattUuid &uuid, std::string &value);
+    bool popNotification(HostGattNotification &notification);
+    bool isAdvertising() const { return advertising; }
+    const std::string &getManufacturerData() const { return manufacturer_data; }
+    const std::string &getAdvertisingData() const { return advertising_data; } // Paquete completo, como en el aire
+
+private:
+    /**
+     * @struct Attribute
+     * @brief Característica o descriptor con su valor.
+     */
+    struct Attribute
+    {
+        GattUuid uuid;
+        std::string value;
+        GattHandle owner; // Característica propietaria (descriptores); -1 en características
+        uint8_t properties;
+        GattWriteHandler onWrite;
+        void *context;
+        GattReadHandler onRead;
+        void *readContext;
+    };
+
+    int find(const GattUuid &uuid) const; // Índice de una característica, -1 si no existe
+
+    GattEventHandler event_handler;
+    std::vector<Attribute> characteristics;
+    std::vector<Attribute> descriptors;
+    std::deque<HostGattNotification> notifications;
+    GattConnectionParams params;
+    std::string manufacturer_data;
+    std::string advertising_data;
+    uint16_t mtu;
+    bool connected;
+    bool advertising;
+    bool connectable;
+};
+
+#endif // GATT_BACKEND_HOST
+
+#endif // HOST_GATT_SERVER_H
@@ -0,0 +1,75 @@
+#ifndef I2C_INVENTORY_H
+#define I2C_INVENTORY_H
+
+#include <Arduino.h>
+
+/**
+ * @enum I2CChip
+ * @brief Chips que el inventario sabe identificar por su registro de ID.
+ */
+enum I2CChip
+{
+    CHIP_UNKNOWN, // Responde en el bus pero no se reconoce
+    CHIP_BMP180,
+    CHIP_BMP280,
+    CHIP_BME280,
+    CHIP_CCS811
+};
+
+/**
+ * @struct I2CDevice
+ * @brief Dispositivo encontrado en el bus.
+ */
+struct I2CDevice
+{
+    uint8_t address; // Dirección de 7 bits
+    I2CChip chip;    // Chip identificado
+    uint8_t chipId;  // Valor leído del registro de ID (0 si no se leyó)
+};
+
+/**
+ * @class I2CInventory
+ * @brief Inventario incremental de los dispositivos del bus I2C.
+ * @details Cada llamada a `step()` sondea solo `PROBES_PER_STEP` direcciones,
+ * de modo que una pasada completa se reparte entre varios ciclos del bucle
+ * principal sin bloquearlo. Los dispositivos en direcciones conocidas se
+ * identifican leyendo su registro de ID. El inventario publicado solo se
+ * sustituye al terminar una pasada, así que siempre es coherente.
+ */
+class I2CInventory
+{
+public:
+    // --- Métodos Públicos ---
+    I2CInventory(); // Constructor
+    void restart();  // Empieza una nueva pasada desde la primera dirección
+    bool step();     // Sondea unas pocas direcciones; `true` al terminar una pasada
+    void scanAll();  // Completa la pasada en curso de forma síncrona (arranque)
+    bool isScanning();
+    bool hasChanged(); // Si el inventario cambió desde la última consulta
+    const I2CDevice *find(I2CChip chip) const;
+    uint8_t getDeviceCount() const;
+    const I2CDevice &getDevice(uint8_t index) const;
+    String describe() const; // Inventario en texto, ej. "0x76=BMP280;0x3C=UNKNOWN"
+
+private:
+    // --- Métodos Privados ---
+    void probe(uint8_t address);
+    I2CChip identify(uint8_t address, uint8_t &chipId);
+    bool readRegister(uint8_t address, uint8_t reg, uint8_t &value);
+
+    // --- Constantes ---
+    static const uint8_t FIRST_ADDRESS = 0x08;  // 0x00-0x07 están reservadas
+    static const uint8_t LAST_ADDRESS = 0x77;   // 0x78-0x7F están reservadas
+    static const uint8_t PROBES_PER_STEP = 4;   // ~0.4 ms por paso a 100 kHz
+    static const uint8_t MAX_DEVICES = 16;
+
+    // --- Variables de Estado ---
+    I2CDevice devices[MAX_DEVICES]; // Inventario de la última pasada completa
+    uint8_t device_count;
+    I2CDevice pending[MAX_DEVICES]; // Dispositivos de la pasada en curso
+    uint8_t pending_count;
+    uint8_t next_address; // Siguiente dirección a sondear (0 = sin pasada en curso)
+    bool changed;
+};
+
+#endif // I2C_INVENTORY_H
@@ -0,0 +1,129 @@
+#ifndef MHZ19_LINK_H
+#define MHZ19_LINK_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Sin `NODE_SIMULATION`, el enlace usa el driver UART de ESP-IDF con
+ * cola de eventos; en la simulación, el `HardwareSerial` de la capa Arduino.
+ */
+#if !defined(NODE_SIMULATION)
+#define MHZ19_UART_IDF
+#include <atomic>
+#include <driver/uart.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#endif
+
+/**
+ * @brief Calcula el checksum para un comando del sensor MH-Z19C.
+ * @details Esta función es específica del protocolo del sensor MH-Z19C.
+ * Suma los bytes del 1 al 7, resta el resultado de 0xFF y suma 1.
+ * @param packet Puntero a un array de 8 bytes (los primeros 8 bytes del comando).
+ * @return byte El byte de checksum calculado.
+ */
+inline byte mhz19Checksum(const byte *packet)
+{
+    byte checksum = 0;
+    for (int i = 1; i < 8; i++)
+    {
+        checksum += packet[i];
+    }
+    checksum = 0xFF - checksum;
+    checksum += 1;
+    return checksum;
+}
+
+/**
+ * @class Mhz19Link
+ * @brief Transporte de tramas de 9 bytes con el MH-Z19C, compartido por las
+ * lecturas y los comandos de calibración.
+ * @details Ninguna operación espera al sensor: las tramas se escriben en el
+ * buffer de transmisión del UART y las respuestas se consultan con
+ * `isResponseReady()`. Un comando que llega con una lectura en curso se
+ * encola y se envía al terminar esa lectura, de modo que nunca se mezcla con
+ * su respuesta. Cada trama se escribe con una sola llamada, así que tampoco
+ * se mezclan en la línea las de tareas distintas.
+ *
+ * Con el driver de ESP-IDF, una tarea de recepción espera en la cola de
+ * eventos del UART y arma las tramas: la detección de patrón marca cada 0xFF
+ * precedido de silencio en la línea (una cabecera, no un byte de datos que
+ * valga 0xFF). Cuando llega la respuesta válida de la lectura en curso, se
+ * notifica a la tarea que la pidió, que puede dormir en
+ * `ulTaskNotifyTake()` en vez de consultar el UART. Las respuestas a otros
+ * comandos se descartan. `reopen()` detiene la tarea, desinstala el driver
+ * y lo vuelve a instalar, con lo que el periférico queda como al arrancar.
+ *
+ * En la simulación se consulta el `HardwareSerial`, y antes de cada lectura
+ * se descartan los bytes pendientes, como las respuestas de comandos anteriores.
+ */
+class Mhz19Link
+{
+public:
+    // --- Comandos del protocolo ---
+    static const uint8_t CMD_READ_CO2 = 0x86;
+    static const uint8_t CMD_ZERO_POINT = 0x87; // Calibra el punto cero (400 ppm)
+    static const uint8_t CMD_SPAN_POINT = 0x88; // Calibra el span al valor indicado
+    static const uint8_t CMD_SET_ABC = 0x79;    // Autocalibración: 0xA0 activa, 0x00 desactiva
+    static const uint8_t CMD_SET_RANGE = 0x99;  // Rango de detección
+    static const size_t FRAME_SIZE = 9;
+
+    // --- Métodos Públicos ---
+    Mhz19Link(HardwareSerial &port, uint8_t uartNum); // Constructor
+    void begin(int rxPin, int txPin);
+    void reopen(); // Reinicia el UART y descarta lo recibido (recuperación)
+    bool sendCommand(uint8_t command, uint8_t b3 = 0, uint8_t b4 = 0, uint8_t b5 = 0, uint8_t b6 = 0, uint8_t b7 = 0);
+    void startRead();         // Solicita una lectura de CO2
+    bool isResponseReady();   // Si ya llegó la respuesta completa
+    bool readResponse(byte *response); // Lee la respuesta; `false` si no es válida
+    void abortRead();         // Da por perdida la lectura en curso (timeout)
+    uint32_t getDroppedFrames() const; // Tramas inválidas o que nadie esperaba
+
+private:
+    // --- Métodos Privados ---
+    void writeFrame(const uint8_t *args); // args: comando y bytes 3 a 7
+    void finishRead();
+    void discardInput();
+#ifdef MHZ19_UART_IDF
+    void install(); // Driver UART y tarea de recepción
+    static void rxTask(void *parameter);
+    void receive(size_t len);  // Lee `len` bytes del driver y arma tramas
+    void assemble(uint8_t b);  // Añade un byte a la trama en curso
+#endif
+
+    // --- Constantes ---
+    static const uint8_t QUEUE_SIZE = 4;
+#ifdef MHZ19_UART_IDF
+    static const int RX_BUFFER_SIZE = 256;  // Mínimo del driver (> tamaño de la FIFO)
+    static const int TX_BUFFER_SIZE = 256;  // Las escrituras no esperan a la FIFO
+    static const int EVENT_QUEUE_SIZE = 16;
+    static const int PATTERN_PRE_IDLE = 20; // Silencio previo a una cabecera, en ciclos de baudio
+    static const uint32_t STOP_TIMEOUT_MS = 100; // Espera a que termine `rxTask` en `reopen()`
+#endif
+
+    // --- Variables de Estado ---
+    HardwareSerial &port; // Solo en la simulación
+    uint8_t uart_num;     // UART del driver de ESP-IDF (Serial2 = 2)
+    int rx_pin;
+    int tx_pin;
+    bool started;
+    bool read_pending;
+    uint8_t queue[QUEUE_SIZE][6]; // Comandos a la espera de que termine la lectura
+    uint8_t queue_count;
+#ifdef MHZ19_UART_IDF
+    // -- Recepción (tarea `rxTask`) --
+    QueueHandle_t events;
+    uint8_t frame[FRAME_SIZE];           // Trama en construcción
+    uint8_t frame_len;                   // 0 = esperando cabecera
+    uint8_t response[FRAME_SIZE];        // Última respuesta válida de la lectura
+    std::atomic<bool> response_ready;    // `response` es de la lectura en curso
+    std::atomic<TaskHandle_t> waiter;    // Tarea a notificar al llegar la respuesta
+    std::atomic<uint32_t> dropped_frames;
+    std::atomic<bool> rx_running;        // `rxTask` sigue leyendo de `events`
+#else
+    uint32_t dropped_frames;
+#endif
+};
+
+#endif // MHZ19_LINK_H
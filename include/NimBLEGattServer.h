@@ -0,0 +1,59 @@
+#ifndef NIMBLE_GATT_SERVER_H
+#define NIMBLE_GATT_SERVER_H
+
+#include "GattServer.h"
+
+#if defined(GATT_BACKEND_NIMBLE)
+
+#include <Arduino.h>
+#include <NimBLEDevice.h>
+
+class NimBLEGattCharacteristicCallbacks;
+
+/**
+ * @class NimBLEGattServer
+ * @brief Servidor GATT sobre la pila NimBLE (librería NimBLE-Arduino).
+ * @details NimBLE crea el CCCD de las características con NOTIFY/INDICATE y
+ * reserva los handles de cada servicio por sí mismo, así que `numHandles` se
+ * ignora.
+ */
+class NimBLEGattServer : public GattServer
+{
+public:
+    NimBLEGattServer(); // Constructor
+    bool begin(const char *deviceName, GattEventHandler onEvent) override;
+    void beginService(const GattUuid &uuid, uint16_t numHandles) override;
+    GattHandle addCharacteristic(const GattUuid &uuid, uint8_t properties,
+                                 GattWriteHandler onWrite = nullptr, void *context = nullptr) override;
+    void addDescriptor(GattHandle characteristic, const GattUuid &uuid, const uint8_t *value, size_t len,
+                       size_t maxLen, GattWriteHandler onWrite = nullptr, void *context = nullptr) override;
+    void endService() override;
+    void setReadHandler(GattHandle handle, GattReadHandler onRead, void *context = nullptr) override;
+    void setValue(GattHandle handle, const uint8_t *data, size_t len) override;
+    using GattServer::setValue;
+    void notify(GattHandle handle) override;
+    void indicate(GattHandle handle) override;
+    void setAdvertisingData(const char *name, const uint8_t *manufacturerData, size_t len) override;
+    void setScanResponseServices(const GattUuid *uuids, size_t count) override;
+    void startAdvertising(bool connectable) override;
+    bool isConnected() override;
+    uint16_t getPeerMtu() override;
+    void requestConnectionParams(const GattConnectionParams &params) override;
+    bool getConnectionParams(GattConnectionParams &params) override;
+    const char *name() const override { return "NIMBLE"; }
+
+private:
+    static const uint8_t MAX_CHARACTERISTICS = 24;
+
+    NimBLEGattCharacteristicCallbacks *callbacksFor(GattHandle handle);
+
+    NimBLEServer *server;
+    NimBLEService *service; // Servicio en construcción
+    NimBLECharacteristic *characteristics[MAX_CHARACTERISTICS];
+    NimBLEGattCharacteristicCallbacks *callbacks[MAX_CHARACTERISTICS]; // Creados al añadir el primer callback
+    uint8_t characteristic_count;
+};
+
+#endif // GATT_BACKEND_NIMBLE
+
+#endif // NIMBLE_GATT_SERVER_H
@@ -0,0 +1,86 @@
+#ifndef SAMPLE_CODEC_H
+#define SAMPLE_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @file SampleCodec.h
+ * @brief Códec de compresión para secuencias de muestras (historial).
+ * @details Las muestras consecutivas cambian muy poco, así que cada campo se
+ * codifica como delta-de-delta respecto a las dos muestras anteriores, con
+ * codificación zigzag y varint. Las muestras se agrupan en bloques
+ * autocontenidos cuya primera muestra (keyframe) va en valor absoluto, lo que
+ * permite resincronizar el flujo al inicio de cualquier bloque.
+ *
+ * Formato de un bloque:
+ * | Tamaño | Campo                                          |
+ * |--------|------------------------------------------------|
+ * | 1      | Marca de inicio `CODEC_BLOCK_MAGIC`            |
+ * | 1      | Número de muestras del bloque                  |
+ * | 2      | Longitud del payload (little-endian)           |
+ * | N      | Payload: keyframe + deltas-de-delta (varints)  |
+ * | 1      | CRC-8 (polinomio 0x07) de todo lo anterior     |
+ *
+ * Este archivo no depende de Arduino para poder usarse también en el host.
+ */
+
+/**
+ * @enum SampleField
+ * @brief Campos de una muestra del historial, en punto fijo.
+ */
+enum SampleField
+{
+    FIELD_TEMPERATURE, // 0.01 °C
+    FIELD_HUMIDITY,    // 0.01 %
+    FIELD_PRESSURE,    // 0.1 hPa
+    FIELD_CO2,         // ppm
+    SAMPLE_FIELD_COUNT
+};
+
+/**
+ * @struct HistorySample
+ * @brief Una muestra del historial con todos sus campos en punto fijo.
+ */
+struct HistorySample
+{
+    int32_t fields[SAMPLE_FIELD_COUNT];
+};
+
+/** @brief Marca que identifica el inicio de un bloque. */
+static const uint8_t CODEC_BLOCK_MAGIC = 0xA5;
+/** @brief Tamaño de la cabecera de un bloque (marca, cuenta y longitud). */
+static const size_t CODEC_HEADER_SIZE = 4;
+/** @brief Número máximo de muestras por bloque (distancia entre keyframes). */
+static const uint8_t CODEC_MAX_BLOCK_SAMPLES = 32;
+/** @brief Capacidad máxima del payload de un bloque, en bytes. */
+static const size_t CODEC_MAX_PAYLOAD = 512;
+/** @brief Tamaño máximo de un bloque completo (cabecera + payload + CRC). */
+static const size_t CODEC_MAX_BLOCK_SIZE = CODEC_HEADER_SIZE + CODEC_MAX_PAYLOAD + 1;
+
+/**
+ * @class SampleBlockEncoder
+ * @brief Acumula muestras y las comprime en un bloque.
+ */
+class SampleBlockEncoder
+{
+public:
+    SampleBlockEncoder(); // Constructor
+    void reset();         // Empieza un bloque nuevo
+    bool append(const HistorySample &sample); // Añade una muestra; `false` si el bloque está lleno
+    bool isFull() const;
+    uint8_t count() const;
+    size_t finalize(uint8_t *out, size_t capacity) const; // Escribe el bloque completo
+
+private:
+    uint8_t payload[CODEC_MAX_PAYLOAD];
+    size_t payloadLen;
+    uint8_t sampleCount;
+    int64_t lastValue[SAMPLE_FIELD_COUNT];
+    int64_t lastDelta[SAMPLE_FIELD_COUNT];
+};
+
+size_t decodeSampleBlock(const uint8_t *data, size_t len, HistorySample *out, size_t maxSamples, size_t *count);
+size_t findSampleBlock(const uint8_t *data, size_t len);
+
+#endif // SAMPLE_CODEC_H
@@ -0,0 +1,34 @@
+#ifndef SENSOR_DATA_H
+#define SENSOR_DATA_H
+
+#include <stdint.h>
+
+/**
+ * @struct SensorData
+ * @brief Una estructura simple para contener todas las lecturas de los sensores.
+ * @details Un valor de -1 indica que la lectura falló o que la placa no tiene
+ * el sensor correspondiente.
+ *
+ * `monotonicUs` es el instante de la adquisición en el reloj monótono de
+ * 64 bits; `wallUs` es su hora de pared estimada (µs desde la época Unix), o
+ * -1 si el cliente aún no ha sincronizado la hora.
+ */
+struct SensorData
+{
+    float temperature;
+    float humidity;
+    float pressure;
+    int co2;
+    uint64_t monotonicUs;
+    int64_t wallUs;
+    // SensorState state;
+};
+
+enum SensorState
+{
+    PREHEATING,
+    READY,
+    CALIBRATING
+};
+
+#endif // SENSOR_DATA_H
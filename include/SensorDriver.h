@@ -0,0 +1,515 @@
+#ifndef SENSOR_DRIVER_H
+#define SENSOR_DRIVER_H
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <tuple>
+#include <type_traits>
+#include "SensorData.h"
+#include "TimeBase.h"
+
+/**
+ * @file SensorDriver.h
+ * @brief Interfaz estática (CRTP) de los drivers de sensores y su composición.
+ * @details Cada driver hereda de `SensorDriver<Driver>` e implementa:
+ * - `static const SensorKind KIND` y `static const unsigned long TIMEOUT_MS`
+ * - `static const uint32_t STUCK_TIMEOUT_MS`: tiempo con lecturas idénticas a
+ *   partir del cual el sensor se considera congelado (0 = sin detección)
+ * - `bool beginSensor()`: inicialización del hardware
+ * - `bool startSensor()`: inicia una medida (`false` si no se pudo)
+ * - `MeasurementStatus pollSensor()`: comprueba si la medida terminó
+ * - `bool readSensor(SensorData &)`: escribe los campos que le corresponden
+ *   (`false` si la respuesta no es válida)
+ * - `void invalidate(SensorData &)`: marca esos mismos campos como inválidos
+ * - `int32_t stuckKey(const SensorData &)`: resumen de sus campos para detectar valores congelados
+ * - `bool recoverSensor()`: reinicia el sensor (y su bus) tras un fallo
+ * - `void onTimeout()`: se llama si la medida supera `TIMEOUT_MS`
+ *
+ * Un driver cuyo timeout sea configurable puede ocultar `timeoutMs()`, que por
+ * defecto devuelve `TIMEOUT_MS`. Uno que a veces devuelve una lectura guardada
+ * en lugar de una conversión nueva (la librería DHT repite la última durante
+ * 2 s) puede ocultar `isFreshConversion()`, que por defecto devuelve `true`.
+ * Uno que avisa a la tarea al terminar la medida (el MH-Z19C, con una
+ * notificación al llegar la trama) oculta `notifiesCompletion()` para que
+ * `SensorSet` pueda dormir hasta el aviso en lugar de sondearlo.
+ *
+ * La base lleva el modelo de salud de cada sensor: cuenta los fallos seguidos,
+ * detecta valores congelados y, cuando el sensor entra en fallo, lo reinicia
+ * con espera exponencial entre intentos. Mientras espera no se intenta medir,
+ * así que un sensor colgado no añade su timeout a cada ciclo.
+ *
+ * Un sensor está congelado si su lectura no cambia durante `STUCK_TIMEOUT_MS`
+ * (medido con `monotonicMicros()`, independiente del periodo de muestreo) y
+ * además a lo largo de al menos `STUCK_MIN_CONVERSIONS` conversiones nuevas;
+ * las lecturas repetidas de una caché no cuentan. Una cámara estable puede
+ * mantener un valor exacto durante minutos, así que las ventanas son largas.
+ * Un sensor congelado sigue en fallo mientras su lectura no cambie.
+ *
+ * Todas las llamadas se resuelven en tiempo de compilación: no hay funciones
+ * virtuales ni memoria dinámica.
+ */
+
+/**
+ * @enum SensorKind
+ * @brief Tipo de sensor que implementa un driver, para poder localizarlo en un `SensorSet`.
+ */
+enum SensorKind
+{
+    SENSOR_TEMP_HUMIDITY,
+    SENSOR_PRESSURE,
+    SENSOR_CO2
+};
+
+/**
+ * @enum MeasurementStatus
+ * @brief Estado de la medida en curso de un driver.
+ */
+enum MeasurementStatus
+{
+    MEASUREMENT_PENDING,
+    MEASUREMENT_READY,
+    MEASUREMENT_FAILED
+};
+
+/**
+ * @class SensorDriver
+ * @brief Base CRTP con la lógica común a todos los drivers: estado y timeout de la
+ * medida y modelo de salud del sensor.
+ * @tparam Derived Driver concreto.
+ */
+template <typename Derived>
+class SensorDriver
+{
+public:
+    /**
+     * @brief Inicializa el sensor y su modelo de salud.
+     * @details Si el sensor no responde, queda en fallo y se reintentará con espera exponencial.
+     * @return bool `true` si el sensor respondió.
+     */
+    bool begin()
+    {
+        bool ok = derived().beginSensor();
+        if (!ok)
+        {
+            markFaulty("no responde al iniciar");
+        }
+        return ok;
+    }
+
+    /**
+     * @brief Inicia una medida sin esperar su resultado.
+     * @details Si el sensor está en fallo, solo se intenta medir cuando toca un
+     * reintento de recuperación, y solo si el ciclo aún no ha gastado el suyo.
+     * @param recoveryAllowed `true` si este ciclo todavía puede hacer una recuperación;
+     * se pone a `false` si este driver la consume.
+     */
+    void startMeasurement(bool &recoveryAllowed)
+    {
+        unsigned long now = millis();
+        if (faulty)
+        {
+            if (!recoveryAllowed || (long)(now - next_recovery_time) < 0)
+            {
+                collected = false;
+                status = MEASUREMENT_FAILED;
+                return;
+            }
+            recoveryAllowed = false;
+            attemptRecovery(now);
+        }
+        collected = false;
+        start_time = millis();
+        status = derived().startSensor() ? MEASUREMENT_PENDING : MEASUREMENT_FAILED;
+    }
+
+    /**
+     * @brief Comprueba el progreso de la medida en curso.
+     * @details Si la medida supera `timeoutMs()`, se da por fallida.
+     * @return MeasurementStatus El estado de la medida.
+     */
+    MeasurementStatus poll()
+    {
+        if (status == MEASUREMENT_PENDING)
+        {
+            status = derived().pollSensor();
+            if (status == MEASUREMENT_PENDING && millis() - start_time > derived().timeoutMs())
+            {
+                status = MEASUREMENT_FAILED;
+                derived().onTimeout();
+            }
+        }
+        return status;
+    }
+
+    /**
+     * @brief Escribe el resultado de la medida en `data`.
+     * @details Si la medida falló, los campos del driver quedan marcados como inválidos.
+     * @param data Estructura de lecturas a completar.
+     */
+    void read(SensorData &data)
+    {
+        bool ok = status == MEASUREMENT_READY && derived().readSensor(data);
+        if (ok && isFrozen(data))
+        {
+            ok = false;
+        }
+
+        last_read_ok = ok;
+        if (ok)
+        {
+            consecutive_failures = 0;
+            if (faulty)
+            {
+                faulty = false;
+                Serial.printf("Sensor %d recuperado.\n", (int)Derived::KIND);
+            }
+        }
+        else
+        {
+            derived().invalidate(data);
+            if (consecutive_failures < 255)
+            {
+                consecutive_failures++;
+            }
+            if (!faulty && consecutive_failures >= FAILURE_THRESHOLD)
+            {
+                markFaulty("fallos consecutivos");
+            }
+        }
+    }
+
+    /**
+     * @brief Lee el resultado en cuanto la medida termina, una sola vez por medida.
+     * @param data Estructura de lecturas a completar.
+     * @return bool `true` si la medida ya terminó (y su resultado está en `data`).
+     */
+    bool collect(SensorData &data)
+    {
+        if (collected)
+        {
+            return true;
+        }
+        if (poll() == MEASUREMENT_PENDING)
+        {
+            return false;
+        }
+        read(data);
+        collected = true;
+        return true;
+    }
+
+    /**
+     * @brief Tiempo máximo de una medida; los drivers pueden ocultarlo.
+     */
+    unsigned long timeoutMs() const
+    {
+        return Derived::TIMEOUT_MS;
+    }
+
+    /**
+     * @brief Indica si el driver notifica a la tarea al terminar la medida; los drivers pueden ocultarlo.
+     */
+    bool notifiesCompletion() const
+    {
+        return false;
+    }
+
+    /**
+     * @brief Tiempo que queda hasta el timeout de la medida en curso.
+     * @return unsigned long Milisegundos, 0 si ya se superó.
+     */
+    unsigned long remainingMs()
+    {
+        unsigned long elapsed = millis() - start_time;
+        unsigned long timeout = derived().timeoutMs();
+        return elapsed >= timeout ? 0 : timeout - elapsed;
+    }
+
+    /**
+     * @brief Indica si la última lectura viene de una conversión nueva; los drivers pueden ocultarlo.
+     */
+    bool isFreshConversion() const
+    {
+        return true;
+    }
+
+    /**
+     * @brief Indica si el sensor está en fallo.
+     */
+    bool isFaulty() const
+    {
+        return faulty;
+    }
+
+    /**
+     * @brief Indica si la última lectura fue válida.
+     */
+    bool lastReadValid() const
+    {
+        return last_read_ok;
+    }
+
+protected:
+    SensorDriver()
+        : status(MEASUREMENT_FAILED), collected(false), start_time(0), consecutive_failures(0), stuck_conversions(0),
+          last_key(0), stuck_since_us(0), frozen(false), faulty(false), last_read_ok(false),
+          backoff_ms(INITIAL_BACKOFF_MS), next_recovery_time(0) {}
+
+private:
+    static const uint8_t FAILURE_THRESHOLD = 3;           // Fallos seguidos para entrar en fallo
+    static const uint32_t INITIAL_BACKOFF_MS = 1000;      // Primera espera entre reintentos
+    static const uint32_t MAX_BACKOFF_MS = 60 * 1000UL;   // Espera máxima entre reintentos
+    static const uint16_t STUCK_MIN_CONVERSIONS = 10;     // Conversiones nuevas idénticas para un valor congelado
+
+    Derived &derived() { return static_cast<Derived &>(*this); }
+
+    /**
+     * @brief Pasa el sensor a fallo y programa un reintento inmediato.
+     * @param reason Motivo, para el registro por consola.
+     */
+    void markFaulty(const char *reason)
+    {
+        faulty = true;
+        backoff_ms = INITIAL_BACKOFF_MS;
+        next_recovery_time = millis();
+        Serial.printf("Sensor %d en fallo (%s).\n", (int)Derived::KIND, reason);
+    }
+
+    /**
+     * @brief Actualiza la detección de valores congelados con una lectura válida.
+     * @details El tiempo cuenta desde la primera lectura con el valor actual;
+     * solo las conversiones nuevas suman al mínimo de conversiones.
+     * @param data Lecturas recién escritas por el driver.
+     * @return bool `true` si el sensor está congelado y la lectura no debe usarse.
+     */
+    bool isFrozen(const SensorData &data)
+    {
+        if (Derived::STUCK_TIMEOUT_MS == 0)
+        {
+            return false;
+        }
+        int32_t key = derived().stuckKey(data);
+        uint64_t now = monotonicMicros();
+        if (stuck_conversions == 0 || key != last_key)
+        {
+            last_key = key;
+            stuck_since_us = now;
+            stuck_conversions = 0;
+            frozen = false;
+        }
+        if (derived().isFreshConversion() && stuck_conversions < 0xFFFF)
+        {
+            stuck_conversions++;
+        }
+        if (!frozen && stuck_conversions >= STUCK_MIN_CONVERSIONS &&
+            now - stuck_since_us >= (uint64_t)Derived::STUCK_TIMEOUT_MS * 1000ULL)
+        {
+            frozen = true;
+            markFaulty("valor congelado");
+        }
+        return frozen;
+    }
+
+    /**
+     * @brief Reinicia el sensor y programa el siguiente reintento.
+     * @details La espera se duplica en cada intento hasta `MAX_BACKOFF_MS`. El
+     * fallo solo se da por resuelto cuando llega una lectura válida.
+     * @param now Tiempo actual en milisegundos.
+     */
+    void attemptRecovery(unsigned long now)
+    {
+        Serial.printf("Intentando recuperar el sensor %d...\n", (int)Derived::KIND);
+        derived().recoverSensor();
+        next_recovery_time = now + backoff_ms;
+        backoff_ms = backoff_ms * 2 > MAX_BACKOFF_MS ? MAX_BACKOFF_MS : backoff_ms * 2;
+    }
+
+    MeasurementStatus status;          // Estado de la medida en curso
+    bool collected;                    // El resultado de la medida ya se leyó
+    unsigned long start_time;          // Inicio de la medida en curso
+    // -- Modelo de salud --
+    uint8_t consecutive_failures;      // Lecturas fallidas seguidas
+    uint16_t stuck_conversions;        // Conversiones nuevas con el valor actual
+    int32_t last_key;                  // Resumen de la última lectura válida
+    uint64_t stuck_since_us;           // Primera lectura con el valor actual (`monotonicMicros()`)
+    bool frozen;                       // Valor congelado; sigue en fallo hasta que cambie
+    bool faulty;                       // El sensor está en fallo
+    bool last_read_ok;                 // La última lectura fue válida
+    uint32_t backoff_ms;               // Espera hasta el siguiente reintento
+    unsigned long next_recovery_time;  // Momento del siguiente reintento
+};
+
+/**
+ * @class SensorSet
+ * @brief Lista de drivers fijada en tiempo de compilación.
+ * @details Los drivers se guardan por valor en una tupla y se recorren con
+ * expresiones de plegado, sin indirecciones.
+ * @tparam Drivers Drivers que componen la placa.
+ */
+template <typename... Drivers>
+class SensorSet
+{
+public:
+    /**
+     * @brief Inicializa todos los drivers.
+     */
+    void begin()
+    {
+        std::apply([](auto &...driver) { (driver.begin(), ...); }, drivers);
+    }
+
+    /**
+     * @brief Adquiere una muestra completa de todos los drivers.
+     * @details Primero se inician todas las medidas y después se recoge cada
+     * resultado en cuanto está listo, así que las esperas de los sensores se
+     * solapan y el ciclo dura lo que el más lento, no la suma. Mientras
+     * quede alguna medida que solo se puede sondear (DHT22, BMP280), la tarea
+     * espera un tick entre comprobaciones; cuando solo faltan medidas que
+     * notifican (la trama del MH-Z19C), duerme en su notificación hasta el
+     * aviso o hasta el timeout más próximo. Los campos sin driver en esta
+     * placa quedan en -1.
+     * @param data Estructura de lecturas a completar.
+     */
+    void acquire(SensorData &data)
+    {
+        unsigned long start = micros();
+        data = {-1.0f, -1.0f, -1.0f, -1, 0, -1};
+        // Como mucho una recuperación por ciclo, para acotar el tiempo del bucle.
+        bool recoveryAllowed = true;
+        std::apply([&](auto &...driver) { (driver.startMeasurement(recoveryAllowed), ...); }, drivers);
+        bool done;
+        do
+        {
+            done = true;
+            bool polling = false;           // Alguna medida pendiente necesita sondeo
+            unsigned long waitMs = ~0UL;    // Timeout más próximo de las que notifican
+            std::apply([&](auto &...driver) { (collectOne(driver, data, done, polling, waitMs), ...); }, drivers);
+#if !defined(NODE_SIMULATION)
+            if (!done)
+            {
+                // Sondeo: un tick. Solo notificaciones: hasta el aviso o el timeout (+1 tick para superarlo).
+                ulTaskNotifyTake(pdTRUE, polling ? 1 : pdMS_TO_TICKS(waitMs) + 1);
+            }
+#else
+            (void)polling;
+#endif
+        } while (!done);
+        last_acquire_us = micros() - start;
+    }
+
+    /**
+     * @brief Duración del último ciclo de adquisición, en microsegundos.
+     */
+    unsigned long lastAcquireMicros() const
+    {
+        return last_acquire_us;
+    }
+
+    /**
+     * @brief Obtiene el estado de salud de todos los drivers.
+     * @return uint8_t Máscara con el bit `1 << KIND` activo para cada sensor en fallo.
+     */
+    uint8_t faultMask()
+    {
+        uint8_t mask = 0;
+        std::apply([&mask](auto &...driver) { ((mask |= driver.isFaulty() ? (1 << driver.KIND) : 0), ...); }, drivers);
+        return mask;
+    }
+
+    /**
+     * @brief Indica si la última muestra fue válida en todos los drivers.
+     */
+    bool allValid()
+    {
+        return std::apply([](auto &...driver) { return (driver.lastReadValid() && ...); }, drivers);
+    }
+
+    /**
+     * @brief Indica si la placa tiene un driver del tipo indicado.
+     * @tparam Kind Tipo de sensor buscado.
+     */
+    template <SensorKind Kind>
+    static constexpr bool contains()
+    {
+        return indexOf<Kind>() < sizeof...(Drivers);
+    }
+
+    /**
+     * @brief Obtiene el driver del tipo indicado.
+     * @details Solo debe usarse si `contains<Kind>()` es `true`.
+     * @tparam Kind Tipo de sensor buscado.
+     */
+    template <SensorKind Kind>
+    auto &get()
+    {
+        return std::get<indexOf<Kind>()>(drivers);
+    }
+
+    /**
+     * @brief Llama a `fn` con el driver del tipo indicado, si la placa lo tiene.
+     * @details Permite usar un driver concreto desde código que no es plantilla
+     * sin romper la compilación en placas que no lo incluyen.
+     * @tparam Kind Tipo de sensor buscado.
+     * @param fn Función (normalmente una lambda genérica) que recibe el driver.
+     */
+    template <SensorKind Kind, typename Function>
+    void with(Function fn)
+    {
+        if constexpr (contains<Kind>())
+        {
+            fn(get<Kind>());
+        }
+    }
+
+private:
+    /**
+     * @brief Recoge el resultado de un driver y anota cómo esperar si sigue pendiente.
+     * @param driver Driver a comprobar.
+     * @param data Estructura de lecturas a completar.
+     * @param done Se pone a `false` si la medida sigue pendiente.
+     * @param polling Se pone a `true` si la medida pendiente necesita sondeo.
+     * @param waitMs Se reduce al tiempo hasta su timeout si la medida notifica.
+     */
+    template <typename Driver>
+    static void collectOne(Driver &driver, SensorData &data, bool &done, bool &polling, unsigned long &waitMs)
+    {
+        if (driver.collect(data))
+        {
+            return;
+        }
+        done = false;
+        if (!driver.notifiesCompletion())
+        {
+            polling = true;
+        }
+        else if (driver.remainingMs() < waitMs)
+        {
+            waitMs = driver.remainingMs();
+        }
+    }
+
+    /**
+     * @brief Posición del primer driver del tipo indicado, o el número de drivers si no hay ninguno.
+     */
+    template <SensorKind Kind, size_t I = 0>
+    static constexpr size_t indexOf()
+    {
+        if constexpr (I == sizeof...(Drivers))
+        {
+            return I;
+        }
+        else if constexpr (std::tuple_element_t<I, std::tuple<Drivers...>>::KIND == Kind)
+        {
+            return I;
+        }
+        else
+        {
+            return indexOf<Kind, I + 1>();
+        }
+    }
+
+    std::tuple<Drivers...> drivers;
+    unsigned long last_acquire_us = 0; // Duración del último ciclo de adquisición
+};
+
+#endif // SENSOR_DRIVER_H
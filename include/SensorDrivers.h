@@ -0,0 +1,400 @@
+#ifndef SENSOR_DRIVERS_H
+#define SENSOR_DRIVERS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_BMP280.h>
+#include <DHT.h>
+#include "SensorDriver.h"
+#include "Mhz19Link.h"
+
+/**
+ * @file SensorDrivers.h
+ * @brief Drivers de los sensores soportados (DHT22, BMP280 y MH-Z19C).
+ * @details Los pines y direcciones son parámetros de plantilla, así que cada
+ * variante de placa instancia los drivers con su propio cableado (ver BoardConfig.h).
+ */
+
+/**
+ * @brief Libera un bus I2C bloqueado por un esclavo que mantiene SDA en bajo.
+ * @details Genera hasta 9 pulsos de reloj para que el esclavo termine el byte
+ * que estaba enviando, seguidos de una condición de STOP, y reinicia Wire.
+ * Tarda menos de 0.2 ms.
+ */
+inline void recoverI2CBus()
+{
+    Wire.end();
+    pinMode(SDA, INPUT_PULLUP);
+    pinMode(SCL, OUTPUT_OPEN_DRAIN);
+    digitalWrite(SCL, HIGH);
+    for (int i = 0; i < 9 && digitalRead(SDA) == LOW; i++)
+    {
+        digitalWrite(SCL, LOW);
+        delayMicroseconds(5);
+        digitalWrite(SCL, HIGH);
+        delayMicroseconds(5);
+    }
+    // Condición de STOP: SDA sube mientras SCL está en alto.
+    pinMode(SDA, OUTPUT_OPEN_DRAIN);
+    digitalWrite(SDA, LOW);
+    delayMicroseconds(5);
+    digitalWrite(SDA, HIGH);
+    delayMicroseconds(5);
+    Wire.begin();
+}
+
+/**
+ * @class Dht22Driver
+ * @brief Driver del sensor de temperatura y humedad DHT22.
+ * @details La librería DHT realiza la transacción completa al leer (~5 ms, con
+ * las interrupciones desactivadas), así que la medida está lista en cuanto se
+ * inicia. En un `SensorSet` esa transacción se hace mientras el BMP280 convierte
+ * y el MH-Z19C prepara su respuesta.
+ *
+ * La librería no repite la transacción si la anterior fue hace menos de 2 s y
+ * devuelve la lectura guardada; el driver lleva la misma cuenta para que esas
+ * repeticiones no sumen a la detección de valores congelados.
+ * @tparam Pin Pin de datos del sensor.
+ */
+template <uint8_t Pin>
+class Dht22Driver : public SensorDriver<Dht22Driver<Pin>>
+{
+public:
+    static const SensorKind KIND = SENSOR_TEMP_HUMIDITY;
+    static const unsigned long TIMEOUT_MS = 50;
+    static const uint32_t STUCK_TIMEOUT_MS = 30 * 60 * 1000UL; // 30 minutos sin cambiar ni 0.1 °C ni 0.1 %HR
+
+    Dht22Driver() : dht(Pin, DHT22), last_conversion_ms(0), fresh(false) {}
+
+    bool beginSensor()
+    {
+        dht.begin();
+        last_conversion_ms = millis() - LIBRARY_MIN_INTERVAL_MS;
+        return true;
+    }
+
+    bool startSensor() { return true; }
+
+    MeasurementStatus pollSensor() { return MEASUREMENT_READY; }
+
+    bool readSensor(SensorData &data)
+    {
+        // Misma regla que la librería: dentro del intervalo mínimo repite la última lectura.
+        unsigned long now = millis();
+        fresh = now - last_conversion_ms >= LIBRARY_MIN_INTERVAL_MS;
+        if (fresh)
+        {
+            last_conversion_ms = now;
+        }
+        data.humidity = dht.readHumidity();
+        data.temperature = dht.readTemperature();
+        // Comprueba si la lectura del DHT22 fue exitosa.
+        if (isnan(data.humidity) || isnan(data.temperature))
+        {
+            Serial.println(F("Error al leer del sensor DHT!"));
+            return false;
+        }
+        return true;
+    }
+
+    void invalidate(SensorData &data)
+    {
+        data.humidity = -1.0;
+        data.temperature = -1.0;
+    }
+
+    int32_t stuckKey(const SensorData &data)
+    {
+        return (int32_t)(data.temperature * 10.0f) * 1000 + (int32_t)(data.humidity * 10.0f);
+    }
+
+    bool isFreshConversion() const { return fresh; }
+
+    bool recoverSensor()
+    {
+        // Vuelve a configurar el pin de datos y reinicia la temporización de la librería.
+        dht.begin();
+        last_conversion_ms = millis() - LIBRARY_MIN_INTERVAL_MS;
+        return true;
+    }
+
+    void onTimeout() {}
+
+private:
+    static const unsigned long LIBRARY_MIN_INTERVAL_MS = 2000; // Intervalo mínimo entre transacciones de la librería
+
+    DHT dht;
+    unsigned long last_conversion_ms; // Última transacción real de la librería
+    bool fresh;                       // La última lectura fue una transacción nueva
+};
+
+/**
+ * @class Bmp280Driver
+ * @brief Driver del sensor de presión BMP280.
+ * @details Trabaja en modo forzado: cada inicio de medida dispara una
+ * conversión y el resultado se lee cuando el sensor la termina, así que la
+ * presión corresponde al instante de la muestra y la conversión se solapa
+ * con los demás sensores.
+ *
+ * Si el sensor no responde, cada inicio de medida falla hasta que la
+ * recuperación (liberación del bus I2C y reinicio) consigue reconectarlo.
+ * Antes de `begin()` se puede elegir otra dirección o un BME280 (compatible en
+ * presión) con `selectDevice()`, según lo que encuentre el inventario I2C.
+ * @tparam Address Dirección I2C por defecto del sensor.
+ */
+template <uint8_t Address>
+class Bmp280Driver : public SensorDriver<Bmp280Driver<Address>>
+{
+public:
+    static const SensorKind KIND = SENSOR_PRESSURE;
+    static const unsigned long TIMEOUT_MS = 60; // Conversión máxima de ~43 ms con el muestreo elegido
+    static const uint32_t STUCK_TIMEOUT_MS = 30 * 60 * 1000UL; // 30 minutos con la presión idéntica al Pa
+
+    Bmp280Driver() : address(Address), chip_id(BMP280_CHIP_ID), initialized(false), conversion_start(0) {}
+
+    /**
+     * @brief Elige la dirección y el chip que se usarán al conectar.
+     * @param deviceAddress Dirección I2C del sensor.
+     * @param chipId Valor del registro de ID (0x58 para BMP280, 0x60 para BME280).
+     */
+    void selectDevice(uint8_t deviceAddress, uint8_t chipId)
+    {
+        address = deviceAddress;
+        chip_id = chipId;
+    }
+
+    bool beginSensor()
+    {
+        if (connect())
+        {
+            Serial.println(F("Sensor BMP280 encontrado e inicializado."));
+        }
+        else
+        {
+            Serial.println(F("ADVERTENCIA: No se pudo encontrar un sensor BMP280 válido. Se reintentará periódicamente."));
+            Serial.print("Sensor ID: 0x");
+            Serial.println(bmp.sensorID(), HEX);
+        }
+        return initialized;
+    }
+
+    bool startSensor()
+    {
+        if (!initialized)
+        {
+            return false;
+        }
+        applySampling(); // Escribir el modo forzado dispara la conversión
+        conversion_start = millis();
+        return true;
+    }
+
+    MeasurementStatus pollSensor()
+    {
+        // No se consulta el bus antes del tiempo típico de conversión.
+        if (millis() - conversion_start < CONVERSION_MIN_MS)
+        {
+            return MEASUREMENT_PENDING;
+        }
+        return (bmp.getStatus() & STATUS_MEASURING) ? MEASUREMENT_PENDING : MEASUREMENT_READY;
+    }
+
+    bool readSensor(SensorData &data)
+    {
+        data.pressure = bmp.readPressure() / 100.0F; // Convierte de Pa a hPa
+        // Con el bus caído la librería devuelve NaN o valores fuera de rango.
+        return !isnan(data.pressure) && data.pressure > 300.0F && data.pressure < 1100.0F;
+    }
+
+    void invalidate(SensorData &data)
+    {
+        data.pressure = -1.0;
+    }
+
+    int32_t stuckKey(const SensorData &data)
+    {
+        return (int32_t)(data.pressure * 100.0f);
+    }
+
+    bool recoverSensor()
+    {
+        // Un BMP280 que se reinicia a mitad de una transacción puede dejar SDA en bajo.
+        recoverI2CBus();
+        if (connect())
+        {
+            Serial.println("¡BMP280 reconectado exitosamente!");
+        }
+        return initialized;
+    }
+
+    void onTimeout() {}
+
+private:
+
+    /**
+     * @brief Inicializa el sensor y aplica la configuración de muestreo y filtrado.
+     * @return bool `true` si el sensor respondió.
+     */
+    bool connect()
+    {
+        initialized = bmp.begin(address, chip_id);
+        return initialized;
+    }
+
+    /**
+     * @brief Escribe la configuración de muestreo y filtrado en modo forzado.
+     * @details En modo forzado el sensor hace una conversión y vuelve a reposo.
+     */
+    void applySampling()
+    {
+        bmp.setSampling(Adafruit_BMP280::MODE_FORCED,
+                        Adafruit_BMP280::SAMPLING_X2,
+                        Adafruit_BMP280::SAMPLING_X16,
+                        Adafruit_BMP280::FILTER_X16,
+                        Adafruit_BMP280::STANDBY_MS_500);
+    }
+
+    static const uint8_t BMP280_CHIP_ID = 0x58;
+    static const uint8_t STATUS_MEASURING = 0x08;       // Bit `measuring` del registro de estado
+    static const unsigned long CONVERSION_MIN_MS = 38;  // Conversión típica con X2/X16 (hoja de datos)
+
+    Adafruit_BMP280 bmp;
+    uint8_t address;  // Dirección I2C en uso
+    uint8_t chip_id;  // ID de chip que la librería espera encontrar
+    bool initialized; // Flag para saber si el BMP280 está funcionando
+    unsigned long conversion_start; // Inicio de la conversión en curso
+};
+
+/**
+ * @class MhZ19cDriver
+ * @brief Driver del sensor de CO2 MH-Z19C por UART (Serial2).
+ * @details Gestiona también el precalentamiento del sensor (1 minuto por defecto).
+ * Las tramas pasan por un `Mhz19Link`, que comparte con la calibración por UART.
+ * @tparam RxPin Pin RX del ESP32 conectado al TX del sensor.
+ * @tparam TxPin Pin TX del ESP32 conectado al RX del sensor.
+ */
+template <int RxPin, int TxPin>
+class MhZ19cDriver : public SensorDriver<MhZ19cDriver<RxPin, TxPin>>
+{
+public:
+    static const SensorKind KIND = SENSOR_CO2;
+    static const unsigned long TIMEOUT_MS = 150;
+    static const uint32_t STUCK_TIMEOUT_MS = 30 * 60 * 1000UL; // 30 minutos con exactamente el mismo ppm
+
+    MhZ19cDriver()
+        : link(Serial2, 2), state(PREHEATING), preheat_start_time(0), timeout_ms(TIMEOUT_MS), preheat_ms(PREHEAT_TIME_MS) {}
+
+    /**
+     * @brief Ajusta los tiempos del sensor según la configuración.
+     * @param timeoutMs Espera máxima de la respuesta a una lectura.
+     * @param preheatMs Duración del precalentamiento.
+     */
+    void configure(unsigned long timeoutMs, unsigned long preheatMs)
+    {
+        timeout_ms = timeoutMs;
+        preheat_ms = preheatMs;
+    }
+
+    unsigned long timeoutMs() const { return timeout_ms; }
+
+    bool notifiesCompletion() const { return true; } // Mhz19Link notifica al llegar la trama
+
+    bool beginSensor()
+    {
+        // Inicia comunicación UART en el puerto Serial2.
+        link.begin(RxPin, TxPin);
+
+        // Envía el comando para desactivar la calibración automática del sensor.
+        Serial.println("Desactivando autocalibración del sensor de CO2...");
+        link.sendCommand(Mhz19Link::CMD_SET_ABC, 0x00);
+
+        // Inicia el temporizador de precalentamiento.
+        preheat_start_time = millis();
+        Serial.printf("Iniciado precalentamiento de %lu s para el sensor de CO2.\n", preheat_ms / 1000);
+        return true;
+    }
+
+    bool startSensor()
+    {
+        // Comprueba si el tiempo de precalentamiento ha finalizado.
+        if (state == PREHEATING && millis() - preheat_start_time > preheat_ms)
+        {
+            Serial.println("Precalentamiento del sensor de CO2 completado. El sensor está listo (READY).");
+            state = READY;
+        }
+
+        // Solicita la lectura de CO2.
+        link.startRead();
+        return true;
+    }
+
+    MeasurementStatus pollSensor()
+    {
+        return link.isResponseReady() ? MEASUREMENT_READY : MEASUREMENT_PENDING;
+    }
+
+    bool readSensor(SensorData &data)
+    {
+        byte response[Mhz19Link::FRAME_SIZE];
+
+        // Valida y procesa la respuesta.
+        if (link.readResponse(response))
+        {
+            // El valor de CO2 se forma con 2 bytes (High y Low).
+            data.co2 = (response[2] << 8) | response[3];
+            return true;
+        }
+        Serial.println("Respuesta inválida del sensor de CO2.");
+        return false;
+    }
+
+    void invalidate(SensorData &data)
+    {
+        data.co2 = -1;
+    }
+
+    int32_t stuckKey(const SensorData &data)
+    {
+        return data.co2;
+    }
+
+    bool recoverSensor()
+    {
+        // Reabre el UART y descarta cualquier resto de trama desincronizada.
+        link.reopen();
+        return true;
+    }
+
+    void onTimeout()
+    {
+        link.abortRead();
+        Serial.println("Timeout esperando respuesta del sensor de CO2.");
+    }
+
+    /**
+     * @brief Obtiene el estado del sensor (`PREHEATING` o `READY`).
+     */
+    SensorState getState()
+    {
+        return state;
+    }
+
+    /**
+     * @brief Obtiene el transporte de tramas, para enviar comandos de calibración.
+     */
+    Mhz19Link &getLink()
+    {
+        return link;
+    }
+
+private:
+    static const unsigned long PREHEAT_TIME_MS = 60 * 1000UL; // 1 minuto, por defecto
+
+    Mhz19Link link;                   // Transporte compartido con la calibración por UART
+    SensorState state;                // Estado actual del sensor de CO2
+    unsigned long preheat_start_time; // Tiempo de inicio del precalentamiento
+    unsigned long timeout_ms;         // Espera máxima de la respuesta
+    unsigned long preheat_ms;         // Duración del precalentamiento
+};
+
+#endif // SENSOR_DRIVERS_H
@@ -1,67 +1,75 @@
 #ifndef SENSOR_MANAGER_H
 #define SENSOR_MANAGER_H
 
+#include "SensorData.h"
+#include "BoardConfig.h"
+#include "FanController.h"
+#include "I2CInventory.h"
+#include "ConfigStore.h"
+#include "TimedOutput.h"
+
 /**
- * @struct SensorData
- * @brief Una estructura simple para contener todas las lecturas de los sensores.
+ * @enum FanTarget
+ * @brief Magnitud que regula el control automático del ventilador.
  */
-struct SensorData
-{
-    float temperature;
-    float humidity;
-    float pressure;
-    int co2;
-    // SensorState state;
-};
-
-enum SensorState
+enum FanTarget
 {
-    PREHEATING,
-    READY,
-    CALIBRATING
+    FAN_TARGET_TEMPERATURE, // Consigna en 0.01 °C
+    FAN_TARGET_CO2          // Consigna en ppm
 };
 
-#endif // SENSOR_MANAGER_H
-
-// (Asegurarse de que esté entre el #define y el #endif)
-#include <Adafruit_BMP280.h>
-#include <DHT.h>
-
 /**
  * @class SensorManager
- * @brief Gestiona la inicialización y lectura de todos los sensores del PCB1.
+ * @brief Gestiona la inicialización y lectura de todos los sensores de la placa.
+ * @details El conjunto de drivers lo decide la variante de placa en tiempo de
+ * compilación (ver BoardConfig.h); esta clase solo los coordina y gestiona el
+ * ventilador.
  */
 class SensorManager
 {
 public:
     SensorManager(); // Constructor
-    void init();
+    void init(const I2CInventory &inventory); // Elige los dispositivos I2C según el inventario
+    void applyConfig(const DeviceConfig &config); // Aplica los tiempos de los drivers y el modo del ventilador
     SensorData readAllSensors(); // Lee todos los sensores y devuelve sus datos
     SensorState getState();      // Para obtener el estado del sensor de CO2
+    uint8_t getFaultMask();      // Sensores en fallo (bit `1 << SensorKind`)
+    bool isSampleValid();        // Si la última muestra fue válida en todos los sensores
+    unsigned long getAcquireMicros(); // Duración del último ciclo de adquisición
     bool getFanState();          // Para saber si el ventilador está encendido
-    void setFanState(bool on);   // Para controlar el ventilador
+    void setFanState(bool on);   // Control manual: encendido al 100 % o apagado
+    void setFanDuty(uint16_t duty); // Control manual con un duty concreto
+    void setFanAuto();           // Devuelve el ventilador al control automático
+    bool handleFanCommand(const String &cmd); // Procesa un comando recibido por BLE
+    void updateFanControl(const SensorData &data); // Ejecuta un paso del lazo PI
+    String getFanStatus();       // Estado legible, ej. "AUTO 45%"
+    Mhz19Link *getCo2Link();     // Transporte del MH-Z19C, o `nullptr` si la placa no lo tiene
+    TimedOutput &getFanOutput() { return fan_output; } // Para el registro de flancos
 
 private:
     // --- Métodos Privados ---
-    int readCO2(); // Función de ayuda interna para leer el sensor de CO2
+    void applyFanDuty(uint16_t duty); // Escribe el duty en el canal PWM
+    static void writeFanDuty(void *context, uint16_t duty); // Escritura de `fan_output`
 
     // --- Pines y Definiciones ---
     static const int FAN_PIN = 26; // Pin para el ventilador del sensor de CO2
-    static const int DHT_PIN = 25;
-    static const int HD_PIN = 12;
-    static const int RXD2_PIN = 16;
-    static const int TXD2_PIN = 17;
 
-    // --- Objetos de Sensores ---
-    DHT dht;
-    Adafruit_BMP280 bmp;
+    // --- PWM del ventilador (LEDC) ---
+    static const int FAN_PWM_CHANNEL = 0;
+    static const int FAN_PWM_FREQ_HZ = 25000; // Fuera del rango audible
+    static const int FAN_PWM_RESOLUTION = 10; // Duty de 0 a FAN_DUTY_MAX
+
+    // --- Drivers de Sensores ---
+    BoardSensors sensors; // Conjunto de drivers elegido por la variante de placa
 
     // --- Variables de estado ---
-    // -- BMP280 --
-    bool bmp_initialized;                     // Flag para saber si el BMP280 está funcionando
-    unsigned long last_bmp_reconnect_attempt; // Temporizador para reintentos
-    // -- MH-Z19C --
-    SensorState state;                // Estado actual del sensor de CO2
-    unsigned long preheat_start_time; // Tiempo de inicio del precalentamiento
-    bool fan_state;                   // Estado actual del ventilador
-};
\ No newline at end of file
+    SensorState state; // Último estado conocido del sensor de CO2
+    // -- Ventilador --
+    FanController fanController;      // Lazo PI del modo automático
+    bool fan_auto;                    // `true` si el duty lo decide el controlador
+    bool fan_auto_after_preheat;      // FAN_MODE=1: control automático al terminar el precalentamiento
+    TimedOutput fan_output;           // Canal PWM; el fin del arranque lo da un temporizador
+    unsigned long last_fan_update;    // Momento del último paso del controlador
+};
+
+#endif // SENSOR_MANAGER_H
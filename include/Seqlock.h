@@ -0,0 +1,119 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+/**
+ * @file Seqlock.h
+ * @brief Registro compartido entre tareas con un seqlock (un escritor, varios lectores).
+ * @details El escritor nunca espera: incrementa el número de secuencia (impar
+ * mientras escribe), copia el registro y lo vuelve a incrementar. El lector
+ * copia el registro y lo acepta solo si la secuencia era par y no cambió
+ * durante la copia, así que nunca ve un registro a medias.
+ *
+ * El registro se guarda en palabras atómicas de 32 bits con acceso relajado,
+ * de modo que la copia concurrente no es una carrera de datos; el orden lo
+ * dan las barreras alrededor de la secuencia.
+ *
+ * El lector no bloquea al escritor, pero si lo adelanta a mitad de escritura
+ * (misma CPU, mayor prioridad) nunca vería terminar la escritura: por eso
+ * `read()` hace un número limitado de intentos y el llamador decide qué hacer
+ * si fallan (normalmente, devolver el último valor que leyó).
+ *
+ * No depende de Arduino para poder probarlo en el host con varios hilos.
+ */
+
+/**
+ * @class Seqlock
+ * @brief Último valor de un registro `T`, publicado sin bloqueos.
+ * @tparam T Tipo trivialmente copiable con tamaño múltiplo de 4 bytes.
+ */
+template <typename T>
+class Seqlock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock requiere un tipo trivialmente copiable");
+    static_assert(sizeof(T) % sizeof(uint32_t) == 0, "El tamaño del registro debe ser múltiplo de 4 bytes");
+
+public:
+    /** @brief Intentos de lectura por defecto antes de rendirse. */
+    static const uint8_t DEFAULT_ATTEMPTS = 16;
+
+    /**
+     * @brief Constructor: el registro empieza a ceros, con secuencia 0.
+     */
+    Seqlock() : sequence(0)
+    {
+        for (size_t i = 0; i < WORDS; i++)
+        {
+            words[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Publica un valor nuevo. Solo puede haber un escritor.
+     * @param value Valor a publicar.
+     */
+    void write(const T &value)
+    {
+        uint32_t buffer[WORDS];
+        memcpy(buffer, &value, sizeof(T));
+
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++)
+        {
+            words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copia el último valor publicado.
+     * @param value Destino; solo se modifica si la lectura tiene éxito.
+     * @param attempts Intentos antes de rendirse si el escritor está a mitad.
+     * @return bool `false` si ningún intento obtuvo una copia coherente.
+     */
+    bool read(T &value, uint8_t attempts = DEFAULT_ATTEMPTS) const
+    {
+        uint32_t buffer[WORDS];
+        for (uint8_t attempt = 0; attempt < attempts; attempt++)
+        {
+            uint32_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1)
+            {
+                continue; // Escritura en curso
+            }
+            for (size_t i = 0; i < WORDS; i++)
+            {
+                buffer[i] = words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before)
+            {
+                memcpy(&value, buffer, sizeof(T));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Número de escrituras completadas.
+     */
+    uint32_t getWriteCount() const
+    {
+        return sequence.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    static const size_t WORDS = sizeof(T) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint32_t> words[WORDS];
+};
+
+#endif // SEQLOCK_H
@@ -0,0 +1,133 @@
+#ifndef TIME_BASE_H
+#define TIME_BASE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @file TimeBase.h
+ * @brief Reloj monótono de 64 bits y sincronización con la hora de pared del cliente.
+ * @details `millis()` es de 32 bits y da la vuelta a los 49.7 días; las marcas
+ * de tiempo de las muestras usan en su lugar `monotonicMicros()`, que no da la
+ * vuelta en la práctica (2^64 µs).
+ *
+ * El cliente escribe su hora de pared en la característica de sincronización;
+ * `ClockSync` guarda los últimos pares (instante local, hora de pared) y ajusta
+ * una recta por mínimos cuadrados, de modo que estima a la vez el desfase y
+ * la deriva del oscilador.
+ *
+ * Las clases no dependen de Arduino para poder probar en el host la deriva y
+ * la vuelta del contador con un oscilador simulado.
+ */
+
+/**
+ * @brief Microsegundos desde el arranque, monótonos y de 64 bits.
+ * @details En el ESP32 es `esp_timer_get_time()`. En la simulación se extiende
+ * `micros()` (32 bits, da la vuelta cada 71.6 min) con `CounterExtender`.
+ * Fuera de Arduino es un reloj virtual que fija el programa de pruebas.
+ */
+uint64_t monotonicMicros();
+#ifndef ARDUINO
+void setMonotonicMicros(uint64_t us); // Reloj virtual en el host
+#endif
+
+/**
+ * @class CounterExtender
+ * @brief Extiende un contador de 32 bits que da la vuelta a uno de 64 bits.
+ * @details Debe consultarse al menos una vez por vuelta del contador.
+ */
+class CounterExtender
+{
+public:
+    CounterExtender(); // Constructor
+    uint64_t extend(uint32_t raw);
+
+private:
+    uint32_t last_raw;
+    uint32_t wraps; // Vueltas completas del contador
+};
+
+/**
+ * @class ClockSync
+ * @brief Estima la hora de pared a partir del reloj monótono y de puntos de sincronización.
+ * @details La recta se ajusta sobre los últimos `MAX_POINTS` puntos, con las
+ * coordenadas relativas al punto más reciente para no perder precisión. La
+ * pendiente (deriva) solo se estima cuando los puntos abarcan al menos
+ * `MIN_DRIFT_SPAN_US`: con puntos muy juntos la latencia de la escritura BLE
+ * dominaría la estimación. Si un punto se aleja más de `STEP_THRESHOLD_US` de
+ * la predicción, se entiende que el reloj del cliente saltó y se empieza de cero.
+ */
+class ClockSync
+{
+public:
+    // --- Métodos Públicos ---
+    ClockSync(); // Constructor
+    bool addPoint(uint64_t localUs, int64_t wallUs); // `false` si el punto reinició el ajuste
+    bool isSynced() const { return count > 0; }
+    int64_t toWallUs(uint64_t localUs) const; // -1 si aún no hay sincronización
+    float getDriftPpm() const;                 // Deriva estimada del oscilador local
+    int64_t getLastErrorUs() const { return last_error_us; }
+    uint8_t getPointCount() const { return count; }
+    size_t describe(char *out, size_t len) const; // "POINTS=3;DRIFT=+12.5ppm;ERR=-4ms"
+
+    // --- Constantes ---
+    static const uint8_t MAX_POINTS = 8;
+    static const int64_t STEP_THRESHOLD_US = 2000000;      // Salto del reloj del cliente
+    static const uint64_t MIN_DRIFT_SPAN_US = 60000000ULL; // Separación mínima para estimar la deriva
+    static constexpr double MAX_DRIFT = 500e-6;            // Deriva máxima aceptada (500 ppm)
+
+private:
+    // --- Métodos Privados ---
+    void fit();
+
+    // --- Variables de Estado ---
+    uint64_t local_us[MAX_POINTS]; // Puntos de sincronización (búfer circular)
+    int64_t wall_us[MAX_POINTS];
+    uint8_t head;  // Posición del próximo punto
+    uint8_t count; // Puntos válidos
+    // -- Recta ajustada: wall = fit_wall_us + slope * (local - ref_local_us) --
+    uint64_t ref_local_us;
+    int64_t fit_wall_us;
+    double slope;
+    int64_t last_error_us; // Error de la predicción en el último punto, antes de añadirlo
+};
+
+/**
+ * @class SampleScheduler
+ * @brief Decide cuándo tomar cada muestra, alineada a una rejilla de la hora de pared.
+ * @details Con la hora sincronizada, las muestras se toman en los múltiplos
+ * del periodo contados desde la época Unix, así que todos los nodos
+ * sincronizados con el mismo cliente o pasarela muestrean a la vez y sus
+ * lecturas se pueden comparar sin interpolar. La deriva ya la corrige
+ * `ClockSync`, de modo que el error de fase no crece entre sincronizaciones.
+ *
+ * Sin sincronizar, el periodo se cuenta desde la muestra anterior con el
+ * reloj local. Si se pierde algún instante de la rejilla (calibración en
+ * curso), se salta al siguiente en vez de tomar varias muestras seguidas; si
+ * la hora retrocede más de un periodo, la rejilla se vuelve a fijar.
+ */
+class SampleScheduler
+{
+public:
+    // --- Métodos Públicos ---
+    SampleScheduler(); // Constructor
+    void setPeriodUs(uint64_t periodUs);                  // Reinicia la rejilla si el periodo cambia
+    void resetGrid();                                     // Tras un salto de la hora del cliente
+    bool poll(uint64_t nowUs, const ClockSync &sync);     // `true` cuando toca tomar la muestra
+    void recordSample(int64_t wallUs);                    // Hora de pared de la muestra tomada
+    bool hasPhaseError() const { return phase_valid; }
+    int64_t getPhaseErrorUs() const { return phase_error_us; }
+    size_t describe(char *out, size_t len) const;         // "PHASE=+1.2ms" o "PHASE=NA"
+
+private:
+    // --- Variables de Estado ---
+    uint64_t period_us;
+    uint64_t last_sample_us; // Instante local de la última muestra (modo libre)
+    bool sampled;            // Ya se tomó alguna muestra
+    int64_t next_grid_us;    // Próximo instante de la rejilla; -1 = sin fijar
+    int64_t taken_grid_us;   // Instante de la rejilla de la última muestra; -1 = sin alinear
+    int64_t phase_error_us;  // Hora de la muestra menos su instante de la rejilla
+    bool phase_valid;
+};
+
+#endif // TIME_BASE_H
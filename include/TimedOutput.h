@@ -0,0 +1,116 @@
+#ifndef TIMED_OUTPUT_H
+#define TIMED_OUTPUT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @file TimedOutput.h
+ * @brief Salidas con flancos programados en un temporizador hardware.
+ * @details Un flanco programado (`setAt()`, o el final de `pulse()`) lo da un
+ * `esp_timer` de un solo disparo, no el bucle principal: aunque el bucle se
+ * detenga (una espera del UART del CO2, una descarga del historial...), el
+ * flanco llega a su hora. Los callbacks de `esp_timer` se despachan desde su
+ * propia tarea de alta prioridad, con una latencia de decenas de µs.
+ *
+ * Cada flanco, inmediato o programado, se anota con su hora pedida y la real
+ * (`monotonicMicros()`); el bucle las recoge con `popEdge()` para el registro.
+ *
+ * En el host (y con `-D NODE_SIMULATION`) no hay `esp_timer`: un temporizador
+ * falso dispara los flancos desde `runHostTimers()`, anotándolos a su hora
+ * pedida más una latencia configurable, como lo haría el hardware aunque el
+ * bucle llegue tarde. Así se pueden comprobar en el host los contratos de
+ * tiempo de quien use la salida.
+ */
+
+#if defined(ARDUINO) && !defined(NODE_SIMULATION)
+#define TIMED_OUTPUT_ESP_TIMER
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#endif
+
+/** @brief Función que escribe el valor en el hardware (nivel digital o duty). */
+typedef void (*OutputWrite)(void *context, uint16_t value);
+
+/**
+ * @struct OutputEdge
+ * @brief Registro de un flanco: valor escrito, hora pedida y hora real.
+ */
+struct OutputEdge
+{
+    uint64_t requestedUs; // `monotonicMicros()` pedido
+    uint64_t actualUs;    // `monotonicMicros()` tras escribir la salida
+    uint16_t previous;    // Valor anterior de la salida
+    uint16_t value;
+    bool scheduled;       // `true` si lo dio el temporizador
+};
+
+/**
+ * @class TimedOutput
+ * @brief Salida digital o PWM con un flanco programado como máximo.
+ * @details Un `set()` o un `setAt()` nuevo sustituye al flanco pendiente. Si
+ * un `set()` coincide con el disparo del temporizador, la escritura puede
+ * quedar antes o después del flanco programado; los usuarios de la clase no
+ * dependen de ese orden.
+ */
+class TimedOutput
+{
+public:
+    // --- Métodos Públicos ---
+    TimedOutput(const char *name, OutputWrite write, void *context); // Constructor
+    ~TimedOutput(); // Libera el temporizador (o sale de la lista del host)
+    TimedOutput(const TimedOutput &) = delete;
+    TimedOutput &operator=(const TimedOutput &) = delete;
+    bool begin(); // Crea el temporizador; `false` si no hay recursos
+    void set(uint16_t value);                    // Flanco inmediato (no escribe si no cambia)
+    bool setAt(uint16_t value, uint64_t atUs);   // Flanco programado en `monotonicMicros()`
+    bool pulse(uint16_t active, uint16_t idle, uint64_t durationUs); // Flanco ya y vuelta a `idle`
+    void cancel();                               // Descarta el flanco pendiente
+    bool isPending();
+    uint16_t getValue();
+    const char *getName() const { return name; }
+    bool popEdge(OutputEdge &edge); // Siguiente flanco sin registrar, `false` si no hay
+    uint32_t getDroppedEdges() const { return dropped_edges; }
+    int64_t getMaxLatenessUs() const { return max_lateness_us; }
+
+    static void runHostTimers(uint64_t nowUs); // Temporizador falso; en el ESP32 no hace nada
+    static void setHostLatencyUs(uint32_t latencyUs);
+
+    // --- Constantes ---
+    static const uint8_t EDGE_LOG_SIZE = 8;
+
+private:
+    // --- Métodos Privados ---
+    void fire(uint64_t nowUs); // Flanco programado, desde el temporizador
+    void write(uint16_t newValue, uint64_t requestedUs, bool scheduled);
+    void lock();
+    void unlock();
+
+    // --- Variables de Estado ---
+    const char *name;
+    OutputWrite write_fn;
+    void *context;
+    uint16_t value;
+    bool written;            // Ya se escribió al menos una vez
+    bool pending;            // Hay un flanco programado por dar
+    uint16_t pending_value;
+    uint64_t pending_at_us;
+    OutputEdge edges[EDGE_LOG_SIZE]; // Cola de flancos para el registro
+    uint8_t edge_head;
+    uint8_t edge_count;
+    uint32_t dropped_edges;  // Flancos que no cupieron en la cola
+    int64_t max_lateness_us;
+
+#ifdef TIMED_OUTPUT_ESP_TIMER
+    static void onTimer(void *arg);
+
+    esp_timer_handle_t timer;
+    portMUX_TYPE spinlock; // Protege el estado frente a la tarea de `esp_timer`
+#else
+    TimedOutput *next_host; // Lista de salidas para `runHostTimers()`
+    static TimedOutput *host_outputs;
+    static uint32_t host_latency_us;
+#endif
+};
+
+#endif // TIMED_OUTPUT_H
@@ -0,0 +1,99 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @file TimerWheel.h
+ * @brief Rueda jerárquica de temporizadores (tick de 1 ms) para los plazos del firmware.
+ * @details Cuatro niveles de 64 ranuras: el nivel 0 cubre 64 ms con
+ * resolución de 1 ms, el 1 unos 4 s, el 2 unos 4.4 min y el 3 unas 4.7 h. Un
+ * temporizador se guarda en la ranura del nivel que corresponde a su plazo y
+ * baja de nivel ("cascada") cuando el tiempo se acerca, así que insertar y
+ * cancelar son O(1) y avanzar la rueda no recorre los temporizadores lejanos.
+ *
+ * Los temporizadores son de quien los usa (memoria estática): la rueda solo
+ * los enlaza en sus listas. Un mapa de bits por nivel marca las ranuras
+ * ocupadas, de modo que `nextExpiryMs()` no recorre listas.
+ *
+ * No depende de Arduino: el tiempo lo pasa quien avanza la rueda, así que se
+ * puede probar en el host con miles de temporizadores y un reloj virtual.
+ */
+
+/** @brief Función llamada al vencer un temporizador. */
+typedef void (*TimerCallback)(void *context);
+
+/**
+ * @struct TimerLink
+ * @brief Enlace de las listas doblemente enlazadas y circulares de la rueda.
+ */
+struct TimerLink
+{
+    TimerLink *next;
+    TimerLink *prev;
+};
+
+/**
+ * @class Timer
+ * @brief Temporizador de un solo disparo o periódico.
+ * @details Debe vivir mientras esté activo (normalmente, un miembro o una
+ * variable global del subsistema que lo usa).
+ */
+class Timer
+{
+public:
+    Timer(TimerCallback callback, void *context); // Constructor
+    bool isActive() const { return active; }
+
+private:
+    friend class TimerWheel;
+
+    TimerLink link; // Primer miembro: un `TimerLink*` de la rueda es un `Timer*`
+    TimerCallback callback;
+    void *context;
+    uint32_t expires_ms; // Instante de vencimiento
+    uint32_t period_ms;  // 0 = un solo disparo
+    uint8_t level;       // Posición en la rueda, para cancelar en O(1)
+    uint8_t slot;
+    bool active;
+};
+
+/**
+ * @class TimerWheel
+ * @brief Rueda de temporizadores avanzada por el bucle principal.
+ */
+class TimerWheel
+{
+public:
+    // --- Métodos Públicos ---
+    TimerWheel(); // Constructor
+    void reset(uint32_t nowMs); // Fija el instante inicial; la rueda debe estar vacía
+    void start(Timer &timer, uint32_t delayMs, uint32_t periodMs = 0); // (Re)arma, relativo a `nowMs()`
+    void cancel(Timer &timer);
+    void advance(uint32_t nowMs); // Ejecuta los temporizadores vencidos hasta `nowMs`
+    bool nextExpiryMs(uint32_t &expiryMs) const; // Cota inferior del próximo vencimiento
+    uint32_t nowMs() const { return current_ms; }
+    uint16_t getActiveCount() const { return active_count; }
+
+    // --- Constantes ---
+    static const uint8_t LEVELS = 4;
+    static const uint8_t SLOT_BITS = 6;
+    static const uint8_t SLOTS = 1 << SLOT_BITS;
+    static const uint32_t MAX_DELAY_MS = (1UL << (LEVELS * SLOT_BITS)) - 1; // ~4.7 h
+
+private:
+    // --- Métodos Privados ---
+    void insert(Timer &timer);
+    void unlink(Timer &timer);
+    void cascade(uint8_t level);
+    void expireSlot(uint8_t slot);
+
+    // --- Variables de Estado ---
+    TimerLink slots[LEVELS][SLOTS]; // Cabeceras de las listas de cada ranura
+    uint64_t occupied[LEVELS];      // Ranuras con temporizadores
+    uint32_t current_ms;            // Último tick procesado
+    uint16_t active_count;
+};
+
+#endif // TIMER_WHEEL_H
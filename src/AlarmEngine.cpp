@@ -0,0 +1,310 @@
+/**
+ * @file AlarmEngine.cpp
+ * @brief Implementación de la evaluación de umbrales de alarma.
+ * @details Este archivo no depende de Arduino para poder reproducir en el host
+ * secuencias de muestras y comprobar las transiciones.
+ */
+
+#include "AlarmEngine.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+/** @brief Nombres de las magnitudes, en el orden de `SampleField`. */
+static const char *const FIELD_NAMES[SAMPLE_FIELD_COUNT] = {"T", "H", "P", "CO2"};
+/** @brief Nombres de `AlarmLevel`, en el mismo orden que la enumeración. */
+static const char *const LEVEL_NAMES[] = {"NONE", "LOW", "HIGH"};
+
+/**
+ * @brief Constructor de la clase AlarmEngine.
+ * @details Todas las magnitudes empiezan sin umbrales.
+ */
+AlarmEngine::AlarmEngine()
+{
+    for (uint8_t i = 0; i < SAMPLE_FIELD_COUNT; i++)
+    {
+        rules[i] = disabledRule();
+        states[i].level = ALARM_NONE;
+        states[i].pending = ALARM_NONE;
+        states[i].pendingSince = 0;
+        states[i].acknowledged = false;
+        states[i].lastValue = 0;
+    }
+    queue_head = 0;
+    queue_count = 0;
+}
+
+/**
+ * @brief Regla sin umbrales: la magnitud nunca entra en alarma.
+ */
+AlarmRule AlarmEngine::disabledRule()
+{
+    AlarmRule rule;
+    rule.low = INT32_MIN;
+    rule.high = INT32_MAX;
+    rule.hysteresis = 0;
+    rule.minDurationMs = 0;
+    rule.latched = false;
+    return rule;
+}
+
+/**
+ * @brief Cambia los umbrales de una magnitud.
+ * @details El estado actual se conserva: si la alarma ya no se cumple con los
+ * nuevos umbrales, se apagará en las siguientes muestras como cualquier otra.
+ * @param field Magnitud (`SampleField`).
+ * @param rule Nuevos umbrales.
+ */
+void AlarmEngine::setRule(uint8_t field, const AlarmRule &rule)
+{
+    if (field < SAMPLE_FIELD_COUNT)
+    {
+        rules[field] = rule;
+        if (rules[field].hysteresis < 0)
+        {
+            rules[field].hysteresis = 0;
+        }
+    }
+}
+
+/**
+ * @brief Obtiene los umbrales de una magnitud.
+ * @param field Magnitud (`SampleField`), menor que `SAMPLE_FIELD_COUNT`.
+ */
+const AlarmRule &AlarmEngine::getRule(uint8_t field) const
+{
+    return rules[field];
+}
+
+/**
+ * @brief Evalúa las alarmas con una muestra nueva.
+ * @param data Lecturas de los sensores (-1 = no disponible).
+ * @param nowMs Tiempo actual en ms (por ejemplo `millis()`).
+ */
+void AlarmEngine::evaluate(const SensorData &data, uint32_t nowMs)
+{
+    if (data.temperature != -1)
+    {
+        evaluateField(FIELD_TEMPERATURE, (int32_t)lroundf(data.temperature * 100.0f), nowMs);
+    }
+    if (data.humidity != -1)
+    {
+        evaluateField(FIELD_HUMIDITY, (int32_t)lroundf(data.humidity * 100.0f), nowMs);
+    }
+    if (data.pressure != -1)
+    {
+        evaluateField(FIELD_PRESSURE, (int32_t)lroundf(data.pressure * 10.0f), nowMs);
+    }
+    if (data.co2 != -1)
+    {
+        evaluateField(FIELD_CO2, data.co2, nowMs);
+    }
+}
+
+/**
+ * @brief Reconoce la alarma enclavada de una magnitud.
+ * @details La alarma se apaga en cuanto la condición desaparezca (o ya mismo,
+ * tras la duración mínima, si ya había desaparecido).
+ * @param field Magnitud (`SampleField`).
+ * @return bool `false` si la magnitud no tiene una alarma enclavada activa.
+ */
+bool AlarmEngine::acknowledge(uint8_t field)
+{
+    if (field >= SAMPLE_FIELD_COUNT || states[field].level == ALARM_NONE || !rules[field].latched)
+    {
+        return false;
+    }
+    states[field].acknowledged = true;
+    return true;
+}
+
+/**
+ * @brief Saca la transición más antigua de la cola.
+ * @param event Transición extraída.
+ * @return bool `false` si no hay transiciones pendientes.
+ */
+bool AlarmEngine::popEvent(AlarmEvent &event)
+{
+    if (queue_count == 0)
+    {
+        return false;
+    }
+    event = queue[queue_head];
+    queue_head = (queue_head + 1) % QUEUE_SIZE;
+    queue_count--;
+    return true;
+}
+
+/**
+ * @brief Obtiene el estado de la alarma de una magnitud.
+ * @param field Magnitud (`SampleField`), menor que `SAMPLE_FIELD_COUNT`.
+ */
+AlarmLevel AlarmEngine::getLevel(uint8_t field) const
+{
+    return (AlarmLevel)states[field].level;
+}
+
+/**
+ * @brief Describe las alarmas activas en texto.
+ * @details Formato: "ACTIVE=CO2:HIGH@1520,T:LOW@-512" (valores en punto fijo),
+ * o "ACTIVE=NONE". Una alarma enclavada pendiente de reconocer lleva un '!'.
+ * @param out Buffer de salida.
+ * @param len Tamaño de `out`.
+ * @return size_t Longitud del texto escrito.
+ */
+size_t AlarmEngine::describe(char *out, size_t len) const
+{
+    if (len == 0)
+    {
+        return 0;
+    }
+    size_t pos = snprintf(out, len, "ACTIVE=");
+    bool any = false;
+    for (uint8_t i = 0; i < SAMPLE_FIELD_COUNT && pos < len; i++)
+    {
+        if (states[i].level == ALARM_NONE)
+        {
+            continue;
+        }
+        bool waitingAck = rules[i].latched && !states[i].acknowledged;
+        int written = snprintf(out + pos, len - pos, "%s%s:%s@%ld%s", any ? "," : "", FIELD_NAMES[i],
+                               LEVEL_NAMES[states[i].level], (long)states[i].lastValue, waitingAck ? "!" : "");
+        if (written < 0)
+        {
+            break;
+        }
+        pos += written;
+        any = true;
+    }
+    if (!any && pos < len)
+    {
+        pos += snprintf(out + pos, len - pos, "NONE");
+    }
+    return pos < len ? pos : len - 1;
+}
+
+/**
+ * @brief Obtiene el nombre corto de una magnitud ("T", "H", "P" o "CO2").
+ */
+const char *AlarmEngine::fieldName(uint8_t field)
+{
+    return field < SAMPLE_FIELD_COUNT ? FIELD_NAMES[field] : "?";
+}
+
+/**
+ * @brief Busca una magnitud por su nombre corto.
+ * @param name Nombre, ej. "CO2".
+ * @return int Magnitud (`SampleField`), o -1 si no existe.
+ */
+int AlarmEngine::fieldFromName(const char *name)
+{
+    for (uint8_t i = 0; i < SAMPLE_FIELD_COUNT; i++)
+    {
+        if (strcmp(name, FIELD_NAMES[i]) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Obtiene el nombre de un nivel de alarma.
+ */
+const char *AlarmEngine::levelName(uint8_t level)
+{
+    return level <= ALARM_HIGH ? LEVEL_NAMES[level] : "?";
+}
+
+/**
+ * @brief Evalúa la alarma de una magnitud.
+ * @details El nivel que indica la medida debe mantenerse `minDurationMs`
+ * antes de publicarse. Una alarma enclavada sin reconocer conserva su nivel
+ * aunque la medida vuelva al rango normal.
+ * @param field Magnitud (`SampleField`).
+ * @param value Medida en punto fijo.
+ * @param nowMs Tiempo actual en ms.
+ */
+void AlarmEngine::evaluateField(uint8_t field, int32_t value, uint32_t nowMs)
+{
+    FieldState &state = states[field];
+    const AlarmRule &rule = rules[field];
+    state.lastValue = value;
+
+    uint8_t target = condition(field, value);
+    if (rule.latched && state.level != ALARM_NONE && target == ALARM_NONE && !state.acknowledged)
+    {
+        target = state.level; // Enclavada: espera al reconocimiento
+    }
+    if (target == state.level)
+    {
+        state.pending = state.level;
+        return;
+    }
+    if (target != state.pending)
+    {
+        state.pending = target;
+        state.pendingSince = nowMs;
+    }
+    if (nowMs - state.pendingSince >= rule.minDurationMs)
+    {
+        transition(field, target, value);
+    }
+}
+
+/**
+ * @brief Nivel que corresponde a una medida, con histéresis respecto al actual.
+ * @param field Magnitud (`SampleField`).
+ * @param value Medida en punto fijo.
+ */
+uint8_t AlarmEngine::condition(uint8_t field, int32_t value) const
+{
+    const AlarmRule &rule = rules[field];
+    uint8_t level = states[field].level;
+    if (level == ALARM_HIGH && rule.high != INT32_MAX && value > rule.high - rule.hysteresis)
+    {
+        return ALARM_HIGH;
+    }
+    if (level == ALARM_LOW && rule.low != INT32_MIN && value < rule.low + rule.hysteresis)
+    {
+        return ALARM_LOW;
+    }
+    if (value > rule.high)
+    {
+        return ALARM_HIGH;
+    }
+    if (value < rule.low)
+    {
+        return ALARM_LOW;
+    }
+    return ALARM_NONE;
+}
+
+/**
+ * @brief Publica un nuevo nivel y encola la transición.
+ * @details Si la cola está llena se descarta la transición más antigua: la
+ * cola se vacía en cada muestra, así que solo ocurre si nadie la atiende.
+ * @param field Magnitud (`SampleField`).
+ * @param level Nuevo nivel.
+ * @param value Medida que provocó la transición.
+ */
+void AlarmEngine::transition(uint8_t field, uint8_t level, int32_t value)
+{
+    states[field].level = level;
+    states[field].pending = level;
+    states[field].acknowledged = false;
+
+    if (queue_count == QUEUE_SIZE)
+    {
+        queue_head = (queue_head + 1) % QUEUE_SIZE;
+        queue_count--;
+    }
+    AlarmEvent &event = queue[(queue_head + queue_count) % QUEUE_SIZE];
+    queue_count++;
+    event.sequence = 0;
+    event.uptimeS = 0;
+    event.bootCount = 0;
+    event.field = field;
+    event.level = level;
+    event.value = value;
+}
@@ -0,0 +1,187 @@
+/**
+ * @file AlarmLog.cpp
+ * @brief Implementación del historial persistente de transiciones de alarma.
+ */
+
+#include "AlarmLog.h"
+#include <LittleFS.h>
+#include <Preferences.h>
+
+/** @brief Archivo con las transiciones más recientes. */
+static const char *ALARM_FILE = "/alarms.bin";
+/** @brief Archivo con las transiciones anteriores a la última rotación. */
+static const char *ALARM_OLD_FILE = "/alarms.old";
+/** @brief Archivos en orden cronológico, para buscar la siguiente transición. */
+static const char *const ALARM_FILES[] = {ALARM_OLD_FILE, ALARM_FILE};
+
+/** @brief Espacio de nombres en NVS de la secuencia y la confirmación. */
+static const char *ALARM_NAMESPACE = "alarms";
+
+/**
+ * @brief Constructor de la clase AlarmLog.
+ */
+AlarmLog::AlarmLog()
+{
+    boot_count = 0;
+    last_sequence = 0;
+    acknowledged = 0;
+}
+
+/**
+ * @brief Recupera la secuencia y la última confirmación guardadas en NVS.
+ * @param bootCount Arranque actual (ver CalibrationLog::getBootCount()).
+ */
+void AlarmLog::init(uint16_t bootCount)
+{
+    boot_count = bootCount;
+    Preferences prefs;
+    if (prefs.begin(ALARM_NAMESPACE, true))
+    {
+        last_sequence = prefs.getUInt("seq", 0);
+        acknowledged = prefs.getUInt("acked", 0);
+        prefs.end();
+    }
+    if (acknowledged > last_sequence)
+    {
+        acknowledged = last_sequence;
+    }
+    Serial.printf("Alarmas: última transición #%lu, confirmada hasta #%lu.\n",
+                  (unsigned long)last_sequence, (unsigned long)acknowledged);
+}
+
+/**
+ * @brief Añade una transición al final del historial.
+ * @details Rellena `sequence`, `bootCount` y `uptimeS`. La secuencia se guarda
+ * en NVS antes de escribir el archivo, así que nunca se reutiliza un número.
+ * @param event Transición a añadir.
+ * @return bool `true` si se escribió completa.
+ */
+bool AlarmLog::append(AlarmEvent &event)
+{
+    event.sequence = ++last_sequence;
+    event.bootCount = boot_count;
+    event.uptimeS = millis() / 1000;
+
+    Preferences prefs;
+    if (prefs.begin(ALARM_NAMESPACE, false))
+    {
+        prefs.putUInt("seq", last_sequence);
+        prefs.end();
+    }
+
+    File current = LittleFS.open(ALARM_FILE, FILE_READ);
+    size_t size = current ? current.size() : 0;
+    current.close();
+    if (size >= MAX_FILE_SIZE)
+    {
+        LittleFS.remove(ALARM_OLD_FILE);
+        LittleFS.rename(ALARM_FILE, ALARM_OLD_FILE);
+    }
+    File file = LittleFS.open(ALARM_FILE, FILE_APPEND);
+    if (!file)
+    {
+        return false;
+    }
+    bool ok = file.write((const uint8_t *)&event, sizeof(event)) == sizeof(event);
+    file.close();
+    return ok;
+}
+
+/**
+ * @brief Busca la transición más antigua con secuencia mayor que la indicada.
+ * @details Recorre los archivos del más antiguo al más reciente. Si la
+ * siguiente transición ya se perdió por la rotación, devuelve la más antigua
+ * que se conserva.
+ * @param sequence Última transición que el cliente ya tiene.
+ * @param event Transición encontrada.
+ * @return bool `false` si no hay ninguna posterior.
+ */
+bool AlarmLog::findAfter(uint32_t sequence, AlarmEvent &event)
+{
+    if (sequence >= last_sequence)
+    {
+        return false;
+    }
+    for (const char *path : ALARM_FILES)
+    {
+        if (!LittleFS.exists(path))
+        {
+            continue;
+        }
+        File file = LittleFS.open(path, FILE_READ);
+        while (file && file.read((uint8_t *)&event, sizeof(event)) == sizeof(event))
+        {
+            if (event.sequence > sequence)
+            {
+                file.close();
+                return true;
+            }
+        }
+        file.close();
+    }
+    return false;
+}
+
+/**
+ * @brief Registra que el cliente recibió todas las transiciones hasta `sequence`.
+ * @param sequence Secuencia confirmada por el cliente.
+ * @return bool `false` si no confirma nada nuevo.
+ */
+bool AlarmLog::acknowledge(uint32_t sequence)
+{
+    if (sequence <= acknowledged || sequence > last_sequence)
+    {
+        return false;
+    }
+    acknowledged = sequence;
+    Preferences prefs;
+    if (prefs.begin(ALARM_NAMESPACE, false))
+    {
+        prefs.putUInt("acked", acknowledged);
+        prefs.end();
+    }
+    return true;
+}
+
+/**
+ * @brief Obtiene la secuencia de la última transición (0 = ninguna).
+ */
+uint32_t AlarmLog::getLastSequence()
+{
+    return last_sequence;
+}
+
+/**
+ * @brief Obtiene la última secuencia confirmada por el cliente.
+ */
+uint32_t AlarmLog::getAcknowledged()
+{
+    return acknowledged;
+}
+
+/**
+ * @brief Describe una transición en texto.
+ * @details Formato: "#12:B3+456s,CO2,HIGH,1520" (valor en el punto fijo del
+ * historial, ver `SampleField`).
+ * @param event Transición a describir.
+ * @param out Buffer de salida.
+ * @param len Tamaño de `out`.
+ * @return size_t Longitud del texto escrito.
+ */
+size_t AlarmLog::describe(const AlarmEvent &event, char *out, size_t len)
+{
+    if (len == 0)
+    {
+        return 0;
+    }
+    int written = snprintf(out, len, "#%lu:B%u+%lus,%s,%s,%ld", (unsigned long)event.sequence,
+                           (unsigned)event.bootCount, (unsigned long)event.uptimeS,
+                           AlarmEngine::fieldName(event.field), AlarmEngine::levelName(event.level),
+                           (long)event.value);
+    if (written < 0)
+    {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < len ? (size_t)written : len - 1;
+}
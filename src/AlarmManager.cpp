@@ -0,0 +1,281 @@
+/**
+ * @file AlarmManager.cpp
+ * @brief Implementación de las alarmas por umbral y su entrega por BLE.
+ */
+
+#include "AlarmManager.h"
+#include <Preferences.h>
+
+/** @brief Espacio de nombres y clave de los umbrales en NVS. */
+static const char *RULES_NAMESPACE = "alarms";
+static const char *RULES_KEY = "rules";
+
+/**
+ * @brief Lee un argumento sin signo de un comando "RULE=".
+ * @details Solo admite dígitos (entre 1 y 9), sin signo ni espacios: un valor
+ * negativo o no numérico no debe convertirse en una histéresis o duración
+ * que desactive la regla.
+ * @param text Argumento.
+ * @param value Valor leído.
+ * @return bool `false` si el texto no es un número válido.
+ */
+static bool parseUnsigned(const String &text, uint32_t &value)
+{
+    if (text.length() == 0 || text.length() > 9)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < text.length(); i++)
+    {
+        if (text[i] < '0' || text[i] > '9')
+        {
+            return false;
+        }
+    }
+    value = strtoul(text.c_str(), nullptr, 10);
+    return true;
+}
+
+/**
+ * @brief Constructor de la clase AlarmManager.
+ */
+AlarmManager::AlarmManager()
+{
+    was_connected = false;
+    sent_sequence = 0;
+    sent_time = 0;
+    status_changed = true;
+}
+
+/**
+ * @brief Carga los umbrales y la secuencia de transiciones.
+ * @param bootCount Arranque actual (ver CalibrationLog::getBootCount()).
+ */
+void AlarmManager::init(uint16_t bootCount)
+{
+    loadRules();
+    alarmLog.init(bootCount);
+    status_changed = true;
+}
+
+/**
+ * @brief Procesa un comando de la característica de alarmas.
+ * @details Comandos:
+ * - "ACK=<n>": el cliente recibió todas las transiciones hasta la `n`.
+ * - "CLEAR=<magnitud>": reconoce una alarma enclavada, ej. "CLEAR=CO2".
+ * - "RULE=<magnitud>,<bajo>,<alto>,<histéresis>,<ms>,<LATCH|AUTO>": cambia los
+ *   umbrales, en el punto fijo del historial; "-" desactiva un umbral. Ej.
+ *   "RULE=CO2,-,1500,100,60000,AUTO".
+ * @param cmd Comando recibido.
+ * @return bool `true` si se aplicó.
+ */
+bool AlarmManager::handleCommand(const String &cmd)
+{
+    bool ok = false;
+    if (cmd.startsWith("ACK="))
+    {
+        ok = alarmLog.acknowledge((uint32_t)cmd.substring(4).toInt());
+    }
+    else if (cmd.startsWith("CLEAR="))
+    {
+        int field = AlarmEngine::fieldFromName(cmd.substring(6).c_str());
+        ok = field >= 0 && engine.acknowledge((uint8_t)field);
+    }
+    else if (cmd.startsWith("RULE="))
+    {
+        ok = parseRule(cmd.substring(5));
+        if (ok)
+        {
+            saveRules();
+        }
+    }
+    status_changed |= ok;
+    Serial.printf("Comando de alarmas %s: %s\n", cmd.c_str(), ok ? "aplicado" : "rechazado");
+    return ok;
+}
+
+/**
+ * @brief Evalúa las alarmas con la última muestra y guarda las transiciones.
+ * @param data Lecturas de los sensores.
+ */
+void AlarmManager::onSample(const SensorData &data)
+{
+    engine.evaluate(data, millis());
+    AlarmEvent event;
+    while (engine.popEvent(event))
+    {
+        alarmLog.append(event);
+        char text[48];
+        AlarmLog::describe(event, text, sizeof(text));
+        Serial.printf("Alarma: %s\n", text);
+        status_changed = true;
+    }
+}
+
+/**
+ * @brief Decide si hay que indicar una transición al cliente.
+ * @details Indica la transición más antigua sin confirmar. Al reconectar se
+ * empieza de nuevo por la primera sin confirmar; si el cliente no confirma en
+ * `ACK_TIMEOUT_MS`, se vuelve a indicar.
+ * @param connected Si hay un cliente conectado.
+ * @param out Buffer para el texto de la transición (ver AlarmLog::describe()).
+ * @param len Tamaño de `out`.
+ * @return bool `true` si hay que enviar `out` como indicación.
+ */
+bool AlarmManager::nextIndication(bool connected, char *out, size_t len)
+{
+    if (connected != was_connected)
+    {
+        was_connected = connected;
+        sent_sequence = 0; // Conexión nueva: todo lo no confirmado está pendiente
+    }
+    uint32_t acknowledged = alarmLog.getAcknowledged();
+    if (!connected || acknowledged >= alarmLog.getLastSequence())
+    {
+        return false;
+    }
+    if (sent_sequence > acknowledged && millis() - sent_time < ACK_TIMEOUT_MS)
+    {
+        return false; // Esperando la confirmación de la anterior
+    }
+    AlarmEvent event;
+    if (!alarmLog.findAfter(acknowledged, event))
+    {
+        return false;
+    }
+    sent_sequence = event.sequence;
+    sent_time = millis();
+    AlarmLog::describe(event, out, len);
+    return true;
+}
+
+/**
+ * @brief Indica si el estado cambió desde la última consulta, y lo olvida.
+ */
+bool AlarmManager::hasStatusChanged()
+{
+    bool changed = status_changed;
+    status_changed = false;
+    return changed;
+}
+
+/**
+ * @brief Describe las alarmas activas y el estado de la entrega.
+ * @details Formato: "ACTIVE=CO2:HIGH@1520!;LAST=12;ACKED=10" (ver
+ * AlarmEngine::describe()).
+ * @param out Buffer de salida.
+ * @param len Tamaño de `out`.
+ * @return size_t Longitud del texto escrito.
+ */
+size_t AlarmManager::describeStatus(char *out, size_t len)
+{
+    size_t pos = engine.describe(out, len);
+    if (pos + 1 < len)
+    {
+        int written = snprintf(out + pos, len - pos, ";LAST=%lu;ACKED=%lu",
+                               (unsigned long)alarmLog.getLastSequence(), (unsigned long)alarmLog.getAcknowledged());
+        if (written > 0)
+        {
+            pos += written;
+        }
+    }
+    return pos < len ? pos : len - 1;
+}
+
+/**
+ * @brief Carga los umbrales de NVS.
+ * @details Sin umbrales guardados, solo se vigila el CO2: alarma alta a
+ * 1500 ppm que se apaga por debajo de 1400 ppm, con un minuto de antirrebote.
+ */
+void AlarmManager::loadRules()
+{
+    AlarmRule rules[SAMPLE_FIELD_COUNT];
+    Preferences prefs;
+    bool found = false;
+    if (prefs.begin(RULES_NAMESPACE, true))
+    {
+        found = prefs.getBytesLength(RULES_KEY) == sizeof(rules) &&
+                prefs.getBytes(RULES_KEY, rules, sizeof(rules)) == sizeof(rules);
+        prefs.end();
+    }
+    if (!found)
+    {
+        for (uint8_t i = 0; i < SAMPLE_FIELD_COUNT; i++)
+        {
+            rules[i] = AlarmEngine::disabledRule();
+        }
+        rules[FIELD_CO2].high = 1500;
+        rules[FIELD_CO2].hysteresis = 100;
+        rules[FIELD_CO2].minDurationMs = 60000UL;
+    }
+    for (uint8_t i = 0; i < SAMPLE_FIELD_COUNT; i++)
+    {
+        engine.setRule(i, rules[i]);
+    }
+}
+
+/**
+ * @brief Guarda los umbrales actuales en NVS.
+ */
+void AlarmManager::saveRules()
+{
+    AlarmRule rules[SAMPLE_FIELD_COUNT];
+    for (uint8_t i = 0; i < SAMPLE_FIELD_COUNT; i++)
+    {
+        rules[i] = engine.getRule(i);
+    }
+    Preferences prefs;
+    if (prefs.begin(RULES_NAMESPACE, false))
+    {
+        prefs.putBytes(RULES_KEY, rules, sizeof(rules));
+        prefs.end();
+    }
+}
+
+/**
+ * @brief Interpreta los argumentos de un comando "RULE=".
+ * @param args "<magnitud>,<bajo>,<alto>,<histéresis>,<ms>,<LATCH|AUTO>".
+ * @return bool `false` si el formato no es válido; entonces no cambia nada.
+ */
+bool AlarmManager::parseRule(const String &args)
+{
+    String parts[6];
+    int start = 0;
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        int comma = args.indexOf(',', start);
+        if ((comma < 0) != (i == 5))
+        {
+            return false; // Faltan o sobran argumentos
+        }
+        parts[i] = comma < 0 ? args.substring(start) : args.substring(start, comma);
+        start = comma + 1;
+    }
+    int field = AlarmEngine::fieldFromName(parts[0].c_str());
+    if (field < 0 || (parts[5] != "LATCH" && parts[5] != "AUTO"))
+    {
+        return false;
+    }
+    AlarmRule rule = AlarmEngine::disabledRule();
+    if (parts[1] != "-")
+    {
+        rule.low = parts[1].toInt();
+    }
+    if (parts[2] != "-")
+    {
+        rule.high = parts[2].toInt();
+    }
+    if (rule.low >= rule.high)
+    {
+        return false;
+    }
+    uint32_t hysteresis;
+    if (!parseUnsigned(parts[3], hysteresis) || !parseUnsigned(parts[4], rule.minDurationMs))
+    {
+        return false;
+    }
+    rule.hysteresis = (int32_t)hysteresis;
+    rule.latched = parts[5] == "LATCH";
+    engine.setRule((uint8_t)field, rule);
+    return true;
+}
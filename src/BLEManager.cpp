@@ -9,216 +9,813 @@
  */
 
 #include "BLEManager.h"
+#include "BroadcastPayload.h"
+#include "CommandMailbox.h"
+#include "ConfigStore.h"
+#include "Seqlock.h"
+#include "TimeBase.h"
 #include <Arduino.h> // Necesario para Serial.println()
 
 // --- DEFINICIONES PARA EL SERVIDOR BLE ---
 
-/** @def SERVICE_UUID
- * @brief UUID principal del servicio BLE que agrupa todas las características. */
-#define SERVICE_UUID "4fafc201-1fb5-459e-8fcc-c5c9c331914b"
-/** @def CHARACTERISTIC_UUID_TMP
- * @brief UUID para la característica de temperatura (lectura). */
-#define CHARACTERISTIC_UUID_TMP "beb5483e-36e1-4688-b7f5-ea07361b26a8"
-/** @def CHARACTERISTIC_UUID_PRES
- * @brief UUID para la característica de presión (lectura). */
-#define CHARACTERISTIC_UUID_PRES "cba1d466-344c-4be3-ab3f-189f80dd7518"
-/** @def CHARACTERISTIC_UUID_HUM
- * @brief UUID para la característica de humedad (lectura). */
-#define CHARACTERISTIC_UUID_HUM "d2b2d3e1-36e1-4688-b7f5-ea07361b26a8"
-/** @def CHARACTERISTIC_UUID_CO2
- * @brief UUID para la característica de CO2 (lectura). */
-#define CHARACTERISTIC_UUID_CO2 "a1b2c3d4-5678-90ab-cdef-1234567890ab"
-/** @def CHARACTERISTIC_UUID_CALIBRATE
- * @brief UUID para la característica de calibración (lectura/escritura). */
-#define CHARACTERISTIC_UUID_CALIBRATE "12345678-1234-1234-1234-123456789abc"
-/** @def CHARACTERISTIC_UUID_SYSTEM_STATE
- * @brief UUID para la característica de estado del sistema (lectura). */
-#define CHARACTERISTIC_UUID_SYSTEM_STATE "c1a7d131-15e1-413f-b565-8123c5a31a1e"
-/** @def CHARACTERISTIC_UUID_COOLER_STATE
- * @brief UUID para la característica de estado del ventilador (lectura/escritura). */
-#define CHARACTERISTIC_UUID_COOLER_STATE "d2b8d232-26f1-4688-b7f5-ea07361b26a8"
+/** @brief UUID principal del servicio BLE que agrupa todas las características.
+ * @details Los UUID de las características están en la tabla `CHARACTERISTICS`. */
+static constexpr GattUuid SERVICE_UUID = gattUuid128("4fafc201-1fb5-459e-8fcc-c5c9c331914b");
+/** @brief Número de handles reservados para el servicio principal. */
+static const uint16_t SERVICE_NUM_HANDLES = 40;
+/** @brief Servicios anunciados en la respuesta de escaneo (el propio y Environmental Sensing). */
+static constexpr GattUuid SCAN_RESPONSE_SERVICES[] = {SERVICE_UUID, gattUuid16(0x181A)};
+
+// --- Perfiles de Parámetros de Conexión ---
+
+/** @brief Tabla de parámetros indexada por `ConnectionProfile`. */
+static const GattConnectionParams CONNECTION_PROFILES[] = {
+    // PROFILE_STEADY: 100-200 ms, se pueden saltar 4 eventos, timeout de 6 s.
+    {80, 160, 4, 600},
+    // PROFILE_BULK: 7.5-15 ms, sin latencia, timeout de 4 s.
+    {6, 12, 0, 400},
+};
 
 // --- Variables Globales ---
 
 /** @brief Flag global que indica el estado de la conexión BLE. */
 bool deviceConnected = false;
-/** @brief Flag global volátil para solicitar el cambio de estado del ventilador.
- * @details Es `volatile` porque se modifica en un callback (contexto de interrupción)
- * y se lee en el bucle principal. */
-volatile bool toggleCoolerRequest = false;
+
+/** @brief Flag volátil que indica que el cliente pidió descargar el historial. */
+static volatile bool historyRequest = false;
+
+/** @brief Perfil de conexión solicitado actualmente. */
+static ConnectionProfile currentProfile = PROFILE_STEADY;
+
+/** @brief Máscara de sensores en fallo (bit `1 << SensorKind`), publicada en el diagnóstico. */
+static uint8_t sensorFaults = 0;
+
+/** @brief Tiempo hasta la primera publicidad, en ms desde el arranque (0 = desconocido). */
+static uint32_t bootTtfaMs = 0;
+/** @brief Tiempo hasta la primera muestra válida, en ms desde el arranque (0 = todavía no). */
+static uint32_t bootTtfsMs = 0;
+
+/** @brief Duración de la inicialización de la pila BLE y del servidor GATT, en ms. */
+static uint32_t stackInitMs = 0;
+/** @brief Heap libre justo después de inicializar la pila BLE, en bytes. */
+static uint32_t stackFreeHeap = 0;
+
+/** @brief Nombre con el que se anuncia el dispositivo. */
+static String advertisedName = "SRV_NAME";
+
+/** @brief Indica si las lecturas se difunden en los datos de publicidad. */
+static bool broadcastEnabled = false;
+/** @brief Contador rodante incluido en cada payload de difusión. */
+static uint8_t broadcastCounter = 0;
+
+/**
+ * @brief Configura los datos de publicidad principales.
+ * @details Siempre incluye los flags y el nombre del dispositivo; si se pasa
+ * un payload de fabricante, lo añade como datos específicos del fabricante.
+ * @param manufacturerData Bytes de los datos de fabricante, o `nullptr`.
+ * @param len Longitud de `manufacturerData`.
+ */
+static void setAdvertisementPayload(const uint8_t *manufacturerData, size_t len)
+{
+    gattServer().setAdvertisingData(advertisedName.c_str(), manufacturerData, len);
+}
+
+/**
+ * @brief Envía al cliente conectado la solicitud de parámetros de un perfil.
+ * @param profile Perfil cuyos parámetros se solicitan.
+ */
+static void requestConnectionParams(ConnectionProfile profile)
+{
+    gattServer().requestConnectionParams(CONNECTION_PROFILES[profile]);
+}
 
 /**
- * @class MyServerCallbacks
- * @brief Gestiona los eventos de conexión y desconexión del servidor BLE.
- * @details Esta clase hereda de `BLEServerCallbacks` para implementar
- * comportamiento personalizado cuando un cliente se conecta o desconecta.
+ * @brief Gestiona los eventos de conexión y desconexión del servidor GATT.
+ * @details Al conectar, solicita los parámetros del perfil de conexión activo;
+ * al desconectar, reinicia la publicidad para permitir nuevas conexiones.
+ * @param event Evento recibido de la pila BLE.
  */
-class MyServerCallbacks : public BLEServerCallbacks
+static void onGattEvent(GattEvent event)
 {
-    /**
-     * @brief Método llamado cuando un cliente BLE se conecta.
-     * @param pServer Puntero al servidor BLE.
-     */
-    void onConnect(BLEServer *pServer)
+    if (event == GATT_EVENT_CONNECT)
     {
         deviceConnected = true;
         Serial.println("Dispositivo conectado");
-    }
+        requestConnectionParams(currentProfile);
 
-    /**
-     * @brief Método llamado cuando un cliente BLE se desconecta.
-     * @param pServer Puntero al servidor BLE.
-     */
-    void onDisconnect(BLEServer *pServer)
+        // En modo difusión se sigue publicitando, pero sin aceptar más conexiones.
+        if (broadcastEnabled)
+        {
+            gattServer().startAdvertising(false);
+        }
+    }
+    else
     {
         deviceConnected = false;
         Serial.println("Dispositivo desconectado");
-        pServer->startAdvertising(); // Reinicia la publicidad para permitir nuevas conexiones.
+        gattServer().startAdvertising(true);
         Serial.println("Publicidad reiniciada");
     }
+}
+
+/** @brief Longitud máxima de un comando de calibración ("RANGE=10000" es el más largo). */
+static const size_t CALIBRATION_COMMAND_MAX_LEN = 16;
+/** @brief Último comando de calibración recibido. */
+static CommandMailbox<CALIBRATION_COMMAND_MAX_LEN> calibrationCommand;
+
+/**
+ * @brief Se ejecuta cuando un cliente BLE escribe en la característica de calibración.
+ * @details Guarda el comando ("START_CAL", "SPAN=...", "ABC=..." o "RANGE=...")
+ * para que el bucle principal lo valide y lo envíe al sensor.
+ * @param context Sin uso.
+ * @param data Bytes escritos por el cliente.
+ * @param len Longitud de `data`.
+ */
+static void onCalibrationWrite(void *context, const uint8_t *data, size_t len)
+{
+    if (calibrationCommand.post(data, len))
+    {
+        Serial.printf("Comando de calibración recibido: %.*s\n", (int)len, (const char *)data);
+    }
+    else if (len > 0)
+    {
+        Serial.println("Comando de calibración descartado: demasiado largo.");
+    }
+}
+
+/** @brief Último comando del ventilador recibido ("AUTO", "ON", "OFF" o "0".."100"). */
+static CommandMailbox<8> coolerCommand;
+
+/**
+ * @brief Se ejecuta cuando un cliente BLE escribe en la característica del ventilador.
+ * @details Guarda el valor escrito para que el bucle principal lo valide y lo
+ * procese. Una escritura vacía o demasiado larga se descarta.
+ * @param context Sin uso.
+ * @param data Bytes escritos por el cliente.
+ * @param len Longitud de `data`.
+ */
+static void onCoolerWrite(void *context, const uint8_t *data, size_t len)
+{
+    if (!coolerCommand.post(data, len))
+    {
+        Serial.println("Comando del cooler descartado: vacío o demasiado largo.");
+    }
+}
+
+/** @brief Último comando de configuración recibido. */
+static CommandMailbox<CONFIG_COMMAND_MAX_LEN> configCommand;
+
+/**
+ * @brief Se ejecuta cuando un cliente BLE escribe en la característica de configuración.
+ * @details Guarda el comando ("CLAVE=valor;..." o "RESET") para que el bucle
+ * principal lo aplique y lo guarde en NVS fuera de la tarea de la pila BLE.
+ * @param context Sin uso.
+ * @param data Bytes escritos por el cliente.
+ * @param len Longitud de `data`.
+ */
+static void onConfigWrite(void *context, const uint8_t *data, size_t len)
+{
+    if (len > CONFIG_COMMAND_MAX_LEN)
+    {
+        Serial.println("Comando de configuración descartado: demasiado largo.");
+        return;
+    }
+    configCommand.post(data, len); // Una escritura vacía no deja comando
+}
+
+/** @brief Registro (desde el más reciente) pedido del historial de calibraciones; -1 = ninguno. */
+static volatile int calHistoryRequest = -1;
+
+/** @brief Longitud máxima de un comando de alarmas ("RULE=..." es el más largo). */
+static const size_t ALARM_COMMAND_MAX_LEN = 64;
+/** @brief Último comando de alarmas recibido. */
+static CommandMailbox<ALARM_COMMAND_MAX_LEN> alarmCommand;
+
+/**
+ * @brief Se ejecuta cuando un cliente BLE escribe en la característica de alarmas.
+ * @details Guarda el comando ("ACK=n", "CLEAR=..." o "RULE=...") para que el
+ * bucle principal lo aplique fuera de la tarea de la pila BLE.
+ * @param context Sin uso.
+ * @param data Bytes escritos por el cliente.
+ * @param len Longitud de `data`.
+ */
+static void onAlarmWrite(void *context, const uint8_t *data, size_t len)
+{
+    if (len > ALARM_COMMAND_MAX_LEN)
+    {
+        Serial.println("Comando de alarmas descartado: demasiado largo.");
+        return;
+    }
+    alarmCommand.post(data, len); // Una escritura vacía no deja comando
+}
+
+/**
+ * @struct TimeSyncPoint
+ * @brief Punto de sincronización recibido: instante local y hora del cliente (µs).
+ */
+struct TimeSyncPoint
+{
+    uint64_t localUs;
+    int64_t wallUs;
+    uint32_t serial; // Número de punto, para no procesar el mismo dos veces
 };
 
-/** @brief Almacena el último comando de calibración recibido. */
-String calibrationCommand = "";
+/**
+ * @brief Último punto de sincronización, escrito por la tarea de la pila BLE.
+ * @details Los dos campos de 64 bits no se copian de una vez: el seqlock evita
+ * que el bucle principal combine el instante de un punto con la hora de otro.
+ */
+static Seqlock<TimeSyncPoint> timeSyncPoint;
+/** @brief Puntos escritos, solo para la tarea de la pila BLE. */
+static uint32_t timeSyncWritten = 0;
+/** @brief Último punto procesado, solo para el bucle principal. */
+static uint32_t timeSyncConsumed = 0;
+
+/**
+ * @brief Se ejecuta cuando un cliente BLE escribe en la característica de sincronización de hora.
+ * @details El cliente escribe su hora de pared en milisegundos desde la época
+ * Unix, en ASCII. El instante local se captura antes de nada para que el
+ * punto no incluya el tiempo de procesado; el bucle principal lo incorpora
+ * al ajuste a través de `getTimeSync()`.
+ * @param context Sin uso.
+ * @param data Bytes escritos por el cliente.
+ * @param len Longitud de `data`.
+ */
+static void onTimeSyncWrite(void *context, const uint8_t *data, size_t len)
+{
+    uint64_t localUs = monotonicMicros();
+    std::string value((const char *)data, len);
+    char *end = nullptr;
+    long long wallMs = strtoll(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || wallMs <= 0)
+    {
+        Serial.println("Hora de sincronización no válida.");
+        return;
+    }
+    TimeSyncPoint point = {localUs, (int64_t)wallMs * 1000, ++timeSyncWritten};
+    timeSyncPoint.write(point);
+}
 
 /**
- * @class MyCharacteristicCallbacks
- * @brief Gestiona los eventos de escritura en la característica de calibración.
+ * @brief Se ejecuta cuando un cliente BLE escribe en la característica del historial de calibraciones.
+ * @details El valor escrito es el número del primer registro a mostrar,
+ * contando desde el más reciente (0 = los últimos). El bucle principal
+ * prepara la página, que el cliente obtiene con una lectura.
+ * @param context Sin uso.
+ * @param data Bytes escritos por el cliente.
+ * @param len Longitud de `data`.
  */
-class MyCharacteristicCallbacks : public BLECharacteristicCallbacks
+static void onCalHistoryWrite(void *context, const uint8_t *data, size_t len)
 {
-    /**
-     * @brief Se ejecuta cuando un cliente BLE escribe en la característica de calibración.
-     * @param pCharacteristic Puntero a la característica que fue escrita.
-     */
-    void onWrite(BLECharacteristic *pCharacteristic)
+    std::string value((const char *)data, len);
+    calHistoryRequest = value.length() > 0 ? atoi(value.c_str()) : 0;
+    if (calHistoryRequest < 0)
     {
-        std::string value = pCharacteristic->getValue();
-        if (value.length() > 0)
+        calHistoryRequest = 0;
+    }
+}
+
+/**
+ * @brief Se ejecuta cuando un cliente BLE escribe en la característica del historial.
+ * @details La escritura de "GET" solicita la descarga completa; el bucle
+ * principal la procesa a través de `getHistoryRequest()`.
+ * @param context Sin uso.
+ * @param data Bytes escritos por el cliente.
+ * @param len Longitud de `data`.
+ */
+static void onHistoryWrite(void *context, const uint8_t *data, size_t len)
+{
+    if (len == 3 && memcmp(data, "GET", 3) == 0)
+    {
+        historyRequest = true;
+        Serial.println("Solicitud de descarga del historial recibida vía BLE.");
+    }
+}
+
+// --- Esquema GATT del servicio principal ---
+
+/**
+ * @struct CharacteristicSources
+ * @brief Valores de una muestra de los que se alimentan las características.
+ * @details Los textos se copian para que el registro pueda compartirse con la
+ * tarea de la pila BLE; si no caben, se truncan.
+ */
+struct CharacteristicSources
+{
+    float temperature;
+    float humidity;
+    float pressure;
+    int co2;
+    char systemState[24];
+    char coolerState[24];
+};
+
+/** @brief Convierte el campo de origen de una característica al texto que lee el cliente. */
+typedef size_t (*CharacteristicEncoder)(const void *field, char *out, size_t len);
+
+/**
+ * @brief Longitud escrita por `snprintf`, limitada al tamaño del buffer.
+ */
+static size_t clampedLength(int written, size_t len)
+{
+    if (written < 0)
+    {
+        return 0;
+    }
+    return (size_t)written < len ? (size_t)written : len - 1;
+}
+
+/** @brief Codifica un `float` con dos decimales, ej. "23.45". */
+static size_t encodeFixed2(const void *field, char *out, size_t len)
+{
+    return clampedLength(snprintf(out, len, "%.2f", *(const float *)field), len);
+}
+
+/** @brief Codifica un `int` en decimal. */
+static size_t encodeInteger(const void *field, char *out, size_t len)
+{
+    return clampedLength(snprintf(out, len, "%d", *(const int *)field), len);
+}
+
+/** @brief Copia un texto terminado en '\0'. */
+static size_t encodeText(const void *field, char *out, size_t len)
+{
+    return clampedLength(snprintf(out, len, "%s", (const char *)field), len);
+}
+
+/**
+ * @struct CharacteristicSpec
+ * @brief Descripción estática de una característica del servicio principal.
+ * @details Las características con NOTIFY o INDICATE reciben su CCCD del
+ * backend. Las que tienen codificador se generan al leerlas a partir de la
+ * última muestra (ver `onSampleRead()`); las demás se actualizan con su
+ * método de BLEManager.
+ */
+struct CharacteristicSpec
+{
+    GattUuid uuid;                // UUID de 128 bits, calculado al compilar
+    uint8_t properties;           // Combinación de `GattProperty`
+    GattWriteHandler onWrite;     // Callback de escritura, o `nullptr`
+    CharacteristicEncoder encode; // Codificador de la muestra, o `nullptr`
+    uint8_t source;               // Desplazamiento del campo en `CharacteristicSources`
+    uint8_t sourceSize;           // Tamaño del campo, para detectar cambios
+    const char *initialValue;     // Valor antes de la primera actualización, o `nullptr`
+};
+
+/** @brief Codificador y campo de origen de una fila de la tabla. */
+#define SOURCE(encoder, field) encoder, offsetof(CharacteristicSources, field), sizeof(CharacteristicSources::field)
+/** @brief Fila sin campo de origen. */
+#define NO_SOURCE nullptr, 0, 0
+
+/** @brief Tabla indexada por `CharacteristicId`, en el orden de registro. */
+static constexpr CharacteristicSpec CHARACTERISTICS[] = {
+    {gattUuid128("beb5483e-36e1-4688-b7f5-ea07361b26a8"), GATT_PROP_READ, nullptr, SOURCE(encodeFixed2, temperature), nullptr},
+    {gattUuid128("cba1d466-344c-4be3-ab3f-189f80dd7518"), GATT_PROP_READ, nullptr, SOURCE(encodeFixed2, pressure), nullptr},
+    {gattUuid128("d2b2d3e1-36e1-4688-b7f5-ea07361b26a8"), GATT_PROP_READ, nullptr, SOURCE(encodeFixed2, humidity), nullptr},
+    {gattUuid128("a1b2c3d4-5678-90ab-cdef-1234567890ab"), GATT_PROP_READ, nullptr, SOURCE(encodeInteger, co2), nullptr},
+    {gattUuid128("12345678-1234-1234-1234-123456789abc"), GATT_PROP_READ | GATT_PROP_WRITE, onCalibrationWrite, NO_SOURCE, "READY"},
+    {gattUuid128("c1a7d131-15e1-413f-b565-8123c5a31a1e"), GATT_PROP_READ, nullptr, SOURCE(encodeText, systemState), "PREHEATING"},
+    {gattUuid128("d2b8d232-26f1-4688-b7f5-ea07361b26a8"), GATT_PROP_READ | GATT_PROP_WRITE, onCoolerWrite, SOURCE(encodeText, coolerState), "OFF"},
+    {gattUuid128("e3c1f7a0-6a2b-4c1e-9d3f-5b8a2c4d6e01"), GATT_PROP_READ, nullptr, NO_SOURCE, nullptr},
+    {gattUuid128("e3c1f7a0-6a2b-4c1e-9d3f-5b8a2c4d6e02"), GATT_PROP_WRITE | GATT_PROP_NOTIFY, onHistoryWrite, NO_SOURCE, nullptr},
+    {gattUuid128("e3c1f7a0-6a2b-4c1e-9d3f-5b8a2c4d6e03"), GATT_PROP_READ, nullptr, NO_SOURCE, "NONE"},
+    {gattUuid128("e3c1f7a0-6a2b-4c1e-9d3f-5b8a2c4d6e04"), GATT_PROP_READ | GATT_PROP_WRITE, onConfigWrite, NO_SOURCE, nullptr},
+    {gattUuid128("e3c1f7a0-6a2b-4c1e-9d3f-5b8a2c4d6e05"), GATT_PROP_READ | GATT_PROP_WRITE, onCalHistoryWrite, NO_SOURCE, nullptr},
+    {gattUuid128("e3c1f7a0-6a2b-4c1e-9d3f-5b8a2c4d6e06"), GATT_PROP_READ, nullptr, NO_SOURCE, "DEW=NA;AH=NA;CO2C=NA;ALT=NA"},
+    {gattUuid128("e3c1f7a0-6a2b-4c1e-9d3f-5b8a2c4d6e07"), GATT_PROP_READ | GATT_PROP_WRITE | GATT_PROP_INDICATE, onAlarmWrite, NO_SOURCE, nullptr},
+    {gattUuid128("e3c1f7a0-6a2b-4c1e-9d3f-5b8a2c4d6e08"), GATT_PROP_READ | GATT_PROP_WRITE, onTimeSyncWrite, NO_SOURCE, "POINTS=0;DRIFT=NA;ERR=NA;PHASE=NA"},
+};
+
+static_assert(sizeof(CHARACTERISTICS) / sizeof(CHARACTERISTICS[0]) == CHARACTERISTIC_COUNT,
+              "CHARACTERISTICS debe tener una fila por cada CharacteristicId");
+
+/**
+ * @brief Comprueba al compilar que todos los UUID de la tabla son válidos y distintos.
+ */
+static constexpr bool characteristicsValid()
+{
+    for (size_t i = 0; i < CHARACTERISTIC_COUNT; i++)
+    {
+        if (CHARACTERISTICS[i].uuid.len != 16 || gattUuidEquals(CHARACTERISTICS[i].uuid, SERVICE_UUID))
         {
-            calibrationCommand = ""; // Limpia el comando anterior.
-            for (int i = 0; i < value.length(); i++)
+            return false;
+        }
+        for (size_t j = 0; j < i; j++)
+        {
+            if (gattUuidEquals(CHARACTERISTICS[i].uuid, CHARACTERISTICS[j].uuid))
             {
-                calibrationCommand += value[i];
+                return false;
             }
-            Serial.print("Comando de calibración recibido: ");
-            Serial.println(calibrationCommand);
         }
     }
+    return true;
+}
+
+static_assert(characteristicsValid(), "UUID mal formado o repetido en CHARACTERISTICS");
+
+// --- Última muestra, compartida con la tarea de la pila BLE ---
+
+/**
+ * @struct SampleSnapshot
+ * @brief Última muestra publicada y la generación del campo de cada característica.
+ * @details La generación de una característica solo avanza cuando cambia su
+ * campo de origen, así que el texto codificado puede reutilizarse mientras no
+ * cambie.
+ */
+struct SampleSnapshot
+{
+    CharacteristicSources sources;
+    uint32_t generations[CHARACTERISTIC_COUNT];
 };
 
 /**
- * @class CoolerCharacteristicCallbacks
- * @brief Gestiona los eventos de escritura en la característica del ventilador.
+ * @struct EncodedValue
+ * @brief Texto codificado de una característica y la generación de la que procede.
  */
-class CoolerCharacteristicCallbacks : public BLECharacteristicCallbacks
+struct EncodedValue
 {
-    /**
-     * @brief Se ejecuta cuando un cliente BLE escribe en la característica del ventilador.
-     * @details Cualquier escritura activa el flag `toggleCoolerRequest` para que
-     * el bucle principal procese la solicitud de cambio de estado.
-     * @param pCharacteristic Puntero a la característica que fue escrita.
-     */
-    void onWrite(BLECharacteristic *pCharacteristic)
+    uint32_t generation;
+    uint8_t len;
+    char text[31];
+};
+
+/** @brief Muestra publicada por el bucle principal; la leen los callbacks de lectura. */
+static Seqlock<SampleSnapshot> sampleSnapshot;
+/** @brief Copia de la última muestra publicada, solo para el escritor. */
+static SampleSnapshot publishedSample = {};
+/** @brief Si ya se publicó alguna muestra, solo para el escritor. */
+static bool samplePublished = false;
+/** @brief Textos codificados, solo para la tarea de la pila BLE. */
+static EncodedValue encodedValues[CHARACTERISTIC_COUNT];
+
+/**
+ * @brief Genera el valor de una característica de la muestra cuando el cliente la lee.
+ * @details Lee la muestra del seqlock sin bloquear al bucle principal y solo
+ * vuelve a codificar si la generación del campo cambió. Si el bucle principal
+ * está justo publicando y no se consigue una copia coherente, se responde con
+ * el último texto codificado.
+ * @param context Índice de la característica (`CharacteristicId`).
+ * @param out Buffer de salida.
+ * @param maxLen Tamaño de `out`.
+ * @return size_t Longitud del valor.
+ */
+static size_t onSampleRead(void *context, uint8_t *out, size_t maxLen)
+{
+    size_t index = (size_t)(uintptr_t)context;
+    EncodedValue &cached = encodedValues[index];
+
+    SampleSnapshot snapshot;
+    if (sampleSnapshot.read(snapshot) && snapshot.generations[index] != cached.generation)
     {
-        toggleCoolerRequest = true;
-        Serial.println("Solicitud para alternar el estado del cooler recibida vía BLE.");
+        const CharacteristicSpec &spec = CHARACTERISTICS[index];
+        cached.len = spec.encode((const uint8_t *)&snapshot.sources + spec.source, cached.text, sizeof(cached.text));
+        cached.generation = snapshot.generations[index];
     }
-};
+    size_t len = cached.len < maxLen ? cached.len : maxLen;
+    memcpy(out, cached.text, len);
+    return len;
+}
 
 /**
  * @brief Constructor de la clase BLEManager.
- * @details Inicializa todos los punteros de objetos BLE a `nullptr`.
+ * @details Deja todas las características sin crear (`GATT_INVALID_HANDLE`).
  */
 BLEManager::BLEManager()
 {
-    pServer = nullptr;
-    pCharacteristicTemp = nullptr;
-    pCharacteristicPres = nullptr;
-    pCharacteristicHum = nullptr;
-    pCharacteristicCO2 = nullptr;
-    pCharacteristicCalibrate = nullptr;
-    pCharacteristicSystemState = nullptr;
-    pCharacteristicCoolerState = nullptr;
+    gatt = &gattServer();
+    for (uint8_t i = 0; i < CHARACTERISTIC_COUNT; i++)
+    {
+        handles[i] = GATT_INVALID_HANDLE;
+    }
 }
 
 /**
  * @brief Inicializa y configura el servidor BLE.
- * @details Crea el dispositivo BLE, el servidor, el servicio y todas las
- * características con sus propiedades y callbacks correspondientes.
- * Finalmente, inicia la publicidad BLE.
+ * @details Inicializa la pila elegida al compilar (ver GattServer.h), crea el
+ * servicio y todas las características con sus propiedades y callbacks
+ * correspondientes, e inicia la publicidad BLE. Mide el tiempo de
+ * inicialización y el heap libre resultante para compararlas entre pilas.
+ * @param deviceName Nombre con el que se anuncia el dispositivo.
  */
-void BLEManager::init()
+void BLEManager::init(const char *deviceName)
 {
-    BLEDevice::init("SRV_NAME");
-
-    pServer = BLEDevice::createServer();
-    pServer->setCallbacks(new MyServerCallbacks());
+    unsigned long initStart = millis();
+    advertisedName = deviceName;
+    gatt->begin(deviceName, onGattEvent);
 
-    BLEService *pService = pServer->createService(SERVICE_UUID);
+    // Cada característica ocupa 2 handles (3 con descriptor); el valor por
+    // defecto de 15 handles no alcanza para todas las características.
+    gatt->beginService(SERVICE_UUID, SERVICE_NUM_HANDLES);
 
     // --- Creación de Características ---
-    pCharacteristicTemp = pService->createCharacteristic(CHARACTERISTIC_UUID_TMP, BLECharacteristic::PROPERTY_READ);
-    pCharacteristicPres = pService->createCharacteristic(CHARACTERISTIC_UUID_PRES, BLECharacteristic::PROPERTY_READ);
-    pCharacteristicHum = pService->createCharacteristic(CHARACTERISTIC_UUID_HUM, BLECharacteristic::PROPERTY_READ);
-    pCharacteristicCO2 = pService->createCharacteristic(CHARACTERISTIC_UUID_CO2, BLECharacteristic::PROPERTY_READ);
-
-    pCharacteristicCalibrate = pService->createCharacteristic(CHARACTERISTIC_UUID_CALIBRATE, BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_WRITE);
-    pCharacteristicCalibrate->setCallbacks(new MyCharacteristicCallbacks());
-    pCharacteristicCalibrate->setValue("READY");
-
-    pCharacteristicSystemState = pService->createCharacteristic(CHARACTERISTIC_UUID_SYSTEM_STATE, BLECharacteristic::PROPERTY_READ);
-    pCharacteristicSystemState->setValue("PREHEATING");
+    for (uint8_t i = 0; i < CHARACTERISTIC_COUNT; i++)
+    {
+        const CharacteristicSpec &spec = CHARACTERISTICS[i];
+        handles[i] = gatt->addCharacteristic(spec.uuid, spec.properties, spec.onWrite);
+        if (spec.initialValue != nullptr)
+        {
+            gatt->setValue(handles[i], spec.initialValue);
+        }
+        if (spec.encode != nullptr)
+        {
+            // Hasta la primera muestra se lee el valor inicial (generación 0).
+            encodedValues[i].generation = 0;
+            encodedValues[i].len = (uint8_t)snprintf(encodedValues[i].text, sizeof(encodedValues[i].text), "%s",
+                                                     spec.initialValue != nullptr ? spec.initialValue : "");
+            gatt->setReadHandler(handles[i], onSampleRead, (void *)(uintptr_t)i);
+        }
+    }
 
-    pCharacteristicCoolerState = pService->createCharacteristic(CHARACTERISTIC_UUID_COOLER_STATE, BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_WRITE);
-    pCharacteristicCoolerState->setCallbacks(new CoolerCharacteristicCallbacks());
-    pCharacteristicCoolerState->setValue("OFF");
+    gatt->endService();
 
-    pService->start();
+    // --- Servicio estándar Environmental Sensing (0x181A) ---
+    environmentalSensing.init(*gatt);
 
     // --- Configuración de la Publicidad (Advertising) ---
-    BLEAdvertising *pAdvertising = BLEDevice::getAdvertising();
-    BLEAdvertisementData advertisementData;
-    advertisementData.setName("SRV_NAME");
-    advertisementData.setFlags(0x06); // General Discoverable Mode
-    pAdvertising->setAdvertisementData(advertisementData);
-
-    BLEAdvertisementData scanResponseData;
-    scanResponseData.setCompleteServices(pService->getUUID());
-    pAdvertising->setScanResponseData(scanResponseData);
+    setAdvertisementPayload(nullptr, 0);
+    gatt->setScanResponseServices(SCAN_RESPONSE_SERVICES, sizeof(SCAN_RESPONSE_SERVICES) / sizeof(SCAN_RESPONSE_SERVICES[0]));
+    gatt->startAdvertising(true);
 
-    BLEDevice::startAdvertising();
-    Serial.println("Servidor BLE iniciado y publicitando...");
+    // --- Coste de la pila ---
+    stackInitMs = millis() - initStart;
+    stackFreeHeap = ESP.getFreeHeap();
+    updateDiagnostics();
+    Serial.printf("Servidor BLE (%s) iniciado y publicitando en %lu ms; heap libre %lu B, firmware %lu B de %lu B de flash.\n",
+                  gatt->name(), (unsigned long)stackInitMs, (unsigned long)stackFreeHeap,
+                  (unsigned long)ESP.getSketchSize(), (unsigned long)ESP.getFlashChipSize());
 }
 
 /**
- * @brief Actualiza los valores de todas las características BLE.
- * @details Si un dispositivo está conectado, convierte los datos de los sensores
- * y los estados del sistema a strings y los asigna a sus características
- * correspondientes.
+ * @brief Publica una muestra nueva para las características BLE.
+ * @details La muestra se publica siempre en el seqlock, sin codificar nada:
+ * las características se generan cuando el cliente las lee. Para cada fila de
+ * `CHARACTERISTICS` con codificador se avanza su generación solo si su campo
+ * cambió, o siempre en la primera muestra. El diagnóstico y el servicio ESS solo se refrescan si hay un
+ * cliente conectado.
  * @param temp Temperatura actual.
  * @param hum Humedad actual.
  * @param pres Presión actual.
  * @param co2 Concentración de CO2 actual.
  * @param systemStatus Estado actual del sistema (ej. "PREHEATING").
- * @param coolerStatus Estado actual del ventilador (ej. "ON").
+ * @param coolerStatus Estado actual del ventilador (ej. "AUTO 45%").
  */
 void BLEManager::updateSensorValues(float temp, float hum, float pres, int co2, String systemStatus, String coolerStatus)
 {
+    SampleSnapshot next = {};
+    next.sources.temperature = temp;
+    next.sources.humidity = hum;
+    next.sources.pressure = pres;
+    next.sources.co2 = co2;
+    snprintf(next.sources.systemState, sizeof(next.sources.systemState), "%s", systemStatus.c_str());
+    snprintf(next.sources.coolerState, sizeof(next.sources.coolerState), "%s", coolerStatus.c_str());
+
+    const uint8_t *current = (const uint8_t *)&next.sources;
+    const uint8_t *previous = (const uint8_t *)&publishedSample.sources;
+    for (uint8_t i = 0; i < CHARACTERISTIC_COUNT; i++)
+    {
+        const CharacteristicSpec &spec = CHARACTERISTICS[i];
+        next.generations[i] = publishedSample.generations[i];
+        // La primera muestra siempre avanza la generación: un campo que vale
+        // todo ceros no se distinguiría de la muestra inicial vacía.
+        if (spec.encode != nullptr &&
+            (!samplePublished || memcmp(current + spec.source, previous + spec.source, spec.sourceSize) != 0))
+        {
+            next.generations[i]++;
+        }
+    }
+    sampleSnapshot.write(next);
+    publishedSample = next;
+    samplePublished = true;
+
     if (deviceConnected)
     {
-        String tempStr = String(temp, 2);
-        String presStr = String(pres, 2);
-        String humStr = String(hum, 2);
-        String co2Str = String(co2);
+        updateDiagnostics();
+
+        // Las características binarias estándar deciden por sí mismas si notificar.
+        environmentalSensing.update(temp, hum, pres);
+    }
+}
+
+/**
+ * @brief Obtiene el último comando del ventilador recibido.
+ * @details Devuelve el comando y lo limpia para evitar procesarlo múltiples veces.
+ * @return String El comando del ventilador, o un string vacío si no hay ninguno nuevo.
+ */
+String BLEManager::getCoolerCommand()
+{
+    CommandMailbox<8>::Buffer cmd;
+    return coolerCommand.take(cmd) ? String(cmd) : String("");
+}
+
+/**
+ * @brief Cambia el perfil de parámetros de conexión.
+ * @details Si hay un cliente conectado y el perfil cambia, solicita de inmediato
+ * la actualización de parámetros. Si no hay cliente, el perfil se aplicará
+ * en la próxima conexión.
+ * @param profile Nuevo perfil (`PROFILE_STEADY` o `PROFILE_BULK`).
+ */
+void BLEManager::setConnectionProfile(ConnectionProfile profile)
+{
+    if (profile == currentProfile)
+    {
+        return;
+    }
+    currentProfile = profile;
+    Serial.printf("Perfil de conexión cambiado a %s.\n", profile == PROFILE_BULK ? "BULK" : "STEADY");
+    if (deviceConnected)
+    {
+        requestConnectionParams(profile);
+    }
+}
+
+/**
+ * @brief Obtiene el perfil de parámetros de conexión solicitado actualmente.
+ * @return ConnectionProfile El perfil activo.
+ */
+ConnectionProfile BLEManager::getConnectionProfile()
+{
+    return currentProfile;
+}
+
+/**
+ * @brief Actualiza la característica de diagnóstico.
+ * @details Publica el perfil solicitado y los parámetros de conexión realmente
+ * acordados con el cliente, en el formato
+ * `PROFILE=STEADY;INT=187.50ms;LAT=4;TO=6000ms`, seguidos de la pila BLE en
+ * uso, su tiempo de inicialización y el heap libre tras inicializarla.
+ */
+void BLEManager::updateDiagnostics()
+{
+    GattConnectionParams achieved;
+    gatt->getConnectionParams(achieved);
+
+    char diag[176];
+    snprintf(diag, sizeof(diag), "PROFILE=%s;INT=%.2fms;LAT=%u;TO=%ums;FAULTS=0x%02X;TTFA=%lums;TTFS=%lums;STACK=%s;INIT=%lums;HEAP=%lu",
+             currentProfile == PROFILE_BULK ? "BULK" : "STEADY",
+             achieved.maxInterval * 1.25f,
+             (unsigned)achieved.latency,
+             (unsigned)achieved.timeout * 10,
+             (unsigned)sensorFaults,
+             (unsigned long)bootTtfaMs,
+             (unsigned long)bootTtfsMs,
+             gatt->name(),
+             (unsigned long)stackInitMs,
+             (unsigned long)stackFreeHeap);
+    gatt->setValue(handles[CHARACTERISTIC_DIAGNOSTICS], diag);
+}
+
+/**
+ * @brief Publica qué sensores están en fallo.
+ * @details Solo refresca la característica de diagnóstico si la máscara cambió.
+ * @param faultMask Bit `1 << SensorKind` activo para cada sensor en fallo.
+ */
+void BLEManager::setSensorFaults(uint8_t faultMask)
+{
+    if (faultMask != sensorFaults)
+    {
+        sensorFaults = faultMask;
+        updateDiagnostics();
+    }
+}
+
+/**
+ * @brief Publica los tiempos de arranque en la característica de diagnóstico.
+ * @param ttfaMs Milisegundos desde el arranque hasta la primera publicidad.
+ * @param ttfsMs Milisegundos desde el arranque hasta la primera muestra válida (0 si aún no hay).
+ */
+void BLEManager::setBootMetrics(uint32_t ttfaMs, uint32_t ttfsMs)
+{
+    bootTtfaMs = ttfaMs;
+    bootTtfsMs = ttfsMs;
+    updateDiagnostics();
+}
+
+/**
+ * @brief Obtiene el último comando de configuración recibido.
+ * @details Devuelve el comando y lo limpia para evitar procesarlo múltiples veces.
+ * @return String El comando, o un string vacío si no hay ninguno nuevo.
+ */
+String BLEManager::getConfigCommand()
+{
+    CommandMailbox<CONFIG_COMMAND_MAX_LEN>::Buffer cmd;
+    return configCommand.take(cmd) ? String(cmd) : String("");
+}
+
+/**
+ * @brief Publica la configuración actual en su característica.
+ * @param config Configuración en texto, ej. "UPDATE_MS=500;...;NAME=SRV_NAME".
+ */
+void BLEManager::setConfigValue(const char *config)
+{
+    gatt->setValue(handles[CHARACTERISTIC_CONFIG], config);
+}
+
+/**
+ * @brief Obtiene la última consulta del historial de calibraciones.
+ * @details Devuelve la consulta y la limpia para evitar procesarla múltiples veces.
+ * @return int Primer registro pedido (0 = el más reciente), o -1 si no hay consulta nueva.
+ */
+int BLEManager::getCalibrationHistoryRequest()
+{
+    int request = calHistoryRequest;
+    calHistoryRequest = -1;
+    return request;
+}
+
+/**
+ * @brief Publica una página del historial de calibraciones.
+ * @param history Texto de la página (ver CalibrationLog::describe()).
+ */
+void BLEManager::setCalibrationHistory(const char *history)
+{
+    gatt->setValue(handles[CHARACTERISTIC_CAL_HISTORY], history);
+}
+
+/**
+ * @brief Publica las magnitudes derivadas de la última muestra.
+ * @param derived Texto de las magnitudes (ver DerivedMetrics::describe()).
+ */
+void BLEManager::setDerivedMetrics(const char *derived)
+{
+    gatt->setValue(handles[CHARACTERISTIC_DERIVED], derived);
+}
+
+/**
+ * @brief Obtiene el último comando de alarmas recibido.
+ * @details Devuelve el comando y lo limpia para evitar procesarlo múltiples veces.
+ * @return String El comando, o un string vacío si no hay ninguno nuevo.
+ */
+String BLEManager::getAlarmCommand()
+{
+    CommandMailbox<ALARM_COMMAND_MAX_LEN>::Buffer cmd;
+    return alarmCommand.take(cmd) ? String(cmd) : String("");
+}
+
+/**
+ * @brief Envía una transición de alarma como indicación.
+ * @details La pila espera la confirmación de la indicación; la confirmación
+ * de la aplicación ("ACK=n") la escribe el cliente después.
+ * @param event Texto de la transición (ver AlarmLog::describe()).
+ * @return bool `false` si no hay cliente conectado.
+ */
+bool BLEManager::indicateAlarm(const char *event)
+{
+    if (!deviceConnected)
+    {
+        return false;
+    }
+    gatt->setValue(handles[CHARACTERISTIC_ALARMS], event);
+    gatt->indicate(handles[CHARACTERISTIC_ALARMS]);
+    return true;
+}
 
-        pCharacteristicTemp->setValue(tempStr.c_str());
-        pCharacteristicPres->setValue(presStr.c_str());
-        pCharacteristicHum->setValue(humStr.c_str());
-        pCharacteristicCO2->setValue(co2Str.c_str());
-        pCharacteristicSystemState->setValue(systemStatus.c_str());
-        pCharacteristicCoolerState->setValue(coolerStatus.c_str());
+/**
+ * @brief Publica el estado de las alarmas para las lecturas.
+ * @param status Texto del estado (ver AlarmManager::describeStatus()).
+ */
+void BLEManager::setAlarmStatus(const char *status)
+{
+    gatt->setValue(handles[CHARACTERISTIC_ALARMS], status);
+}
+
+/**
+ * @brief Obtiene el último punto de sincronización de hora recibido.
+ * @details Lo marca como procesado para no añadirlo dos veces al ajuste. Si
+ * la tarea de la pila BLE está escribiendo otro punto justo entonces, se
+ * recoge en la siguiente vuelta del bucle.
+ * @param localUs Instante local (`monotonicMicros()`) de la escritura.
+ * @param wallUs Hora de pared del cliente, en µs desde la época Unix.
+ * @return bool `true` si había un punto nuevo.
+ */
+bool BLEManager::getTimeSync(uint64_t &localUs, int64_t &wallUs)
+{
+    TimeSyncPoint point;
+    if (!timeSyncPoint.read(point) || point.serial == timeSyncConsumed)
+    {
+        return false;
     }
+    timeSyncConsumed = point.serial;
+    localUs = point.localUs;
+    wallUs = point.wallUs;
+    return true;
+}
+
+/**
+ * @brief Publica el estado de la sincronización de hora.
+ * @param status Texto del estado (ver ClockSync::describe()).
+ */
+void BLEManager::setTimeSyncStatus(const char *status)
+{
+    gatt->setValue(handles[CHARACTERISTIC_TIME_SYNC], status);
+}
+
+/**
+ * @brief Publica el inventario del bus I2C.
+ * @param inventory Descripción del inventario, ej. "0x76=BMP280;0x3C=UNKNOWN".
+ */
+void BLEManager::setI2CInventory(const String &inventory)
+{
+    gatt->setValue(handles[CHARACTERISTIC_I2C_INVENTORY], inventory.c_str());
 }
 
 /**
@@ -237,11 +834,114 @@ bool BLEManager::isDeviceConnected()
  */
 String BLEManager::getCalibrationCommand()
 {
-    if (calibrationCommand != "")
+    CommandMailbox<CALIBRATION_COMMAND_MAX_LEN>::Buffer cmd;
+    return calibrationCommand.take(cmd) ? String(cmd) : String("");
+}
+
+/**
+ * @brief Activa o desactiva el modo de difusión sin conexión.
+ * @details En modo difusión las lecturas se codifican en los datos de fabricante
+ * de la publicidad, de modo que un escáner puede recogerlas sin conectarse.
+ * Las características GATT siguen disponibles para enviar comandos.
+ * @param enabled `true` para difundir las lecturas, `false` para publicidad normal.
+ */
+void BLEManager::setBroadcastEnabled(bool enabled)
+{
+    broadcastEnabled = enabled;
+    if (!enabled)
     {
-        String cmd = calibrationCommand;
-        calibrationCommand = ""; // Resetea el comando una vez leído.
-        return cmd;
+        setAdvertisementPayload(nullptr, 0);
     }
-    return "";
+    Serial.printf("Modo difusión %s.\n", enabled ? "activado" : "desactivado");
+}
+
+/**
+ * @brief Refresca los datos de publicidad con las últimas lecturas.
+ * @details Debe llamarse en cada muestra, haya o no un cliente conectado.
+ * No hace nada si el modo difusión está desactivado. Los valores negativos
+ * (usados como marca de error por SensorManager) se difunden como inválidos.
+ * @param temp Temperatura actual.
+ * @param hum Humedad actual.
+ * @param pres Presión actual.
+ * @param co2 Concentración de CO2 actual.
+ * @param state Estado del sensor de CO2 (valor de `SensorState`).
+ * @param fanOn Estado actual del ventilador.
+ */
+void BLEManager::updateBroadcast(float temp, float hum, float pres, int co2, int state, bool fanOn)
+{
+    if (!broadcastEnabled)
+    {
+        return;
+    }
+
+    BroadcastReading reading;
+    reading.counter = broadcastCounter++;
+    reading.temperature = temp;
+    reading.humidity = hum;
+    reading.pressure = pres;
+    reading.co2 = co2;
+    reading.state = (uint8_t)state;
+    reading.fanOn = fanOn;
+    // El DHT22 marca temperatura y humedad con -1 a la vez cuando falla.
+    reading.tempValid = hum >= 0;
+    reading.humValid = hum >= 0;
+    reading.presValid = pres >= 0;
+    reading.co2Valid = co2 >= 0;
+
+    uint8_t payload[BROADCAST_PAYLOAD_LEN];
+    size_t len = encodeBroadcastPayload(reading, payload);
+    setAdvertisementPayload(payload, len);
+}
+
+/**
+ * @brief Obtiene y limpia la petición de descarga del historial.
+ * @return bool `true` si el cliente escribió "GET" desde la última consulta.
+ */
+bool BLEManager::getHistoryRequest()
+{
+    if (historyRequest)
+    {
+        historyRequest = false;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Envía un fragmento del historial como notificación.
+ * @details Un fragmento de longitud 0 marca el final de la descarga.
+ * @param data Bytes del fragmento.
+ * @param len Longitud del fragmento (como mucho `getMaxNotifySize()`).
+ * @return bool `false` si no hay ningún cliente conectado.
+ */
+bool BLEManager::sendHistoryChunk(const uint8_t *data, size_t len)
+{
+    if (!deviceConnected)
+    {
+        return false;
+    }
+    gatt->setValue(handles[CHARACTERISTIC_HISTORY], data, len);
+    gatt->notify(handles[CHARACTERISTIC_HISTORY]);
+    return true;
+}
+
+/**
+ * @brief UUID de una característica del servicio principal.
+ * @details Para los clientes que la direccionan por su `CharacteristicId`,
+ * como la simulación en el host, sin repetir la tabla `CHARACTERISTICS`.
+ * @param id Característica.
+ */
+GattUuid BLEManager::characteristicUuid(CharacteristicId id)
+{
+    return CHARACTERISTICS[id].uuid;
+}
+
+/**
+ * @brief Calcula el tamaño máximo de una notificación con el MTU negociado.
+ * @return size_t MTU del cliente menos los 3 bytes de cabecera ATT.
+ */
+size_t BLEManager::getMaxNotifySize()
+{
+    uint16_t mtu = gatt->getPeerMtu();
+    return mtu > 23 ? mtu - 3 : 20;
 }
@@ -0,0 +1,383 @@
+/**
+ * @file BluedroidGattServer.cpp
+ * @brief Implementación del servidor GATT sobre el wrapper Bluedroid de Arduino.
+ * @details Solo se compila con `-D GATT_BACKEND_BLUEDROID`.
+ */
+
+#include "BluedroidGattServer.h"
+#include "BroadcastPayload.h"
+
+#if defined(GATT_BACKEND_BLUEDROID) && !defined(NODE_SIMULATION)
+
+// --- Estado compartido con las callbacks de la pila ---
+
+/** @brief Propietario de los eventos de conexión. */
+static GattEventHandler eventHandler = nullptr;
+/** @brief Si hay un cliente conectado. */
+static volatile bool connected = false;
+/** @brief Dirección del cliente conectado, necesaria para solicitar parámetros de conexión. */
+static esp_bd_addr_t connectedPeerAddress;
+
+// --- Parámetros de conexión obtenidos (los escribe el manejador GAP) ---
+/** @brief Intervalo de conexión acordado, en unidades de 1.25 ms (0 = desconocido). */
+static volatile uint16_t achievedInterval = 0;
+/** @brief Latencia de esclavo acordada, en eventos de conexión. */
+static volatile uint16_t achievedLatency = 0;
+/** @brief Timeout de supervisión acordado, en unidades de 10 ms. */
+static volatile uint16_t achievedTimeout = 0;
+
+/**
+ * @brief Manejador de eventos GAP adicional al de la librería.
+ * @details Registra los parámetros de conexión que realmente se acordaron con
+ * el cliente, que pueden diferir de los solicitados.
+ * @param event Tipo de evento GAP.
+ * @param param Datos asociados al evento.
+ */
+static void gapEventHandler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param)
+{
+    if (event == ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT && param->update_conn_params.status == ESP_BT_STATUS_SUCCESS)
+    {
+        achievedInterval = param->update_conn_params.conn_int;
+        achievedLatency = param->update_conn_params.latency;
+        achievedTimeout = param->update_conn_params.timeout;
+    }
+}
+
+/**
+ * @class BluedroidServerCallbacks
+ * @brief Traduce las conexiones y desconexiones a eventos de la fachada.
+ */
+class BluedroidServerCallbacks : public BLEServerCallbacks
+{
+    void onConnect(BLEServer *pServer, esp_ble_gatts_cb_param_t *param)
+    {
+        memcpy(connectedPeerAddress, param->connect.remote_bda, sizeof(esp_bd_addr_t));
+        connected = true;
+        eventHandler(GATT_EVENT_CONNECT);
+    }
+
+    void onDisconnect(BLEServer *pServer)
+    {
+        connected = false;
+        achievedInterval = 0;
+        achievedLatency = 0;
+        achievedTimeout = 0;
+        eventHandler(GATT_EVENT_DISCONNECT);
+    }
+};
+
+/**
+ * @class BluedroidCharacteristicCallbacks
+ * @brief Entrega las escrituras y lecturas de una característica a sus callbacks de la fachada.
+ */
+class BluedroidCharacteristicCallbacks : public BLECharacteristicCallbacks
+{
+public:
+    GattWriteHandler writeHandler = nullptr;
+    void *writeContext = nullptr;
+    GattReadHandler readHandler = nullptr;
+    void *readContext = nullptr;
+
+    void onWrite(BLECharacteristic *pCharacteristic)
+    {
+        if (writeHandler != nullptr)
+        {
+            std::string value = pCharacteristic->getValue();
+            writeHandler(writeContext, (const uint8_t *)value.data(), value.length());
+        }
+    }
+
+    /**
+     * @brief Genera el valor justo antes de que la pila responda a la lectura.
+     */
+    void onRead(BLECharacteristic *pCharacteristic)
+    {
+        if (readHandler != nullptr)
+        {
+            uint8_t buffer[GATT_READ_BUFFER_LEN];
+            size_t len = readHandler(readContext, buffer, sizeof(buffer));
+            pCharacteristic->setValue(buffer, len);
+        }
+    }
+};
+
+/**
+ * @class BluedroidDescriptorCallbacks
+ * @brief Entrega las escrituras de un descriptor a su `GattWriteHandler`.
+ */
+class BluedroidDescriptorCallbacks : public BLEDescriptorCallbacks
+{
+public:
+    BluedroidDescriptorCallbacks(GattWriteHandler handler, void *context) : handler(handler), context(context) {}
+
+    void onWrite(BLEDescriptor *pDescriptor)
+    {
+        handler(context, pDescriptor->getValue(), pDescriptor->getLength());
+    }
+
+private:
+    GattWriteHandler handler;
+    void *context;
+};
+
+/**
+ * @brief Convierte un UUID de la fachada al tipo de la librería.
+ * @details Ambos guardan los bytes en little-endian: no se interpreta texto.
+ */
+static BLEUUID toBLEUUID(const GattUuid &uuid)
+{
+    if (uuid.len == 2)
+    {
+        return BLEUUID((uint16_t)(uuid.bytes[0] | (uuid.bytes[1] << 8)));
+    }
+    return BLEUUID((uint8_t *)uuid.bytes, 16, false);
+}
+
+/**
+ * @brief Constructor de la clase BluedroidGattServer.
+ */
+BluedroidGattServer::BluedroidGattServer()
+{
+    server = nullptr;
+    service = nullptr;
+    characteristic_count = 0;
+}
+
+/**
+ * @brief Inicializa la pila Bluedroid y crea el servidor.
+ * @param deviceName Nombre del dispositivo.
+ * @param onEvent Receptor de los eventos de conexión.
+ */
+bool BluedroidGattServer::begin(const char *deviceName, GattEventHandler onEvent)
+{
+    eventHandler = onEvent;
+    BLEDevice::setCustomGapHandler(gapEventHandler);
+    BLEDevice::init(deviceName);
+    server = BLEDevice::createServer();
+    server->setCallbacks(new BluedroidServerCallbacks());
+    return server != nullptr;
+}
+
+/**
+ * @brief Empieza un servicio nuevo.
+ * @param uuid UUID del servicio.
+ * @param numHandles Handles reservados: cada característica ocupa 2 (más uno
+ * por descriptor); el valor por defecto de la librería (15) es escaso.
+ */
+void BluedroidGattServer::beginService(const GattUuid &uuid, uint16_t numHandles)
+{
+    service = server->createService(toBLEUUID(uuid), numHandles);
+}
+
+/**
+ * @brief Añade una característica al servicio en construcción.
+ * @return GattHandle Identificador, o `GATT_INVALID_HANDLE` si no caben más.
+ */
+GattHandle BluedroidGattServer::addCharacteristic(const GattUuid &uuid, uint8_t properties, GattWriteHandler onWrite, void *context)
+{
+    if (characteristic_count >= MAX_CHARACTERISTICS)
+    {
+        return GATT_INVALID_HANDLE;
+    }
+    uint32_t bluedroidProperties = 0;
+    bluedroidProperties |= (properties & GATT_PROP_READ) ? BLECharacteristic::PROPERTY_READ : 0;
+    bluedroidProperties |= (properties & GATT_PROP_WRITE) ? BLECharacteristic::PROPERTY_WRITE : 0;
+    bluedroidProperties |= (properties & GATT_PROP_NOTIFY) ? BLECharacteristic::PROPERTY_NOTIFY : 0;
+    bluedroidProperties |= (properties & GATT_PROP_INDICATE) ? BLECharacteristic::PROPERTY_INDICATE : 0;
+
+    BLECharacteristic *characteristic = service->createCharacteristic(toBLEUUID(uuid), bluedroidProperties);
+    if (properties & (GATT_PROP_NOTIFY | GATT_PROP_INDICATE))
+    {
+        characteristic->addDescriptor(new BLE2902());
+    }
+    characteristics[characteristic_count] = characteristic;
+    callbacks[characteristic_count] = nullptr;
+    if (onWrite != nullptr)
+    {
+        BluedroidCharacteristicCallbacks *handlers = callbacksFor(characteristic_count);
+        handlers->writeHandler = onWrite;
+        handlers->writeContext = context;
+    }
+    return characteristic_count++;
+}
+
+/**
+ * @brief Añade un descriptor a una característica.
+ * @param characteristic Característica propietaria.
+ * @param uuid UUID del descriptor.
+ * @param value Valor inicial.
+ * @param len Longitud de `value`.
+ * @param maxLen Longitud máxima que puede escribir el cliente.
+ * @param onWrite Callback de escritura, o `nullptr` si es de solo lectura.
+ * @param context Argumento de `onWrite`.
+ */
+void BluedroidGattServer::addDescriptor(GattHandle characteristic, const GattUuid &uuid, const uint8_t *value, size_t len,
+                                        size_t maxLen, GattWriteHandler onWrite, void *context)
+{
+    if (characteristic < 0 || characteristic >= characteristic_count)
+    {
+        return;
+    }
+    BLEDescriptor *descriptor = new BLEDescriptor(toBLEUUID(uuid), maxLen);
+    descriptor->setValue((uint8_t *)value, len);
+    if (onWrite != nullptr)
+    {
+        descriptor->setCallbacks(new BluedroidDescriptorCallbacks(onWrite, context));
+    }
+    characteristics[characteristic]->addDescriptor(descriptor);
+}
+
+/**
+ * @brief Hace que el valor de una característica se genere en cada lectura del cliente.
+ * @param handle Característica.
+ * @param onRead Callback que produce el valor.
+ * @param context Argumento de `onRead`.
+ */
+void BluedroidGattServer::setReadHandler(GattHandle handle, GattReadHandler onRead, void *context)
+{
+    if (handle < 0 || handle >= characteristic_count)
+    {
+        return;
+    }
+    BluedroidCharacteristicCallbacks *handlers = callbacksFor(handle);
+    handlers->readHandler = onRead;
+    handlers->readContext = context;
+}
+
+/**
+ * @brief Callbacks de una característica, creados y registrados la primera vez.
+ */
+BluedroidCharacteristicCallbacks *BluedroidGattServer::callbacksFor(GattHandle handle)
+{
+    if (callbacks[handle] == nullptr)
+    {
+        callbacks[handle] = new BluedroidCharacteristicCallbacks();
+        characteristics[handle]->setCallbacks(callbacks[handle]);
+    }
+    return callbacks[handle];
+}
+
+/**
+ * @brief Arranca el servicio en construcción.
+ */
+void BluedroidGattServer::endService()
+{
+    service->start();
+    service = nullptr;
+}
+
+/**
+ * @brief Cambia el valor de una característica.
+ */
+void BluedroidGattServer::setValue(GattHandle handle, const uint8_t *data, size_t len)
+{
+    characteristics[handle]->setValue((uint8_t *)data, len);
+}
+
+/**
+ * @brief Notifica el valor actual de una característica.
+ */
+void BluedroidGattServer::notify(GattHandle handle)
+{
+    characteristics[handle]->notify();
+}
+
+/**
+ * @brief Indica el valor actual de una característica.
+ */
+void BluedroidGattServer::indicate(GattHandle handle)
+{
+    characteristics[handle]->indicate();
+}
+
+/**
+ * @brief Configura los datos de publicidad principales.
+ * @details Flags, nombre y, si se pasa, el payload de fabricante. El paquete lo
+ * arma `buildAdvertisingData()`, que recorta el nombre para no pasar de 31
+ * bytes: la pila rechazaría el paquete entero y el nodo dejaría de publicitar.
+ */
+void BluedroidGattServer::setAdvertisingData(const char *name, const uint8_t *manufacturerData, size_t len)
+{
+    uint8_t raw[ADV_DATA_MAX_LEN];
+    size_t rawLen = buildAdvertisingData(name, manufacturerData, len, raw);
+    BLEAdvertisementData advertisementData;
+    advertisementData.addData(std::string((const char *)raw, rawLen));
+    BLEDevice::getAdvertising()->setAdvertisementData(advertisementData);
+}
+
+/**
+ * @brief Anuncia los servicios en la respuesta de escaneo.
+ */
+void BluedroidGattServer::setScanResponseServices(const GattUuid *uuids, size_t count)
+{
+    BLEAdvertisementData scanResponseData;
+    for (size_t i = 0; i < count; i++)
+    {
+        scanResponseData.setCompleteServices(toBLEUUID(uuids[i]));
+    }
+    BLEDevice::getAdvertising()->setScanResponseData(scanResponseData);
+}
+
+/**
+ * @brief (Re)inicia la publicidad.
+ * @param connectable `false` para publicitar sin aceptar conexiones.
+ */
+void BluedroidGattServer::startAdvertising(bool connectable)
+{
+    BLEDevice::getAdvertising()->setAdvertisementType(connectable ? ADV_TYPE_IND : ADV_TYPE_NONCONN_IND);
+    BLEDevice::startAdvertising();
+}
+
+/**
+ * @brief Indica si hay un cliente conectado.
+ */
+bool BluedroidGattServer::isConnected()
+{
+    return connected;
+}
+
+/**
+ * @brief MTU acordado con el cliente conectado.
+ */
+uint16_t BluedroidGattServer::getPeerMtu()
+{
+    return server->getPeerMTU(server->getConnId());
+}
+
+/**
+ * @brief Solicita al cliente nuevos parámetros de conexión.
+ */
+void BluedroidGattServer::requestConnectionParams(const GattConnectionParams &params)
+{
+    esp_ble_conn_update_params_t update;
+    memcpy(update.bda, connectedPeerAddress, sizeof(esp_bd_addr_t));
+    update.min_int = params.minInterval;
+    update.max_int = params.maxInterval;
+    update.latency = params.latency;
+    update.timeout = params.timeout;
+    esp_ble_gap_update_conn_params(&update);
+}
+
+/**
+ * @brief Parámetros acordados en la última actualización de la conexión.
+ * @return bool `false` si todavía no se conocen.
+ */
+bool BluedroidGattServer::getConnectionParams(GattConnectionParams &params)
+{
+    params.minInterval = achievedInterval;
+    params.maxInterval = achievedInterval;
+    params.latency = achievedLatency;
+    params.timeout = achievedTimeout;
+    return achievedInterval != 0;
+}
+
+/**
+ * @brief Servidor GATT de la pila Bluedroid.
+ */
+GattServer &gattServer()
+{
+    static BluedroidGattServer server;
+    return server;
+}
+
+#endif // GATT_BACKEND_BLUEDROID
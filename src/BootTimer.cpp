@@ -0,0 +1,82 @@
+/**
+ * @file BootTimer.cpp
+ * @brief Implementación del cronómetro de las fases del arranque.
+ */
+
+#include "BootTimer.h"
+
+/** @brief Nombres de `BootPhase`, en el mismo orden que la enumeración. */
+static const char *const PHASE_NAMES[] = {"BLE", "I2C", "SENSORES", "ALMACEN", "SETUP", "1A_MUESTRA"};
+
+/**
+ * @brief Constructor de la clase BootTimer.
+ * @details Todas las fases empiezan sin marcar.
+ */
+BootTimer::BootTimer()
+{
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++)
+    {
+        start_us[i] = 0;
+        end_us[i] = 0;
+    }
+}
+
+/**
+ * @brief Marca el inicio de una fase.
+ * @param phase Fase que empieza.
+ */
+void BootTimer::start(BootPhase phase)
+{
+    start_us[phase] = micros();
+}
+
+/**
+ * @brief Marca el fin de una fase.
+ * @details Las llamadas posteriores se ignoran, de modo que se puede llamar en
+ * cada ciclo hasta que la condición de la fase se cumpla por primera vez.
+ * @param phase Fase que termina.
+ */
+void BootTimer::finish(BootPhase phase)
+{
+    if (end_us[phase] == 0)
+    {
+        uint32_t now = micros();
+        end_us[phase] = now > 0 ? now : 1;
+    }
+}
+
+/**
+ * @brief Indica si una fase ya terminó.
+ */
+bool BootTimer::isFinished(BootPhase phase)
+{
+    return end_us[phase] != 0;
+}
+
+/**
+ * @brief Obtiene el momento en que terminó una fase.
+ * @return uint32_t Milisegundos desde el arranque, o 0 si la fase no terminó.
+ */
+uint32_t BootTimer::getEndMs(BootPhase phase)
+{
+    return end_us[phase] / 1000;
+}
+
+/**
+ * @brief Imprime por consola el inicio, el fin y la duración de cada fase.
+ */
+void BootTimer::report()
+{
+    Serial.println("--- Tiempos de arranque ---");
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++)
+    {
+        if (end_us[i] == 0)
+        {
+            Serial.printf("%-10s pendiente\n", PHASE_NAMES[i]);
+            continue;
+        }
+        Serial.printf("%-10s %7.1f -> %7.1f ms (%.1f ms)\n", PHASE_NAMES[i],
+                      start_us[i] / 1000.0f, end_us[i] / 1000.0f,
+                      (end_us[i] - start_us[i]) / 1000.0f);
+    }
+}
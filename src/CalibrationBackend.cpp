@@ -0,0 +1,133 @@
+/**
+ * @file CalibrationBackend.cpp
+ * @brief Implementación de los backends de calibración del MH-Z19C (pin HD y UART).
+ */
+
+#include "CalibrationBackend.h"
+
+// --- Pin HD ---
+
+/**
+ * @brief Constructor de la clase HdPinCalibration.
+ * @param pin Pin conectado a la entrada HD del sensor.
+ * @param pulseMs Referencia a la duración del pulso en la configuración.
+ */
+HdPinCalibration::HdPinCalibration(int pin, const uint32_t &pulseMs)
+    : pin(pin), pulse_ms(pulseMs), output("HD", writePin, this), hardware_timed(false)
+{
+}
+
+/**
+ * @brief Configura el pin HD como salida en ALTO (inactivo).
+ */
+void HdPinCalibration::begin()
+{
+    pinMode(pin, OUTPUT);
+    if (!output.begin())
+    {
+        Serial.println("Sin temporizador para el pin HD: el pulso lo termina el bucle.");
+    }
+    output.set(HIGH);
+}
+
+/**
+ * @brief Empieza el pulso poniendo el pin HD en BAJO y programa su final.
+ */
+void HdPinCalibration::startZero()
+{
+    hardware_timed = output.pulse(LOW, HIGH, (uint64_t)pulse_ms * 1000);
+}
+
+/**
+ * @brief Indica si el pulso ha terminado.
+ * @details Con temporizador, el flanco de subida ya se dio a su hora y aquí
+ * solo se comprueba. Sin él, el pulso termina en la primera llamada tras
+ * `pulse_ms`.
+ * @param elapsedMs Tiempo desde `startZero()`.
+ * @return bool `true` cuando el pulso ha terminado.
+ */
+bool HdPinCalibration::updateZero(unsigned long elapsedMs)
+{
+    if (hardware_timed)
+    {
+        return !output.isPending();
+    }
+    if (elapsedMs < pulse_ms)
+    {
+        return false;
+    }
+    output.set(HIGH);
+    return true;
+}
+
+/**
+ * @brief Devuelve el pin HD a ALTO sin completar el pulso.
+ */
+void HdPinCalibration::abortZero()
+{
+    output.set(HIGH); // También descarta el flanco programado
+}
+
+/**
+ * @brief Escritura de `output` en el pin HD; puede llamarse desde el temporizador.
+ */
+void HdPinCalibration::writePin(void *context, uint16_t level)
+{
+    digitalWrite(static_cast<HdPinCalibration *>(context)->pin, level);
+}
+
+// --- UART ---
+
+/**
+ * @brief Constructor de la clase UartCalibration.
+ * @param link Transporte del MH-Z19C, o `nullptr` si la placa no lo tiene.
+ */
+UartCalibration::UartCalibration(Mhz19Link *link) : link(link), command_sent(false)
+{
+}
+
+/**
+ * @brief Envía el comando de calibración del punto cero (0x87).
+ */
+void UartCalibration::startZero()
+{
+    command_sent = link != nullptr && link->sendCommand(Mhz19Link::CMD_ZERO_POINT);
+}
+
+/**
+ * @brief La calibración termina tras un margen desde el envío del comando.
+ * @details Si el comando no se pudo enviar, termina de inmediato (el historial
+ * lo reflejará sin cambio en la lectura).
+ * @param elapsedMs Tiempo desde `startZero()`.
+ */
+bool UartCalibration::updateZero(unsigned long elapsedMs)
+{
+    return !command_sent || elapsedMs >= ZERO_SETTLE_MS;
+}
+
+/**
+ * @brief Calibra el span con un gas de referencia (0x88).
+ * @param ppm Concentración del gas de referencia.
+ */
+bool UartCalibration::setSpan(uint16_t ppm)
+{
+    return link != nullptr && link->sendCommand(Mhz19Link::CMD_SPAN_POINT, ppm >> 8, ppm & 0xFF);
+}
+
+/**
+ * @brief Activa o desactiva la autocalibración (ABC) del sensor (0x79).
+ * @param enabled `true` para activarla.
+ */
+bool UartCalibration::setAutoCalibration(bool enabled)
+{
+    return link != nullptr && link->sendCommand(Mhz19Link::CMD_SET_ABC, enabled ? 0xA0 : 0x00);
+}
+
+/**
+ * @brief Cambia el rango de detección del sensor (0x99).
+ * @param ppm Fondo de escala, ej. 2000 o 5000.
+ */
+bool UartCalibration::setDetectionRange(uint16_t ppm)
+{
+    return link != nullptr && link->sendCommand(Mhz19Link::CMD_SET_RANGE, 0, 0, 0, ppm >> 8, ppm & 0xFF);
+}
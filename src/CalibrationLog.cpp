@@ -0,0 +1,171 @@
+/**
+ * @file CalibrationLog.cpp
+ * @brief Implementación del historial persistente de calibraciones.
+ */
+
+#include "CalibrationLog.h"
+#include <LittleFS.h>
+#include <Preferences.h>
+
+/** @brief Archivo con los registros más recientes. */
+static const char *CALIBRATION_FILE = "/calibration.bin";
+/** @brief Archivo con los registros anteriores a la última rotación. */
+static const char *CALIBRATION_OLD_FILE = "/calibration.old";
+
+/** @brief Nombres de `CalibrationResult`, en el mismo orden que la enumeración. */
+static const char *const RESULT_NAMES[] = {"OK", "NO_READING", "ABORTED"};
+
+/**
+ * @brief Cuenta los registros completos de un archivo.
+ * @param path Ruta del archivo.
+ */
+static uint32_t recordsIn(const char *path)
+{
+    if (!LittleFS.exists(path))
+    {
+        return 0;
+    }
+    File file = LittleFS.open(path, FILE_READ);
+    uint32_t records = file ? file.size() / sizeof(CalibrationRecord) : 0;
+    file.close();
+    return records;
+}
+
+/**
+ * @brief Constructor de la clase CalibrationLog.
+ */
+CalibrationLog::CalibrationLog()
+{
+    boot_count = 0;
+}
+
+/**
+ * @brief Incrementa el contador de arranques guardado en NVS.
+ * @details El contador identifica el arranque de cada registro mientras no haya
+ * reloj de tiempo real.
+ */
+void CalibrationLog::init()
+{
+    Preferences prefs;
+    if (prefs.begin("calib", false))
+    {
+        boot_count = prefs.getUInt("boots", 0) + 1;
+        prefs.putUInt("boots", boot_count);
+        prefs.end();
+    }
+    Serial.printf("Historial de calibraciones: %lu registros (arranque %u).\n",
+                  (unsigned long)count(), (unsigned)boot_count);
+}
+
+/**
+ * @brief Añade un registro al final del historial.
+ * @details Rellena `bootCount` y `uptimeS` con el momento actual. Si el archivo
+ * alcanzó su tamaño máximo, antes lo rota.
+ * @param record Registro a añadir.
+ * @return bool `true` si se escribió completo.
+ */
+bool CalibrationLog::append(CalibrationRecord &record)
+{
+    record.bootCount = boot_count;
+    record.uptimeS = millis() / 1000;
+    record.reserved = 0;
+
+    if (recordsIn(CALIBRATION_FILE) * sizeof(CalibrationRecord) >= MAX_FILE_SIZE)
+    {
+        LittleFS.remove(CALIBRATION_OLD_FILE);
+        LittleFS.rename(CALIBRATION_FILE, CALIBRATION_OLD_FILE);
+    }
+    File file = LittleFS.open(CALIBRATION_FILE, FILE_APPEND);
+    if (!file)
+    {
+        return false;
+    }
+    bool ok = file.write((const uint8_t *)&record, sizeof(record)) == sizeof(record);
+    file.close();
+    return ok;
+}
+
+/**
+ * @brief Obtiene el número total de registros.
+ */
+uint32_t CalibrationLog::count()
+{
+    return recordsIn(CALIBRATION_FILE) + recordsIn(CALIBRATION_OLD_FILE);
+}
+
+/**
+ * @brief Lee un registro contando desde el más reciente.
+ * @param indexFromNewest 0 para el último registro.
+ * @param record Registro leído.
+ * @return bool `false` si no existe.
+ */
+bool CalibrationLog::read(uint32_t indexFromNewest, CalibrationRecord &record)
+{
+    const char *path = CALIBRATION_FILE;
+    uint32_t records = recordsIn(CALIBRATION_FILE);
+    if (indexFromNewest >= records)
+    {
+        indexFromNewest -= records;
+        path = CALIBRATION_OLD_FILE;
+        records = recordsIn(CALIBRATION_OLD_FILE);
+        if (indexFromNewest >= records)
+        {
+            return false;
+        }
+    }
+    File file = LittleFS.open(path, FILE_READ);
+    if (!file)
+    {
+        return false;
+    }
+    bool ok = file.seek((records - 1 - indexFromNewest) * sizeof(CalibrationRecord)) &&
+              file.read((uint8_t *)&record, sizeof(record)) == sizeof(record);
+    file.close();
+    return ok;
+}
+
+/**
+ * @brief Describe en texto varios registros, del más reciente al más antiguo.
+ * @details Formato: "TOTAL=n" seguido de un registro por cada '|', ej.
+ * "|#0:B12+3456s,OK,CO2=523>405,T=22.51,H=45.20,P=1013.2".
+ * @param out Buffer de salida.
+ * @param len Tamaño de `out`.
+ * @param offset Primer registro a describir, contando desde el más reciente.
+ * @return size_t Longitud del texto escrito.
+ */
+size_t CalibrationLog::describe(char *out, size_t len, uint32_t offset)
+{
+    if (len == 0)
+    {
+        return 0;
+    }
+    uint32_t total = count();
+    size_t pos = snprintf(out, len, "TOTAL=%lu", (unsigned long)total);
+    CalibrationRecord record;
+    for (uint32_t i = offset; i < total && i < offset + RECORDS_PER_QUERY && pos < len; i++)
+    {
+        if (!read(i, record))
+        {
+            break;
+        }
+        int written = snprintf(out + pos, len - pos, "|#%lu:B%u+%lus,%s,CO2=%d>%d,T=%.2f,H=%.2f,P=%.1f",
+                               (unsigned long)i, (unsigned)record.bootCount, (unsigned long)record.uptimeS,
+                               record.result < 3 ? RESULT_NAMES[record.result] : "?",
+                               record.co2Before, record.co2After,
+                               record.temperature / 100.0f, record.humidity / 100.0f, record.pressure / 10.0f);
+        if (written < 0)
+        {
+            break;
+        }
+        pos += written;
+    }
+    return pos < len ? pos : len - 1;
+}
+
+/**
+ * @brief Obtiene el número del arranque actual.
+ */
+uint16_t CalibrationLog::getBootCount()
+{
+    return boot_count;
+}
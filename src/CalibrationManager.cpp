@@ -1,54 +1,342 @@
 /**
  * @file CalibrationManager.cpp
  * @brief Implementación de la clase CalibrationManager para la calibración del sensor de CO2.
- * @details Este archivo contiene la lógica de la máquina de estados que gestiona
- * el proceso de calibración manual a 400 ppm del sensor MH-Z19C.
+ * @details Este archivo contiene el flujo que gestiona el proceso de
+ * calibración manual a 400 ppm del sensor MH-Z19C. La orden de calibración la
+ * ejecuta un CalibrationBackend (pin HD o UART).
  * @author Francisco Aguirre
  * @date 2025-08-28
  */
 
 #include "CalibrationManager.h"
 #include <Arduino.h> // Necesario para millis(), Serial, etc.
+#include <Preferences.h>
+#include <stdlib.h>
+
+/** @brief Espacio de nombres y clave del punto de control en NVS. */
+static const char *CHECKPOINT_NAMESPACE = "calib";
+static const char *CHECKPOINT_KEY = "ckpt";
+
+/** @brief Gas de referencia admitido para la calibración del span. */
+static const unsigned long SPAN_MIN_PPM = 400;
+static const unsigned long SPAN_MAX_PPM = 10000;
+/** @brief Rangos de detección que admite el MH-Z19C. */
+static const unsigned long DETECTION_RANGES_PPM[] = {2000, 5000, 10000};
+
+/**
+ * @brief Lee un valor en ppm de un comando.
+ * @details Solo admite dígitos (entre 1 y 5), sin signo ni espacios: un valor
+ * vacío o no numérico no debe convertirse en un 0 que llegue al sensor.
+ * @param text Texto tras el '='.
+ * @param ppm Valor leído.
+ * @return bool `false` si el texto no es un número válido.
+ */
+static bool parsePpm(const char *text, unsigned long &ppm)
+{
+    size_t len = strlen(text);
+    if (len == 0 || len > 5)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++)
+    {
+        if (text[i] < '0' || text[i] > '9')
+        {
+            return false;
+        }
+    }
+    ppm = strtoul(text, nullptr, 10);
+    return true;
+}
+
+/**
+ * @brief Indica si el MH-Z19C admite el rango de detección indicado.
+ */
+static bool isSupportedRange(unsigned long ppm)
+{
+    for (unsigned long range : DETECTION_RANGES_PPM)
+    {
+        if (ppm == range)
+        {
+            return true;
+        }
+    }
+    return false;
+}
 
 /**
  * @brief Constructor de la clase CalibrationManager.
- * @details Inicializa la máquina de estados en IDLE y resetea los
- * temporizadores de estado y de registro de mensajes.
+ * @details Deja el flujo parado, en IDLE, y resetea los temporizadores.
  */
-CalibrationManager::CalibrationManager()
+CalibrationManager::CalibrationManager() : flow(flowBody, this)
 {
     currentState = IDLE;
+    config = nullptr;
+    hd_backend = nullptr;
+    uart_backend = nullptr;
+    active_backend = nullptr;
     stateStartTime = 0;
-    lastLogTime = 0;
+    lastCheckpointTime = 0;
+    last_sample = {-1.0f, -1.0f, -1.0f, -1, 0, -1};
+    before_sample = last_sample;
+    awaiting_post_sample = false;
+    pulse_end_time = 0;
 }
 
 /**
  * @brief Inicializa el gestor de calibración.
- * @details Configura el pin HD (utilizado para la calibración) como una salida
- * y lo establece en un nivel ALTO para asegurar que el proceso de
- * calibración no se active accidentalmente al iniciar el sistema.
+ * @details Deja ambos backends en reposo (el pin HD en ALTO, para que la
+ * calibración no se active accidentalmente al iniciar el sistema). Después
+ * recupera la calibración que estuviera en curso antes de un reinicio.
+ * Requiere LittleFS montado (ver HistoryLog::init()).
+ * @param config Configuración del dispositivo; se guarda una referencia, así
+ * que los cambios de tiempos y de backend se aplican en la siguiente calibración.
+ * @param hdPin Backend del pulso en el pin HD.
+ * @param uart Backend de comandos UART.
+ * @param scheduler Planificador del bucle principal, que ejecutará el flujo.
  */
-void CalibrationManager::init()
+void CalibrationManager::init(const DeviceConfig &config, CalibrationBackend &hdPin, CalibrationBackend &uart,
+                              CoroutineScheduler &scheduler)
 {
-    pinMode(HD_PIN, OUTPUT);
-    digitalWrite(HD_PIN, HIGH);
+    scheduler.add(flow);
+    this->config = &config;
+    hd_backend = &hdPin;
+    uart_backend = &uart;
+    hd_backend->begin();
+    uart_backend->begin();
+    calibrationLog.init();
+    restoreCheckpoint();
     Serial.println("Calibration Manager inicializado.");
 }
 
+/**
+ * @brief Recupera la calibración interrumpida por un reinicio.
+ * @details Una estabilización se reanuda desde el último punto de control (se
+ * pierde como mucho `CHECKPOINT_INTERVAL_MS`). Un pulso interrumpido no se
+ * puede reanudar, porque no se sabe cuánto duró: el backend ya está en reposo,
+ * así que se registra como abortado.
+ */
+void CalibrationManager::restoreCheckpoint()
+{
+    Checkpoint checkpoint;
+    Preferences prefs;
+    if (!prefs.begin(CHECKPOINT_NAMESPACE, true))
+    {
+        return;
+    }
+    bool found = prefs.getBytesLength(CHECKPOINT_KEY) == sizeof(checkpoint) &&
+                 prefs.getBytes(CHECKPOINT_KEY, &checkpoint, sizeof(checkpoint)) == sizeof(checkpoint);
+    prefs.end();
+    if (!found)
+    {
+        return;
+    }
+
+    before_sample = checkpoint.before;
+    if (checkpoint.state == STABILIZING)
+    {
+        Serial.printf("Reanudando la estabilización interrumpida (%lu s transcurridos).\n",
+                      (unsigned long)(checkpoint.elapsedMs / 1000));
+        currentState = STABILIZING;
+        stateStartTime = millis() - checkpoint.elapsedMs;
+        lastCheckpointTime = millis();
+        flow.start(millis());
+    }
+    else if (checkpoint.state == PULSING)
+    {
+        Serial.println("ADVERTENCIA: Pulso de calibración interrumpido por un reinicio. Calibración abortada.");
+        zeroBackend().abortZero();
+        finishRecord(CAL_RESULT_ABORTED, -1);
+        clearCheckpoint();
+    }
+    else
+    {
+        clearCheckpoint();
+    }
+}
+
+/**
+ * @brief Obtiene el backend de calibración a cero elegido en la configuración.
+ */
+CalibrationBackend &CalibrationManager::zeroBackend()
+{
+    return config->calBackend == 1 ? *uart_backend : *hd_backend;
+}
+
+/**
+ * @brief Procesa un comando recibido en la característica de calibración.
+ * @details Comandos aceptados: "START_CAL" (calibración a cero con estabilización),
+ * "SPAN=<ppm>" (de `SPAN_MIN_PPM` a `SPAN_MAX_PPM`), "ABC=ON"/"ABC=OFF" y
+ * "RANGE=<ppm>" (2000, 5000 o 10000). Los tres últimos se envían siempre por
+ * UART, porque el pin HD no los admite, y se rechazan mientras hay una
+ * calibración a cero en curso.
+ * @param cmd Comando recibido.
+ * @return bool `true` si el comando se reconoció y se aceptó.
+ */
+bool CalibrationManager::handleCommand(const String &cmd)
+{
+    if (cmd == "START_CAL")
+    {
+        startCalibration();
+        return true;
+    }
+    if (isCalibrating())
+    {
+        Serial.printf("Comando de calibración %s rechazado: calibración a cero en curso.\n", cmd.c_str());
+        return false;
+    }
+    bool ok = false;
+    unsigned long ppm = 0;
+    if (cmd.startsWith("SPAN="))
+    {
+        ok = parsePpm(cmd.c_str() + 5, ppm) && ppm >= SPAN_MIN_PPM && ppm <= SPAN_MAX_PPM &&
+             uart_backend->setSpan((uint16_t)ppm);
+    }
+    else if (cmd == "ABC=ON" || cmd == "ABC=OFF")
+    {
+        ok = uart_backend->setAutoCalibration(cmd == "ABC=ON");
+    }
+    else if (cmd.startsWith("RANGE="))
+    {
+        ok = parsePpm(cmd.c_str() + 6, ppm) && isSupportedRange(ppm) && uart_backend->setDetectionRange((uint16_t)ppm);
+    }
+    Serial.printf("Comando de calibración %s: %s\n", cmd.c_str(), ok ? "enviado" : "rechazado");
+    return ok;
+}
+
+/**
+ * @brief Cambia de estado y guarda el punto de control correspondiente.
+ * @param state Nuevo estado.
+ */
+void CalibrationManager::enterState(CalibrationState state)
+{
+    currentState = state;
+    stateStartTime = millis();
+    if (state == IDLE)
+    {
+        clearCheckpoint();
+    }
+    else
+    {
+        saveCheckpoint();
+    }
+}
+
+/**
+ * @brief Guarda en NVS el estado actual y el tiempo transcurrido en él.
+ */
+void CalibrationManager::saveCheckpoint()
+{
+    Checkpoint checkpoint;
+    checkpoint.state = currentState;
+    checkpoint.elapsedMs = millis() - stateStartTime;
+    checkpoint.before = before_sample;
+    Preferences prefs;
+    if (prefs.begin(CHECKPOINT_NAMESPACE, false))
+    {
+        prefs.putBytes(CHECKPOINT_KEY, &checkpoint, sizeof(checkpoint));
+        prefs.end();
+    }
+    lastCheckpointTime = millis();
+}
+
+/**
+ * @brief Borra el punto de control: no hay calibración en curso.
+ */
+void CalibrationManager::clearCheckpoint()
+{
+    Preferences prefs;
+    if (prefs.begin(CHECKPOINT_NAMESPACE, false))
+    {
+        prefs.remove(CHECKPOINT_KEY);
+        prefs.end();
+    }
+}
+
+/**
+ * @brief Añade la calibración terminada al historial.
+ * @param result Resultado de la calibración.
+ * @param co2After Lectura de CO2 tras el pulso, o -1 si no hay.
+ */
+void CalibrationManager::finishRecord(CalibrationResult result, int co2After)
+{
+    CalibrationRecord record = {};
+    record.result = result;
+    record.co2Before = before_sample.co2;
+    record.co2After = co2After;
+    record.temperature = (int16_t)lroundf(before_sample.temperature * 100.0f);
+    record.humidity = before_sample.humidity < 0 ? 0 : (uint16_t)lroundf(before_sample.humidity * 100.0f);
+    record.pressure = before_sample.pressure < 0 ? 0 : (uint16_t)lroundf(before_sample.pressure * 10.0f);
+    if (!calibrationLog.append(record))
+    {
+        Serial.println("ADVERTENCIA: No se pudo guardar el registro de calibración.");
+    }
+    awaiting_post_sample = false;
+}
+
+/**
+ * @brief Recibe la última muestra de los sensores.
+ * @details La guarda como condiciones previas de la próxima calibración y, si
+ * acaba de terminar un pulso, usa la primera lectura válida de CO2 tras
+ * `POST_SETTLE_MS` para completar el registro del historial.
+ * @param data Lecturas de los sensores.
+ */
+void CalibrationManager::onSample(const SensorData &data)
+{
+    last_sample = data;
+    if (!awaiting_post_sample)
+    {
+        return;
+    }
+    unsigned long sincePulse = millis() - pulse_end_time;
+    if (sincePulse >= POST_SETTLE_MS && data.co2 >= 0)
+    {
+        Serial.printf("Calibración registrada: %d ppm antes, %d ppm después.\n", before_sample.co2, data.co2);
+        finishRecord(CAL_RESULT_OK, data.co2);
+    }
+    else if (sincePulse >= POST_TIMEOUT_MS)
+    {
+        finishRecord(CAL_RESULT_NO_READING, -1);
+    }
+}
+
+/**
+ * @brief Describe el historial de calibraciones (ver CalibrationLog::describe()).
+ * @param out Buffer de salida.
+ * @param len Tamaño de `out`.
+ * @param offset Primer registro a describir, contando desde el más reciente.
+ * @return size_t Longitud del texto escrito.
+ */
+size_t CalibrationManager::describeHistory(char *out, size_t len, uint32_t offset)
+{
+    return calibrationLog.describe(out, len, offset);
+}
+
+/**
+ * @brief Obtiene el número del arranque actual (ver CalibrationLog::init()).
+ * @details Lo comparten los demás historiales para fechar sus registros.
+ */
+uint16_t CalibrationManager::getBootCount()
+{
+    return calibrationLog.getBootCount();
+}
+
 /**
  * @brief Inicia el proceso de calibración del sensor.
- * @details Si el sistema no está ya en un proceso de calibración (es decir,
- * está en estado IDLE), cambia al estado STABILIZING y comienza
- * la cuenta regresiva de 20 minutos para la estabilización del sensor.
+ * @details Si no hay ya una calibración en curso, pasa a STABILIZING y lanza
+ * el flujo, que empieza por la estabilización del sensor (`CAL_STAB_MS`, 20
+ * minutos por defecto).
  */
 void CalibrationManager::startCalibration()
 {
     if (currentState == IDLE)
     {
-        Serial.println("Comando de calibración recibido. Iniciando fase de estabilización (20 min)...");
-        currentState = STABILIZING;
-        stateStartTime = millis();
-        lastLogTime = stateStartTime;
+        Serial.printf("Comando de calibración recibido. Iniciando fase de estabilización (%lu s, backend %s)...\n",
+                      (unsigned long)(config->calStabilizationMs / 1000), zeroBackend().name());
+        before_sample = last_sample;
+        awaiting_post_sample = false; // Una calibración nueva sustituye a la pendiente de registrar
+        enterState(STABILIZING);
+        flow.start(millis());
     }
 }
 
@@ -62,68 +350,84 @@ bool CalibrationManager::isCalibrating()
 }
 
 /**
- * @brief Ejecuta la lógica de la máquina de estados de calibración.
- * @details Esta función debe ser llamada repetidamente en el bucle principal del programa.
- * Gestiona las transiciones entre los estados IDLE, STABILIZING y PULSING.
+ * @brief Adaptador para el planificador: avanza el flujo del objeto indicado.
+ * @param context El CalibrationManager.
  */
-void CalibrationManager::run()
+void CalibrationManager::flowBody(void *context)
 {
-    switch (currentState)
-    {
-    /**
-     * @brief Estado de reposo. El sistema no está realizando ninguna acción de calibración.
-     */
-    case IDLE:
-        // No se realiza ninguna acción.
-        break;
+    static_cast<CalibrationManager *>(context)->stepFlow();
+}
 
-    /**
-     * @brief Estado de estabilización. El sistema espera 20 minutos antes de
-     * activar el pulso de calibración para asegurar que el sensor esté en
-     * un ambiente estable de 400 ppm.
-     */
-    case STABILIZING:
-    {
-        unsigned long now = millis();
-        unsigned long elapsed = now - stateStartTime;
+/**
+ * @brief Tiempo que falta para terminar la estabilización.
+ * @return unsigned long Milisegundos, 0 si ya terminó.
+ */
+unsigned long CalibrationManager::stabilizationRemaining()
+{
+    unsigned long elapsed = millis() - stateStartTime;
+    return elapsed >= config->calStabilizationMs ? 0 : config->calStabilizationMs - elapsed;
+}
 
-        // Cada 10 segundos, informa el tiempo restante por el monitor serie.
-        if (now - lastLogTime >= 10000)
+/**
+ * @brief Indica si la orden de calibración en curso ha superado su plazo.
+ * @details El plazo es la duración del pulso más `ZERO_TIMEOUT_MARGIN_MS`,
+ * que también cubre el margen del comando UART.
+ */
+bool CalibrationManager::zeroTimedOut()
+{
+    return millis() - stateStartTime > config->calPulseMs + ZERO_TIMEOUT_MARGIN_MS;
+}
+
+/**
+ * @brief Flujo de calibración: estabilización, orden de calibración y vuelta a IDLE.
+ * @details Se reanuda desde el planificador del bucle principal. Tras un
+ * reinicio durante la estabilización, `restoreCheckpoint()` lo lanza con
+ * `stateStartTime` ya desplazado, así que solo espera lo que faltaba.
+ */
+void CalibrationManager::stepFlow()
+{
+    CO_BEGIN(flow);
+
+    // --- Estabilización: el sensor debe estar en un ambiente estable de 400 ppm ---
+    while (stabilizationRemaining() > 0)
+    {
+        CO_DELAY(flow, stabilizationRemaining() < LOG_INTERVAL_MS ? stabilizationRemaining() : LOG_INTERVAL_MS);
+        if (stabilizationRemaining() > 0)
         {
             Serial.print("Estabilizando... quedan ");
-            Serial.print((STABILIZATION_TIME_MS - elapsed) / 1000);
+            Serial.print(stabilizationRemaining() / 1000);
             Serial.println(" segundos.");
-            lastLogTime = now;
         }
-
-        // Cuando se completan los 20 minutos, pasa al estado de PULSING.
-        if (elapsed >= STABILIZATION_TIME_MS)
+        // Punto de control periódico, para reanudar tras un reinicio.
+        if (millis() - lastCheckpointTime >= CHECKPOINT_INTERVAL_MS)
         {
-            Serial.println("Estabilización completada. Iniciando pulso de calibración (7 seg)...");
-            currentState = PULSING;
-            stateStartTime = millis();
-            // Pone el pin HD en BAJO para iniciar el pulso de calibración.
-            digitalWrite(HD_PIN, LOW);
+            saveCheckpoint();
         }
-        break;
     }
 
-    /**
-     * @brief Estado de pulso de calibración. El pin HD se mantiene en BAJO
-     * durante 7 segundos para indicarle al sensor que calibre su punto cero.
-     */
-    case PULSING:
+    // --- Orden de calibración: pulso en el pin HD (`CAL_PULSE_MS`) o comando 0x87 y margen ---
+    Serial.println("Estabilización completada. Enviando la orden de calibración...");
+    active_backend = &zeroBackend();
+    enterState(PULSING);
+    active_backend->startZero();
+    CO_AWAIT(flow, active_backend->updateZero(millis() - stateStartTime) || zeroTimedOut());
+
+    if (zeroTimedOut())
     {
-        // Comprueba si han transcurrido los 7 segundos del pulso.
-        if (millis() - stateStartTime >= PULSE_TIME_MS)
-        {
-            // Termina el pulso devolviendo el pin HD a un estado ALTO.
-            digitalWrite(HD_PIN, HIGH);
-            Serial.println("Sensor calibrado manualmente a 400 ppm.");
-            // Vuelve al estado de reposo.
-            currentState = IDLE;
-        }
-        break;
+        // El backend no terminó a tiempo (ej. el temporizador del pin HD no llegó a dispararse).
+        Serial.println("ADVERTENCIA: La orden de calibración no terminó a tiempo. Calibración abortada.");
+        active_backend->abortZero();
+        enterState(IDLE);
+        finishRecord(CAL_RESULT_ABORTED, -1);
     }
+    else
+    {
+        Serial.println("Sensor calibrado manualmente a 400 ppm.");
+        // Vuelve al estado de reposo; el registro se completa con la siguiente lectura.
+        enterState(IDLE);
+        awaiting_post_sample = true;
+        pulse_end_time = millis();
     }
+
+    CO_END(flow);
 }
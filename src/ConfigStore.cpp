@@ -0,0 +1,499 @@
+/**
+ * @file ConfigStore.cpp
+ * @brief Implementación de la configuración persistente del dispositivo.
+ * @details Formato del blob (esquema 1):
+ * - 1 byte: versión del esquema
+ * - Por cada campo: 1 byte de clave, 1 byte de longitud y el valor. Los
+ *   números van en varint (7 bits por byte) y el nombre en ASCII sin terminador.
+ */
+
+#include "ConfigStore.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef ARDUINO
+#include <Preferences.h>
+
+/** @brief Espacio de nombres y clave del blob en NVS. */
+static const char *NVS_NAMESPACE = "config";
+static const char *NVS_KEY = "blob";
+#endif
+
+/**
+ * @struct ConfigField
+ * @brief Descripción de un campo del esquema.
+ * @details Los campos numéricos son `uint32_t` validados contra [minValue, maxValue];
+ * los de texto son cadenas con terminador de hasta `maxValue` caracteres.
+ */
+struct ConfigField
+{
+    uint8_t key;       // Identificador en el blob; nunca se reutiliza
+    const char *name;  // Nombre en la característica BLE
+    size_t offset;     // Posición del campo en DeviceConfig
+    bool isText;
+    uint32_t minValue;
+    uint32_t maxValue;
+    uint32_t defaultValue; // Solo campos numéricos
+};
+
+/** @brief Nombre BLE por defecto. */
+static const char *DEFAULT_DEVICE_NAME = "SRV_NAME";
+
+/** @brief Esquema de la configuración. Las claves son estables entre versiones. */
+static const ConfigField CONFIG_FIELDS[] = {
+    {1, "UPDATE_MS", offsetof(DeviceConfig, updateIntervalMs), false, 100, 60000UL, 500},
+    {2, "HISTORY_MS", offsetof(DeviceConfig, historyIntervalMs), false, 1000, 3600000UL, 10000},
+    {3, "CAL_STAB_MS", offsetof(DeviceConfig, calStabilizationMs), false, 0, 3600000UL, 20 * 60 * 1000UL},
+    {4, "CAL_PULSE_MS", offsetof(DeviceConfig, calPulseMs), false, 1000, 30000UL, 7000},
+    {5, "CO2_TIMEOUT_MS", offsetof(DeviceConfig, co2TimeoutMs), false, 50, 1000UL, 150},
+    {6, "CO2_PREHEAT_MS", offsetof(DeviceConfig, co2PreheatMs), false, 0, 600000UL, 60 * 1000UL},
+    {7, "NAME", offsetof(DeviceConfig, deviceName), true, 1, CONFIG_NAME_MAX, 0},
+    {8, "CAL_MODE", offsetof(DeviceConfig, calBackend), false, 0, 1, 0},
+    {9, "FAN_MODE", offsetof(DeviceConfig, fanMode), false, 0, 1, 0},
+};
+
+static const size_t CONFIG_FIELD_COUNT = sizeof(CONFIG_FIELDS) / sizeof(CONFIG_FIELDS[0]);
+
+// --- Utilidades ---
+
+static uint32_t &numberAt(DeviceConfig &config, const ConfigField &field)
+{
+    return *(uint32_t *)((uint8_t *)&config + field.offset);
+}
+
+static const uint32_t &numberAt(const DeviceConfig &config, const ConfigField &field)
+{
+    return *(const uint32_t *)((const uint8_t *)&config + field.offset);
+}
+
+static char *textAt(DeviceConfig &config, const ConfigField &field)
+{
+    return (char *)&config + field.offset;
+}
+
+static const char *textAt(const DeviceConfig &config, const ConfigField &field)
+{
+    return (const char *)&config + field.offset;
+}
+
+/**
+ * @brief Comprueba que un texto se puede guardar y mostrar en la característica.
+ * @details Solo ASCII imprimible, sin los separadores ';' y '='.
+ */
+static bool isValidText(const char *text, size_t len, const ConfigField &field)
+{
+    if (len < field.minValue || len > field.maxValue)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++)
+    {
+        if (text[i] < 0x20 || text[i] > 0x7E || text[i] == ';' || text[i] == '=')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static const ConfigField *findField(uint8_t key)
+{
+    for (const ConfigField &field : CONFIG_FIELDS)
+    {
+        if (field.key == key)
+        {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+static const ConfigField *findField(const char *name)
+{
+    for (const ConfigField &field : CONFIG_FIELDS)
+    {
+        if (strcmp(field.name, name) == 0)
+        {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Convierte una configuración guardada con un esquema anterior al actual.
+ * @details Cada caso pasa del esquema `version` al `version + 1`. Los campos
+ * nuevos no necesitan caso (toman su valor por defecto); solo los cambios de
+ * significado o de unidades de un campo existente. El esquema 1 es el primero.
+ * @param fromVersion Versión con la que se guardó el blob.
+ * @param config Configuración ya leída, que se modifica en el sitio.
+ */
+static void migrate(uint8_t fromVersion, DeviceConfig &config)
+{
+    (void)config; // Sin migraciones mientras el esquema 1 sea el actual
+    for (uint8_t version = fromVersion; version < CONFIG_SCHEMA_VERSION; version++)
+    {
+        switch (version)
+        {
+        default:
+            break;
+        }
+    }
+}
+
+// --- Serialización ---
+
+/**
+ * @brief Rellena una configuración con los valores por defecto.
+ * @param config Configuración a rellenar.
+ */
+void ConfigStore::defaults(DeviceConfig &config)
+{
+    memset(&config, 0, sizeof(config));
+    for (const ConfigField &field : CONFIG_FIELDS)
+    {
+        if (!field.isText)
+        {
+            numberAt(config, field) = field.defaultValue;
+        }
+    }
+    strncpy(config.deviceName, DEFAULT_DEVICE_NAME, CONFIG_NAME_MAX);
+}
+
+/**
+ * @brief Serializa una configuración en el formato del blob.
+ * @param config Configuración a serializar.
+ * @param out Buffer de salida.
+ * @param len Tamaño de `out`; con `CONFIG_MAX_BLOB_SIZE` siempre basta.
+ * @return size_t Bytes escritos, o 0 si no caben.
+ */
+size_t ConfigStore::serialize(const DeviceConfig &config, uint8_t *out, size_t len)
+{
+    if (len < 1)
+    {
+        return 0;
+    }
+    size_t pos = 0;
+    out[pos++] = CONFIG_SCHEMA_VERSION;
+    for (const ConfigField &field : CONFIG_FIELDS)
+    {
+        uint8_t value[CONFIG_NAME_MAX];
+        size_t valueLen = 0;
+        if (field.isText)
+        {
+            valueLen = strnlen(textAt(config, field), field.maxValue);
+            memcpy(value, textAt(config, field), valueLen);
+        }
+        else
+        {
+            uint32_t number = numberAt(config, field);
+            do
+            {
+                uint8_t bits = number & 0x7F;
+                number >>= 7;
+                value[valueLen++] = number != 0 ? (bits | 0x80) : bits;
+            } while (number != 0);
+        }
+        if (pos + 2 + valueLen > len)
+        {
+            return 0;
+        }
+        out[pos++] = field.key;
+        out[pos++] = (uint8_t)valueLen;
+        memcpy(&out[pos], value, valueLen);
+        pos += valueLen;
+    }
+    return pos;
+}
+
+/**
+ * @brief Reconstruye una configuración a partir de un blob.
+ * @details Parte de los valores por defecto: las claves desconocidas (de un
+ * esquema más nuevo) se saltan y los valores fuera de rango se descartan.
+ * Después aplica las migraciones desde la versión del blob.
+ * @param data Blob leído del almacenamiento.
+ * @param len Longitud de `data`.
+ * @param config Configuración resultante.
+ * @return bool `false` si el blob está vacío o truncado (`config` queda con los valores por defecto).
+ */
+bool ConfigStore::deserialize(const uint8_t *data, size_t len, DeviceConfig &config)
+{
+    defaults(config);
+    if (len < 1 || data[0] == 0)
+    {
+        return false;
+    }
+    DeviceConfig parsed = config;
+    size_t pos = 1;
+    while (pos < len)
+    {
+        if (pos + 2 > len || pos + 2 + data[pos + 1] > len)
+        {
+            return false;
+        }
+        uint8_t key = data[pos];
+        uint8_t valueLen = data[pos + 1];
+        const uint8_t *value = &data[pos + 2];
+        pos += 2 + valueLen;
+
+        const ConfigField *field = findField(key);
+        if (field == nullptr)
+        {
+            continue;
+        }
+        if (field->isText)
+        {
+            if (isValidText((const char *)value, valueLen, *field))
+            {
+                memcpy(textAt(parsed, *field), value, valueLen);
+                textAt(parsed, *field)[valueLen] = '\0';
+            }
+            continue;
+        }
+        uint32_t number = 0;
+        bool complete = false;
+        for (uint8_t i = 0; i < valueLen && i < 5; i++)
+        {
+            number |= (uint32_t)(value[i] & 0x7F) << (7 * i);
+            if ((value[i] & 0x80) == 0)
+            {
+                complete = true;
+                break;
+            }
+        }
+        if (complete && number >= field->minValue && number <= field->maxValue)
+        {
+            numberAt(parsed, *field) = number;
+        }
+    }
+    migrate(data[0], parsed);
+    config = parsed;
+    return true;
+}
+
+// --- Almacén ---
+
+/**
+ * @brief Constructor de la clase ConfigStore.
+ * @details La caché empieza con los valores por defecto, así que es válida
+ * incluso antes de `begin()`.
+ */
+ConfigStore::ConfigStore()
+{
+    defaults(config);
+#ifndef ARDUINO
+    file_path = "config.bin";
+#endif
+}
+
+/**
+ * @brief Carga la configuración guardada en la caché.
+ * @return bool `true` si había una configuración guardada; `false` si se usan los valores por defecto.
+ */
+bool ConfigStore::begin()
+{
+    uint8_t blob[CONFIG_MAX_BLOB_SIZE];
+    size_t len = 0;
+    if (!readBlob(blob, sizeof(blob), len))
+    {
+        defaults(config);
+        return false;
+    }
+    return deserialize(blob, len, config);
+}
+
+/**
+ * @brief Cambia un campo de la caché.
+ * @details No guarda nada: hay que llamar a `commit()` para persistir.
+ * @param key Nombre del campo (ej. "UPDATE_MS").
+ * @param value Valor en texto.
+ * @return bool `false` si el campo no existe o el valor no es válido.
+ */
+bool ConfigStore::set(const char *key, const char *value)
+{
+    const ConfigField *field = findField(key);
+    if (field == nullptr)
+    {
+        return false;
+    }
+    if (field->isText)
+    {
+        size_t len = strlen(value);
+        if (!isValidText(value, len, *field))
+        {
+            return false;
+        }
+        memcpy(textAt(config, *field), value, len + 1);
+        return true;
+    }
+    char *end = nullptr;
+    unsigned long number = strtoul(value, &end, 10);
+    if (*value < '0' || *value > '9' || *end != '\0' || number < field->minValue || number > field->maxValue)
+    {
+        return false;
+    }
+    numberAt(config, *field) = (uint32_t)number;
+    return true;
+}
+
+/**
+ * @brief Aplica un comando de configuración recibido por BLE.
+ * @details Acepta "RESET" (valores por defecto) o una lista "CLAVE=valor"
+ * separada por ';'. Si algún par no es válido no se aplica ninguno.
+ * @param command Comando recibido.
+ * @return bool `true` si el comando se aplicó completo.
+ */
+bool ConfigStore::apply(const char *command)
+{
+    if (strcmp(command, "RESET") == 0)
+    {
+        resetDefaults();
+        return true;
+    }
+    char buffer[CONFIG_COMMAND_MAX_LEN + 1];
+    if (strlen(command) >= sizeof(buffer))
+    {
+        return false;
+    }
+    strcpy(buffer, command);
+
+    DeviceConfig previous = config;
+    char *saveptr = nullptr;
+    for (char *pair = strtok_r(buffer, ";", &saveptr); pair != nullptr; pair = strtok_r(nullptr, ";", &saveptr))
+    {
+        char *separator = strchr(pair, '=');
+        if (separator == nullptr)
+        {
+            config = previous;
+            return false;
+        }
+        *separator = '\0';
+        if (!set(pair, separator + 1))
+        {
+            config = previous;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Guarda la caché en el almacenamiento.
+ * @return bool `true` si se escribió correctamente.
+ */
+bool ConfigStore::commit()
+{
+    uint8_t blob[CONFIG_MAX_BLOB_SIZE];
+    size_t len = serialize(config, blob, sizeof(blob));
+    return len > 0 && writeBlob(blob, len);
+}
+
+/**
+ * @brief Restablece la caché a los valores por defecto (sin guardar).
+ */
+void ConfigStore::resetDefaults()
+{
+    defaults(config);
+}
+
+/**
+ * @brief Describe la configuración actual en texto.
+ * @param out Buffer de salida.
+ * @param len Tamaño de `out`.
+ * @return size_t Longitud del texto escrito (truncado si `out` no basta).
+ */
+size_t ConfigStore::describe(char *out, size_t len) const
+{
+    size_t pos = 0;
+    if (len > 0)
+    {
+        out[0] = '\0';
+    }
+    for (size_t i = 0; i < CONFIG_FIELD_COUNT && pos < len; i++)
+    {
+        const ConfigField &field = CONFIG_FIELDS[i];
+        int written;
+        if (field.isText)
+        {
+            written = snprintf(out + pos, len - pos, "%s%s=%s", i > 0 ? ";" : "", field.name, textAt(config, field));
+        }
+        else
+        {
+            written = snprintf(out + pos, len - pos, "%s%s=%lu", i > 0 ? ";" : "", field.name,
+                               (unsigned long)numberAt(config, field));
+        }
+        if (written < 0)
+        {
+            break;
+        }
+        pos += (size_t)written;
+    }
+    return pos < len ? pos : (len > 0 ? len - 1 : 0);
+}
+
+// --- Almacenamiento ---
+
+#ifdef ARDUINO
+
+bool ConfigStore::readBlob(uint8_t *out, size_t maxLen, size_t &len)
+{
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, true))
+    {
+        return false; // El espacio de nombres aún no existe
+    }
+    len = prefs.getBytesLength(NVS_KEY);
+    bool ok = len > 0 && len <= maxLen && prefs.getBytes(NVS_KEY, out, len) == len;
+    prefs.end();
+    return ok;
+}
+
+bool ConfigStore::writeBlob(const uint8_t *data, size_t len)
+{
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false))
+    {
+        return false;
+    }
+    bool ok = prefs.putBytes(NVS_KEY, data, len) == len;
+    prefs.end();
+    return ok;
+}
+
+#else
+
+/**
+ * @brief Cambia el archivo que hace de NVS en el host.
+ * @param path Ruta del archivo; debe seguir siendo válida mientras se use el almacén.
+ */
+void ConfigStore::setFilePath(const char *path)
+{
+    file_path = path;
+}
+
+bool ConfigStore::readBlob(uint8_t *out, size_t maxLen, size_t &len)
+{
+    FILE *file = fopen(file_path, "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    len = fread(out, 1, maxLen, file);
+    fclose(file);
+    return len > 0;
+}
+
+bool ConfigStore::writeBlob(const uint8_t *data, size_t len)
+{
+    FILE *file = fopen(file_path, "wb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    bool ok = fwrite(data, 1, len, file) == len;
+    fclose(file);
+    return ok;
+}
+
+#endif
@@ -0,0 +1,153 @@
+/**
+ * @file Coroutine.cpp
+ * @brief Implementación de las corrutinas sin pila y de su planificador.
+ * @details Este archivo no depende de Arduino para poder ejecutar los flujos
+ * en el host con un reloj virtual.
+ */
+
+#include "Coroutine.h"
+
+// --- Coroutine ---
+
+/**
+ * @brief Constructor de la clase Coroutine.
+ * @param body Función con el cuerpo del flujo (ver `CO_BEGIN`).
+ * @param context Argumento para `body`, normalmente el objeto dueño del flujo.
+ */
+Coroutine::Coroutine(CoroutineBody body, void *context) : wake_timer(onWake, this)
+{
+    this->body = body;
+    this->context = context;
+    resume_point = 0;
+    running = false;
+    sleeping = false;
+    now_ms = 0;
+    wheel = nullptr;
+}
+
+/**
+ * @brief Inicia el flujo desde el principio; se reanuda en la siguiente pasada.
+ * @param nowMs Instante actual.
+ */
+void Coroutine::start(uint32_t nowMs)
+{
+    finish(); // Cancela una espera pendiente de la ejecución anterior
+    running = true;
+    now_ms = nowMs;
+}
+
+/**
+ * @brief Abandona el flujo; el dueño debe dejar sus recursos en reposo.
+ */
+void Coroutine::stop()
+{
+    finish();
+}
+
+/**
+ * @brief Avanza el flujo hasta su siguiente suspensión.
+ * @param nowMs Instante de la reanudación (lo usa `now()`).
+ */
+void Coroutine::resume(uint32_t nowMs)
+{
+    now_ms = nowMs;
+    body(context);
+}
+
+/**
+ * @brief Duerme el flujo hasta que venza su temporizador en la rueda.
+ * @details Sin planificador (`attach()`), equivale a `CO_YIELD`.
+ * @param ms Plazo desde el instante actual de la rueda.
+ */
+void Coroutine::sleepFor(uint32_t ms)
+{
+    if (wheel != nullptr)
+    {
+        sleeping = true;
+        wheel->start(wake_timer, ms);
+    }
+}
+
+/**
+ * @brief Marca el flujo como terminado y cancela su espera.
+ */
+void Coroutine::finish()
+{
+    running = false;
+    resume_point = 0;
+    sleeping = false;
+    if (wheel != nullptr)
+    {
+        wheel->cancel(wake_timer);
+    }
+}
+
+/**
+ * @brief Callback de `wake_timer`: el flujo vuelve a estar listo.
+ */
+void Coroutine::onWake(void *context)
+{
+    static_cast<Coroutine *>(context)->sleeping = false;
+}
+
+// --- CoroutineScheduler ---
+
+/**
+ * @brief Constructor de la clase CoroutineScheduler.
+ * @param wheel Rueda donde se programan los `CO_DELAY` de los flujos.
+ */
+CoroutineScheduler::CoroutineScheduler(TimerWheel &wheel) : wheel(wheel)
+{
+    count = 0;
+    resume_count = 0;
+}
+
+/**
+ * @brief Registra un flujo. Los flujos no se retiran: uno terminado no se reanuda.
+ * @param coroutine Flujo a registrar; debe vivir tanto como el planificador.
+ * @return bool `false` si ya hay `MAX_COROUTINES` flujos.
+ */
+bool CoroutineScheduler::add(Coroutine &coroutine)
+{
+    if (count >= MAX_COROUTINES)
+    {
+        return false;
+    }
+    coroutine.attach(wheel);
+    coroutines[count++] = &coroutine;
+    return true;
+}
+
+/**
+ * @brief Reanuda cada flujo activo que no esté dormido.
+ * @param nowMs Instante actual.
+ */
+void CoroutineScheduler::run(uint32_t nowMs)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        Coroutine *coroutine = coroutines[i];
+        if (coroutine->isReady())
+        {
+            coroutine->resume(nowMs);
+            resume_count++;
+        }
+    }
+}
+
+/**
+ * @brief Indica si algún flujo se reanudará en la siguiente pasada.
+ * @details Los flujos dormidos no cuentan: su despertar ya figura en la rueda.
+ * @return bool `true` si algún flujo está en `CO_AWAIT`, `CO_YIELD` o recién iniciado.
+ */
+bool CoroutineScheduler::hasReadyFlows() const
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (coroutines[i]->isReady())
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,244 @@
+/**
+ * @file DerivedMetrics.cpp
+ * @brief Implementación de las magnitudes derivadas (punto de rocío, humedad
+ * absoluta, CO2 compensado y altitud).
+ * @details Este archivo no depende de Arduino para poder comparar sus
+ * aproximaciones en el host con las funciones de `<math.h>`.
+ */
+
+#include "DerivedMetrics.h"
+#include <math.h> // Solo para NAN
+#include <stdio.h>
+#include <string.h>
+
+// --- Constantes de la fórmula de Magnus (Sonntag, sobre agua líquida) ---
+static const float MAGNUS_B = 17.62f;
+static const float MAGNUS_C = 243.12f; // °C
+static const float MAGNUS_E0 = 6.112f; // hPa a 0 °C
+
+/** @brief 100 · M_agua / R: pasa de hPa de vapor y K a g/m³. */
+static const float ABSOLUTE_HUMIDITY_K = 216.7f;
+/** @brief Exponente de la fórmula barométrica internacional (1 / 5.255). */
+static const float BAROMETRIC_EXPONENT = 0.190295f;
+/** @brief Altura de escala de la fórmula barométrica, en m. */
+static const float BAROMETRIC_SCALE_M = 44330.0f;
+
+static const float LN2 = 0.69314718f;
+static const float LOG2E = 1.44269504f;
+static const float SQRT2 = 1.41421356f;
+
+/**
+ * @brief Constructor de la clase DerivedMetrics.
+ */
+DerivedMetrics::DerivedMetrics()
+{
+    memset(&derived, 0, sizeof(derived));
+    // NAN nunca es igual a nada: la primera muestra siempre se calcula.
+    last_temperature = NAN;
+    last_humidity = NAN;
+    last_pressure = NAN;
+    last_co2 = -2;
+    compute_count = 0;
+}
+
+/**
+ * @brief Actualiza las magnitudes derivadas con una muestra nueva.
+ * @details Solo recalcula los grupos cuyas entradas han cambiado desde la
+ * muestra anterior; con lecturas estables no hace ningún cálculo.
+ * @param data Muestra de `SensorManager::readAllSensors()`.
+ * @return const DerivedData& Magnitudes actualizadas.
+ */
+const DerivedData &DerivedMetrics::update(const SensorData &data)
+{
+    bool pressureChanged = data.pressure != last_pressure;
+    if (data.temperature != last_temperature || data.humidity != last_humidity)
+    {
+        computeHumidity(data.temperature, data.humidity);
+    }
+    if (pressureChanged || data.co2 != last_co2)
+    {
+        computeCo2(data.co2, data.pressure);
+    }
+    if (pressureChanged)
+    {
+        computeAltitude(data.pressure);
+    }
+    last_temperature = data.temperature;
+    last_humidity = data.humidity;
+    last_pressure = data.pressure;
+    last_co2 = data.co2;
+    return derived;
+}
+
+/**
+ * @brief Obtiene las últimas magnitudes calculadas.
+ */
+const DerivedData &DerivedMetrics::get() const
+{
+    return derived;
+}
+
+/**
+ * @brief Obtiene cuántos grupos de magnitudes se han recalculado.
+ * @details Cambia cada vez que cambia alguna magnitud (o su validez), así que
+ * sirve para publicar solo cuando hay algo nuevo.
+ */
+uint32_t DerivedMetrics::getComputeCount() const
+{
+    return compute_count;
+}
+
+/**
+ * @brief Describe las magnitudes en texto.
+ * @details Formato: "DEW=12.34;AH=9.87;CO2C=455;ALT=123.4". Las magnitudes no
+ * disponibles se indican como "NA".
+ * @param out Buffer de salida.
+ * @param len Tamaño de `out`.
+ * @return size_t Longitud del texto escrito.
+ */
+size_t DerivedMetrics::describe(char *out, size_t len) const
+{
+    if (len == 0)
+    {
+        return 0;
+    }
+    char dew[12] = "NA", ah[12] = "NA", co2[12] = "NA", alt[12] = "NA";
+    if (derived.valid & DERIVED_DEW_POINT)
+    {
+        snprintf(dew, sizeof(dew), "%.2f", derived.dewPoint);
+    }
+    if (derived.valid & DERIVED_ABSOLUTE_HUMIDITY)
+    {
+        snprintf(ah, sizeof(ah), "%.2f", derived.absoluteHumidity);
+    }
+    if (derived.valid & DERIVED_CO2_COMPENSATED)
+    {
+        snprintf(co2, sizeof(co2), "%d", derived.co2Compensated);
+    }
+    if (derived.valid & DERIVED_ALTITUDE)
+    {
+        snprintf(alt, sizeof(alt), "%.1f", derived.altitude);
+    }
+    int written = snprintf(out, len, "DEW=%s;AH=%s;CO2C=%s;ALT=%s", dew, ah, co2, alt);
+    if (written < 0)
+    {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < len ? (size_t)written : len - 1;
+}
+
+/**
+ * @brief Logaritmo en base 2 aproximado.
+ * @details Separa el exponente del float y lleva la mantisa a [√½, √2). Para
+ * esa mantisa, ln(m) = 2·atanh(s) con s = (m-1)/(m+1), |s| < 0.172, y basta la
+ * serie de atanh hasta s⁷ (error < 3e-8).
+ * @param x Argumento, positivo y normalizado.
+ */
+float DerivedMetrics::fastLog2(float x)
+{
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    int exponent = (int)((bits >> 23) & 0xFF) - 127;
+    bits = (bits & 0x007FFFFF) | 0x3F800000; // Mantisa en [1, 2)
+    float m;
+    memcpy(&m, &bits, sizeof(m));
+    if (m > SQRT2)
+    {
+        m *= 0.5f;
+        exponent++;
+    }
+    float s = (m - 1.0f) / (m + 1.0f);
+    float s2 = s * s;
+    float lnM = 2.0f * s * (1.0f + s2 * (1.0f / 3 + s2 * (1.0f / 5 + s2 * (1.0f / 7))));
+    return exponent + lnM * LOG2E;
+}
+
+/**
+ * @brief Potencia de 2 aproximada.
+ * @details Separa x en entero n y fracción f ∈ [-½, ½]; 2^n se construye en el
+ * exponente del float y 2^f = e^(f·ln2) con el polinomio de Taylor de grado 6
+ * (error relativo < 2e-7).
+ * @param x Exponente; se satura al rango de un float normalizado.
+ */
+float DerivedMetrics::fastExp2(float x)
+{
+    if (x < -126.0f)
+    {
+        x = -126.0f;
+    }
+    if (x > 127.0f)
+    {
+        x = 127.0f;
+    }
+    int n = (int)(x >= 0 ? x + 0.5f : x - 0.5f);
+    float t = (x - n) * LN2;
+    float p = 1.0f + t * (1.0f + t * (1.0f / 2 + t * (1.0f / 6 + t * (1.0f / 24 + t * (1.0f / 120 + t * (1.0f / 720))))));
+    uint32_t bits = (uint32_t)(n + 127) << 23;
+    float scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+/**
+ * @brief Calcula el punto de rocío y la humedad absoluta.
+ * @details Magnus: γ = ln(HR/100) + b·T/(c+T), Td = c·γ/(b-γ). La humedad
+ * absoluta usa la presión de vapor e = HR/100 · e0·exp(b·T/(c+T)), que
+ * comparte el mismo término.
+ * @param temperature Temperatura en °C (-1 = no disponible).
+ * @param humidity Humedad relativa en % (-1 = no disponible).
+ */
+void DerivedMetrics::computeHumidity(float temperature, float humidity)
+{
+    compute_count++;
+    derived.valid &= ~(DERIVED_DEW_POINT | DERIVED_ABSOLUTE_HUMIDITY);
+    if (temperature == -1 || humidity <= 0 || humidity > 100 || temperature <= -MAGNUS_C + 1)
+    {
+        return;
+    }
+    float magnus = MAGNUS_B * temperature / (MAGNUS_C + temperature);
+    float gamma = fastLog2(humidity / 100.0f) * LN2 + magnus;
+    derived.dewPoint = MAGNUS_C * gamma / (MAGNUS_B - gamma);
+
+    float vapourHpa = humidity / 100.0f * MAGNUS_E0 * fastExp2(magnus * LOG2E);
+    derived.absoluteHumidity = ABSOLUTE_HUMIDITY_K * vapourHpa / (273.15f + temperature);
+    derived.valid |= DERIVED_DEW_POINT | DERIVED_ABSOLUTE_HUMIDITY;
+}
+
+/**
+ * @brief Refiere la lectura de CO2 a la presión estándar.
+ * @details El sensor NDIR mide densidad de moléculas, que escala con la
+ * presión: ppm(1013.25) = ppm · 1013.25 / p.
+ * @param co2 Lectura en ppm (-1 = no disponible).
+ * @param pressure Presión en hPa (-1 = no disponible).
+ */
+void DerivedMetrics::computeCo2(int co2, float pressure)
+{
+    compute_count++;
+    derived.valid &= ~DERIVED_CO2_COMPENSATED;
+    if (co2 < 0 || pressure <= 0)
+    {
+        return;
+    }
+    derived.co2Compensated = (int)(co2 * SEA_LEVEL_HPA / pressure + 0.5f);
+    derived.valid |= DERIVED_CO2_COMPENSATED;
+}
+
+/**
+ * @brief Calcula la altitud barométrica respecto a `SEA_LEVEL_HPA`.
+ * @details h = 44330 · (1 - (p/p0)^0.1903), con la potencia como
+ * 2^(0.1903 · log2(p/p0)).
+ * @param pressure Presión en hPa (-1 = no disponible).
+ */
+void DerivedMetrics::computeAltitude(float pressure)
+{
+    compute_count++;
+    derived.valid &= ~DERIVED_ALTITUDE;
+    if (pressure <= 0)
+    {
+        return;
+    }
+    float ratio = pressure / SEA_LEVEL_HPA;
+    derived.altitude = BAROMETRIC_SCALE_M * (1.0f - fastExp2(BAROMETRIC_EXPONENT * fastLog2(ratio)));
+    derived.valid |= DERIVED_ALTITUDE;
+}
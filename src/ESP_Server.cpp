@@ -4,45 +4,175 @@
  * @details Este archivo contiene las funciones setup() y loop() principales.
  * Su única responsabilidad es inicializar y coordinar los diferentes
  * módulos del sistema (BLE, Sensores, Calibración).
+ *
+ * Con `-D NODE_SIMULATION` (ejecución en el host contra un Arduino simulado,
+ * con reloj virtual) los sensores se arrancan en `setup()` sin tarea aparte,
+ * de modo que una misma secuencia de entradas produce siempre la misma
+ * ejecución.
  */
 #include <Arduino.h>
+#include <atomic>
 #include "BLEManager.h"
 #include "SensorManager.h"
 #include "CalibrationManager.h"
-
-extern volatile bool toggleCoolerRequest;
+#include "HistoryLog.h"
+#include "I2CInventory.h"
+#include "BootTimer.h"
+#include "ConfigStore.h"
+#include "CalibrationBackend.h"
+#include "DerivedMetrics.h"
+#include "AlarmManager.h"
+#include "TimeBase.h"
+#include "Coroutine.h"
+#include "TimerWheel.h"
+#include "TimedOutput.h"
 
 // --- OBJETOS GLOBALES DE LOS MÓDULOS ---
 // Creamos una instancia para cada manager que controlará una parte del sistema.
 BLEManager bleManager;
 SensorManager sensorManager;
 CalibrationManager calibrationManager;
+HistoryLog historyLog;
+I2CInventory i2cInventory;
+BootTimer bootTimer;
+ConfigStore configStore;
+DerivedMetrics derivedMetrics;
+AlarmManager alarmManager;
+ClockSync clockSync;
+SampleScheduler sampleScheduler;
+TimerWheel timers;                // Plazos y tareas periódicas del bucle principal
+CoroutineScheduler scheduler(timers); // Flujos temporizados (calibración)
+HdPinCalibration hdPinCalibration(BOARD_HD_PIN, configStore.get().calPulseMs);
+UartCalibration uartCalibration(sensorManager.getCo2Link());
+
+void serviceHistoryTransfer();
+void bootSensors();
+#ifndef NODE_SIMULATION
+void sensorBootTask(void *parameter);
+#endif
+void publishConfig();
+void publishCalibrationHistory(uint32_t offset);
+void serviceAlarms();
+void publishTimeSync();
+void startTimers();
+void logActuations();
+void idleUntilNextTimer();
+void onHistoryTimer(void *context);
+void setFlag(void *context);
+
+/** @brief Difunde las lecturas en la publicidad BLE para escáneres sin conexión. */
+const bool BROADCAST_MODE_ENABLED = false;
 
-void scan();
+/**
+ * @brief Lo activa la tarea de arranque cuando el bus I2C y los sensores están listos.
+ * @details La tarea puede correr en el otro núcleo: la escritura con `release`
+ * y la lectura con `acquire` garantizan que `loop()` ve el estado de los
+ * drivers que dejó la tarea antes de activar el flag.
+ */
+std::atomic<bool> sensorsReady(false);
 
 /**
  * @brief Configuración inicial del microcontrolador.
- * @details Inicializa la comunicación serial y todos los módulos principales.
+ * @details La inicialización del bus I2C y de los sensores (que puede esperar
+ * a sensores que no responden) se lanza en una tarea aparte, mientras aquí se
+ * levanta la pila BLE para empezar a publicitar cuanto antes. No se espera al
+ * puerto serie: sin monitor conectado el arranque no se detiene.
  */
 void setup()
 {
-    Wire.begin();
     Serial.begin(115200); // Usamos una velocidad más alta para depuración
-    while (!Serial)
-        ; // Espera a que el puerto serial se conecte
+    bootTimer.start(BOOT_PHASE_SETUP);
+    bootTimer.start(BOOT_PHASE_FIRST_SAMPLE);
+
+    // La configuración se lee antes que nada: la necesitan todos los módulos.
+    if (!configStore.begin())
+    {
+        Serial.println("Sin configuración guardada: se usan los valores por defecto.");
+    }
+    sensorManager.applyConfig(configStore.get());
+
+#ifdef NODE_SIMULATION
+    bootSensors(); // Sin tareas: el orden de arranque es siempre el mismo
+#else
+    xTaskCreatePinnedToCore(sensorBootTask, "sensorBoot", 4096, nullptr, 1, nullptr, tskNO_AFFINITY);
+#endif
 
-    // Inicializamos cada uno de nuestros managers
-    bleManager.init();
-    sensorManager.init();
-    calibrationManager.init();
+    bootTimer.start(BOOT_PHASE_BLE);
+    bleManager.init(configStore.get().deviceName);
+    bleManager.setBroadcastEnabled(BROADCAST_MODE_ENABLED);
+    publishConfig();
+    bootTimer.finish(BOOT_PHASE_BLE);
 
+    bootTimer.start(BOOT_PHASE_STORAGE);
+    historyLog.init(); // Monta LittleFS, que también usa el historial de calibraciones
+    calibrationManager.init(configStore.get(), hdPinCalibration, uartCalibration, scheduler);
+    publishCalibrationHistory(0);
+    alarmManager.init(calibrationManager.getBootCount());
+    bootTimer.finish(BOOT_PHASE_STORAGE);
+
+    startTimers();
+
+    bootTimer.finish(BOOT_PHASE_SETUP);
+    bleManager.setBootMetrics(bootTimer.getEndMs(BOOT_PHASE_BLE), 0);
     Serial.println("Sistema inicializado y listo.");
-    // scan();
 }
 
-// Variables para controlar el tiempo de envío de datos
-unsigned long lastUpdateTime = 0;
-const int UPDATE_INTERVAL_MS = 500; // Intervalo de 500ms = 2 datos por segundo
+/**
+ * @brief Arranque del bus I2C y de los sensores.
+ * @details Hace el inventario del bus e inicializa los drivers con los
+ * dispositivos encontrados. Hasta entonces `loop()` no toca los sensores.
+ */
+void bootSensors()
+{
+    bootTimer.start(BOOT_PHASE_I2C_INVENTORY);
+    Wire.begin();
+    i2cInventory.scanAll();
+    Serial.printf("Bus I2C: %s\n", i2cInventory.describe().c_str());
+    bootTimer.finish(BOOT_PHASE_I2C_INVENTORY);
+
+    bootTimer.start(BOOT_PHASE_SENSORS);
+    sensorManager.init(i2cInventory);
+    bootTimer.finish(BOOT_PHASE_SENSORS);
+
+    sensorsReady.store(true, std::memory_order_release);
+}
+
+#ifndef NODE_SIMULATION
+/**
+ * @brief Tarea que ejecuta `bootSensors()` mientras `setup()` levanta la pila BLE.
+ * @param parameter Sin uso.
+ */
+void sensorBootTask(void *parameter)
+{
+    bootSensors();
+    vTaskDelete(nullptr);
+}
+#endif
+
+// Variables para el historial persistente (periodo en `HISTORY_MS`) y su descarga
+bool historyDue = false; // Lo activa `historyTimer`; se graba con la siguiente muestra
+Timer historyTimer(onHistoryTimer, nullptr);
+unsigned long lastHistoryChunkTime = 0;
+const unsigned long HISTORY_CHUNK_INTERVAL_MS = 15; // Un lote de notificaciones por evento de conexión
+const int HISTORY_CHUNKS_PER_BATCH = 4;
+
+// Variables para el inventario del bus I2C
+bool inventoryDue = false; // Lo activa `inventoryTimer`; la pasada empieza con los sensores listos
+Timer inventoryTimer(setFlag, &inventoryDue);
+const unsigned long INVENTORY_INTERVAL_MS = 60000; // Una pasada por el bus cada minuto
+
+// Reposo del bucle entre temporizadores; acota la latencia de comandos y muestras
+const uint32_t LOOP_IDLE_MAX_MS = 2;
+
+/**
+ * @brief Arma las tareas periódicas del bucle; la rueda empieza a contar desde aquí.
+ */
+void startTimers()
+{
+    timers.reset(millis());
+    timers.start(inventoryTimer, INVENTORY_INTERVAL_MS, INVENTORY_INTERVAL_MS);
+    timers.start(historyTimer, configStore.get().historyIntervalMs);
+}
 
 /**
  * @brief Bucle principal del programa.
@@ -51,103 +181,351 @@ const int UPDATE_INTERVAL_MS = 500; // Intervalo de 500ms = 2 datos por segundo
  */
 void loop()
 {
-    // Preguntamos al BLEManager si ha llegado un nuevo comando.
+    // Temporizadores del firmware: vencen aquí, en el contexto del bucle.
+    idleUntilNextTimer();
+    timers.advance(millis());
+    TimedOutput::runHostTimers(monotonicMicros()); // Solo en el host: en el ESP32 los da esp_timer
+    logActuations();
+
+    // Consultas del historial de calibraciones.
+    int calHistoryRequest = bleManager.getCalibrationHistoryRequest();
+    if (calHistoryRequest >= 0)
+    {
+        publishCalibrationHistory(calHistoryRequest);
+    }
+
+    // Cambios de configuración: se validan, se guardan en NVS y se aplican.
+    String configCmd = bleManager.getConfigCommand();
+    if (configCmd != "")
+    {
+        Serial.printf("Comando de configuración recibido: %s\n", configCmd.c_str());
+        if (configStore.apply(configCmd.c_str()) && configStore.commit())
+        {
+            sensorManager.applyConfig(configStore.get());
+            Serial.println("Configuración guardada.");
+        }
+        else
+        {
+            Serial.println("Comando de configuración rechazado.");
+        }
+        publishConfig();
+    }
+
+    // Descarga del historial: se atiende aunque haya una calibración en curso.
+    if (bleManager.getHistoryRequest() && historyLog.beginTransfer())
+    {
+        bleManager.setConnectionProfile(PROFILE_BULK);
+    }
+    if (historyLog.isTransferActive())
+    {
+        serviceHistoryTransfer();
+    }
+
+    // --- Alarmas: comandos, indicaciones pendientes y estado ---
+    String alarmCommand = bleManager.getAlarmCommand();
+    if (alarmCommand != "")
+    {
+        alarmManager.handleCommand(alarmCommand);
+    }
+    serviceAlarms();
+
+    // --- Sincronización de hora: cada escritura del cliente afina desfase y deriva ---
+    uint64_t syncLocalUs;
+    int64_t syncWallUs;
+    if (bleManager.getTimeSync(syncLocalUs, syncWallUs))
+    {
+        if (!clockSync.addPoint(syncLocalUs, syncWallUs))
+        {
+            Serial.println("Salto en la hora del cliente: se reinicia la sincronización.");
+            sampleScheduler.resetGrid();
+        }
+        Serial.printf("Sincronización de hora: %u puntos, deriva %+.1f ppm\n", clockSync.getPointCount(),
+                      clockSync.getDriftPpm());
+        publishTimeSync();
+    }
+
+    if (!sensorsReady.load(std::memory_order_acquire))
+    {
+        return; // El bus I2C y los sensores siguen inicializándose en su tarea
+    }
+
+    // Comandos de calibración: los UART usan el enlace del MH-Z19C, así que
+    // esperan en su buzón hasta que el driver esté iniciado.
     String cmd = bleManager.getCalibrationCommand();
-    if (cmd == "START_CAL")
-    { // Usamos un comando más descriptivo
-        calibrationManager.startCalibration();
+    if (cmd != "")
+    { // "START_CAL", o comandos UART como "SPAN=2000"
+        calibrationManager.handleCommand(cmd);
     }
 
-    // El calibrationManager se encarga de su propia máquina de estados interna.
-    calibrationManager.run();
+    // Flujos temporizados (calibración): cada uno se reanuda cuando le toca.
+    scheduler.run(millis());
 
-    if (toggleCoolerRequest)
+    // Comandos manuales del ventilador (AUTO, ON, OFF o porcentaje).
+    String coolerCmd = bleManager.getCoolerCommand();
+    if (coolerCmd != "")
     {
-        sensorManager.setFanState(!sensorManager.getFanState()); // Alternamos el estado
-        toggleCoolerRequest = false;                             // Reseteamos la bandera para la próxima petición
+        sensorManager.handleFanCommand(coolerCmd);
+    }
+
+    // Inventario del bus I2C: unas pocas direcciones por ciclo.
+    if (inventoryDue)
+    {
+        inventoryDue = false;
+        i2cInventory.restart();
+    }
+    i2cInventory.step();
+    if (i2cInventory.hasChanged())
+    {
+        Serial.printf("Inventario I2C: %s\n", i2cInventory.describe().c_str());
+        bleManager.setI2CInventory(i2cInventory.describe());
     }
 
     if (!calibrationManager.isCalibrating())
     {
         // --- Lógica de temporización para no bloquear el procesador ---
-        if (millis() - lastUpdateTime >= UPDATE_INTERVAL_MS)
+        // Con la hora sincronizada, las muestras caen en múltiplos del periodo
+        // de la hora de pared, alineadas con los demás nodos.
+        sampleScheduler.setPeriodUs((uint64_t)configStore.get().updateIntervalMs * 1000);
+        if (sampleScheduler.poll(monotonicMicros(), clockSync))
         {
-            lastUpdateTime = millis(); // Actualizamos el tiempo del último envío
-
             SensorData data = sensorManager.readAllSensors();
+            data.wallUs = clockSync.toWallUs(data.monotonicUs); // -1 hasta que el cliente sincronice
+            sampleScheduler.recordSample(data.wallUs);
+            if (sampleScheduler.hasPhaseError())
+            {
+                publishTimeSync(); // Error de fase de esta muestra
+            }
+            sensorManager.updateFanControl(data); // Lazo PI del ventilador
+            bleManager.setSensorFaults(sensorManager.getFaultMask());
+            calibrationManager.onSample(data); // Condiciones para el historial de calibraciones
+            alarmManager.onSample(data);       // Umbrales de alarma
+
+            // --- Magnitudes derivadas (solo se recalculan si cambian las entradas) ---
+            uint32_t computeCount = derivedMetrics.getComputeCount();
+            derivedMetrics.update(data);
+            if (derivedMetrics.getComputeCount() != computeCount)
+            {
+                char derivedText[64];
+                derivedMetrics.describe(derivedText, sizeof(derivedText));
+                bleManager.setDerivedMetrics(derivedText);
+            }
+
+            // Primera muestra válida: cierra las métricas de arranque.
+            if (!bootTimer.isFinished(BOOT_PHASE_FIRST_SAMPLE) && sensorManager.isSampleValid())
+            {
+                bootTimer.finish(BOOT_PHASE_FIRST_SAMPLE);
+                bootTimer.report();
+                bleManager.setBootMetrics(bootTimer.getEndMs(BOOT_PHASE_BLE), bootTimer.getEndMs(BOOT_PHASE_FIRST_SAMPLE));
+            }
 
             // Mostramos en la consola los valores reales
-            Serial.printf("Enviando -> Temp: %.2f C, Hum: %.2f %%, Pres: %.2f hPa, CO2: %d ppm\n",
-                          data.temperature, data.humidity, data.pressure, data.co2);
+            Serial.printf("Enviando -> Temp: %.2f C, Hum: %.2f %%, Pres: %.2f hPa, CO2: %d ppm (adquisición %.1f ms)\n",
+                          data.temperature, data.humidity, data.pressure, data.co2,
+                          sensorManager.getAcquireMicros() / 1000.0f);
+
+            // --- Historial persistente ---
+            if (historyDue)
+            {
+                historyDue = false;
+                historyLog.record(data);
+            }
+
+            // --- Difusión en la publicidad (sin conexión) ---
+            bleManager.updateBroadcast(data.temperature, data.humidity, data.pressure, data.co2,
+                                       sensorManager.getState(), sensorManager.getFanState());
 
             // --- Actualización del Servidor BLE ---
-            // Le pasamos los datos al BLEManager para que los envíe
-            if (bleManager.isDeviceConnected())
+            // Se publica aunque no haya cliente: el BLEManager solo guarda la
+            // muestra y las características se generan cuando el cliente las lee.
+            // Obtenemos los estados actuales desde el SensorManager
+            String systemStateStr = "UNKNOWN";
+            switch (sensorManager.getState())
             {
-                // Obtenemos los estados actuales desde el SensorManager
-                String systemStateStr = "UNKNOWN";
-                switch (sensorManager.getState())
-                {
-                case PREHEATING:
-                    systemStateStr = "PREHEATING";
-                    break;
-                case READY:
-                    systemStateStr = "READY";
-                    break;
-                case CALIBRATING:
-                    systemStateStr = "CALIBRATING";
-                    break;
-                }
-
-                String coolerStateStr = sensorManager.getFanState() ? "ON" : "OFF";
-
-                // Le pasamos todos los datos, incluidos los nuevos estados, al BLEManager
-                bleManager.updateSensorValues(data.temperature, data.humidity, data.pressure, data.co2, systemStateStr, coolerStateStr);
+            case PREHEATING:
+                systemStateStr = "PREHEATING";
+                break;
+            case READY:
+                systemStateStr = "READY";
+                break;
+            case CALIBRATING:
+                systemStateStr = "CALIBRATING";
+                break;
             }
+
+            String coolerStateStr = sensorManager.getFanStatus();
+
+            // Le pasamos todos los datos, incluidos los nuevos estados, al BLEManager
+            bleManager.updateSensorValues(data.temperature, data.humidity, data.pressure, data.co2, systemStateStr, coolerStateStr);
         }
         // Otras tareas que necesiten ejecutarse en cada ciclo podrían ir aquí
     }
 }
 
-void scan()
+/**
+ * @brief Envía el siguiente lote de fragmentos de la descarga del historial.
+ * @details Se limita a `HISTORY_CHUNKS_PER_BATCH` notificaciones cada
+ * `HISTORY_CHUNK_INTERVAL_MS` para no agotar los buffers de la pila BLE. Al
+ * terminar envía un fragmento vacío como marca de fin y vuelve al perfil de
+ * conexión de bajo consumo.
+ */
+void serviceHistoryTransfer()
 {
-    byte error, address;
-    int nDevices;
+    if (!bleManager.isDeviceConnected())
+    {
+        historyLog.cancelTransfer();
+        bleManager.setConnectionProfile(PROFILE_STEADY);
+        return;
+    }
+    if (millis() - lastHistoryChunkTime < HISTORY_CHUNK_INTERVAL_MS)
+    {
+        return;
+    }
+    lastHistoryChunkTime = millis();
 
-    Serial.println("Escaneando...");
-    nDevices = 0;
-    for (address = 1; address < 127; address++)
+    uint8_t chunk[244];
+    size_t maxLen = min(sizeof(chunk), bleManager.getMaxNotifySize());
+    for (int i = 0; i < HISTORY_CHUNKS_PER_BATCH; i++)
     {
-        Wire.beginTransmission(address);
-        error = Wire.endTransmission();
+        size_t len = historyLog.readTransfer(chunk, maxLen);
+        bleManager.sendHistoryChunk(chunk, len);
+        if (len == 0)
+        {
+            bleManager.setConnectionProfile(PROFILE_STEADY);
+            break;
+        }
+    }
+}
 
-        if (error == 0)
+/**
+ * @brief Publica la configuración actual en su característica BLE.
+ * @details Tras un comando rechazado el cliente lee los valores vigentes, que no cambiaron.
+ */
+void publishConfig()
+{
+    char text[192];
+    configStore.describe(text, sizeof(text));
+    bleManager.setConfigValue(text);
+}
+
+/**
+ * @brief Publica una página del historial de calibraciones en su característica BLE.
+ * @param offset Primer registro a mostrar, contando desde el más reciente.
+ */
+void publishCalibrationHistory(uint32_t offset)
+{
+    char text[512];
+    calibrationManager.describeHistory(text, sizeof(text), offset);
+    bleManager.setCalibrationHistory(text);
+}
+
+/**
+ * @brief Entrega las transiciones de alarma pendientes y publica el estado.
+ * @details La indicación sobrescribe el valor de la característica, así que
+ * después se vuelve a publicar el estado para las lecturas.
+ */
+void serviceAlarms()
+{
+    char text[96];
+    bool indicated = false;
+    if (alarmManager.nextIndication(bleManager.isDeviceConnected(), text, sizeof(text)))
+    {
+        indicated = bleManager.indicateAlarm(text);
+    }
+    if (alarmManager.hasStatusChanged() || indicated)
+    {
+        alarmManager.describeStatus(text, sizeof(text));
+        bleManager.setAlarmStatus(text);
+    }
+}
+
+/**
+ * @brief Publica el estado de la sincronización de hora y el error de fase del muestreo.
+ * @details Formato: "POINTS=3;DRIFT=+12.5ppm;ERR=-4ms;PHASE=+1.2ms".
+ */
+void publishTimeSync()
+{
+    char syncText[64];
+    size_t len = clockSync.describe(syncText, sizeof(syncText));
+    if (len + 1 < sizeof(syncText))
+    {
+        syncText[len++] = ';';
+        sampleScheduler.describe(syncText + len, sizeof(syncText) - len);
+    }
+    bleManager.setTimeSyncStatus(syncText);
+}
+
+/**
+ * @brief Cede la CPU hasta el próximo temporizador de la rueda.
+ * @details Duerme como mucho `LOOP_IDLE_MAX_MS`, para que los comandos BLE y
+ * la rejilla de muestreo (que no están en la rueda) se atiendan a tiempo, y
+ * no duerme si hay trabajo por pasadas pendiente: una descarga del historial,
+ * una pasada del inventario o un flujo esperando una condición (los flujos
+ * solo corren con los sensores listos).
+ */
+void idleUntilNextTimer()
+{
+    bool flowsReady = sensorsReady.load(std::memory_order_acquire) && scheduler.hasReadyFlows();
+    if (historyLog.isTransferActive() || i2cInventory.isScanning() || flowsReady)
+    {
+        return;
+    }
+    uint32_t idleMs = LOOP_IDLE_MAX_MS;
+    uint32_t expiryMs;
+    if (timers.nextExpiryMs(expiryMs))
+    {
+        int32_t untilExpiry = (int32_t)(expiryMs - millis());
+        if (untilExpiry <= 0)
         {
-            Serial.print("Dispositivo I2C encontrado en la dirección 0x");
-            if (address < 16)
-            {
-                Serial.print("0");
-            }
-            Serial.println(address, HEX);
-            nDevices++;
+            return;
         }
-        else if (error == 4)
+        if ((uint32_t)untilExpiry < idleMs)
         {
-            Serial.print("Error desconocido en la dirección 0x");
-            if (address < 16)
-            {
-                Serial.print("0");
-            }
-            Serial.println(address, HEX);
+            idleMs = untilExpiry;
         }
     }
-    if (nDevices == 0)
-    {
-        Serial.println("No se encontraron dispositivos I2C\n");
-    }
-    else
+    delay(idleMs);
+}
+
+/**
+ * @brief Callback de `historyTimer`: marca la muestra y se rearma con el periodo vigente.
+ * @details Es de un solo disparo para que un cambio de `HISTORY_MS` se aplique
+ * desde la siguiente muestra del historial.
+ */
+void onHistoryTimer(void *context)
+{
+    historyDue = true;
+    timers.start(historyTimer, configStore.get().historyIntervalMs);
+}
+
+/**
+ * @brief Callback genérico de temporizador: pone a `true` el `bool` del contexto.
+ */
+void setFlag(void *context)
+{
+    *static_cast<bool *>(context) = true;
+}
+
+/**
+ * @brief Escribe en la consola los flancos de las salidas temporizadas.
+ * @details Cada flanco lleva su hora pedida y el retraso de la real. Los
+ * ajustes de duty del lazo PI del ventilador no se escriben: solo los
+ * encendidos, los apagados y los flancos del temporizador.
+ */
+void logActuations()
+{
+    TimedOutput *outputs[] = {&hdPinCalibration.getOutput(), &sensorManager.getFanOutput()};
+    for (TimedOutput *output : outputs)
     {
-        Serial.println("Escaneo finalizado\n");
+        OutputEdge edge;
+        while (output->popEdge(edge))
+        {
+            if (!edge.scheduled && (edge.previous == 0) == (edge.value == 0))
+            {
+                continue;
+            }
+            Serial.printf("Salida %s: %u -> %u, pedido %.3f s, real %+ld us%s\n", output->getName(), edge.previous,
+                          edge.value, edge.requestedUs / 1e6, (long)(edge.actualUs - edge.requestedUs),
+                          edge.scheduled ? " (temporizador)" : "");
+        }
     }
-    delay(5000); // Espera 5 segundos para el próximo escaneo
-}
\ No newline at end of file
+}
@@ -0,0 +1,296 @@
+/**
+ * @file EnvironmentalSensing.cpp
+ * @brief Implementación del servicio Environmental Sensing (0x181A).
+ * @details Crea el servicio estándar con las características binarias de
+ * temperatura, humedad y presión, y evalúa en el dispositivo las condiciones
+ * configuradas por el cliente en los descriptores ES Trigger Setting.
+ */
+
+#include "EnvironmentalSensing.h"
+
+#if !defined(NODE_SIMULATION)
+#include <freertos/FreeRTOS.h>
+
+/**
+ * @brief Protege los disparadores: la tarea BLE escribe la condición mientras
+ * el bucle principal la evalúa y actualiza el último valor notificado.
+ */
+static portMUX_TYPE triggerLock = portMUX_INITIALIZER_UNLOCKED;
+
+static inline void lockTriggers() { portENTER_CRITICAL(&triggerLock); }
+static inline void unlockTriggers() { portEXIT_CRITICAL(&triggerLock); }
+#else
+// En el host la escritura del cliente virtual llega en el mismo hilo que el bucle.
+static inline void lockTriggers() {}
+static inline void unlockTriggers() {}
+#endif
+
+// --- UUIDs asignados por el Bluetooth SIG ---
+
+/** @brief Servicio Environmental Sensing. */
+static constexpr GattUuid ESS_SERVICE_UUID = gattUuid16(0x181A);
+/** @brief Descriptor ES Measurement. */
+static constexpr GattUuid ESS_MEASUREMENT_UUID = gattUuid16(0x290C);
+/** @brief Descriptor ES Trigger Setting. */
+static constexpr GattUuid ESS_TRIGGER_SETTING_UUID = gattUuid16(0x290D);
+/** @brief Handles reservados: 3 características con valor y 3 descriptores cada una. */
+static const uint16_t ESS_NUM_HANDLES = 20;
+
+/**
+ * @enum EssTriggerCondition
+ * @brief Condiciones del descriptor ES Trigger Setting definidas por la especificación ESS.
+ */
+enum EssTriggerCondition
+{
+    TRIGGER_INACTIVE = 0x00,         // Nunca notificar
+    TRIGGER_FIXED_INTERVAL = 0x01,   // Notificar cada N segundos
+    TRIGGER_MIN_INTERVAL = 0x02,     // Notificar cambios, como mucho cada N segundos
+    TRIGGER_VALUE_CHANGED = 0x03,    // Notificar cuando cambia el valor
+    TRIGGER_LESS_THAN = 0x04,        // Mientras sea menor que el operando
+    TRIGGER_LESS_OR_EQUAL = 0x05,    // Mientras sea menor o igual que el operando
+    TRIGGER_GREATER_THAN = 0x06,     // Mientras sea mayor que el operando
+    TRIGGER_GREATER_OR_EQUAL = 0x07, // Mientras sea mayor o igual que el operando
+    TRIGGER_EQUAL = 0x08,            // Mientras sea igual al operando
+    TRIGGER_NOT_EQUAL = 0x09         // Mientras sea distinto del operando
+};
+
+/**
+ * @struct EssQuantityInfo
+ * @brief Descripción estática de cada magnitud expuesta por el servicio.
+ */
+struct EssQuantityInfo
+{
+    uint16_t uuid;       // UUID de la característica
+    uint8_t valueSize;   // Tamaño del valor en bytes
+    bool isSigned;       // Si el valor es con signo
+    uint8_t uncertainty; // Incertidumbre según hoja de datos, en unidades de 0.5 %
+};
+
+/** @brief Tabla indexada por `EnvironmentalSensing::EssQuantity`. */
+static const EssQuantityInfo ESS_QUANTITIES[] = {
+    {0x2A6E, 2, true, 4},  // Temperature: sint16, 0.01 °C (DHT22 ±0.5 °C)
+    {0x2A6F, 2, false, 8}, // Humidity: uint16, 0.01 % (DHT22 ±2 %RH)
+    {0x2A6D, 4, false, 1}, // Pressure: uint32, 0.1 Pa (BMP280 ±1 hPa)
+};
+
+/**
+ * @brief Lee un entero little-endian de `size` bytes, opcionalmente con signo.
+ * @param data Bytes de entrada.
+ * @param size Número de bytes (1 a 4).
+ * @param isSigned Si se debe extender el signo.
+ * @return int32_t El valor leído.
+ */
+static int32_t readLittleEndian(const uint8_t *data, size_t size, bool isSigned)
+{
+    uint32_t value = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        value |= (uint32_t)data[i] << (8 * i);
+    }
+    if (isSigned && size < 4 && (value & (1UL << (8 * size - 1))))
+    {
+        value |= 0xFFFFFFFFUL << (8 * size);
+    }
+    return (int32_t)value;
+}
+
+/**
+ * @brief Decide si un nuevo valor debe notificarse según la condición del disparador.
+ * @param trigger Disparador de la característica.
+ * @param value Nuevo valor, en unidades de la característica.
+ * @param now Tiempo actual en milisegundos.
+ * @return bool `true` si se debe notificar.
+ * @note Para `TRIGGER_VALUE_CHANGED` se acepta un operando opcional (extensión a
+ * la especificación) con el cambio mínimo que debe superarse; 0 = cualquier cambio.
+ */
+static bool triggerFires(const EssTrigger &trigger, int32_t value, unsigned long now)
+{
+    bool changed = !trigger.hasLastValue || value != trigger.lastValue;
+    unsigned long elapsed = now - trigger.lastNotifyTime;
+
+    switch (trigger.condition)
+    {
+    case TRIGGER_FIXED_INTERVAL:
+        return !trigger.hasLastValue || elapsed >= (unsigned long)trigger.operand * 1000UL;
+    case TRIGGER_MIN_INTERVAL:
+        return changed && (!trigger.hasLastValue || elapsed >= (unsigned long)trigger.operand * 1000UL);
+    case TRIGGER_VALUE_CHANGED:
+        if (!trigger.hasLastValue || trigger.operand == 0)
+        {
+            return changed;
+        }
+        return labs((long)value - (long)trigger.lastValue) > (long)trigger.operand;
+    case TRIGGER_LESS_THAN:
+        return value < trigger.operand;
+    case TRIGGER_LESS_OR_EQUAL:
+        return value <= trigger.operand;
+    case TRIGGER_GREATER_THAN:
+        return value > trigger.operand;
+    case TRIGGER_GREATER_OR_EQUAL:
+        return value >= trigger.operand;
+    case TRIGGER_EQUAL:
+        return value == trigger.operand;
+    case TRIGGER_NOT_EQUAL:
+        return value != trigger.operand;
+    case TRIGGER_INACTIVE:
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Se ejecuta cuando el cliente escribe una nueva condición en un ES Trigger Setting.
+ * @details El primer byte es la condición; el resto es el operando, un uint24
+ * de segundos para las condiciones de tiempo o un valor en el formato de la
+ * característica para las comparaciones.
+ * @param context Disparador (`EssTrigger`) que se actualiza con cada escritura.
+ * @param data Bytes escritos por el cliente.
+ * @param len Longitud de `data`.
+ */
+static void onTriggerWrite(void *context, const uint8_t *data, size_t len)
+{
+    EssTrigger *pTrigger = (EssTrigger *)context;
+    const EssQuantityInfo *info = &ESS_QUANTITIES[pTrigger->quantity];
+    if (len == 0 || data[0] > TRIGGER_NOT_EQUAL)
+    {
+        return;
+    }
+
+    uint8_t condition = data[0];
+    int32_t operand = 0;
+    if (condition == TRIGGER_FIXED_INTERVAL || condition == TRIGGER_MIN_INTERVAL)
+    {
+        if (len >= 4)
+        {
+            operand = readLittleEndian(&data[1], 3, false);
+        }
+    }
+    else if (len >= 1u + info->valueSize)
+    {
+        operand = readLittleEndian(&data[1], info->valueSize, info->isSigned);
+    }
+
+    // Condición y operando ya están decodificados; se publican juntos para que
+    // el bucle nunca evalúe una condición con el operando de otra.
+    lockTriggers();
+    EssTrigger updated = *pTrigger;
+    updated.condition = condition;
+    updated.operand = operand;
+    updated.hasLastValue = false; // Fuerza una notificación con la nueva condición
+    *pTrigger = updated;
+    unlockTriggers();
+    Serial.printf("ESS: disparador 0x%04X configurado (condición %u, operando %ld).\n",
+                  info->uuid, condition, (long)operand);
+}
+
+/**
+ * @brief Constructor de la clase EnvironmentalSensing.
+ * @details Deja todos los disparadores en "notificar al cambiar el valor".
+ */
+EnvironmentalSensing::EnvironmentalSensing()
+{
+    gatt = nullptr;
+    for (int i = 0; i < ESS_QUANTITY_COUNT; i++)
+    {
+        handles[i] = GATT_INVALID_HANDLE;
+        triggers[i].quantity = i;
+        triggers[i].condition = TRIGGER_VALUE_CHANGED;
+        triggers[i].operand = 0;
+        triggers[i].hasLastValue = false;
+        triggers[i].lastValue = 0;
+        triggers[i].lastNotifyTime = 0;
+    }
+}
+
+/**
+ * @brief Crea el servicio ESS con sus características y descriptores.
+ * @param server Servidor GATT ya iniciado por BLEManager.
+ */
+void EnvironmentalSensing::init(GattServer &server)
+{
+    gatt = &server;
+    gatt->beginService(ESS_SERVICE_UUID, ESS_NUM_HANDLES);
+
+    for (int i = 0; i < ESS_QUANTITY_COUNT; i++)
+    {
+        const EssQuantityInfo &info = ESS_QUANTITIES[i];
+        handles[i] = gatt->addCharacteristic(gattUuid16(info.uuid), GATT_PROP_READ | GATT_PROP_NOTIFY);
+
+        // ES Measurement: flags, función de muestreo, periodo de medida,
+        // intervalo de actualización, aplicación e incertidumbre.
+        uint8_t measurement[11] = {
+            0x00, 0x00,       // Flags
+            0x01,             // Sampling function: instantaneous
+            0x00, 0x00, 0x00, // Measurement period: no usado
+            0x01, 0x00, 0x00, // Update interval: 1 s
+            0x01,             // Application: Air
+            info.uncertainty, // Measurement uncertainty
+        };
+        gatt->addDescriptor(handles[i], ESS_MEASUREMENT_UUID, measurement, sizeof(measurement), sizeof(measurement));
+
+        uint8_t trigger = triggers[i].condition;
+        gatt->addDescriptor(handles[i], ESS_TRIGGER_SETTING_UUID, &trigger, 1, 1 + info.valueSize,
+                            onTriggerWrite, &triggers[i]);
+    }
+
+    gatt->endService();
+    Serial.println("Servicio Environmental Sensing (0x181A) iniciado.");
+}
+
+/**
+ * @brief Actualiza los valores del servicio con una nueva muestra.
+ * @details Convierte las lecturas al formato binario estándar y, para cada
+ * característica, notifica solo si su disparador lo indica. Las lecturas con
+ * error (valores negativos de SensorManager) no se publican.
+ * @param temp Temperatura en °C.
+ * @param hum Humedad relativa en %.
+ * @param pres Presión en hPa.
+ */
+void EnvironmentalSensing::update(float temp, float hum, float pres)
+{
+    // El DHT22 marca temperatura y humedad con -1 a la vez cuando falla.
+    if (hum >= 0)
+    {
+        publish(ESS_TEMPERATURE, (int32_t)lroundf(temp * 100.0f));
+        publish(ESS_HUMIDITY, (int32_t)lroundf(hum * 100.0f));
+    }
+    if (pres >= 0)
+    {
+        publish(ESS_PRESSURE, (int32_t)lroundf(pres * 1000.0f)); // hPa -> 0.1 Pa
+    }
+}
+
+/**
+ * @brief Escribe un valor en su característica y lo notifica si el disparador se cumple.
+ * @param quantity Magnitud a publicar.
+ * @param value Valor en las unidades de la característica.
+ */
+void EnvironmentalSensing::publish(EssQuantity quantity, int32_t value)
+{
+    const EssQuantityInfo &info = ESS_QUANTITIES[quantity];
+    uint8_t bytes[4];
+    for (int i = 0; i < info.valueSize; i++)
+    {
+        bytes[i] = (uint8_t)((uint32_t)value >> (8 * i));
+    }
+    gatt->setValue(handles[quantity], bytes, info.valueSize);
+
+    // La evaluación y el registro de la notificación van juntos en la sección
+    // crítica: una escritura del cliente entre ambos se perdería al sobrescribir
+    // `hasLastValue`. La notificación se envía ya fuera.
+    EssTrigger &trigger = triggers[quantity];
+    unsigned long now = millis();
+    lockTriggers();
+    bool fires = triggerFires(trigger, value, now);
+    if (fires)
+    {
+        trigger.hasLastValue = true;
+        trigger.lastValue = value;
+        trigger.lastNotifyTime = now;
+    }
+    unlockTriggers();
+    if (fires)
+    {
+        gatt->notify(handles[quantity]);
+    }
+}
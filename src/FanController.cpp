@@ -0,0 +1,204 @@
+/**
+ * @file FanController.cpp
+ * @brief Implementación del controlador PI en punto fijo del ventilador.
+ * @details Este archivo no depende de Arduino para poder ejecutarse también
+ * en el host contra un modelo térmico simulado.
+ */
+
+#include "FanController.h"
+#include <string.h>
+
+/** @brief Valor máximo del término integral, en Q16.16. */
+static const int64_t INTEGRAL_MAX = (int64_t)FAN_DUTY_MAX << 16;
+
+/**
+ * @brief Constructor de la clase FanController.
+ * @details La configuración por defecto mantiene el ventilador apagado hasta
+ * que se llame a `configure()`.
+ */
+FanController::FanController()
+{
+    cfg.setpoint = INT32_MAX;
+    cfg.hysteresis = 0;
+    cfg.kp = 0;
+    cfg.ki = 0;
+    cfg.minDuty = 0;
+    cfg.spinUpDuty = 0;
+    cfg.spinUpMs = 0;
+    reset();
+}
+
+/**
+ * @brief Aplica una nueva sintonía.
+ * @details No reinicia el estado, así que se puede resintonizar en marcha.
+ * @param config Nuevos parámetros.
+ */
+void FanController::configure(const FanControllerConfig &config)
+{
+    cfg = config;
+}
+
+/**
+ * @brief Apaga el ventilador y borra el integrador.
+ */
+void FanController::reset()
+{
+    integral = 0;
+    spinUpRemainingMs = 0;
+    duty = 0;
+    run_duty = 0;
+    running = false;
+}
+
+/**
+ * @brief Ejecuta un paso del controlador.
+ * @param measurement Medida actual, en las unidades de la consigna.
+ * @param dtMs Tiempo transcurrido desde el paso anterior, en milisegundos.
+ * @return uint16_t El nuevo duty, entre 0 y `FAN_DUTY_MAX`.
+ */
+uint16_t FanController::update(int32_t measurement, uint32_t dtMs)
+{
+    // Error positivo = hace falta refrigerar.
+    int64_t error = (int64_t)measurement - cfg.setpoint;
+
+    // --- Histéresis de encendido/apagado ---
+    if (!running && error > 0)
+    {
+        running = true;
+        integral = 0;
+        spinUpRemainingMs = cfg.spinUpMs;
+    }
+    else if (running && error < -(int64_t)cfg.hysteresis)
+    {
+        reset();
+        return duty;
+    }
+    if (!running)
+    {
+        return duty;
+    }
+
+    // --- Término proporcional ---
+    int64_t proportional = (cfg.kp * error) >> 16;
+    int64_t output = proportional + (integral >> 16);
+
+    // --- Término integral con anti-windup ---
+    // Solo se integra si la salida no está saturada en la dirección del error.
+    bool saturatedHigh = output >= FAN_DUTY_MAX && error > 0;
+    bool saturatedLow = output <= cfg.minDuty && error < 0;
+    if (!saturatedHigh && !saturatedLow)
+    {
+        integral += (cfg.ki * error * (int64_t)dtMs) / 1000;
+        if (integral < 0)
+        {
+            integral = 0;
+        }
+        else if (integral > INTEGRAL_MAX)
+        {
+            integral = INTEGRAL_MAX;
+        }
+        output = proportional + (integral >> 16);
+    }
+
+    // --- Límites y arranque ---
+    if (output < cfg.minDuty)
+    {
+        output = cfg.minDuty;
+    }
+    if (output > FAN_DUTY_MAX)
+    {
+        output = FAN_DUTY_MAX;
+    }
+    run_duty = (uint16_t)output;
+    if (spinUpRemainingMs > 0)
+    {
+        if (output < cfg.spinUpDuty)
+        {
+            output = cfg.spinUpDuty;
+        }
+        spinUpRemainingMs = dtMs >= spinUpRemainingMs ? 0 : spinUpRemainingMs - dtMs;
+    }
+
+    duty = (uint16_t)output;
+    return duty;
+}
+
+/**
+ * @brief Obtiene el último duty calculado.
+ * @return uint16_t Duty entre 0 y `FAN_DUTY_MAX`.
+ */
+uint16_t FanController::getDuty() const
+{
+    return duty;
+}
+
+/**
+ * @brief Obtiene el duty que tendrá el ventilador al terminar el arranque.
+ * @return uint16_t Salida PI del último paso, entre `minDuty` y `FAN_DUTY_MAX`.
+ */
+uint16_t FanController::getRunDuty() const
+{
+    return run_duty;
+}
+
+/**
+ * @brief Obtiene el tiempo de arranque que queda tras el último paso.
+ * @details Permite terminar el arranque a su hora aunque el siguiente paso
+ * llegue más tarde.
+ * @return uint32_t Milisegundos, 0 si no hay arranque en curso.
+ */
+uint32_t FanController::getSpinUpRemainingMs() const
+{
+    return spinUpRemainingMs;
+}
+
+/**
+ * @brief Indica si el controlador tiene el ventilador en marcha.
+ * @return bool `true` si el ventilador está girando.
+ */
+bool FanController::isRunning() const
+{
+    return running;
+}
+
+/**
+ * @brief Valida un comando del ventilador recibido por BLE.
+ * @details Comandos aceptados: "AUTO", "ON" (100 %), "OFF" o un porcentaje
+ * entero de "0" a "100". Cualquier otro texto, incluido el vacío, se rechaza.
+ * @param text Comando terminado en '\0'.
+ * @param command Comando decodificado; solo se escribe si es válido.
+ * @return bool `true` si el comando es válido.
+ */
+bool parseFanCommand(const char *text, FanCommand &command)
+{
+    if (strcmp(text, "AUTO") == 0)
+    {
+        command = {true, 0};
+        return true;
+    }
+    if (strcmp(text, "ON") == 0 || strcmp(text, "OFF") == 0)
+    {
+        command = {false, text[1] == 'N' ? FAN_DUTY_MAX : (uint16_t)0};
+        return true;
+    }
+    size_t len = strlen(text);
+    if (len == 0 || len > 3)
+    {
+        return false;
+    }
+    uint32_t percent = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (text[i] < '0' || text[i] > '9')
+        {
+            return false;
+        }
+        percent = percent * 10 + (uint32_t)(text[i] - '0');
+    }
+    if (percent > 100)
+    {
+        return false;
+    }
+    command = {false, (uint16_t)((percent * FAN_DUTY_MAX + 50) / 100)};
+    return true;
+}
@@ -0,0 +1,239 @@
+/**
+ * @file HistoryLog.cpp
+ * @brief Implementación de la clase HistoryLog para el historial persistente.
+ * @details Comprime las muestras en bloques delta-de-delta (ver SampleCodec.h),
+ * los guarda en LittleFS y permite descargarlos por fragmentos a través de BLE.
+ */
+
+#include "HistoryLog.h"
+
+/** @brief Archivo con los bloques más recientes. */
+static const char *HISTORY_FILE = "/history.bin";
+/** @brief Archivo con los bloques anteriores a la última rotación. */
+static const char *HISTORY_OLD_FILE = "/history.old";
+/** @brief Archivos enviados en una descarga, del más antiguo al más reciente. */
+static const char *TRANSFER_FILES[] = {HISTORY_OLD_FILE, HISTORY_FILE};
+
+/**
+ * @brief Convierte una magnitud física a punto fijo con redondeo.
+ * @param value Valor físico.
+ * @param scale Factor de escala.
+ * @return int32_t Valor en punto fijo.
+ */
+static int32_t toFixedPoint(float value, float scale)
+{
+    return (int32_t)lroundf(value * scale);
+}
+
+/**
+ * @brief Constructor de la clase HistoryLog.
+ */
+HistoryLog::HistoryLog()
+{
+    fs_ready = false;
+    transfer_active = false;
+    transfer_file_index = 0;
+    transfer_remaining = 0;
+    transfer_file_sizes[0] = 0;
+    transfer_file_sizes[1] = 0;
+    open_block_len = 0;
+    open_block_pos = 0;
+}
+
+/**
+ * @brief Monta el sistema de archivos del historial.
+ * @details Si LittleFS no se puede montar, se formatea la partición. Si aun así
+ * falla, el historial queda desactivado pero el resto del sistema sigue funcionando.
+ */
+void HistoryLog::init()
+{
+    fs_ready = LittleFS.begin(true);
+    if (fs_ready)
+    {
+        Serial.println("Historial inicializado en LittleFS.");
+    }
+    else
+    {
+        Serial.println("ADVERTENCIA: No se pudo montar LittleFS. El historial está desactivado.");
+    }
+}
+
+/**
+ * @brief Añade una muestra al historial.
+ * @details La muestra se convierte a punto fijo y se comprime en el bloque
+ * actual. Cuando el bloque se llena se escribe en flash y se empieza otro,
+ * cuya primera muestra es un keyframe.
+ * @param data Lecturas de los sensores.
+ */
+void HistoryLog::record(const SensorData &data)
+{
+    HistorySample sample;
+    sample.fields[FIELD_TEMPERATURE] = toFixedPoint(data.temperature, 100.0f);
+    sample.fields[FIELD_HUMIDITY] = toFixedPoint(data.humidity, 100.0f);
+    sample.fields[FIELD_PRESSURE] = toFixedPoint(data.pressure, 10.0f);
+    sample.fields[FIELD_CO2] = data.co2;
+
+    if (!encoder.append(sample))
+    {
+        flushBlock();
+        encoder.append(sample);
+    }
+    if (encoder.isFull())
+    {
+        flushBlock();
+    }
+}
+
+/**
+ * @brief Escribe el bloque actual en flash y reinicia el codificador.
+ * @details Rota el archivo si supera `MAX_FILE_SIZE`, salvo durante una
+ * descarga, para no mover un archivo que se está leyendo.
+ */
+void HistoryLog::flushBlock()
+{
+    uint8_t block[CODEC_MAX_BLOCK_SIZE];
+    size_t len = encoder.finalize(block, sizeof(block));
+    encoder.reset();
+    if (!fs_ready || len == 0)
+    {
+        return;
+    }
+
+    File file = LittleFS.open(HISTORY_FILE, FILE_APPEND);
+    if (!file)
+    {
+        Serial.println("Error al abrir el archivo de historial.");
+        return;
+    }
+    file.write(block, len);
+    size_t size = file.size();
+    file.close();
+
+    if (size >= MAX_FILE_SIZE && !transfer_active)
+    {
+        LittleFS.remove(HISTORY_OLD_FILE);
+        LittleFS.rename(HISTORY_FILE, HISTORY_OLD_FILE);
+        Serial.println("Archivo de historial rotado.");
+    }
+}
+
+/**
+ * @brief Prepara la descarga completa del historial.
+ * @details Captura el tamaño actual de cada archivo y una copia del bloque
+ * abierto, de modo que las muestras que lleguen durante la descarga no
+ * alteran lo que se envía.
+ * @return bool `true` si la descarga se ha iniciado.
+ */
+bool HistoryLog::beginTransfer()
+{
+    cancelTransfer();
+    for (int i = 0; i < 2; i++)
+    {
+        transfer_file_sizes[i] = 0;
+        if (fs_ready && LittleFS.exists(TRANSFER_FILES[i]))
+        {
+            File file = LittleFS.open(TRANSFER_FILES[i], FILE_READ);
+            transfer_file_sizes[i] = file ? file.size() : 0;
+            file.close();
+        }
+    }
+    open_block_len = encoder.finalize(open_block, sizeof(open_block));
+    open_block_pos = 0;
+    transfer_file_index = -1;
+    transfer_remaining = 0;
+    transfer_active = true;
+    Serial.printf("Descarga de historial iniciada (%u + %u + %u bytes).\n",
+                  (unsigned)transfer_file_sizes[0], (unsigned)transfer_file_sizes[1], (unsigned)open_block_len);
+    return true;
+}
+
+/**
+ * @brief Abre el siguiente archivo con datos pendientes de enviar.
+ * @return bool `true` si hay un archivo abierto; `false` si ya no quedan.
+ */
+bool HistoryLog::openNextTransferFile()
+{
+    while (++transfer_file_index < 2)
+    {
+        if (transfer_file_sizes[transfer_file_index] == 0)
+        {
+            continue;
+        }
+        transfer_file = LittleFS.open(TRANSFER_FILES[transfer_file_index], FILE_READ);
+        if (transfer_file)
+        {
+            transfer_remaining = transfer_file_sizes[transfer_file_index];
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Obtiene el siguiente fragmento de la descarga.
+ * @details Envía primero el archivo rotado, luego el actual y por último la
+ * copia del bloque abierto.
+ * @param out Buffer de salida.
+ * @param maxLen Tamaño máximo del fragmento.
+ * @return size_t Bytes escritos en `out`; 0 cuando la descarga ha terminado.
+ */
+size_t HistoryLog::readTransfer(uint8_t *out, size_t maxLen)
+{
+    if (!transfer_active)
+    {
+        return 0;
+    }
+
+    // --- Archivos en flash ---
+    while (transfer_remaining > 0 || openNextTransferFile())
+    {
+        size_t len = transfer_file.read(out, min(maxLen, transfer_remaining));
+        if (len > 0)
+        {
+            transfer_remaining -= len;
+            if (transfer_remaining == 0)
+            {
+                transfer_file.close();
+            }
+            return len;
+        }
+        // Archivo más corto de lo esperado: se pasa al siguiente.
+        transfer_remaining = 0;
+        transfer_file.close();
+    }
+
+    // --- Bloque abierto ---
+    if (open_block_pos < open_block_len)
+    {
+        size_t len = min(maxLen, open_block_len - open_block_pos);
+        memcpy(out, &open_block[open_block_pos], len);
+        open_block_pos += len;
+        return len;
+    }
+
+    transfer_active = false;
+    Serial.println("Descarga de historial completada.");
+    return 0;
+}
+
+/**
+ * @brief Cancela la descarga en curso, si la hay.
+ */
+void HistoryLog::cancelTransfer()
+{
+    if (transfer_remaining > 0)
+    {
+        transfer_file.close();
+    }
+    transfer_remaining = 0;
+    transfer_active = false;
+}
+
+/**
+ * @brief Indica si hay una descarga en curso.
+ * @return bool `true` si quedan fragmentos por enviar.
+ */
+bool HistoryLog::isTransferActive()
+{
+    return transfer_active;
+}
@@ -0,0 +1,290 @@
+/**
+ * @file HostGattServer.cpp
+ * @brief Implementación del servidor GATT en memoria para la simulación en el host.
+ */
+
+#include "HostGattServer.h"
+#include "BroadcastPayload.h"
+
+#if defined(GATT_BACKEND_HOST)
+
+/**
+ * @brief Constructor de la clase HostGattServer.
+ */
+HostGattServer::HostGattServer()
+{
+    event_handler = nullptr;
+    params = {0, 0, 0, 0};
+    mtu = 23;
+    connected = false;
+    advertising = false;
+    connectable = false;
+}
+
+/**
+ * @brief Guarda el receptor de eventos; no hay pila que inicializar.
+ */
+bool HostGattServer::begin(const char *deviceName, GattEventHandler onEvent)
+{
+    (void)deviceName;
+    event_handler = onEvent;
+    return true;
+}
+
+/**
+ * @brief Los servicios no se modelan: todas las características comparten una tabla.
+ */
+void HostGattServer::beginService(const GattUuid &uuid, uint16_t numHandles)
+{
+    (void)uuid;
+    (void)numHandles;
+}
+
+/**
+ * @brief Añade una característica a la tabla.
+ */
+GattHandle HostGattServer::addCharacteristic(const GattUuid &uuid, uint8_t properties, GattWriteHandler onWrite, void *context)
+{
+    characteristics.push_back({uuid, "", GATT_INVALID_HANDLE, properties, onWrite, context, nullptr, nullptr});
+    return (GattHandle)(characteristics.size() - 1);
+}
+
+/**
+ * @brief Añade un descriptor de una característica.
+ */
+void HostGattServer::addDescriptor(GattHandle characteristic, const GattUuid &uuid, const uint8_t *value, size_t len,
+                                   size_t maxLen, GattWriteHandler onWrite, void *context)
+{
+    (void)maxLen;
+    descriptors.push_back({uuid, std::string((const char *)value, len), characteristic,
+                           (uint8_t)(GATT_PROP_READ | (onWrite != nullptr ? GATT_PROP_WRITE : 0)), onWrite, context,
+                           nullptr, nullptr});
+}
+
+/**
+ * @brief Hace que el valor de una característica se genere en cada lectura del cliente.
+ */
+void HostGattServer::setReadHandler(GattHandle handle, GattReadHandler onRead, void *context)
+{
+    characteristics[handle].onRead = onRead;
+    characteristics[handle].readContext = context;
+}
+
+/**
+ * @brief Cambia el valor que leerá el cliente.
+ */
+void HostGattServer::setValue(GattHandle handle, const uint8_t *data, size_t len)
+{
+    characteristics[handle].value.assign((const char *)data, len);
+}
+
+/**
+ * @brief Encola una notificación si hay cliente conectado.
+ * @details No se comprueba el CCCD: el cliente virtual recibe todo.
+ */
+void HostGattServer::notify(GattHandle handle)
+{
+    if (connected)
+    {
+        notifications.push_back({characteristics[handle].uuid, characteristics[handle].value, false});
+    }
+}
+
+/**
+ * @brief Encola una indicación si hay cliente conectado; se da por confirmada.
+ */
+void HostGattServer::indicate(GattHandle handle)
+{
+    if (connected)
+    {
+        notifications.push_back({characteristics[handle].uuid, characteristics[handle].value, true});
+    }
+}
+
+/**
+ * @brief Guarda el paquete de publicidad para que el escenario lo inspeccione.
+ * @details Se arma igual que en las pilas reales, así que el escenario ve el
+ * nombre recortado y puede decodificarlo como un escáner.
+ */
+void HostGattServer::setAdvertisingData(const char *name, const uint8_t *manufacturerData, size_t len)
+{
+    manufacturer_data.assign(manufacturerData != nullptr ? (const char *)manufacturerData : "", manufacturerData != nullptr ? len : 0);
+    uint8_t raw[ADV_DATA_MAX_LEN];
+    size_t rawLen = buildAdvertisingData(name, manufacturerData, len, raw);
+    advertising_data.assign((const char *)raw, rawLen);
+}
+
+/**
+ * @brief Marca el servidor como visible (y conectable o no).
+ */
+void HostGattServer::startAdvertising(bool connectable)
+{
+    advertising = true;
+    this->connectable = connectable;
+}
+
+/**
+ * @brief Registra los parámetros pedidos como si el cliente los aceptara.
+ * @details Se acuerda el intervalo máximo pedido, como hacen la mayoría de clientes.
+ */
+void HostGattServer::requestConnectionParams(const GattConnectionParams &params)
+{
+    if (connected)
+    {
+        this->params = params;
+        this->params.minInterval = params.maxInterval;
+    }
+}
+
+/**
+ * @brief Parámetros acordados en la conexión simulada.
+ */
+bool HostGattServer::getConnectionParams(GattConnectionParams &params)
+{
+    params = this->params;
+    return connected && params.maxInterval != 0;
+}
+
+// --- Cliente virtual ---
+
+/**
+ * @brief Conecta el cliente virtual.
+ * @param clientMtu MTU que negocia el cliente.
+ * @return bool `false` si ya hay un cliente o no se acepta conexión.
+ */
+bool HostGattServer::clientConnect(uint16_t clientMtu)
+{
+    if (connected || !advertising || !connectable)
+    {
+        return false;
+    }
+    connected = true;
+    advertising = false; // Como el controlador real, deja de publicitar al conectar
+    mtu = clientMtu;
+    event_handler(GATT_EVENT_CONNECT);
+    return true;
+}
+
+/**
+ * @brief Desconecta el cliente virtual y descarta lo que no llegó a leer.
+ */
+void HostGattServer::clientDisconnect()
+{
+    if (!connected)
+    {
+        return;
+    }
+    connected = false;
+    mtu = 23;
+    params = {0, 0, 0, 0};
+    notifications.clear();
+    event_handler(GATT_EVENT_DISCONNECT);
+}
+
+/**
+ * @brief Escribe en una característica como lo haría el cliente.
+ * @return bool `false` si no hay conexión o la característica no admite escritura.
+ */
+bool HostGattServer::clientWrite(const GattUuid &uuid, const std::string &value)
+{
+    int index = find(uuid);
+    if (!connected || index < 0 || !(characteristics[index].properties & GATT_PROP_WRITE))
+    {
+        return false;
+    }
+    Attribute &attribute = characteristics[index];
+    attribute.value = value;
+    if (attribute.onWrite != nullptr)
+    {
+        attribute.onWrite(attribute.context, (const uint8_t *)value.data(), value.size());
+    }
+    return true;
+}
+
+/**
+ * @brief Escribe en un descriptor de una característica.
+ * @return bool `false` si no existe o no admite escritura.
+ */
+bool HostGattServer::clientWriteDescriptor(const GattUuid &uuid, const GattUuid &descriptorUuid, const std::string &value)
+{
+    int owner = find(uuid);
+    if (!connected || owner < 0)
+    {
+        return false;
+    }
+    for (Attribute &descriptor : descriptors)
+    {
+        if (descriptor.owner == owner && gattUuidEquals(descriptor.uuid, descriptorUuid) && descriptor.onWrite != nullptr)
+        {
+            descriptor.value = value;
+            descriptor.onWrite(descriptor.context, (const uint8_t *)value.data(), value.size());
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Lee una característica como lo haría el cliente.
+ * @details Si la característica tiene callback de lectura, el valor se genera
+ * en ese momento, como en la pila real.
+ * @return bool `false` si no hay conexión o no admite lectura.
+ */
+bool HostGattServer::clientRead(const GattUuid &uuid, std::string &value)
+{
+    int index = find(uuid);
+    if (!connected || index < 0 || !(characteristics[index].properties & GATT_PROP_READ))
+    {
+        return false;
+    }
+    Attribute &attribute = characteristics[index];
+    if (attribute.onRead != nullptr)
+    {
+        uint8_t buffer[GATT_READ_BUFFER_LEN];
+        size_t len = attribute.onRead(attribute.readContext, buffer, sizeof(buffer));
+        attribute.value.assign((const char *)buffer, len);
+    }
+    value = attribute.value;
+    return true;
+}
+
+/**
+ * @brief Saca la notificación o indicación más antigua recibida por el cliente.
+ */
+bool HostGattServer::popNotification(HostGattNotification &notification)
+{
+    if (notifications.empty())
+    {
+        return false;
+    }
+    notification = notifications.front();
+    notifications.pop_front();
+    return true;
+}
+
+/**
+ * @brief Busca una característica por UUID.
+ * @return int Índice, o -1 si no existe.
+ */
+int HostGattServer::find(const GattUuid &uuid) const
+{
+    for (size_t i = 0; i < characteristics.size(); i++)
+    {
+        if (gattUuidEquals(characteristics[i].uuid, uuid))
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Servidor GATT en memoria.
+ */
+GattServer &gattServer()
+{
+    static HostGattServer server;
+    return server;
+}
+
+#endif // GATT_BACKEND_HOST
@@ -0,0 +1,251 @@
+/**
+ * @file I2CInventory.cpp
+ * @brief Implementación del inventario incremental del bus I2C.
+ * @details Sustituye al antiguo `scan()`, que recorría todas las direcciones de
+ * golpe y luego esperaba 5 segundos, por un sondeo repartido entre ciclos del
+ * bucle principal.
+ */
+
+#include "I2CInventory.h"
+#include <Wire.h>
+
+/**
+ * @struct ChipSignature
+ * @brief Valor esperado del registro de ID de un chip en una dirección concreta.
+ */
+struct ChipSignature
+{
+    uint8_t address;
+    uint8_t idRegister;
+    uint8_t idValue;
+    I2CChip chip;
+};
+
+/** @brief Chips reconocidos. Solo se lee el registro de ID en estas direcciones. */
+static const ChipSignature CHIP_SIGNATURES[] = {
+    {0x76, 0xD0, 0x58, CHIP_BMP280},
+    {0x77, 0xD0, 0x58, CHIP_BMP280},
+    {0x76, 0xD0, 0x60, CHIP_BME280},
+    {0x77, 0xD0, 0x60, CHIP_BME280},
+    {0x77, 0xD0, 0x55, CHIP_BMP180},
+    {0x5A, 0x20, 0x81, CHIP_CCS811},
+    {0x5B, 0x20, 0x81, CHIP_CCS811},
+};
+
+/** @brief Nombres de `I2CChip`, en el mismo orden que la enumeración. */
+static const char *const CHIP_NAMES[] = {"UNKNOWN", "BMP180", "BMP280", "BME280", "CCS811"};
+
+/**
+ * @brief Constructor de la clase I2CInventory.
+ * @details El inventario empieza vacío y sin pasada en curso.
+ */
+I2CInventory::I2CInventory()
+{
+    device_count = 0;
+    pending_count = 0;
+    next_address = 0;
+    changed = false;
+}
+
+/**
+ * @brief Empieza una nueva pasada por todo el bus.
+ * @details El inventario publicado se mantiene hasta que la nueva pasada termine.
+ */
+void I2CInventory::restart()
+{
+    pending_count = 0;
+    next_address = FIRST_ADDRESS;
+}
+
+/**
+ * @brief Sondea las siguientes `PROBES_PER_STEP` direcciones de la pasada en curso.
+ * @details Al terminar la pasada, sustituye el inventario publicado y marca el
+ * cambio si la lista de dispositivos es distinta.
+ * @return bool `true` si esta llamada completó la pasada.
+ */
+bool I2CInventory::step()
+{
+    if (next_address == 0)
+    {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < PROBES_PER_STEP && next_address <= LAST_ADDRESS; i++)
+    {
+        probe(next_address++);
+    }
+    if (next_address <= LAST_ADDRESS)
+    {
+        return false;
+    }
+    next_address = 0;
+
+    bool same = pending_count == device_count;
+    for (uint8_t i = 0; same && i < pending_count; i++)
+    {
+        same = pending[i].address == devices[i].address && pending[i].chip == devices[i].chip;
+    }
+    memcpy(devices, pending, sizeof(I2CDevice) * pending_count);
+    device_count = pending_count;
+    changed = changed || !same;
+    return true;
+}
+
+/**
+ * @brief Completa de forma síncrona la pasada en curso (o una nueva si no hay ninguna).
+ * @details Pensado para el arranque, antes de elegir los drivers: tarda unos
+ * 12 ms con el bus a 100 kHz.
+ */
+void I2CInventory::scanAll()
+{
+    if (next_address == 0)
+    {
+        restart();
+    }
+    while (!step())
+    {
+    }
+}
+
+/**
+ * @brief Indica si hay una pasada en curso.
+ */
+bool I2CInventory::isScanning()
+{
+    return next_address != 0;
+}
+
+/**
+ * @brief Indica si el inventario cambió desde la última llamada y limpia el aviso.
+ */
+bool I2CInventory::hasChanged()
+{
+    bool result = changed;
+    changed = false;
+    return result;
+}
+
+/**
+ * @brief Busca el primer dispositivo del chip indicado.
+ * @param chip Chip buscado.
+ * @return const I2CDevice* El dispositivo, o `nullptr` si no está en el bus.
+ */
+const I2CDevice *I2CInventory::find(I2CChip chip) const
+{
+    for (uint8_t i = 0; i < device_count; i++)
+    {
+        if (devices[i].chip == chip)
+        {
+            return &devices[i];
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Obtiene el número de dispositivos del inventario publicado.
+ */
+uint8_t I2CInventory::getDeviceCount() const
+{
+    return device_count;
+}
+
+/**
+ * @brief Obtiene un dispositivo del inventario publicado.
+ * @param index Posición, menor que `getDeviceCount()`.
+ */
+const I2CDevice &I2CInventory::getDevice(uint8_t index) const
+{
+    return devices[index];
+}
+
+/**
+ * @brief Describe el inventario publicado en texto.
+ * @return String Pares `dirección=chip` separados por ';', o "NONE" si el bus está vacío.
+ */
+String I2CInventory::describe() const
+{
+    if (device_count == 0)
+    {
+        return String("NONE");
+    }
+    String text;
+    char entry[16];
+    for (uint8_t i = 0; i < device_count; i++)
+    {
+        snprintf(entry, sizeof(entry), "%s0x%02X=%s", i > 0 ? ";" : "",
+                 devices[i].address, CHIP_NAMES[devices[i].chip]);
+        text += entry;
+    }
+    return text;
+}
+
+/**
+ * @brief Sondea una dirección y, si responde, la añade a la pasada en curso.
+ * @param address Dirección de 7 bits.
+ */
+void I2CInventory::probe(uint8_t address)
+{
+    Wire.beginTransmission(address);
+    if (Wire.endTransmission() != 0 || pending_count >= MAX_DEVICES)
+    {
+        return;
+    }
+    I2CDevice &device = pending[pending_count++];
+    device.address = address;
+    device.chipId = 0;
+    device.chip = identify(address, device.chipId);
+}
+
+/**
+ * @brief Identifica el chip de una dirección leyendo su registro de ID.
+ * @param address Dirección de 7 bits.
+ * @param chipId Valor leído del registro de ID, si se leyó alguno.
+ * @return I2CChip El chip reconocido, o `CHIP_UNKNOWN`.
+ */
+I2CChip I2CInventory::identify(uint8_t address, uint8_t &chipId)
+{
+    int lastRegister = -1;
+    uint8_t value = 0;
+    for (const ChipSignature &signature : CHIP_SIGNATURES)
+    {
+        if (signature.address != address)
+        {
+            continue;
+        }
+        // Las firmas de una misma dirección suelen compartir registro: se lee una sola vez.
+        if (signature.idRegister != lastRegister)
+        {
+            if (!readRegister(address, signature.idRegister, value))
+            {
+                return CHIP_UNKNOWN;
+            }
+            lastRegister = signature.idRegister;
+            chipId = value;
+        }
+        if (value == signature.idValue)
+        {
+            return signature.chip;
+        }
+    }
+    return CHIP_UNKNOWN;
+}
+
+/**
+ * @brief Lee un registro de 8 bits de un dispositivo.
+ * @param address Dirección de 7 bits.
+ * @param reg Registro a leer.
+ * @param value Valor leído.
+ * @return bool `true` si el dispositivo respondió.
+ */
+bool I2CInventory::readRegister(uint8_t address, uint8_t reg, uint8_t &value)
+{
+    Wire.beginTransmission(address);
+    Wire.write(reg);
+    if (Wire.endTransmission(false) != 0 || Wire.requestFrom(address, (uint8_t)1) != 1)
+    {
+        return false;
+    }
+    value = Wire.read();
+    return true;
+}
@@ -0,0 +1,438 @@
+/**
+ * @file Mhz19Link.cpp
+ * @brief Implementación del transporte de tramas del MH-Z19C.
+ */
+
+#include "Mhz19Link.h"
+
+/**
+ * @brief Constructor de la clase Mhz19Link.
+ * @param port UART de la capa Arduino conectado al sensor (normalmente
+ * Serial2); solo se usa en la simulación.
+ * @param uartNum UART del driver de ESP-IDF correspondiente a `port`.
+ */
+Mhz19Link::Mhz19Link(HardwareSerial &port, uint8_t uartNum) : port(port)
+{
+    uart_num = uartNum;
+    rx_pin = -1;
+    tx_pin = -1;
+    started = false;
+    read_pending = false;
+    queue_count = 0;
+    dropped_frames = 0;
+#ifdef MHZ19_UART_IDF
+    events = nullptr;
+    frame_len = 0;
+    response_ready = false;
+    waiter = nullptr;
+    rx_running = false;
+#endif
+}
+
+#ifdef MHZ19_UART_IDF
+
+/**
+ * @brief Instala el driver UART, lanza la tarea de recepción y envía los
+ * comandos encolados.
+ * @param rxPin Pin RX del ESP32 conectado al TX del sensor.
+ * @param txPin Pin TX del ESP32 conectado al RX del sensor.
+ */
+void Mhz19Link::begin(int rxPin, int txPin)
+{
+    rx_pin = rxPin;
+    tx_pin = txPin;
+    install();
+    started = true;
+    finishRead();
+}
+
+/**
+ * @brief Reinicia el periférico: desinstala el driver UART y lo vuelve a instalar.
+ * @details Vaciar el buffer no basta para recuperar el enlace: tras ruido en
+ * la línea pueden quedar la FIFO de recepción, la cola de posiciones de
+ * cabecera o la cola de eventos en un estado que el driver no limpia. Antes
+ * de borrar la cola de eventos se detiene la tarea de recepción, que lee de
+ * ella; si no se detiene a tiempo, solo se vacía la entrada.
+ */
+void Mhz19Link::reopen()
+{
+    if (!started)
+    {
+        return; // Sin driver todavía: lo instalará `begin()`
+    }
+    uart_port_t uart = (uart_port_t)uart_num;
+    uart_event_t stop = {};
+    stop.type = UART_EVENT_MAX; // Ningún evento del driver: pide a `rxTask` que termine
+    xQueueReset(events);
+    bool stopped = xQueueSendToFront(events, &stop, pdMS_TO_TICKS(STOP_TIMEOUT_MS)) == pdTRUE;
+    for (uint32_t waited = 0; stopped && rx_running.load(std::memory_order_acquire); waited++)
+    {
+        if (waited >= STOP_TIMEOUT_MS)
+        {
+            stopped = false;
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    if (!stopped)
+    {
+        Serial.println("MH-Z19C: la tarea de recepción no se detuvo; solo se vacía el UART.");
+        discardInput();
+        finishRead();
+        return;
+    }
+
+    uart_driver_delete(uart);
+    events = nullptr;
+    frame_len = 0;
+    response_ready.store(false, std::memory_order_relaxed);
+    install();
+    finishRead();
+}
+
+/**
+ * @brief Instala el driver UART a 9600 baudios, con cola de eventos y
+ * detección de cabeceras, y lanza la tarea de recepción.
+ */
+void Mhz19Link::install()
+{
+    uart_port_t uart = (uart_port_t)uart_num;
+    uart_config_t config = {};
+    config.baud_rate = 9600;
+    config.data_bits = UART_DATA_8_BITS;
+    config.parity = UART_PARITY_DISABLE;
+    config.stop_bits = UART_STOP_BITS_1;
+    config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+    config.source_clk = UART_SCLK_APB;
+    uart_driver_install(uart, RX_BUFFER_SIZE, TX_BUFFER_SIZE, EVENT_QUEUE_SIZE, &events, 0);
+    uart_param_config(uart, &config);
+    uart_set_pin(uart, tx_pin, rx_pin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    // Un solo 0xFF tras un silencio: la cabecera de una trama.
+    uart_enable_pattern_det_baud_intr(uart, 0xFF, 1, 1, 0, PATTERN_PRE_IDLE);
+    uart_pattern_queue_reset(uart, EVENT_QUEUE_SIZE);
+    // Por encima del bucle principal, para entregar la respuesta en cuanto llega.
+    rx_running.store(true, std::memory_order_release);
+    xTaskCreatePinnedToCore(rxTask, "mhz19Rx", 2048, this, 5, nullptr, tskNO_AFFINITY);
+}
+
+#else
+
+/**
+ * @brief Abre el UART a 9600 baudios y envía los comandos encolados antes de abrirlo.
+ * @param rxPin Pin RX del ESP32 conectado al TX del sensor.
+ * @param txPin Pin TX del ESP32 conectado al RX del sensor.
+ */
+void Mhz19Link::begin(int rxPin, int txPin)
+{
+    rx_pin = rxPin;
+    tx_pin = txPin;
+    port.begin(9600, SERIAL_8N1, rx_pin, tx_pin);
+    started = true;
+    finishRead();
+}
+
+/**
+ * @brief Cierra y vuelve a abrir el UART, descartando cualquier trama a medias.
+ */
+void Mhz19Link::reopen()
+{
+    port.end();
+    port.begin(9600, SERIAL_8N1, rx_pin, tx_pin);
+    discardInput();
+    finishRead();
+}
+
+#endif
+
+/**
+ * @brief Envía un comando al sensor, o lo encola si hay una lectura en curso.
+ * @param command Byte de comando (ej. `CMD_ZERO_POINT`).
+ * @param b3 Bytes 3 a 7 de la trama (argumentos del comando).
+ * @return bool `false` si la cola está llena y el comando se descartó.
+ */
+bool Mhz19Link::sendCommand(uint8_t command, uint8_t b3, uint8_t b4, uint8_t b5, uint8_t b6, uint8_t b7)
+{
+    uint8_t args[6] = {command, b3, b4, b5, b6, b7};
+    if (started && !read_pending)
+    {
+        writeFrame(args);
+        return true;
+    }
+    if (queue_count >= QUEUE_SIZE)
+    {
+        return false;
+    }
+    memcpy(queue[queue_count++], args, sizeof(args));
+    return true;
+}
+
+#ifdef MHZ19_UART_IDF
+
+/**
+ * @brief Solicita una lectura de CO2.
+ * @details La tarea que la pide recibirá una notificación cuando llegue la respuesta.
+ */
+void Mhz19Link::startRead()
+{
+    response_ready.store(false, std::memory_order_relaxed);
+    waiter.store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
+    uint8_t args[6] = {CMD_READ_CO2, 0, 0, 0, 0, 0};
+    writeFrame(args);
+    read_pending = true;
+}
+
+/**
+ * @brief Indica si la respuesta de la lectura en curso ya está completa.
+ * @details No toca el UART: la respuesta ya la ha armado la tarea de recepción.
+ */
+bool Mhz19Link::isResponseReady()
+{
+    return response_ready.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Copia la respuesta de la lectura en curso y termina la lectura.
+ * @param response Buffer de `FRAME_SIZE` bytes.
+ * @return bool `true` si había una respuesta (la tarea de recepción ya
+ * comprobó cabecera y checksum).
+ */
+bool Mhz19Link::readResponse(byte *response)
+{
+    bool ready = response_ready.load(std::memory_order_acquire);
+    if (ready)
+    {
+        memcpy(response, this->response, FRAME_SIZE);
+    }
+    finishRead();
+    return ready;
+}
+
+#else
+
+/**
+ * @brief Solicita una lectura de CO2.
+ */
+void Mhz19Link::startRead()
+{
+    discardInput(); // Respuestas de comandos anteriores o restos de una lectura fallida
+    uint8_t args[6] = {CMD_READ_CO2, 0, 0, 0, 0, 0};
+    writeFrame(args);
+    read_pending = true;
+}
+
+/**
+ * @brief Indica si la respuesta de la lectura en curso ya está completa.
+ */
+bool Mhz19Link::isResponseReady()
+{
+    return port.available() >= (int)FRAME_SIZE;
+}
+
+/**
+ * @brief Lee la respuesta de la lectura en curso y termina la lectura.
+ * @param response Buffer de `FRAME_SIZE` bytes.
+ * @return bool `true` si la cabecera y el checksum son correctos.
+ */
+bool Mhz19Link::readResponse(byte *response)
+{
+    size_t received = port.readBytes(response, FRAME_SIZE);
+    finishRead();
+    bool valid = received == FRAME_SIZE && response[0] == 0xFF && response[1] == CMD_READ_CO2 &&
+                 response[8] == mhz19Checksum(response);
+    if (!valid)
+    {
+        dropped_frames++;
+    }
+    return valid;
+}
+
+#endif
+
+/**
+ * @brief Da por perdida la lectura en curso.
+ */
+void Mhz19Link::abortRead()
+{
+    finishRead();
+}
+
+/**
+ * @brief Tramas descartadas: respuestas con cabecera o checksum incorrectos.
+ */
+uint32_t Mhz19Link::getDroppedFrames() const
+{
+    return dropped_frames;
+}
+
+/**
+ * @brief Escribe una trama completa en el buffer de transmisión.
+ * @param args Comando seguido de los bytes 3 a 7.
+ */
+void Mhz19Link::writeFrame(const uint8_t *args)
+{
+    byte frame[FRAME_SIZE] = {0xFF, 0x01, args[0], args[1], args[2], args[3], args[4], args[5], 0x00};
+    frame[8] = mhz19Checksum(frame);
+#ifdef MHZ19_UART_IDF
+    uart_write_bytes((uart_port_t)uart_num, (const char *)frame, FRAME_SIZE);
+#else
+    port.write(frame, FRAME_SIZE);
+#endif
+}
+
+/**
+ * @brief Termina la lectura en curso y envía los comandos que esperaban.
+ */
+void Mhz19Link::finishRead()
+{
+    read_pending = false;
+#ifdef MHZ19_UART_IDF
+    waiter.store(nullptr, std::memory_order_release);
+#endif
+    if (!started)
+    {
+        return;
+    }
+    for (uint8_t i = 0; i < queue_count; i++)
+    {
+        writeFrame(queue[i]);
+    }
+    queue_count = 0;
+}
+
+/**
+ * @brief Descarta los bytes recibidos que nadie espera.
+ */
+void Mhz19Link::discardInput()
+{
+#ifdef MHZ19_UART_IDF
+    uart_flush_input((uart_port_t)uart_num);
+    response_ready.store(false, std::memory_order_relaxed);
+#else
+    while (port.available() > 0)
+    {
+        port.read();
+    }
+#endif
+}
+
+#ifdef MHZ19_UART_IDF
+
+// --- Recepción por eventos ---
+
+/**
+ * @brief Tarea de recepción: espera en la cola de eventos del driver y arma las tramas.
+ * @details No consume CPU mientras la línea está en silencio.
+ * @param parameter El `Mhz19Link` que la lanzó.
+ */
+void Mhz19Link::rxTask(void *parameter)
+{
+    Mhz19Link *link = (Mhz19Link *)parameter;
+    uart_port_t uart = (uart_port_t)link->uart_num;
+    uart_event_t event;
+    for (;;)
+    {
+        if (xQueueReceive(link->events, &event, portMAX_DELAY) != pdTRUE)
+        {
+            continue;
+        }
+        if (event.type == UART_EVENT_MAX)
+        {
+            break; // `reopen()` va a desinstalar el driver
+        }
+        switch (event.type)
+        {
+        case UART_DATA:
+            link->receive(event.size);
+            break;
+        case UART_PATTERN_DET:
+        {
+            // Lo anterior a la cabecera es el resto de otra trama (o ruido).
+            int position = uart_pattern_pop_pos(uart);
+            if (position > 0)
+            {
+                link->receive(position);
+            }
+            if (link->frame_len > 0)
+            {
+                link->dropped_frames++; // Trama incompleta interrumpida por una cabecera
+                link->frame_len = 0;
+            }
+            size_t buffered = 0;
+            uart_get_buffered_data_len(uart, &buffered);
+            link->receive(buffered);
+            break;
+        }
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            uart_flush_input(uart);
+            xQueueReset(link->events);
+            link->frame_len = 0;
+            break;
+        default:
+            break;
+        }
+    }
+    link->rx_running.store(false, std::memory_order_release);
+    vTaskDelete(nullptr);
+}
+
+/**
+ * @brief Lee del driver los bytes ya recibidos, sin esperar.
+ * @param len Bytes a leer como mucho.
+ */
+void Mhz19Link::receive(size_t len)
+{
+    uint8_t buffer[32];
+    while (len > 0)
+    {
+        int chunk = uart_read_bytes((uart_port_t)uart_num, buffer, len < sizeof(buffer) ? len : sizeof(buffer), 0);
+        if (chunk <= 0)
+        {
+            return;
+        }
+        for (int i = 0; i < chunk; i++)
+        {
+            assemble(buffer[i]);
+        }
+        len -= chunk;
+    }
+}
+
+/**
+ * @brief Añade un byte a la trama en curso y entrega la trama al completarse.
+ * @details Solo se entrega la respuesta de una lectura en curso, una vez por
+ * lectura, y se notifica a la tarea que la pidió.
+ * @param b Byte recibido.
+ */
+void Mhz19Link::assemble(uint8_t b)
+{
+    if (frame_len == 0 && b != 0xFF)
+    {
+        return; // Fuera de trama: se espera una cabecera
+    }
+    frame[frame_len++] = b;
+    if (frame_len < FRAME_SIZE)
+    {
+        return;
+    }
+    frame_len = 0;
+    if (frame[8] != mhz19Checksum(frame))
+    {
+        dropped_frames++;
+        return;
+    }
+    if (frame[1] != CMD_READ_CO2)
+    {
+        return; // Respuesta a un comando de calibración o configuración
+    }
+    TaskHandle_t task = waiter.exchange(nullptr, std::memory_order_acq_rel);
+    if (task == nullptr)
+    {
+        return; // Respuesta tardía de una lectura abandonada
+    }
+    memcpy(response, frame, FRAME_SIZE);
+    response_ready.store(true, std::memory_order_release);
+    xTaskNotifyGive(task);
+}
+
+#endif
@@ -0,0 +1,358 @@
+/**
+ * @file NimBLEGattServer.cpp
+ * @brief Implementación del servidor GATT sobre la pila NimBLE.
+ * @details Es el backend por defecto; no se compila con `-D GATT_BACKEND_BLUEDROID`
+ * ni en la simulación.
+ */
+
+#include "NimBLEGattServer.h"
+#include "BroadcastPayload.h"
+
+#if defined(GATT_BACKEND_NIMBLE)
+
+// --- Estado compartido con las callbacks de la pila ---
+
+/** @brief Propietario de los eventos de conexión. */
+static GattEventHandler eventHandler = nullptr;
+/** @brief Handle de la conexión activa (`CONN_HANDLE_NONE` si no hay cliente). */
+static const uint16_t CONN_HANDLE_NONE = 0xFFFF;
+static volatile uint16_t connHandle = CONN_HANDLE_NONE;
+
+/**
+ * @class NimBLEServerEvents
+ * @brief Traduce las conexiones y desconexiones a eventos de la fachada.
+ */
+class NimBLEServerEvents : public NimBLEServerCallbacks
+{
+    void onConnect(NimBLEServer *pServer, ble_gap_conn_desc *desc) override
+    {
+        connHandle = desc->conn_handle;
+        eventHandler(GATT_EVENT_CONNECT);
+    }
+
+    void onDisconnect(NimBLEServer *pServer, ble_gap_conn_desc *desc) override
+    {
+        connHandle = CONN_HANDLE_NONE;
+        eventHandler(GATT_EVENT_DISCONNECT);
+    }
+};
+
+/**
+ * @class NimBLEGattCharacteristicCallbacks
+ * @brief Entrega las escrituras y lecturas de una característica a sus callbacks de la fachada.
+ */
+class NimBLEGattCharacteristicCallbacks : public NimBLECharacteristicCallbacks
+{
+public:
+    GattWriteHandler writeHandler = nullptr;
+    void *writeContext = nullptr;
+    GattReadHandler readHandler = nullptr;
+    void *readContext = nullptr;
+
+    void onWrite(NimBLECharacteristic *pCharacteristic) override
+    {
+        if (writeHandler != nullptr)
+        {
+            NimBLEAttValue value = pCharacteristic->getValue();
+            writeHandler(writeContext, value.data(), value.length());
+        }
+    }
+
+    /**
+     * @brief Genera el valor justo antes de que la pila responda a la lectura.
+     * @details NimBLE no vuelve a llamarlo en los fragmentos de una lectura larga.
+     */
+    void onRead(NimBLECharacteristic *pCharacteristic) override
+    {
+        if (readHandler != nullptr)
+        {
+            uint8_t buffer[GATT_READ_BUFFER_LEN];
+            size_t len = readHandler(readContext, buffer, sizeof(buffer));
+            pCharacteristic->setValue(buffer, len);
+        }
+    }
+};
+
+/**
+ * @class NimBLEDescriptorWriteCallbacks
+ * @brief Entrega las escrituras de un descriptor a su `GattWriteHandler`.
+ */
+class NimBLEDescriptorWriteCallbacks : public NimBLEDescriptorCallbacks
+{
+public:
+    NimBLEDescriptorWriteCallbacks(GattWriteHandler handler, void *context) : handler(handler), context(context) {}
+
+    void onWrite(NimBLEDescriptor *pDescriptor) override
+    {
+        NimBLEAttValue value = pDescriptor->getValue();
+        handler(context, value.data(), value.length());
+    }
+
+private:
+    GattWriteHandler handler;
+    void *context;
+};
+
+/**
+ * @brief Convierte un UUID de la fachada al tipo de la librería.
+ * @details Ambos guardan los bytes en little-endian: no se interpreta texto.
+ */
+static NimBLEUUID toNimBLEUUID(const GattUuid &uuid)
+{
+    return NimBLEUUID(uuid.bytes, uuid.len, false);
+}
+
+/**
+ * @brief Constructor de la clase NimBLEGattServer.
+ */
+NimBLEGattServer::NimBLEGattServer()
+{
+    server = nullptr;
+    service = nullptr;
+    characteristic_count = 0;
+}
+
+/**
+ * @brief Inicializa la pila NimBLE y crea el servidor.
+ * @details La publicidad no se reinicia sola al desconectar: lo decide el
+ * propietario con `startAdvertising()`, como con Bluedroid.
+ * @param deviceName Nombre del dispositivo.
+ * @param onEvent Receptor de los eventos de conexión.
+ */
+bool NimBLEGattServer::begin(const char *deviceName, GattEventHandler onEvent)
+{
+    eventHandler = onEvent;
+    NimBLEDevice::init(deviceName);
+    server = NimBLEDevice::createServer();
+    server->setCallbacks(new NimBLEServerEvents());
+    server->advertiseOnDisconnect(false);
+    return server != nullptr;
+}
+
+/**
+ * @brief Empieza un servicio nuevo.
+ * @param uuid UUID del servicio.
+ * @param numHandles Sin uso: NimBLE calcula los handles del servicio.
+ */
+void NimBLEGattServer::beginService(const GattUuid &uuid, uint16_t numHandles)
+{
+    (void)numHandles;
+    service = server->createService(toNimBLEUUID(uuid));
+}
+
+/**
+ * @brief Añade una característica al servicio en construcción.
+ * @return GattHandle Identificador, o `GATT_INVALID_HANDLE` si no caben más.
+ */
+GattHandle NimBLEGattServer::addCharacteristic(const GattUuid &uuid, uint8_t properties, GattWriteHandler onWrite, void *context)
+{
+    if (characteristic_count >= MAX_CHARACTERISTICS)
+    {
+        return GATT_INVALID_HANDLE;
+    }
+    uint32_t nimbleProperties = 0;
+    nimbleProperties |= (properties & GATT_PROP_READ) ? NIMBLE_PROPERTY::READ : 0;
+    nimbleProperties |= (properties & GATT_PROP_WRITE) ? NIMBLE_PROPERTY::WRITE : 0;
+    nimbleProperties |= (properties & GATT_PROP_NOTIFY) ? NIMBLE_PROPERTY::NOTIFY : 0;
+    nimbleProperties |= (properties & GATT_PROP_INDICATE) ? NIMBLE_PROPERTY::INDICATE : 0;
+
+    NimBLECharacteristic *characteristic = service->createCharacteristic(toNimBLEUUID(uuid), nimbleProperties);
+    characteristics[characteristic_count] = characteristic;
+    callbacks[characteristic_count] = nullptr;
+    if (onWrite != nullptr)
+    {
+        NimBLEGattCharacteristicCallbacks *handlers = callbacksFor(characteristic_count);
+        handlers->writeHandler = onWrite;
+        handlers->writeContext = context;
+    }
+    return characteristic_count++;
+}
+
+/**
+ * @brief Añade un descriptor a una característica.
+ * @param characteristic Característica propietaria.
+ * @param uuid UUID del descriptor.
+ * @param value Valor inicial.
+ * @param len Longitud de `value`.
+ * @param maxLen Longitud máxima que puede escribir el cliente.
+ * @param onWrite Callback de escritura, o `nullptr` si es de solo lectura.
+ * @param context Argumento de `onWrite`.
+ */
+void NimBLEGattServer::addDescriptor(GattHandle characteristic, const GattUuid &uuid, const uint8_t *value, size_t len,
+                                     size_t maxLen, GattWriteHandler onWrite, void *context)
+{
+    if (characteristic < 0 || characteristic >= characteristic_count)
+    {
+        return;
+    }
+    uint32_t properties = NIMBLE_PROPERTY::READ | (onWrite != nullptr ? NIMBLE_PROPERTY::WRITE : 0);
+    NimBLEDescriptor *descriptor = characteristics[characteristic]->createDescriptor(toNimBLEUUID(uuid), properties, maxLen);
+    descriptor->setValue(value, len);
+    if (onWrite != nullptr)
+    {
+        descriptor->setCallbacks(new NimBLEDescriptorWriteCallbacks(onWrite, context));
+    }
+}
+
+/**
+ * @brief Hace que el valor de una característica se genere en cada lectura del cliente.
+ * @param handle Característica.
+ * @param onRead Callback que produce el valor.
+ * @param context Argumento de `onRead`.
+ */
+void NimBLEGattServer::setReadHandler(GattHandle handle, GattReadHandler onRead, void *context)
+{
+    if (handle < 0 || handle >= characteristic_count)
+    {
+        return;
+    }
+    NimBLEGattCharacteristicCallbacks *handlers = callbacksFor(handle);
+    handlers->readHandler = onRead;
+    handlers->readContext = context;
+}
+
+/**
+ * @brief Callbacks de una característica, creados y registrados la primera vez.
+ */
+NimBLEGattCharacteristicCallbacks *NimBLEGattServer::callbacksFor(GattHandle handle)
+{
+    if (callbacks[handle] == nullptr)
+    {
+        callbacks[handle] = new NimBLEGattCharacteristicCallbacks();
+        characteristics[handle]->setCallbacks(callbacks[handle]);
+    }
+    return callbacks[handle];
+}
+
+/**
+ * @brief Arranca el servicio en construcción.
+ */
+void NimBLEGattServer::endService()
+{
+    service->start();
+    service = nullptr;
+}
+
+/**
+ * @brief Cambia el valor de una característica.
+ */
+void NimBLEGattServer::setValue(GattHandle handle, const uint8_t *data, size_t len)
+{
+    characteristics[handle]->setValue(data, len);
+}
+
+/**
+ * @brief Notifica el valor actual de una característica.
+ */
+void NimBLEGattServer::notify(GattHandle handle)
+{
+    characteristics[handle]->notify();
+}
+
+/**
+ * @brief Indica el valor actual de una característica.
+ */
+void NimBLEGattServer::indicate(GattHandle handle)
+{
+    characteristics[handle]->indicate();
+}
+
+/**
+ * @brief Configura los datos de publicidad principales.
+ * @details Flags, nombre y, si se pasa, el payload de fabricante. El paquete lo
+ * arma `buildAdvertisingData()`, que recorta el nombre para no pasar de 31
+ * bytes: la pila rechazaría el paquete entero y el nodo dejaría de publicitar.
+ */
+void NimBLEGattServer::setAdvertisingData(const char *name, const uint8_t *manufacturerData, size_t len)
+{
+    uint8_t raw[ADV_DATA_MAX_LEN];
+    size_t rawLen = buildAdvertisingData(name, manufacturerData, len, raw);
+    NimBLEAdvertisementData advertisementData;
+    advertisementData.addData(std::string((const char *)raw, rawLen));
+    NimBLEDevice::getAdvertising()->setAdvertisementData(advertisementData);
+}
+
+/**
+ * @brief Anuncia los servicios en la respuesta de escaneo.
+ */
+void NimBLEGattServer::setScanResponseServices(const GattUuid *uuids, size_t count)
+{
+    NimBLEAdvertisementData scanResponseData;
+    for (size_t i = 0; i < count; i++)
+    {
+        scanResponseData.setCompleteServices(toNimBLEUUID(uuids[i]));
+    }
+    NimBLEDevice::getAdvertising()->setScanResponseData(scanResponseData);
+}
+
+/**
+ * @brief (Re)inicia la publicidad.
+ * @param connectable `false` para publicitar sin aceptar conexiones.
+ */
+void NimBLEGattServer::startAdvertising(bool connectable)
+{
+    NimBLEAdvertising *advertising = NimBLEDevice::getAdvertising();
+    advertising->stop();
+    advertising->setAdvertisementType(connectable ? BLE_GAP_CONN_MODE_UND : BLE_GAP_CONN_MODE_NON);
+    advertising->start();
+}
+
+/**
+ * @brief Indica si hay un cliente conectado.
+ */
+bool NimBLEGattServer::isConnected()
+{
+    return connHandle != CONN_HANDLE_NONE;
+}
+
+/**
+ * @brief MTU acordado con el cliente conectado.
+ */
+uint16_t NimBLEGattServer::getPeerMtu()
+{
+    uint16_t handle = connHandle;
+    return handle != CONN_HANDLE_NONE ? server->getPeerMTU(handle) : 23;
+}
+
+/**
+ * @brief Solicita al cliente nuevos parámetros de conexión.
+ */
+void NimBLEGattServer::requestConnectionParams(const GattConnectionParams &params)
+{
+    uint16_t handle = connHandle;
+    if (handle != CONN_HANDLE_NONE)
+    {
+        server->updateConnParams(handle, params.minInterval, params.maxInterval, params.latency, params.timeout);
+    }
+}
+
+/**
+ * @brief Parámetros vigentes de la conexión, leídos de la pila.
+ * @return bool `false` si no hay cliente conectado.
+ */
+bool NimBLEGattServer::getConnectionParams(GattConnectionParams &params)
+{
+    uint16_t handle = connHandle;
+    if (handle == CONN_HANDLE_NONE)
+    {
+        params = {0, 0, 0, 0};
+        return false;
+    }
+    NimBLEConnInfo info = server->getPeerIDInfo(handle);
+    params.minInterval = info.getConnInterval();
+    params.maxInterval = params.minInterval;
+    params.latency = info.getConnLatency();
+    params.timeout = info.getConnTimeout();
+    return true;
+}
+
+/**
+ * @brief Servidor GATT de la pila NimBLE.
+ */
+GattServer &gattServer()
+{
+    static NimBLEGattServer server;
+    return server;
+}
+
+#endif // GATT_BACKEND_NIMBLE
@@ -0,0 +1,278 @@
+/**
+ * @file SampleCodec.cpp
+ * @brief Implementación del códec delta-de-delta + zigzag varint del historial.
+ * @details Este archivo no depende de Arduino: las mismas funciones sirven para
+ * comprimir en el dispositivo y para decodificar en el host.
+ */
+
+#include "SampleCodec.h"
+#include <string.h>
+
+/** @brief Máximo de bytes que ocupa un valor de 64 bits en varint. */
+static const size_t VARINT_MAX_BYTES = 10;
+
+// --- Funciones de ayuda ---
+
+/**
+ * @brief Codificación zigzag: intercala positivos y negativos (0, -1, 1, -2...).
+ * @param value Valor con signo.
+ * @return uint64_t Valor sin signo con los números pequeños cerca de 0.
+ */
+static inline uint64_t zigzagEncode(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+/**
+ * @brief Inversa de `zigzagEncode`.
+ * @param value Valor codificado.
+ * @return int64_t Valor con signo original.
+ */
+static inline int64_t zigzagDecode(uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+/**
+ * @brief Escribe un varint (7 bits por byte, bit alto = continuación).
+ * @param out Buffer de salida (al menos `VARINT_MAX_BYTES` libres).
+ * @param value Valor a escribir.
+ * @return size_t Bytes escritos.
+ */
+static size_t writeVarint(uint8_t *out, uint64_t value)
+{
+    size_t n = 0;
+    while (value >= 0x80)
+    {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+/**
+ * @brief Lee un varint.
+ * @param data Bytes de entrada.
+ * @param len Bytes disponibles.
+ * @param value Valor leído.
+ * @return size_t Bytes consumidos, o 0 si el varint está truncado o es inválido.
+ */
+static size_t readVarint(const uint8_t *data, size_t len, uint64_t *value)
+{
+    uint64_t result = 0;
+    for (size_t i = 0; i < len && i < VARINT_MAX_BYTES; i++)
+    {
+        result |= (uint64_t)(data[i] & 0x7F) << (7 * i);
+        if ((data[i] & 0x80) == 0)
+        {
+            *value = result;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Calcula el CRC-8 (polinomio 0x07, valor inicial 0) de un buffer.
+ * @param data Bytes de entrada.
+ * @param len Longitud.
+ * @return uint8_t El CRC calculado.
+ */
+static uint8_t crc8(const uint8_t *data, size_t len)
+{
+    uint8_t crc = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// --- SampleBlockEncoder ---
+
+/**
+ * @brief Constructor de la clase SampleBlockEncoder.
+ */
+SampleBlockEncoder::SampleBlockEncoder()
+{
+    reset();
+}
+
+/**
+ * @brief Descarta el contenido y empieza un bloque nuevo.
+ * @details La siguiente muestra añadida será el keyframe del bloque.
+ */
+void SampleBlockEncoder::reset()
+{
+    payloadLen = 0;
+    sampleCount = 0;
+    memset(lastValue, 0, sizeof(lastValue));
+    memset(lastDelta, 0, sizeof(lastDelta));
+}
+
+/**
+ * @brief Añade una muestra al bloque.
+ * @details La primera muestra se guarda en valor absoluto; las siguientes como
+ * delta-de-delta. Con valores que varían a ritmo constante el resultado es 0 y
+ * ocupa un solo byte por campo.
+ * @param sample Muestra a comprimir.
+ * @return bool `false` si el bloque ya no admite más muestras.
+ */
+bool SampleBlockEncoder::append(const HistorySample &sample)
+{
+    if (isFull())
+    {
+        return false;
+    }
+
+    for (int i = 0; i < SAMPLE_FIELD_COUNT; i++)
+    {
+        int64_t value = sample.fields[i];
+        int64_t encoded;
+        if (sampleCount == 0)
+        {
+            encoded = value;
+            lastDelta[i] = 0;
+        }
+        else
+        {
+            int64_t delta = value - lastValue[i];
+            encoded = delta - lastDelta[i];
+            lastDelta[i] = delta;
+        }
+        lastValue[i] = value;
+        payloadLen += writeVarint(&payload[payloadLen], zigzagEncode(encoded));
+    }
+    sampleCount++;
+    return true;
+}
+
+/**
+ * @brief Indica si el bloque está lleno.
+ * @details Un bloque se cierra al llegar a `CODEC_MAX_BLOCK_SAMPLES` muestras o
+ * cuando el payload restante no garantiza espacio para una muestra más.
+ * @return bool `true` si no se pueden añadir más muestras.
+ */
+bool SampleBlockEncoder::isFull() const
+{
+    return sampleCount >= CODEC_MAX_BLOCK_SAMPLES ||
+           payloadLen + SAMPLE_FIELD_COUNT * VARINT_MAX_BYTES > CODEC_MAX_PAYLOAD;
+}
+
+/**
+ * @brief Obtiene el número de muestras del bloque.
+ * @return uint8_t Muestras acumuladas.
+ */
+uint8_t SampleBlockEncoder::count() const
+{
+    return sampleCount;
+}
+
+/**
+ * @brief Escribe el bloque completo (cabecera, payload y CRC).
+ * @details No modifica el codificador, así que puede usarse para obtener una
+ * copia de un bloque todavía abierto.
+ * @param out Buffer de salida.
+ * @param capacity Tamaño de `out`.
+ * @return size_t Bytes escritos, o 0 si el bloque está vacío o no cabe.
+ */
+size_t SampleBlockEncoder::finalize(uint8_t *out, size_t capacity) const
+{
+    size_t total = CODEC_HEADER_SIZE + payloadLen + 1;
+    if (sampleCount == 0 || total > capacity)
+    {
+        return 0;
+    }
+    out[0] = CODEC_BLOCK_MAGIC;
+    out[1] = sampleCount;
+    out[2] = (uint8_t)(payloadLen & 0xFF);
+    out[3] = (uint8_t)(payloadLen >> 8);
+    memcpy(&out[CODEC_HEADER_SIZE], payload, payloadLen);
+    out[total - 1] = crc8(out, total - 1);
+    return total;
+}
+
+// --- Decodificación ---
+
+/**
+ * @brief Decodifica un bloque completo.
+ * @param data Bytes que empiezan al inicio de un bloque.
+ * @param len Bytes disponibles.
+ * @param out Array donde se escriben las muestras.
+ * @param maxSamples Capacidad de `out`.
+ * @param count Número de muestras decodificadas.
+ * @return size_t Bytes consumidos por el bloque, o 0 si el bloque es inválido
+ * o está incompleto.
+ */
+size_t decodeSampleBlock(const uint8_t *data, size_t len, HistorySample *out, size_t maxSamples, size_t *count)
+{
+    if (len < CODEC_HEADER_SIZE + 1 || data[0] != CODEC_BLOCK_MAGIC)
+    {
+        return 0;
+    }
+    size_t samples = data[1];
+    size_t payloadLen = data[2] | ((size_t)data[3] << 8);
+    size_t total = CODEC_HEADER_SIZE + payloadLen + 1;
+    if (samples == 0 || samples > maxSamples || payloadLen > CODEC_MAX_PAYLOAD || total > len ||
+        crc8(data, total - 1) != data[total - 1])
+    {
+        return 0;
+    }
+
+    const uint8_t *p = &data[CODEC_HEADER_SIZE];
+    const uint8_t *end = p + payloadLen;
+    int64_t value[SAMPLE_FIELD_COUNT] = {0};
+    int64_t delta[SAMPLE_FIELD_COUNT] = {0};
+    for (size_t s = 0; s < samples; s++)
+    {
+        for (int i = 0; i < SAMPLE_FIELD_COUNT; i++)
+        {
+            uint64_t raw;
+            size_t n = readVarint(p, end - p, &raw);
+            if (n == 0)
+            {
+                return 0;
+            }
+            p += n;
+            int64_t decoded = zigzagDecode(raw);
+            if (s == 0)
+            {
+                value[i] = decoded;
+            }
+            else
+            {
+                delta[i] += decoded;
+                value[i] += delta[i];
+            }
+            out[s].fields[i] = (int32_t)value[i];
+        }
+    }
+    *count = samples;
+    return total;
+}
+
+/**
+ * @brief Busca el siguiente bloque válido en un flujo posiblemente corrupto.
+ * @param data Bytes del flujo.
+ * @param len Bytes disponibles.
+ * @return size_t Desplazamiento del primer bloque válido, o `len` si no hay ninguno.
+ */
+size_t findSampleBlock(const uint8_t *data, size_t len)
+{
+    HistorySample scratch[CODEC_MAX_BLOCK_SAMPLES];
+    size_t count;
+    for (size_t offset = 0; offset < len; offset++)
+    {
+        if (data[offset] == CODEC_BLOCK_MAGIC &&
+            decodeSampleBlock(&data[offset], len - offset, scratch, CODEC_MAX_BLOCK_SAMPLES, &count) > 0)
+        {
+            return offset;
+        }
+    }
+    return len;
+}
@@ -1,196 +1,235 @@
 /**
  * @file SensorManager.cpp
  * @brief Implementación de la clase SensorManager para la gestión de sensores.
- * @details Este archivo contiene la lógica para inicializar, leer y gestionar
- * los sensores de CO2 (MH-Z19C), temperatura/humedad (DHT22) y
- * presión (BMP280). También incluye el control del ventilador.
+ * @details Este archivo coordina los drivers de sensores elegidos por la
+ * variante de placa (ver BoardConfig.h) y gestiona el precalentamiento del
+ * sensor de CO2 y el control del ventilador.
  * @author Francisco Aguirre
  * @date 2023-10-27
  */
 
 #include "SensorManager.h"
+#include "TimeBase.h"
 #include <Arduino.h>
 #include <Wire.h>
 
-// --- Prototipos de Funciones Estáticas ---
-static byte calculateChecksum(byte *packet);
+// --- Configuración del control automático del ventilador ---
+
+/** @brief Magnitud que regula el ventilador en modo automático. */
+static const FanTarget FAN_TARGET = FAN_TARGET_TEMPERATURE;
+
+/**
+ * @brief Sintonía del lazo PI del ventilador.
+ * @details Con la consigna en temperatura: arranca por encima de 28.00 °C,
+ * se apaga por debajo de 27.00 °C, ~30 % de duty por cada grado de error y
+ * ~10 % por grado y segundo de integral.
+ */
+static const FanControllerConfig FAN_CONFIG = {
+    2800,      // setpoint: 28.00 °C
+    100,       // hysteresis: 1.00 °C
+    3 << 16,   // kp: 3 duty por 0.01 °C
+    6554,      // ki: 0.1 duty por 0.01 °C y segundo
+    250,       // minDuty: ~25 %, por debajo el ventilador se detiene
+    FAN_DUTY_MAX, // spinUpDuty: arranque a plena potencia
+    2000,      // spinUpMs
+};
 
 /**
  * @brief Constructor de la clase SensorManager.
- * @details Inicializa los objetos de los sensores y establece los valores
- * por defecto para las variables de estado.
+ * @details Los drivers se construyen junto con el conjunto `sensors`; aquí solo
+ * se establecen los valores por defecto para las variables de estado.
  */
-SensorManager::SensorManager() : dht(DHT_PIN, DHT22) {
-    bmp_initialized = false;
-    last_bmp_reconnect_attempt = 0;
-    preheat_start_time = 0;
+SensorManager::SensorManager() : fan_output("FAN", writeFanDuty, nullptr) {
     state = PREHEATING;
-    fan_state = false;
+    fan_auto = false;
+    fan_auto_after_preheat = false;
+    last_fan_update = 0;
 }
 
 /**
  * @brief Inicializa todos los sensores y componentes gestionados por esta clase.
- * @details Configura la comunicación UART para el MH-Z19C, desactiva su
- * autocalibración, inicia el DHT22, y intenta conectar con el BMP280.
- * También configura el pin del ventilador y lo deja apagado.
+ * @details Inicializa cada driver de la placa (UART y autocalibración del
+ * MH-Z19C, DHT22, BMP280...). Los drivers I2C usan el dispositivo que el
+ * inventario haya encontrado; si no encontró ninguno, se quedan con la
+ * dirección por defecto de la placa. También configura el ventilador, que
+ * queda apagado. El pin HD del MH-Z19C pertenece al backend de calibración
+ * (ver CalibrationBackend.h).
+ * @param inventory Inventario del bus I2C, ya completado.
  */
-void SensorManager::init() {
+void SensorManager::init(const I2CInventory &inventory) {
     Serial.println("Inicializando SensorManager...");
 
-    // --- Inicialización del sensor de CO2 (MH-Z19C) ---
-    // Inicia comunicación UART en el puerto Serial2.
-    Serial2.begin(9600, SERIAL_8N1, RXD2_PIN, TXD2_PIN);
-    
-    // Configura el pin HD para la calibración manual y lo pone en ALTO (inactivo).
-    pinMode(HD_PIN, OUTPUT);
-    digitalWrite(HD_PIN, HIGH);
-    
-    // Envía el comando para desactivar la calibración automática del sensor.
-    Serial.println("Desactivando autocalibración del sensor de CO2...");
-    byte cmd_disable_autocal[9] = {0xFF, 0x01, 0x79, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-    cmd_disable_autocal[8] = calculateChecksum(cmd_disable_autocal);
-    Serial2.write(cmd_disable_autocal, 9);
-    
-    // Inicia el temporizador de precalentamiento.
-    preheat_start_time = millis();
-    Serial.println("Iniciado precalentamiento de 1 minuto para el sensor de CO2.");
-    
-    // Configura el pin del ventilador y lo mantiene apagado al inicio.
-    pinMode(FAN_PIN, OUTPUT);
-    digitalWrite(FAN_PIN, LOW);
-    fan_state = false;
-    
-    // --- Inicialización del sensor de Temp/Hum (DHT22) ---
-    dht.begin();
-
-    // --- Inicialización del sensor de Presión (BMP280) ---
-    if (bmp.begin(0x76)) {
-        Serial.println(F("Sensor BMP280 encontrado e inicializado."));
-        // Configura los parámetros de muestreo y filtrado para el BMP280.
-        bmp.setSampling(Adafruit_BMP280::MODE_NORMAL,
-                        Adafruit_BMP280::SAMPLING_X2,
-                        Adafruit_BMP280::SAMPLING_X16,
-                        Adafruit_BMP280::FILTER_X16,
-                        Adafruit_BMP280::STANDBY_MS_500);
-        bmp_initialized = true;
-    } else {
-        Serial.println(F("ADVERTENCIA: No se pudo encontrar un sensor BMP280 válido. Se reintentará periódicamente."));
-        Serial.print("Sensor ID: 0x");
-        Serial.println(bmp.sensorID(), HEX);
-        bmp_initialized = false;
+    // Configura el canal PWM del ventilador y lo mantiene apagado al inicio.
+    ledcSetup(FAN_PWM_CHANNEL, FAN_PWM_FREQ_HZ, FAN_PWM_RESOLUTION);
+    ledcAttachPin(FAN_PIN, FAN_PWM_CHANNEL);
+    if (!fan_output.begin()) {
+        Serial.println("Sin temporizador para el ventilador: el arranque termina con la siguiente muestra.");
     }
-    
+    fanController.configure(FAN_CONFIG);
+    applyFanDuty(0);
+
+    // --- Selección de dispositivos I2C según el inventario ---
+    sensors.with<SENSOR_PRESSURE>([&inventory](auto &pressure) {
+        const I2CDevice *device = inventory.find(CHIP_BMP280);
+        if (device == nullptr) {
+            device = inventory.find(CHIP_BME280); // Compatible en presión y temperatura
+        }
+        if (device != nullptr) {
+            Serial.printf("Sensor de presión en 0x%02X (ID 0x%02X).\n", device->address, device->chipId);
+            pressure.selectDevice(device->address, device->chipId);
+        }
+    });
+
+    // --- Inicialización de los drivers de la placa ---
+    sensors.begin();
+
     Serial.println("Sensores inicializados.");
 }
 
+/**
+ * @brief Aplica a los drivers los tiempos de la configuración.
+ * @details También toma el modo del ventilador tras el precalentamiento. Se
+ * puede llamar antes de `init()` y cada vez que cambie la configuración.
+ * @param config Configuración del dispositivo.
+ */
+void SensorManager::applyConfig(const DeviceConfig &config) {
+    fan_auto_after_preheat = config.fanMode == 1;
+    sensors.with<SENSOR_CO2>([&config](auto &co2) { co2.configure(config.co2TimeoutMs, config.co2PreheatMs); });
+}
+
 /**
  * @brief Lee los valores de todos los sensores.
- * @details Realiza la lectura de temperatura, humedad, presión y CO2.
- * Incluye manejo de errores para el DHT22 y una lógica de
- * reconexión para el BMP280 si la comunicación falla.
+ * @details Adquiere una muestra de cada driver de la placa, con las medidas
+ * en paralelo (ver SensorSet::acquire()). Cuando el sensor
+ * de CO2 termina su precalentamiento, el ventilador se enciende al 100 %, o
+ * pasa a control automático si así está configurado.
  * @return SensorData Una estructura con los últimos valores leídos de los sensores.
  */
 SensorData SensorManager::readAllSensors() {
     SensorData currentData;
+    uint64_t acquiredUs = monotonicMicros(); // Marca de tiempo al inicio de la adquisición
+    sensors.acquire(currentData);
+    currentData.monotonicUs = acquiredUs; // La hora de pared la asigna quien tenga la sincronización
 
-    // --- Lectura de Temperatura y Humedad (DHT22) ---
-    currentData.humidity = dht.readHumidity();
-    currentData.temperature = dht.readTemperature();
-    // Comprueba si la lectura del DHT22 fue exitosa.
-    if (isnan(currentData.humidity) || isnan(currentData.temperature)) {
-        Serial.println(F("Error al leer del sensor DHT!"));
-        currentData.humidity = -1.0;
-        currentData.temperature = -1.0;
-    }
-
-    // --- Lectura de Presión (BMP280) con lógica de reconexión ---
-    if (bmp_initialized) {
-        // Si el sensor está conectado, lee la presión.
-        currentData.pressure = bmp.readPressure() / 100.0F; // Convierte de Pa a hPa
-    } else {
-        // Si no está conectado, asigna un valor de error.
-        currentData.pressure = -1.0; 
-        
-        // Intenta reconectar cada 5 segundos para no bloquear el sistema.
-        if (millis() - last_bmp_reconnect_attempt > 5000) {
-            last_bmp_reconnect_attempt = millis();
-            Serial.println("Intentando reconectar con el sensor BMP280...");
-            if (bmp.begin(0x76)) {
-                Serial.println("¡BMP280 reconectado exitosamente!");
-                // Si la reconexión es exitosa, se reaplica la configuración.
-                bmp.setSampling(Adafruit_BMP280::MODE_NORMAL,
-                                Adafruit_BMP280::SAMPLING_X2,
-                                Adafruit_BMP280::SAMPLING_X16,
-                                Adafruit_BMP280::FILTER_X16,
-                                Adafruit_BMP280::STANDBY_MS_500);
-                bmp_initialized = true;
-            }
+    SensorState newState = getState();
+    if (state == PREHEATING && newState == READY) {
+        // Tras el precalentamiento el ventilador se enciende, salvo que la
+        // configuración pida el control automático (FAN_MODE=1).
+        if (fan_auto_after_preheat) {
+            setFanAuto();
+        } else {
+            setFanState(true);
         }
     }
-
-    // --- Lectura de CO2 (MH-Z19C) ---
-    currentData.co2 = readCO2();
+    state = newState;
 
     return currentData;
 }
 
 /**
- * @brief Lee la concentración de CO2 del sensor MH-Z19C.
- * @details Envía el comando de lectura por UART y procesa la respuesta.
- * También gestiona la máquina de estados de precalentamiento del sensor.
- * @return int La concentración de CO2 en ppm, o -1 si ocurre un error.
- * @note Esta es una función privada de ayuda.
+ * @brief Controla el estado del ventilador en modo manual.
+ * @details Desactiva el control automático y enciende el ventilador al 100 % o lo apaga.
+ * @param on `true` para encender el ventilador, `false` para apagarlo.
  */
-int SensorManager::readCO2() {
-    const unsigned long PREHEAT_TIME_MS = 60 * 1000UL; // 1 minuto
+void SensorManager::setFanState(bool on) {
+    setFanDuty(on ? FAN_DUTY_MAX : 0);
+}
 
-    // Comprueba si el tiempo de precalentamiento ha finalizado.
-    if (state == PREHEATING && millis() - preheat_start_time > PREHEAT_TIME_MS) {
-        setFanState(true); // Enciende el ventilador
-        Serial.println("Precalentamiento del sensor de CO2 completado. El sensor está listo (READY).");
-        state = READY;
-    }
-    
-    // Comando para solicitar la lectura de CO2.
-    byte cmd[9] = {0xFF, 0x01, 0x86, 0, 0, 0, 0, 0, 0x79};
-    Serial2.write(cmd, 9);
-    
-    // Espera la respuesta del sensor con un timeout.
-    unsigned long startTime = millis();
-    while (Serial2.available() < 9) {
-        if (millis() - startTime > 150) { // Timeout de 150ms
-            Serial.println("Timeout esperando respuesta del sensor de CO2.");
-            return -1;
-        }
-    }
+/**
+ * @brief Fija manualmente el duty del ventilador.
+ * @details Desactiva el control automático hasta que se llame a `setFanAuto()`.
+ * @param duty Duty entre 0 y `FAN_DUTY_MAX`.
+ */
+void SensorManager::setFanDuty(uint16_t duty) {
+    fan_auto = false;
+    fanController.reset();
+    applyFanDuty(min(duty, FAN_DUTY_MAX));
+    Serial.printf("Ventilador en modo manual: %s.\n", getFanStatus().c_str());
+}
 
-    byte response[9];
-    Serial2.readBytes(response, 9);
+/**
+ * @brief Devuelve el ventilador al control automático.
+ * @details El controlador parte de cero y decide el duty en el siguiente paso.
+ */
+void SensorManager::setFanAuto() {
+    fan_auto = true;
+    fanController.reset();
+    last_fan_update = millis();
+    Serial.println("Ventilador en modo automático.");
+}
 
-    // Valida y procesa la respuesta.
-    if (response[0] == 0xFF && response[1] == 0x86) {
-        // El valor de CO2 se forma con 2 bytes (High y Low).
-        return (response[2] << 8) | response[3];
+/**
+ * @brief Procesa un comando del ventilador recibido por BLE.
+ * @details Comandos aceptados: "AUTO", "ON", "OFF" o un porcentaje de "0" a
+ * "100" (ver parseFanCommand()). Un comando no reconocido no cambia nada.
+ * @param cmd Comando recibido.
+ * @return bool `true` si el comando se reconoció y se aplicó.
+ */
+bool SensorManager::handleFanCommand(const String &cmd) {
+    FanCommand command;
+    if (!parseFanCommand(cmd.c_str(), command)) {
+        Serial.printf("Comando del ventilador no reconocido: \"%s\".\n", cmd.c_str());
+        return false;
+    }
+    if (command.automatic) {
+        setFanAuto();
     } else {
-        Serial.println("Respuesta inválida del sensor de CO2.");
-        return -1;
+        setFanDuty(command.duty);
     }
+    return true;
 }
 
 /**
- * @brief Controla el estado del ventilador.
- * @details Activa o desactiva el pin del ventilador y actualiza la variable de estado.
- * @param on `true` para encender el ventilador, `false` para apagarlo.
+ * @brief Ejecuta un paso del control automático del ventilador.
+ * @details No hace nada en modo manual ni si la lectura de la magnitud
+ * regulada falló (en ese caso se mantiene el duty anterior).
+ * @param data Últimas lecturas de los sensores.
  */
-void SensorManager::setFanState(bool on) {
-    if (on) {
-        digitalWrite(FAN_PIN, HIGH);
-        fan_state = true;
+void SensorManager::updateFanControl(const SensorData &data) {
+    if (!fan_auto) {
+        return;
+    }
+    unsigned long now = millis();
+    unsigned long dt = now - last_fan_update;
+    last_fan_update = now;
+
+    int32_t measurement;
+    if (FAN_TARGET == FAN_TARGET_CO2) {
+        if (data.co2 < 0) {
+            return;
+        }
+        measurement = data.co2;
     } else {
-        digitalWrite(FAN_PIN, LOW);
-        fan_state = false;
+        if (data.humidity < 0) { // El DHT22 marca ambas lecturas con -1 al fallar
+            return;
+        }
+        measurement = (int32_t)lroundf(data.temperature * 100.0f);
+    }
+    applyFanDuty(fanController.update(measurement, dt));
+
+    // El arranque termina a su hora aunque la siguiente muestra se retrase.
+    uint32_t spinUpMs = fanController.getSpinUpRemainingMs();
+    if (spinUpMs > 0) {
+        fan_output.setAt(fanController.getRunDuty(), monotonicMicros() + spinUpMs * 1000ULL);
     }
-    Serial.printf("Ventilador %s.\n", on ? "activado" : "desactivado");
+}
+
+/**
+ * @brief Escribe el duty en el canal PWM del ventilador.
+ * @details Sustituye al flanco programado pendiente (fin del arranque), si lo hay.
+ * @param duty Duty entre 0 y `FAN_DUTY_MAX`.
+ */
+void SensorManager::applyFanDuty(uint16_t duty) {
+    fan_output.set(duty);
+}
+
+/**
+ * @brief Escritura de `fan_output` en el canal PWM; puede llamarse desde el temporizador.
+ * @param context Sin uso.
+ * @param duty Duty entre 0 y `FAN_DUTY_MAX`.
+ */
+void SensorManager::writeFanDuty(void *context, uint16_t duty) {
+    ledcWrite(FAN_PWM_CHANNEL, duty);
 }
 
 /**
@@ -198,31 +237,60 @@ void SensorManager::setFanState(bool on) {
  * @return bool `true` si el ventilador está encendido, `false` si está apagado.
  */
 bool SensorManager::getFanState() {
-    return fan_state;
+    return fan_output.getValue() > 0;
+}
+
+/**
+ * @brief Obtiene una descripción legible del estado del ventilador.
+ * @return String Modo y duty en porcentaje, ej. "AUTO 45%" o "MANUAL 0%".
+ */
+String SensorManager::getFanStatus() {
+    char status[16];
+    snprintf(status, sizeof(status), "%s %u%%", fan_auto ? "AUTO" : "MANUAL",
+             (unsigned)((fan_output.getValue() * 100UL + FAN_DUTY_MAX / 2) / FAN_DUTY_MAX));
+    return String(status);
 }
 
 /**
  * @brief Obtiene el estado actual del sensor de CO2.
+ * @details En placas sin sensor de CO2 siempre es `READY`.
  * @return SensorState El estado actual (`PREHEATING`, `READY`, `CALIBRATING`).
  */
 SensorState SensorManager::getState() {
-    return state;
+    SensorState co2State = READY;
+    sensors.with<SENSOR_CO2>([&co2State](auto &co2) { co2State = co2.getState(); });
+    return co2State;
 }
 
 /**
- * @brief Calcula el checksum para un comando del sensor MH-Z19C.
- * @details Esta función es específica del protocolo del sensor MH-Z19C.
- * Suma los bytes del 1 al 7, resta el resultado de 0xFF y suma 1.
- * @param packet Puntero a un array de 8 bytes (los primeros 8 bytes del comando).
- * @return byte El byte de checksum calculado.
- * @note Esta es una función estática, privada al archivo.
+ * @brief Obtiene la máscara de sensores en fallo.
+ * @return uint8_t Bit `1 << SensorKind` activo para cada sensor en fallo; 0 si todos están sanos.
  */
-static byte calculateChecksum(byte *packet) {
-    byte checksum = 0;
-    for (int i = 1; i < 8; i++) {
-        checksum += packet[i];
-    }
-    checksum = 0xFF - checksum;
-    checksum += 1;
-    return checksum;
+uint8_t SensorManager::getFaultMask() {
+    return sensors.faultMask();
+}
+
+/**
+ * @brief Indica si la última muestra fue válida en todos los sensores de la placa.
+ */
+bool SensorManager::isSampleValid() {
+    return sensors.allValid();
+}
+
+/**
+ * @brief Obtiene la duración del último ciclo de adquisición.
+ * @return unsigned long Microsegundos desde el inicio de las medidas hasta el último resultado.
+ */
+unsigned long SensorManager::getAcquireMicros() {
+    return sensors.lastAcquireMicros();
+}
+
+/**
+ * @brief Obtiene el transporte de tramas del MH-Z19C, para la calibración por UART.
+ * @return Mhz19Link* El transporte, o `nullptr` en placas sin sensor de CO2.
+ */
+Mhz19Link *SensorManager::getCo2Link() {
+    Mhz19Link *link = nullptr;
+    sensors.with<SENSOR_CO2>([&link](auto &co2) { link = &co2.getLink(); });
+    return link;
 }
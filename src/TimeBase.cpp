@@ -0,0 +1,359 @@
+/**
+ * @file TimeBase.cpp
+ * @brief Implementación del reloj monótono de 64 bits y de la sincronización de hora.
+ */
+
+#include "TimeBase.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// --- Reloj monótono ---
+
+#ifdef ARDUINO
+
+#include <Arduino.h>
+
+#ifdef NODE_SIMULATION
+uint64_t monotonicMicros()
+{
+    static CounterExtender extender;
+    return extender.extend(micros());
+}
+#else
+#include <esp_timer.h>
+uint64_t monotonicMicros()
+{
+    return (uint64_t)esp_timer_get_time();
+}
+#endif
+
+#else
+
+/** @brief Reloj virtual del host. */
+static uint64_t virtualMicros = 0;
+
+uint64_t monotonicMicros()
+{
+    return virtualMicros;
+}
+
+/**
+ * @brief Fija el reloj virtual del host.
+ * @param us Microsegundos desde el "arranque"; no debería retroceder.
+ */
+void setMonotonicMicros(uint64_t us)
+{
+    virtualMicros = us;
+}
+
+#endif
+
+// --- CounterExtender ---
+
+/**
+ * @brief Constructor de la clase CounterExtender.
+ */
+CounterExtender::CounterExtender()
+{
+    last_raw = 0;
+    wraps = 0;
+}
+
+/**
+ * @brief Convierte una lectura del contador de 32 bits en un valor de 64 bits.
+ * @param raw Lectura actual del contador.
+ * @return uint64_t Valor extendido, monótono mientras se consulte al menos una vez por vuelta.
+ */
+uint64_t CounterExtender::extend(uint32_t raw)
+{
+    if (raw < last_raw)
+    {
+        wraps++;
+    }
+    last_raw = raw;
+    return ((uint64_t)wraps << 32) | raw;
+}
+
+// --- ClockSync ---
+
+/**
+ * @brief Constructor de la clase ClockSync.
+ */
+ClockSync::ClockSync()
+{
+    head = 0;
+    count = 0;
+    ref_local_us = 0;
+    fit_wall_us = 0;
+    slope = 1.0;
+    last_error_us = 0;
+}
+
+/**
+ * @brief Añade un punto de sincronización y reajusta la recta.
+ * @param localUs Instante local (`monotonicMicros()`) en que se recibió la hora.
+ * @param wallUs Hora de pared del cliente, en µs desde la época Unix.
+ * @return bool `false` si el punto se alejaba demasiado de la predicción y
+ * se descartaron los anteriores.
+ */
+bool ClockSync::addPoint(uint64_t localUs, int64_t wallUs)
+{
+    bool continued = true;
+    last_error_us = 0;
+    if (count > 0)
+    {
+        last_error_us = wallUs - toWallUs(localUs);
+        if (llabs(last_error_us) > STEP_THRESHOLD_US)
+        {
+            count = 0; // El reloj del cliente saltó: los puntos anteriores ya no sirven
+            continued = false;
+        }
+    }
+
+    local_us[head] = localUs;
+    wall_us[head] = wallUs;
+    head = (head + 1) % MAX_POINTS;
+    if (count < MAX_POINTS)
+    {
+        count++;
+    }
+    fit();
+    return continued;
+}
+
+/**
+ * @brief Estima la hora de pared en un instante local.
+ * @param localUs Instante local (`monotonicMicros()`).
+ * @return int64_t µs desde la época Unix, o -1 si aún no hay sincronización.
+ */
+int64_t ClockSync::toWallUs(uint64_t localUs) const
+{
+    if (count == 0)
+    {
+        return -1;
+    }
+    double elapsed = (double)(int64_t)(localUs - ref_local_us);
+    return fit_wall_us + (int64_t)llround(slope * elapsed);
+}
+
+/**
+ * @brief Deriva estimada del oscilador local respecto al reloj del cliente.
+ * @return float Partes por millón; positiva si el reloj local atrasa.
+ */
+float ClockSync::getDriftPpm() const
+{
+    return (float)((slope - 1.0) * 1e6);
+}
+
+/**
+ * @brief Describe el estado de la sincronización en texto.
+ * @details Formato: "POINTS=3;DRIFT=+12.5ppm;ERR=-4ms", o "POINTS=0;DRIFT=NA;ERR=NA"
+ * sin sincronización. `ERR` es el error de la predicción en el último punto.
+ * @param out Buffer de salida.
+ * @param len Tamaño de `out`.
+ * @return size_t Longitud del texto escrito.
+ */
+size_t ClockSync::describe(char *out, size_t len) const
+{
+    if (len == 0)
+    {
+        return 0;
+    }
+    int written;
+    if (count == 0)
+    {
+        written = snprintf(out, len, "POINTS=0;DRIFT=NA;ERR=NA");
+    }
+    else
+    {
+        written = snprintf(out, len, "POINTS=%u;DRIFT=%+.1fppm;ERR=%+ldms", (unsigned)count, getDriftPpm(),
+                           (long)(last_error_us / 1000));
+    }
+    if (written < 0)
+    {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < len ? (size_t)written : len - 1;
+}
+
+/**
+ * @brief Ajusta la recta por mínimos cuadrados sobre los puntos guardados.
+ * @details Las coordenadas se toman relativas al punto más reciente, así que
+ * caben sin pérdida en un `double` aunque el reloj lleve años en marcha.
+ */
+void ClockSync::fit()
+{
+    uint8_t newest = (head + MAX_POINTS - 1) % MAX_POINTS;
+    ref_local_us = local_us[newest];
+    int64_t refWall = wall_us[newest];
+
+    double meanX = 0;
+    double meanY = 0;
+    uint64_t oldest = ref_local_us;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        uint8_t index = (newest + MAX_POINTS - i) % MAX_POINTS;
+        meanX += (double)(int64_t)(local_us[index] - ref_local_us);
+        meanY += (double)(wall_us[index] - refWall);
+        if (local_us[index] < oldest)
+        {
+            oldest = local_us[index];
+        }
+    }
+    meanX /= count;
+    meanY /= count;
+
+    slope = 1.0;
+    if (ref_local_us - oldest >= MIN_DRIFT_SPAN_US)
+    {
+        double sxx = 0;
+        double sxy = 0;
+        for (uint8_t i = 0; i < count; i++)
+        {
+            uint8_t index = (newest + MAX_POINTS - i) % MAX_POINTS;
+            double dx = (double)(int64_t)(local_us[index] - ref_local_us) - meanX;
+            double dy = (double)(wall_us[index] - refWall) - meanY;
+            sxx += dx * dx;
+            sxy += dx * dy;
+        }
+        slope = sxy / sxx;
+        if (slope > 1.0 + MAX_DRIFT)
+        {
+            slope = 1.0 + MAX_DRIFT;
+        }
+        else if (slope < 1.0 - MAX_DRIFT)
+        {
+            slope = 1.0 - MAX_DRIFT;
+        }
+    }
+    // La recta pasa por el centro de los puntos; se evalúa en el más reciente.
+    fit_wall_us = refWall + (int64_t)llround(meanY - slope * meanX);
+}
+
+// --- SampleScheduler ---
+
+/**
+ * @brief Constructor de la clase SampleScheduler.
+ */
+SampleScheduler::SampleScheduler()
+{
+    period_us = 1000000;
+    last_sample_us = 0;
+    sampled = false;
+    next_grid_us = -1;
+    taken_grid_us = -1;
+    phase_error_us = 0;
+    phase_valid = false;
+}
+
+/**
+ * @brief Cambia el periodo de muestreo.
+ * @param periodUs Periodo en µs; 0 se ignora.
+ */
+void SampleScheduler::setPeriodUs(uint64_t periodUs)
+{
+    if (periodUs == 0 || periodUs == period_us)
+    {
+        return;
+    }
+    period_us = periodUs;
+    next_grid_us = -1; // La rejilla anterior ya no vale
+}
+
+/**
+ * @brief Olvida la rejilla actual; la próxima muestra alineada fija una nueva.
+ * @details Se llama cuando la sincronización empieza de cero porque el reloj
+ * del cliente saltó: la rejilla se calculó con la hora anterior.
+ */
+void SampleScheduler::resetGrid()
+{
+    next_grid_us = -1;
+    taken_grid_us = -1;
+}
+
+/**
+ * @brief Indica si ha llegado el instante de la próxima muestra.
+ * @details Si devuelve `true`, la muestra se da por tomada y se programa la
+ * siguiente; el llamador debe pasar después su hora a `recordSample()`.
+ * @param nowUs Instante local actual (`monotonicMicros()`).
+ * @param sync Sincronización de hora del nodo.
+ * @return bool `true` cuando toca muestrear.
+ */
+bool SampleScheduler::poll(uint64_t nowUs, const ClockSync &sync)
+{
+    if (!sync.isSynced())
+    {
+        next_grid_us = -1;
+        taken_grid_us = -1;
+        if (sampled && nowUs - last_sample_us < period_us)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        int64_t nowWall = sync.toWallUs(nowUs);
+        int64_t period = (int64_t)period_us;
+        if (next_grid_us < 0 || nowWall - next_grid_us >= period || next_grid_us - nowWall > period)
+        {
+            // Primera muestra alineada, instantes perdidos o la hora retrocedió más
+            // de un periodo (sin esto no se muestrearía hasta recuperarla): el
+            // siguiente múltiplo del periodo
+            next_grid_us = (nowWall / period + 1) * period;
+            if (next_grid_us == taken_grid_us)
+            {
+                next_grid_us += period; // Ese instante ya tiene muestra
+            }
+        }
+        if (nowWall < next_grid_us)
+        {
+            return false;
+        }
+        taken_grid_us = next_grid_us;
+        next_grid_us += period;
+    }
+    sampled = true;
+    last_sample_us = nowUs;
+    return true;
+}
+
+/**
+ * @brief Calcula el error de fase de la muestra recién tomada.
+ * @param wallUs Hora de pared de la muestra, o -1 si no estaba sincronizada.
+ */
+void SampleScheduler::recordSample(int64_t wallUs)
+{
+    phase_valid = taken_grid_us >= 0 && wallUs >= 0;
+    phase_error_us = phase_valid ? wallUs - taken_grid_us : 0;
+}
+
+/**
+ * @brief Describe el error de fase de la última muestra.
+ * @param out Buffer de salida.
+ * @param len Tamaño de `out`.
+ * @return size_t Longitud del texto escrito.
+ */
+size_t SampleScheduler::describe(char *out, size_t len) const
+{
+    if (len == 0)
+    {
+        return 0;
+    }
+    int written;
+    if (!phase_valid)
+    {
+        written = snprintf(out, len, "PHASE=NA");
+    }
+    else
+    {
+        written = snprintf(out, len, "PHASE=%+.1fms", phase_error_us / 1000.0);
+    }
+    if (written < 0)
+    {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < len ? (size_t)written : len - 1;
+}
@@ -0,0 +1,350 @@
+/**
+ * @file TimedOutput.cpp
+ * @brief Implementación de las salidas con flancos programados.
+ * @details En el ESP32 los flancos programados los da un `esp_timer`; en el
+ * host, un temporizador falso avanzado con `runHostTimers()`.
+ */
+
+#include "TimedOutput.h"
+#include "TimeBase.h"
+
+#ifndef TIMED_OUTPUT_ESP_TIMER
+TimedOutput *TimedOutput::host_outputs = nullptr;
+uint32_t TimedOutput::host_latency_us = 0;
+#endif
+
+/**
+ * @brief Constructor de la clase TimedOutput.
+ * @param name Nombre para el registro (ej. "HD").
+ * @param write Función que escribe el valor en el hardware.
+ * @param context Argumento para `write`.
+ */
+TimedOutput::TimedOutput(const char *name, OutputWrite write, void *context)
+{
+    this->name = name;
+    write_fn = write;
+    this->context = context;
+    value = 0;
+    written = false;
+    pending_value = 0;
+    pending_at_us = 0;
+    edge_head = 0;
+    edge_count = 0;
+    dropped_edges = 0;
+    max_lateness_us = 0;
+    pending = false;
+#ifdef TIMED_OUTPUT_ESP_TIMER
+    timer = nullptr;
+    portMUX_INITIALIZE(&spinlock);
+#else
+    next_host = host_outputs;
+    host_outputs = this;
+#endif
+}
+
+/**
+ * @brief Destructor de la clase TimedOutput.
+ * @details Descarta el flanco pendiente y libera el temporizador; en el host,
+ * saca la salida de la lista de `runHostTimers()`.
+ */
+TimedOutput::~TimedOutput()
+{
+    cancel();
+#ifdef TIMED_OUTPUT_ESP_TIMER
+    if (timer != nullptr)
+    {
+        esp_timer_delete(timer);
+    }
+#else
+    for (TimedOutput **link = &host_outputs; *link != nullptr; link = &(*link)->next_host)
+    {
+        if (*link == this)
+        {
+            *link = next_host;
+            break;
+        }
+    }
+#endif
+}
+
+/**
+ * @brief Crea el temporizador de la salida.
+ * @details Sin temporizador, `setAt()` y `pulse()` devuelven `false` y el
+ * llamador debe temporizar el flanco por su cuenta.
+ * @return bool `true` si la salida puede programar flancos.
+ */
+bool TimedOutput::begin()
+{
+#ifdef TIMED_OUTPUT_ESP_TIMER
+    if (timer != nullptr)
+    {
+        return true;
+    }
+    esp_timer_create_args_t args = {};
+    args.callback = onTimer;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = name;
+    if (esp_timer_create(&args, &timer) != ESP_OK)
+    {
+        timer = nullptr;
+        return false;
+    }
+#endif
+    return true;
+}
+
+/**
+ * @brief Escribe un valor ya, descartando el flanco pendiente.
+ * @details Si la salida ya tiene ese valor no se escribe ni se anota.
+ * @param newValue Nivel digital o duty.
+ */
+void TimedOutput::set(uint16_t newValue)
+{
+    cancel();
+    if (written && newValue == getValue())
+    {
+        return;
+    }
+    write(newValue, monotonicMicros(), false);
+}
+
+/**
+ * @brief Programa un flanco, sustituyendo al pendiente.
+ * @param newValue Valor a escribir.
+ * @param atUs Instante en `monotonicMicros()`; si ya pasó, el flanco se da cuanto antes.
+ * @return bool `false` si no se pudo armar el temporizador (no hay flanco pendiente).
+ */
+bool TimedOutput::setAt(uint16_t newValue, uint64_t atUs)
+{
+    cancel();
+#ifdef TIMED_OUTPUT_ESP_TIMER
+    if (timer == nullptr)
+    {
+        return false;
+    }
+#endif
+    lock();
+    pending = true;
+    pending_value = newValue;
+    pending_at_us = atUs;
+    unlock();
+#ifdef TIMED_OUTPUT_ESP_TIMER
+    uint64_t now = monotonicMicros();
+    if (esp_timer_start_once(timer, atUs > now ? atUs - now : 0) != ESP_OK)
+    {
+        cancel();
+        return false;
+    }
+#endif
+    return true;
+}
+
+/**
+ * @brief Escribe `active` ya y programa la vuelta a `idle` tras `durationUs`.
+ * @details La duración se cuenta desde la hora pedida del primer flanco, así
+ * que el pulso dura lo pedido aunque el bucle se detenga entre medias.
+ * @return bool `false` si no se pudo programar la vuelta: la salida queda en
+ * `active` y el llamador debe terminar el pulso.
+ */
+bool TimedOutput::pulse(uint16_t active, uint16_t idle, uint64_t durationUs)
+{
+    uint64_t startUs = monotonicMicros();
+    set(active);
+    return setAt(idle, startUs + durationUs);
+}
+
+/**
+ * @brief Descarta el flanco pendiente, si lo hay.
+ */
+void TimedOutput::cancel()
+{
+    lock();
+    bool wasPending = pending;
+    pending = false;
+    unlock();
+#ifdef TIMED_OUTPUT_ESP_TIMER
+    if (wasPending)
+    {
+        esp_timer_stop(timer); // Falla sin consecuencias si el callback ya está en marcha
+    }
+#else
+    (void)wasPending;
+#endif
+}
+
+/**
+ * @brief Indica si queda un flanco programado por dar.
+ */
+bool TimedOutput::isPending()
+{
+    lock();
+    bool current = pending;
+    unlock();
+    return current;
+}
+
+/**
+ * @brief Último valor escrito en la salida.
+ * @return uint16_t Nivel digital o duty.
+ */
+uint16_t TimedOutput::getValue()
+{
+    lock();
+    uint16_t current = value;
+    unlock();
+    return current;
+}
+
+/**
+ * @brief Saca el flanco más antiguo de la cola del registro.
+ * @param edge Flanco extraído.
+ * @return bool `false` si la cola está vacía.
+ */
+bool TimedOutput::popEdge(OutputEdge &edge)
+{
+    lock();
+    bool found = edge_count > 0;
+    if (found)
+    {
+        edge = edges[(edge_head + EDGE_LOG_SIZE - edge_count) % EDGE_LOG_SIZE];
+        edge_count--;
+    }
+    unlock();
+    return found;
+}
+
+/**
+ * @brief Avanza el temporizador falso del host hasta `nowUs`.
+ * @details Da en orden de hora pedida los flancos vencidos de todas las
+ * salidas. En el ESP32 no hace nada: los flancos los da `esp_timer`.
+ * @param nowUs Instante actual (`monotonicMicros()`).
+ */
+void TimedOutput::runHostTimers(uint64_t nowUs)
+{
+#ifndef TIMED_OUTPUT_ESP_TIMER
+    while (true)
+    {
+        TimedOutput *due = nullptr;
+        for (TimedOutput *output = host_outputs; output != nullptr; output = output->next_host)
+        {
+            if (output->pending && output->pending_at_us <= nowUs &&
+                (due == nullptr || output->pending_at_us < due->pending_at_us))
+            {
+                due = output;
+            }
+        }
+        if (due == nullptr)
+        {
+            return;
+        }
+        due->fire(due->pending_at_us);
+    }
+#else
+    (void)nowUs;
+#endif
+}
+
+/**
+ * @brief Fija la latencia que el temporizador falso añade a cada flanco programado.
+ * @details Sirve para comprobar en el host cómo toleran los usuarios un
+ * temporizador lento. En el ESP32 no hace nada.
+ */
+void TimedOutput::setHostLatencyUs(uint32_t latencyUs)
+{
+#ifndef TIMED_OUTPUT_ESP_TIMER
+    host_latency_us = latencyUs;
+#else
+    (void)latencyUs;
+#endif
+}
+
+/**
+ * @brief Da el flanco programado si ya es su hora.
+ * @details El temporizador nunca dispara antes de tiempo: un disparo anterior
+ * a la hora pedida es el de un flanco ya sustituido por otro `setAt()`, y se
+ * ignora (el nuevo tiene su propio disparo).
+ * @param nowUs Instante del disparo.
+ */
+void TimedOutput::fire(uint64_t nowUs)
+{
+    lock();
+    bool due = pending && nowUs >= pending_at_us;
+    if (due)
+    {
+        pending = false;
+    }
+    uint16_t newValue = pending_value;
+    uint64_t requestedUs = pending_at_us;
+    unlock();
+    if (due)
+    {
+        write(newValue, requestedUs, true);
+    }
+}
+
+/**
+ * @brief Escribe la salida y anota el flanco.
+ * @param newValue Valor a escribir.
+ * @param requestedUs Hora pedida del flanco.
+ * @param scheduled `true` si lo da el temporizador.
+ */
+void TimedOutput::write(uint16_t newValue, uint64_t requestedUs, bool scheduled)
+{
+    write_fn(context, newValue);
+    uint64_t actualUs = monotonicMicros();
+#ifndef TIMED_OUTPUT_ESP_TIMER
+    if (scheduled)
+    {
+        actualUs = requestedUs + host_latency_us; // El temporizador falso dispara a su hora
+    }
+#endif
+    int64_t lateness = (int64_t)(actualUs - requestedUs);
+
+    lock();
+    uint16_t previous = value;
+    value = newValue;
+    written = true;
+    if (lateness > max_lateness_us)
+    {
+        max_lateness_us = lateness;
+    }
+    edges[edge_head] = {requestedUs, actualUs, previous, newValue, scheduled};
+    edge_head = (edge_head + 1) % EDGE_LOG_SIZE;
+    if (edge_count < EDGE_LOG_SIZE)
+    {
+        edge_count++;
+    }
+    else
+    {
+        dropped_edges++; // Se pierde el más antiguo
+    }
+    unlock();
+}
+
+/**
+ * @brief Protege el estado compartido con la tarea de `esp_timer`.
+ */
+void TimedOutput::lock()
+{
+#ifdef TIMED_OUTPUT_ESP_TIMER
+    portENTER_CRITICAL(&spinlock);
+#endif
+}
+
+void TimedOutput::unlock()
+{
+#ifdef TIMED_OUTPUT_ESP_TIMER
+    portEXIT_CRITICAL(&spinlock);
+#endif
+}
+
+#ifdef TIMED_OUTPUT_ESP_TIMER
+/**
+ * @brief Callback de `esp_timer`, en la tarea del temporizador.
+ */
+void TimedOutput::onTimer(void *arg)
+{
+    static_cast<TimedOutput *>(arg)->fire(monotonicMicros());
+}
+#endif
@@ -0,0 +1,290 @@
+/**
+ * @file TimerWheel.cpp
+ * @brief Implementación de la rueda jerárquica de temporizadores.
+ * @details Este archivo no depende de Arduino para poder probar la rueda en
+ * el host con un reloj virtual.
+ */
+
+#include "TimerWheel.h"
+
+/** @brief Lista vacía: la cabecera apunta a sí misma. */
+static void listInit(TimerLink &head)
+{
+    head.next = &head;
+    head.prev = &head;
+}
+
+/** @brief Añade `link` al final de la lista de `head`. */
+static void listAppend(TimerLink &head, TimerLink &link)
+{
+    link.prev = head.prev;
+    link.next = &head;
+    head.prev->next = &link;
+    head.prev = &link;
+}
+
+/** @brief Quita `link` de su lista. */
+static void listRemove(TimerLink &link)
+{
+    link.prev->next = link.next;
+    link.next->prev = link.prev;
+    link.next = &link;
+    link.prev = &link;
+}
+
+/** @brief Mueve todos los elementos de `from` a `to`, que debe estar vacía. */
+static void listSplice(TimerLink &from, TimerLink &to)
+{
+    if (from.next == &from)
+    {
+        return;
+    }
+    to.next = from.next;
+    to.prev = from.prev;
+    to.next->prev = &to;
+    to.prev->next = &to;
+    listInit(from);
+}
+
+/** @brief Número de ceros por la derecha de un valor no nulo. */
+static uint8_t lowestBit(uint64_t value)
+{
+    return (uint8_t)__builtin_ctzll(value);
+}
+
+// --- Timer ---
+
+/**
+ * @brief Constructor de la clase Timer.
+ * @param callback Función a llamar al vencer.
+ * @param context Argumento para `callback`.
+ */
+Timer::Timer(TimerCallback callback, void *context)
+{
+    link.next = &link;
+    link.prev = &link;
+    this->callback = callback;
+    this->context = context;
+    expires_ms = 0;
+    period_ms = 0;
+    level = 0;
+    slot = 0;
+    active = false;
+}
+
+// --- TimerWheel ---
+
+/**
+ * @brief Constructor de la clase TimerWheel.
+ */
+TimerWheel::TimerWheel()
+{
+    for (uint8_t level = 0; level < LEVELS; level++)
+    {
+        for (uint8_t slot = 0; slot < SLOTS; slot++)
+        {
+            listInit(slots[level][slot]);
+        }
+        occupied[level] = 0;
+    }
+    current_ms = 0;
+    active_count = 0;
+}
+
+/**
+ * @brief Fija el instante de partida de la rueda.
+ * @details Evita que el primer `advance()` recorra todos los ticks desde 0.
+ * @param nowMs Instante actual.
+ */
+void TimerWheel::reset(uint32_t nowMs)
+{
+    current_ms = nowMs;
+}
+
+/**
+ * @brief Arma (o rearma) un temporizador.
+ * @param timer Temporizador; si ya estaba activo, se reprograma.
+ * @param delayMs Plazo desde `nowMs()`; como mínimo 1 ms y como mucho `MAX_DELAY_MS`.
+ * @param periodMs Periodo de repetición, o 0 para un solo disparo.
+ */
+void TimerWheel::start(Timer &timer, uint32_t delayMs, uint32_t periodMs)
+{
+    if (timer.active)
+    {
+        unlink(timer);
+    }
+    else
+    {
+        active_count++;
+    }
+    if (delayMs == 0)
+    {
+        delayMs = 1; // El tick actual ya se está procesando
+    }
+    if (delayMs > MAX_DELAY_MS)
+    {
+        delayMs = MAX_DELAY_MS;
+    }
+    timer.expires_ms = current_ms + delayMs;
+    timer.period_ms = periodMs > MAX_DELAY_MS ? MAX_DELAY_MS : periodMs;
+    timer.active = true;
+    insert(timer);
+}
+
+/**
+ * @brief Cancela un temporizador; no hace nada si no estaba activo.
+ */
+void TimerWheel::cancel(Timer &timer)
+{
+    if (timer.active)
+    {
+        unlink(timer);
+        timer.active = false;
+        active_count--;
+    }
+}
+
+/**
+ * @brief Avanza la rueda tick a tick hasta `nowMs`, ejecutando lo que venza.
+ * @details Los callbacks pueden armar y cancelar temporizadores, incluido el
+ * suyo. Los periódicos se rearman antes de llamar al callback, sin acumular
+ * deriva.
+ * @param nowMs Instante actual.
+ */
+void TimerWheel::advance(uint32_t nowMs)
+{
+    if (active_count == 0)
+    {
+        current_ms = nowMs; // Nada que vencer ni bajar de nivel
+        return;
+    }
+    while ((int32_t)(nowMs - current_ms) > 0)
+    {
+        current_ms++;
+        // Al completar una vuelta de un nivel, baja la ranura siguiente del nivel superior.
+        for (uint8_t level = 1; level < LEVELS; level++)
+        {
+            if ((current_ms & ((1UL << (level * SLOT_BITS)) - 1)) != 0)
+            {
+                break;
+            }
+            cascade(level);
+        }
+        expireSlot(current_ms & (SLOTS - 1));
+    }
+}
+
+/**
+ * @brief Calcula una cota inferior del próximo vencimiento.
+ * @details En el nivel 0 es exacta; en los superiores es el instante de la
+ * siguiente cascada con temporizadores, así que quien duerma hasta ese
+ * instante puede despertar antes de tiempo, pero nunca tarde.
+ * @param expiryMs Instante calculado.
+ * @return bool `false` si no hay temporizadores activos.
+ */
+bool TimerWheel::nextExpiryMs(uint32_t &expiryMs) const
+{
+    bool found = false;
+    uint32_t earliest = 0; // Distancia desde `current_ms`
+    for (uint8_t level = 0; level < LEVELS; level++)
+    {
+        if (occupied[level] == 0)
+        {
+            continue;
+        }
+        uint8_t shift = level * SLOT_BITS;
+        uint32_t position = current_ms >> shift;
+        // Ranuras a partir de la siguiente, en orden circular.
+        uint8_t first = (position + 1) & (SLOTS - 1);
+        uint64_t rotated = (occupied[level] >> first) | (first ? occupied[level] << (SLOTS - first) : 0);
+        uint32_t steps = lowestBit(rotated) + 1;
+        uint32_t distance = ((position + steps) << shift) - current_ms;
+        if (!found || distance < earliest)
+        {
+            earliest = distance;
+            found = true;
+        }
+    }
+    expiryMs = current_ms + earliest;
+    return found;
+}
+
+/**
+ * @brief Coloca un temporizador en la ranura que corresponde a su plazo.
+ */
+void TimerWheel::insert(Timer &timer)
+{
+    uint32_t delta = timer.expires_ms - current_ms;
+    uint8_t level = 0;
+    while (level < LEVELS - 1 && delta >= (1UL << ((level + 1) * SLOT_BITS)))
+    {
+        level++;
+    }
+    uint8_t slot = (timer.expires_ms >> (level * SLOT_BITS)) & (SLOTS - 1);
+    timer.level = level;
+    timer.slot = slot;
+    listAppend(slots[level][slot], timer.link);
+    occupied[level] |= 1ULL << slot;
+}
+
+/**
+ * @brief Quita un temporizador de su ranura.
+ */
+void TimerWheel::unlink(Timer &timer)
+{
+    TimerLink &head = slots[timer.level][timer.slot];
+    listRemove(timer.link);
+    if (head.next == &head)
+    {
+        occupied[timer.level] &= ~(1ULL << timer.slot);
+    }
+}
+
+/**
+ * @brief Redistribuye en los niveles inferiores la ranura actual de `level`.
+ */
+void TimerWheel::cascade(uint8_t level)
+{
+    uint8_t slot = (current_ms >> (level * SLOT_BITS)) & (SLOTS - 1);
+    TimerLink pending;
+    listInit(pending);
+    listSplice(slots[level][slot], pending);
+    occupied[level] &= ~(1ULL << slot);
+    while (pending.next != &pending)
+    {
+        Timer &timer = *reinterpret_cast<Timer *>(pending.next);
+        listRemove(timer.link);
+        insert(timer);
+    }
+}
+
+/**
+ * @brief Ejecuta los temporizadores de una ranura del nivel 0 (vencen en `current_ms`).
+ */
+void TimerWheel::expireSlot(uint8_t slot)
+{
+    if (!(occupied[0] & (1ULL << slot)))
+    {
+        return;
+    }
+    TimerLink pending;
+    listInit(pending);
+    listSplice(slots[0][slot], pending);
+    occupied[0] &= ~(1ULL << slot);
+    while (pending.next != &pending)
+    {
+        Timer &timer = *reinterpret_cast<Timer *>(pending.next);
+        listRemove(timer.link);
+        if (timer.period_ms > 0)
+        {
+            timer.expires_ms += timer.period_ms;
+            insert(timer);
+        }
+        else
+        {
+            timer.active = false;
+            active_count--;
+        }
+        timer.callback(timer.context);
+    }
+}
@@ -0,0 +1,59 @@
+/**
+ * @file Adafruit_BMP280.cpp
+ * @brief Implementación de la librería del BMP280 del host.
+ */
+
+#include "Adafruit_BMP280.h"
+#include "HostBoard.h"
+
+/**
+ * @brief Lee el ID del chip y los coeficientes de compensación.
+ * @details Como la librería original, guarda el ID leído aunque no coincida.
+ */
+bool Adafruit_BMP280::begin(uint8_t address, uint8_t chipId)
+{
+    this->address = address;
+    Wire.beginTransmission(address);
+    Wire.write((uint8_t)0xD0);
+    sensor_id = (Wire.endTransmission() == 0 && Wire.requestFrom(address, (uint8_t)1) == 1) ? (uint8_t)Wire.read() : 0xFF;
+    if (sensor_id != chipId)
+    {
+        return false;
+    }
+    return hostBoard().bmpBegin(address, chipId);
+}
+
+/**
+ * @brief Registro de estado (0xF3); 0xFF si el sensor no responde.
+ */
+uint8_t Adafruit_BMP280::getStatus()
+{
+    Wire.beginTransmission(address);
+    Wire.write((uint8_t)0xF3);
+    if (Wire.endTransmission() != 0 || Wire.requestFrom(address, (uint8_t)1) != 1)
+    {
+        return 0xFF;
+    }
+    return (uint8_t)Wire.read();
+}
+
+float Adafruit_BMP280::readPressure()
+{
+    return hostBoard().bmpReadPressure();
+}
+
+/**
+ * @brief Escribe `config` y `ctrl_meas`; en modo forzado dispara una conversión.
+ */
+void Adafruit_BMP280::setSampling(sensor_mode mode, sensor_sampling tempSampling, sensor_sampling pressSampling,
+                                  sensor_filter filter, standby_duration duration)
+{
+    (void)tempSampling;
+    (void)pressSampling;
+    (void)filter;
+    (void)duration;
+    if (mode == MODE_FORCED)
+    {
+        hostBoard().bmpStartConversion();
+    }
+}
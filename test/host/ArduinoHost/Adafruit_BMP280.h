@@ -0,0 +1,36 @@
+#ifndef HOST_ADAFRUIT_BMP280_H
+#define HOST_ADAFRUIT_BMP280_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+/**
+ * @file Adafruit_BMP280.h
+ * @brief Librería del BMP280 del host, con la interfaz de la de Adafruit.
+ * @details Habla con el modelo del sensor de HostBoard a través del bus I2C
+ * virtual, así que un sensor ausente o un bus bloqueado fallan como en la placa.
+ */
+
+class Adafruit_BMP280
+{
+public:
+    enum sensor_sampling { SAMPLING_NONE, SAMPLING_X1, SAMPLING_X2, SAMPLING_X4, SAMPLING_X8, SAMPLING_X16 };
+    enum sensor_mode { MODE_SLEEP = 0x00, MODE_FORCED = 0x01, MODE_NORMAL = 0x03, MODE_SOFT_RESET_CODE = 0xB6 };
+    enum sensor_filter { FILTER_OFF, FILTER_X2, FILTER_X4, FILTER_X8, FILTER_X16 };
+    enum standby_duration { STANDBY_MS_1, STANDBY_MS_63, STANDBY_MS_125, STANDBY_MS_250, STANDBY_MS_500 };
+
+    Adafruit_BMP280(TwoWire *wire = &Wire) { (void)wire; }
+    bool begin(uint8_t address = 0x77, uint8_t chipId = 0x58);
+    uint8_t sensorID() { return sensor_id; }
+    uint8_t getStatus();
+    float readPressure();
+    void setSampling(sensor_mode mode = MODE_NORMAL, sensor_sampling tempSampling = SAMPLING_X16,
+                     sensor_sampling pressSampling = SAMPLING_X16, sensor_filter filter = FILTER_OFF,
+                     standby_duration duration = STANDBY_MS_1);
+
+private:
+    uint8_t address = 0x77;
+    uint8_t sensor_id = 0;
+};
+
+#endif // HOST_ADAFRUIT_BMP280_H
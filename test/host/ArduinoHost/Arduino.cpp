@@ -0,0 +1,198 @@
+/**
+ * @file Arduino.cpp
+ * @brief Implementación de la capa Arduino del host sobre la placa virtual.
+ */
+
+#include "Arduino.h"
+#include "HostBoard.h"
+
+HardwareSerial Serial(0);
+HardwareSerial Serial2(2);
+EspClass ESP;
+
+// --- Reloj ---
+
+/**
+ * @brief Milisegundos desde el arranque.
+ * @details Con `unsigned long` de 64 bits en el host no da la vuelta; los
+ * módulos que guardan el valor en 32 bits la ven a los 49.7 días, como en el ESP32.
+ */
+unsigned long millis()
+{
+    hostBoard().readClock();
+    return (unsigned long)(hostBoard().nowUs() / 1000);
+}
+
+/**
+ * @brief Microsegundos desde el arranque, en 32 bits como en el ESP32.
+ * @details Da la vuelta cada 71.6 min; `monotonicMicros()` la extiende.
+ */
+unsigned long micros()
+{
+    hostBoard().readClock();
+    return (uint32_t)hostBoard().nowUs();
+}
+
+void delay(uint32_t ms)
+{
+    hostBoard().advance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    hostBoard().advance(us);
+}
+
+// --- Pines y PWM ---
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    hostBoard().pinMode(pin, mode);
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    hostBoard().digitalWrite(pin, value);
+}
+
+int digitalRead(uint8_t pin)
+{
+    return hostBoard().digitalRead(pin);
+}
+
+double ledcSetup(uint8_t channel, double frequency, uint8_t resolutionBits)
+{
+    (void)channel;
+    (void)resolutionBits;
+    return frequency;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel)
+{
+    hostBoard().ledcAttach(pin, channel);
+}
+
+void ledcWrite(uint8_t channel, uint32_t duty)
+{
+    hostBoard().ledcWrite(channel, duty);
+}
+
+// --- Print ---
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size-- > 0)
+    {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::print(const char *text)
+{
+    return write((const uint8_t *)text, strlen(text));
+}
+
+size_t Print::print(long number, int base)
+{
+    char text[24];
+    if (base == HEX)
+    {
+        snprintf(text, sizeof(text), "%lX", (unsigned long)number);
+    }
+    else
+    {
+        snprintf(text, sizeof(text), "%ld", number);
+    }
+    return print(text);
+}
+
+size_t Print::print(unsigned long number, int base)
+{
+    char text[24];
+    snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", number);
+    return print(text);
+}
+
+size_t Print::print(double number, int digits)
+{
+    char text[48];
+    snprintf(text, sizeof(text), "%.*f", digits, number);
+    return print(text);
+}
+
+size_t Print::printf(const char *format, ...)
+{
+    char text[512];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if (len < 0)
+    {
+        return 0;
+    }
+    return write((const uint8_t *)text, (size_t)len < sizeof(text) ? (size_t)len : sizeof(text) - 1);
+}
+
+// --- Stream ---
+
+/**
+ * @brief Lee hasta `length` bytes de los ya recibidos.
+ * @details El core real espera hasta un timeout de 1 s a que lleguen; aquí se
+ * espera en el reloj virtual, byte a byte, hasta ese mismo timeout.
+ */
+size_t Stream::readBytes(uint8_t *buffer, size_t length)
+{
+    static const uint64_t TIMEOUT_US = 1000000;
+    uint64_t start = hostBoard().nowUs();
+    size_t count = 0;
+    while (count < length)
+    {
+        int c = read();
+        if (c >= 0)
+        {
+            buffer[count++] = (uint8_t)c;
+            continue;
+        }
+        if (hostBoard().nowUs() - start >= TIMEOUT_US)
+        {
+            break;
+        }
+        hostBoard().advance(100);
+    }
+    return count;
+}
+
+// --- HardwareSerial ---
+
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t rxPin, int8_t txPin)
+{
+    (void)baud;
+    (void)config;
+    (void)rxPin;
+    (void)txPin;
+    hostBoard().uartBegin(uart_num);
+}
+
+void HardwareSerial::end()
+{
+    hostBoard().uartEnd(uart_num);
+}
+
+int HardwareSerial::available()
+{
+    return hostBoard().uartAvailable(uart_num);
+}
+
+int HardwareSerial::read()
+{
+    return hostBoard().uartRead(uart_num);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    hostBoard().uartWrite(uart_num, buffer, size);
+    return size;
+}
@@ -0,0 +1,156 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include "WString.h"
+
+/**
+ * @file Arduino.h
+ * @brief Capa Arduino del host para ejecutar el firmware con `-D NODE_SIMULATION`.
+ * @details Implementa la parte del core de Arduino-ESP32 que usa el firmware
+ * sobre la placa virtual de HostBoard.h: el reloj es simulado (`delay()` lo
+ * avanza y cada lectura del reloj cuesta un poco de CPU virtual), los pines y
+ * el PWM se registran, `Serial` es la consola y `Serial2` el UART del MH-Z19C.
+ * Solo se compila en el entorno `sim` de platformio.ini.
+ */
+
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define OUTPUT_OPEN_DRAIN 0x13
+
+#define DEC 10
+#define HEX 16
+
+#define SERIAL_8N1 0x800001c
+
+#define F(text) (text)
+#define IRAM_ATTR
+
+// --- Reloj ---
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+// --- Pines y PWM ---
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+double ledcSetup(uint8_t channel, double frequency, uint8_t resolutionBits);
+void ledcAttachPin(uint8_t pin, uint8_t channel);
+void ledcWrite(uint8_t channel, uint32_t duty);
+
+template <typename T>
+T constrain(T value, T low, T high)
+{
+    return value < low ? low : (value > high ? high : value);
+}
+
+/**
+ * @class Print
+ * @brief Salida de texto con las sobrecargas de Arduino; las subclases solo escriben bytes.
+ */
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t b) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+
+    size_t print(const char *text);
+    size_t print(const String &text) { return print(text.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int number, int base = DEC) { return print((long)number, base); }
+    size_t print(unsigned int number, int base = DEC) { return print((unsigned long)number, base); }
+    size_t print(long number, int base = DEC);
+    size_t print(unsigned long number, int base = DEC);
+    size_t print(double number, int digits = 2);
+
+    size_t println() { return print("\r\n"); }
+    template <typename T>
+    size_t println(const T &value)
+    {
+        size_t n = print(value);
+        return n + println();
+    }
+    template <typename T>
+    size_t println(const T &value, int format)
+    {
+        size_t n = print(value, format);
+        return n + println();
+    }
+
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+/**
+ * @class Stream
+ * @brief Entrada de bytes con las lecturas de Arduino.
+ */
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    size_t readBytes(uint8_t *buffer, size_t length);
+    size_t readBytes(char *buffer, size_t length) { return readBytes((uint8_t *)buffer, length); }
+};
+
+/**
+ * @class HardwareSerial
+ * @brief UART de la placa virtual: 0 es la consola y 2 el enlace con el MH-Z19C.
+ * @details Los bytes recibidos llegan a su hora (según los baudios y la
+ * latencia del dispositivo) y `available()` solo cuenta los ya llegados.
+ */
+class HardwareSerial : public Stream
+{
+public:
+    explicit HardwareSerial(uint8_t uartNum) : uart_num(uartNum) {}
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1);
+    void end();
+    int available() override;
+    int read() override;
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    operator bool() const { return true; }
+
+private:
+    uint8_t uart_num;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial2;
+
+/**
+ * @class EspClass
+ * @brief Datos del chip que publica el diagnóstico; valores fijos de un ESP32 típico.
+ */
+class EspClass
+{
+public:
+    uint32_t getFreeHeap() { return 180 * 1024; }
+    uint32_t getMinFreeHeap() { return 160 * 1024; }
+    uint32_t getSketchSize() { return 1100 * 1024; }
+    uint32_t getFlashChipSize() { return 4 * 1024 * 1024; }
+};
+
+extern EspClass ESP;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,53 @@
+/**
+ * @file DHT.cpp
+ * @brief Implementación de la librería DHT del host.
+ */
+
+#include "DHT.h"
+#include "HostBoard.h"
+
+DHT::DHT(uint8_t pin, uint8_t type, uint8_t count) : pin(pin)
+{
+    (void)type;
+    (void)count;
+    last_read_ms = 0;
+    last_result = false;
+    temperature = NAN;
+    humidity = NAN;
+}
+
+/**
+ * @brief Prepara el pin; la primera lectura posterior hace una transacción.
+ */
+void DHT::begin(uint8_t usec)
+{
+    (void)usec;
+    pinMode(pin, INPUT_PULLUP);
+    last_read_ms = millis() - MIN_INTERVAL_MS;
+}
+
+float DHT::readTemperature(bool scale, bool force)
+{
+    (void)scale;
+    return read(force) ? temperature : NAN;
+}
+
+float DHT::readHumidity(bool force)
+{
+    return read(force) ? humidity : NAN;
+}
+
+/**
+ * @brief Hace la transacción si pasaron 2 s desde la anterior; si no, repite su resultado.
+ */
+bool DHT::read(bool force)
+{
+    unsigned long now = millis();
+    if (!force && now - last_read_ms < MIN_INTERVAL_MS)
+    {
+        return last_result;
+    }
+    last_read_ms = now;
+    last_result = hostBoard().dhtRead(temperature, humidity);
+    return last_result;
+}
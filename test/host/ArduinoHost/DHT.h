@@ -0,0 +1,35 @@
+#ifndef HOST_DHT_H
+#define HOST_DHT_H
+
+#include <Arduino.h>
+
+/**
+ * @file DHT.h
+ * @brief Librería DHT del host, con el comportamiento de la de Adafruit.
+ * @details Como la original, solo hace una transacción real cada 2 s: una
+ * lectura anterior devuelve el último resultado, aunque el entorno haya
+ * cambiado. La transacción la modela HostBoard.
+ */
+
+#define DHT22 22
+
+class DHT
+{
+public:
+    DHT(uint8_t pin, uint8_t type, uint8_t count = 6);
+    void begin(uint8_t usec = 55);
+    float readTemperature(bool scale = false, bool force = false);
+    float readHumidity(bool force = false);
+    bool read(bool force = false);
+
+private:
+    static const uint32_t MIN_INTERVAL_MS = 2000;
+
+    uint8_t pin;
+    unsigned long last_read_ms;
+    bool last_result;
+    float temperature;
+    float humidity;
+};
+
+#endif // HOST_DHT_H
@@ -0,0 +1,73 @@
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include <Arduino.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @file FS.h
+ * @brief Sistema de archivos en memoria del host, con la interfaz de `fs::FS`.
+ */
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs
+{
+
+typedef std::shared_ptr<std::vector<uint8_t>> FileData;
+
+/**
+ * @class File
+ * @brief Archivo abierto: datos compartidos con el sistema de archivos y posición propia.
+ */
+class File : public Stream
+{
+public:
+    File() {}
+    File(FileData data, bool writable, size_t position) : data(data), writable(writable), pos(position) {}
+
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    int available() override { return data ? (int)(data->size() - pos) : 0; }
+    int read() override;
+    size_t read(uint8_t *buffer, size_t size);
+    bool seek(uint32_t position);
+    size_t position() const { return pos; }
+    size_t size() const { return data ? data->size() : 0; }
+    void close() { data.reset(); }
+    operator bool() const { return (bool)data; }
+
+private:
+    FileData data;
+    bool writable = false;
+    size_t pos = 0;
+};
+
+/**
+ * @class FS
+ * @brief Tabla de rutas a contenidos.
+ */
+class FS
+{
+public:
+    File open(const char *path, const char *mode = FILE_READ, bool create = false);
+    bool exists(const char *path) { return files.count(path) > 0; }
+    bool remove(const char *path) { return files.erase(path) > 0; }
+    bool rename(const char *from, const char *to);
+    void format() { files.clear(); }
+
+protected:
+    std::map<std::string, FileData> files;
+};
+
+} // namespace fs
+
+using fs::File;
+
+#endif // HOST_FS_H
@@ -0,0 +1,473 @@
+/**
+ * @file HostBoard.cpp
+ * @brief Implementación de la placa virtual y de los modelos de los sensores.
+ */
+
+#include "HostBoard.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+/** @brief Pines del bus I2C del ESP32 (SDA 21, SCL 22). */
+static const uint8_t SDA_PIN = 21;
+static const uint8_t SCL_PIN = 22;
+
+/** @brief Duración mínima de HD en bajo para que el MH-Z19C calibre a cero. */
+static const uint64_t HD_ZERO_US = 7000000;
+
+/**
+ * @brief Constructor de la clase HostBoard.
+ * @details El entorno de partida es una habitación tranquila.
+ */
+HostBoard::HostBoard()
+{
+    now_us = 0;
+    environment = {22.5f, 45.0f, 1013.25f, 600};
+    memset(pin_levels, 0, sizeof(pin_levels));
+    memset(pin_modes, 0, sizeof(pin_modes));
+    memset(pwm_channel_of_pin, 0xFF, sizeof(pwm_channel_of_pin));
+    memset(pwm_duty, 0, sizeof(pwm_duty));
+    hd_low_since_us = 0;
+    i2c_register = 0;
+    scl_pulses = 0;
+    bmp_converting = false;
+    bmp_ready_us = 0;
+    memset(uart_open, 0, sizeof(uart_open));
+    uart_tx_free_us = 0;
+}
+
+// --- Reloj ---
+
+void HostBoard::advance(uint64_t us)
+{
+    now_us += us;
+}
+
+void HostBoard::readClock()
+{
+    now_us += clockReadCostUs;
+}
+
+// --- Pines y PWM ---
+
+void HostBoard::pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin < sizeof(pin_modes))
+    {
+        pin_modes[pin] = mode;
+    }
+}
+
+/**
+ * @brief Escribe un pin; vigila HD y los pulsos de reloj que liberan el bus I2C.
+ */
+void HostBoard::digitalWrite(uint8_t pin, uint8_t value)
+{
+    if (pin >= sizeof(pin_levels))
+    {
+        return;
+    }
+    uint8_t previous = pin_levels[pin];
+    pin_levels[pin] = value ? 1 : 0;
+
+    if (pin == hdPin && previous != pin_levels[pin])
+    {
+        if (pin_levels[pin] == 0)
+        {
+            hd_low_since_us = now_us;
+        }
+        else if (hd_low_since_us != 0)
+        {
+            if (now_us - hd_low_since_us >= HD_ZERO_US)
+            {
+                co2.offsetPpm = 400 - environment.co2; // El aire actual pasa a leerse como 400 ppm
+                co2.zeroCalibrations++;
+            }
+            hd_low_since_us = 0;
+        }
+    }
+
+    // Un flanco de subida de SCL termina un bit del byte que el BMP280 estaba enviando.
+    if (pin == SCL_PIN && previous == 0 && pin_levels[pin] == 1 && isI2cBusStuck() && ++scl_pulses >= 9)
+    {
+        bmp.holdsSda = false;
+        scl_pulses = 0;
+    }
+}
+
+int HostBoard::digitalRead(uint8_t pin)
+{
+    if (pin == SDA_PIN && isI2cBusStuck())
+    {
+        return 0;
+    }
+    return pin < sizeof(pin_levels) ? pin_levels[pin] : 0;
+}
+
+void HostBoard::ledcAttach(uint8_t pin, uint8_t channel)
+{
+    if (pin < sizeof(pwm_channel_of_pin) && channel < 16)
+    {
+        pwm_channel_of_pin[pin] = channel;
+    }
+}
+
+void HostBoard::ledcWrite(uint8_t channel, uint32_t duty)
+{
+    if (channel < 16)
+    {
+        pwm_duty[channel] = duty;
+    }
+}
+
+uint32_t HostBoard::getPwmDuty(uint8_t pin) const
+{
+    uint8_t channel = pin < sizeof(pwm_channel_of_pin) ? pwm_channel_of_pin[pin] : 0xFF;
+    return channel < 16 ? pwm_duty[channel] : 0;
+}
+
+// --- Bus I2C ---
+
+void HostBoard::addI2cDevice(uint8_t address, uint8_t idRegister, uint8_t idValue)
+{
+    i2c_devices[address][idRegister] = idValue;
+}
+
+/**
+ * @brief Transmisión del maestro: dirección y bytes.
+ * @details El primer byte fija el puntero de registro. Con el bus retenido
+ * toda transacción falla por arbitraje perdido.
+ * @return uint8_t 0 si hubo ACK, 2 si nadie respondió a la dirección, 5 con el bus retenido.
+ */
+uint8_t HostBoard::i2cWrite(uint8_t address, const std::vector<uint8_t> &bytes, bool stop)
+{
+    (void)stop;
+    i2cTransactions++;
+    advance((1 + bytes.size()) * I2C_BYTE_US);
+    if (isI2cBusStuck())
+    {
+        return 5;
+    }
+    bool isBmp = bmp.present && address == bmp.address;
+    if (!isBmp && i2c_devices.find(address) == i2c_devices.end())
+    {
+        return 2;
+    }
+    if (!bytes.empty())
+    {
+        i2c_register = bytes[0];
+    }
+    return 0;
+}
+
+/**
+ * @brief Lectura del maestro a partir del puntero de registro.
+ * @return size_t Bytes recibidos (0 si nadie respondió).
+ */
+size_t HostBoard::i2cRead(uint8_t address, size_t count, std::vector<uint8_t> &bytes)
+{
+    i2cTransactions++;
+    advance((1 + count) * I2C_BYTE_US);
+    bytes.clear();
+    if (isI2cBusStuck())
+    {
+        return 0;
+    }
+    if (bmp.present && address == bmp.address)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            uint8_t reg = (uint8_t)(i2c_register + i);
+            bytes.push_back(reg == 0xD0 ? bmp.chipId : (reg == 0xF3 ? bmpStatus() : 0));
+        }
+        return count;
+    }
+    auto device = i2c_devices.find(address);
+    if (device == i2c_devices.end())
+    {
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        auto reg = device->second.find((uint8_t)(i2c_register + i));
+        bytes.push_back(reg != device->second.end() ? reg->second : 0);
+    }
+    return count;
+}
+
+// --- Sensores ---
+
+/**
+ * @brief Transacción completa del DHT22.
+ * @details Ocupa la CPU ~5 ms. Los valores salen con la resolución del
+ * sensor (0.1 °C y 0.1 % HR).
+ * @return bool `false` si el sensor no respondió.
+ */
+bool HostBoard::dhtRead(float &temperature, float &humidity)
+{
+    advance(dht.transactionUs);
+    if (!dht.connected)
+    {
+        return false;
+    }
+    dht.conversions++;
+    temperature = roundf(environment.temperature * 10.0f) / 10.0f;
+    humidity = roundf(environment.humidity * 10.0f) / 10.0f;
+    return true;
+}
+
+/**
+ * @brief Comprueba el ID del chip al iniciar la librería.
+ */
+bool HostBoard::bmpBegin(uint8_t address, uint8_t chipId)
+{
+    std::vector<uint8_t> reg = {0xD0};
+    std::vector<uint8_t> id;
+    if (i2cWrite(address, reg, false) != 0 || i2cRead(address, 1, id) != 1 || id[0] != chipId)
+    {
+        return false;
+    }
+    std::vector<uint8_t> calibration;
+    i2cWrite(address, {0x88}, false);
+    i2cRead(address, 24, calibration); // Coeficientes de compensación
+    bmp_converting = false;
+    return true;
+}
+
+/**
+ * @brief Escribir el modo forzado en `ctrl_meas` dispara una conversión.
+ */
+void HostBoard::bmpStartConversion()
+{
+    std::vector<uint8_t> bytes = {0xF5, 0x00, 0xF4, 0x00}; // config y ctrl_meas
+    if (i2cWrite(bmp.address, bytes, true) != 0)
+    {
+        return;
+    }
+    bmp_converting = true;
+    bmp_ready_us = now_us + bmp.conversionUs;
+}
+
+/**
+ * @brief Registro de estado; sin respuesta del bus se lee 0xFF (bit `measuring` activo).
+ */
+uint8_t HostBoard::bmpStatus()
+{
+    if (!bmp.present || isI2cBusStuck())
+    {
+        return 0xFF;
+    }
+    if (bmp_converting && now_us >= bmp_ready_us)
+    {
+        bmp_converting = false;
+        bmp.conversions++;
+    }
+    return bmp_converting ? 0x08 : 0x00;
+}
+
+float HostBoard::bmpReadPressure()
+{
+    std::vector<uint8_t> raw;
+    if (i2cWrite(bmp.address, {0xF7}, false) != 0 || i2cRead(bmp.address, 6, raw) != 6)
+    {
+        return NAN;
+    }
+    return environment.pressure * 100.0f;
+}
+
+// --- UART ---
+
+void HostBoard::uartBegin(uint8_t uart)
+{
+    if (uart < 3)
+    {
+        uart_open[uart] = true;
+    }
+}
+
+/**
+ * @brief Cierra el UART: se pierde lo recibido y lo que quedaba por enviar.
+ */
+void HostBoard::uartEnd(uint8_t uart)
+{
+    if (uart < 3)
+    {
+        uart_open[uart] = false;
+    }
+    if (uart == 2)
+    {
+        uart_rx.clear();
+        mhz19_frame.clear();
+    }
+}
+
+/**
+ * @brief Escribe bytes en un UART.
+ * @details En el UART2 los bytes salen uno tras otro a 9600 baudios sin
+ * bloquear (buffer de transmisión) y el MH-Z19C procesa cada trama al
+ * terminar de recibirla.
+ */
+void HostBoard::uartWrite(uint8_t uart, const uint8_t *data, size_t len)
+{
+    if (uart == 0)
+    {
+        consoleWrite(data, len);
+        return;
+    }
+    if (uart != 2 || !uart_open[2])
+    {
+        return;
+    }
+    uint64_t at = uart_tx_free_us > now_us ? uart_tx_free_us : now_us;
+    for (size_t i = 0; i < len; i++)
+    {
+        at += UART_BYTE_US;
+        mhz19_frame.push_back(data[i]);
+        if (mhz19_frame.size() == 9)
+        {
+            mhz19Receive(mhz19_frame.data(), at);
+            mhz19_frame.clear();
+        }
+    }
+    uart_tx_free_us = at;
+}
+
+int HostBoard::uartAvailable(uint8_t uart)
+{
+    if (uart != 2)
+    {
+        return 0;
+    }
+    int count = 0;
+    for (const RxByte &b : uart_rx)
+    {
+        if (b.atUs > now_us)
+        {
+            break;
+        }
+        count++;
+    }
+    return count;
+}
+
+int HostBoard::uartRead(uint8_t uart)
+{
+    if (uartAvailable(uart) == 0)
+    {
+        return -1;
+    }
+    int value = uart_rx.front().value;
+    uart_rx.pop_front();
+    return value;
+}
+
+/**
+ * @brief El MH-Z19C procesa una trama recibida.
+ * @details Las tramas con el checksum mal se ignoran, como hace el sensor.
+ * Solo la lectura (0x86) tiene respuesta.
+ * @param frame Trama de 9 bytes.
+ * @param endUs Instante en que terminó de llegar.
+ */
+void HostBoard::mhz19Receive(const uint8_t *frame, uint64_t endUs)
+{
+    uint8_t sum = 0;
+    for (int i = 1; i < 8; i++)
+    {
+        sum += frame[i];
+    }
+    if (!co2.connected || frame[0] != 0xFF || (uint8_t)(0xFF - sum + 1) != frame[8])
+    {
+        return;
+    }
+    co2.commands.push_back(frame[2]);
+    switch (frame[2])
+    {
+    case 0x86:
+    {
+        co2.readRequests++;
+        int ppm = co2Reading();
+        uint8_t response[9] = {0xFF, 0x86, (uint8_t)(ppm >> 8), (uint8_t)(ppm & 0xFF), 0x40, 0, 0, 0, 0};
+        uint8_t check = 0;
+        for (int i = 1; i < 8; i++)
+        {
+            check += response[i];
+        }
+        response[8] = (uint8_t)(0xFF - check + 1) + (co2.corrupt ? 1 : 0);
+        uint64_t at = endUs + co2.responseDelayUs;
+        for (uint8_t b : response)
+        {
+            at += UART_BYTE_US;
+            uart_rx.push_back({at, b});
+        }
+        break;
+    }
+    case 0x87:
+        co2.offsetPpm = 400 - environment.co2;
+        co2.zeroCalibrations++;
+        break;
+    case 0x79:
+        co2.abcEnabled = frame[3] == 0xA0;
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Lectura del sensor: el entorno más el error de calibración, o el valor congelado.
+ */
+int HostBoard::co2Reading() const
+{
+    if (co2.frozen)
+    {
+        return co2.frozenValue;
+    }
+    int ppm = environment.co2 + co2.offsetPpm;
+    return ppm < 0 ? 0 : (ppm > 5000 ? 5000 : ppm);
+}
+
+// --- Consola ---
+
+void HostBoard::consoleWrite(const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        char c = (char)data[i];
+        if (c == '\r')
+        {
+            continue;
+        }
+        if (c != '\n')
+        {
+            console_line += c;
+            continue;
+        }
+        if (echoConsole)
+        {
+            printf("[%10.3f] %s\n", now_us / 1e6, console_line.c_str());
+        }
+        console.push_back({now_us, console_line});
+        console_line.clear();
+    }
+}
+
+/**
+ * @brief Indica si alguna línea de la consola desde `sinceUs` contiene `text`.
+ */
+bool HostBoard::consoleContains(const std::string &text, uint64_t sinceUs) const
+{
+    for (const ConsoleLine &line : console)
+    {
+        if (line.atUs >= sinceUs && line.text.find(text) != std::string::npos)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+HostBoard &hostBoard()
+{
+    static HostBoard board;
+    return board;
+}
@@ -0,0 +1,188 @@
+#ifndef HOST_BOARD_H
+#define HOST_BOARD_H
+
+#include <stdint.h>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @file HostBoard.h
+ * @brief Placa virtual del PCB1 sobre la que corre la capa Arduino del host.
+ * @details Reúne el reloj simulado, los pines, el PWM, el bus I2C, el UART
+ * del MH-Z19C y los modelos de los sensores (DHT22, BMP280 y MH-Z19C) frente
+ * a un entorno físico que fija el escenario. Cada modelo tiene los tiempos de
+ * su hoja de datos y sus averías típicas, que el escenario puede inyectar.
+ *
+ * El reloj solo avanza con `delay()`, con el tiempo de las transacciones
+ * (bus I2C, lectura del DHT22...) y con un coste fijo por lectura del reloj,
+ * que hace que las esperas activas del firmware terminen.
+ */
+
+/**
+ * @struct Environment
+ * @brief Magnitudes reales del entorno, antes de pasar por los sensores.
+ */
+struct Environment
+{
+    float temperature; // °C
+    float humidity;    // % HR
+    float pressure;    // hPa
+    int co2;           // ppm
+};
+
+/**
+ * @struct HostDht22
+ * @brief Modelo del DHT22 y su librería: una transacción de ~5 ms, como mucho cada 2 s.
+ */
+struct HostDht22
+{
+    bool connected = true;              // Sin sensor la transacción da NaN
+    uint32_t transactionUs = 5000;      // Transacción completa, con las interrupciones desactivadas
+    uint32_t conversions = 0;           // Transacciones reales (no las servidas desde la caché)
+};
+
+/**
+ * @struct HostBmp280
+ * @brief Modelo del BMP280 en modo forzado.
+ */
+struct HostBmp280
+{
+    uint8_t address = 0x76;
+    uint8_t chipId = 0x58;
+    bool present = true;                // Responde en el bus
+    bool holdsSda = false;              // Mantiene SDA en bajo hasta recibir pulsos de reloj
+    uint32_t conversionUs = 37500;      // Conversión típica con X2/X16
+    uint32_t conversions = 0;
+};
+
+/**
+ * @struct HostMhz19
+ * @brief Modelo del MH-Z19C por UART a 9600 baudios.
+ * @details Responde a cada trama válida de lectura tras `responseDelayUs`; los
+ * comandos de calibración se aplican sobre la lectura. Con `frozen` repite
+ * `frozenValue` aunque cambie el entorno.
+ */
+struct HostMhz19
+{
+    bool connected = true;              // Sin sensor no hay respuesta
+    bool corrupt = false;               // Responde con el checksum mal
+    bool frozen = false;
+    int frozenValue = 0;
+    uint32_t responseDelayUs = 2000;    // Desde el fin de la petición al primer byte de la respuesta
+    int offsetPpm = 0;                  // Error de la lectura respecto al entorno
+    bool abcEnabled = true;             // Autocalibración (el firmware la desactiva al arrancar)
+    uint32_t readRequests = 0;
+    uint32_t zeroCalibrations = 0;      // Por comando o por el pin HD
+    std::vector<uint8_t> commands;      // Byte de comando de cada trama recibida
+};
+
+/**
+ * @struct ConsoleLine
+ * @brief Línea escrita en `Serial`, con la hora virtual en que se terminó.
+ */
+struct ConsoleLine
+{
+    uint64_t atUs;
+    std::string text;
+};
+
+/**
+ * @class HostBoard
+ * @brief Hardware virtual compartido por la capa Arduino del host.
+ */
+class HostBoard
+{
+public:
+    HostBoard(); // Constructor
+
+    // --- Reloj ---
+    uint64_t nowUs() const { return now_us; }
+    void advance(uint64_t us); // Pasa el tiempo (una espera o una transacción)
+    void readClock();          // Coste de una lectura del reloj
+    uint32_t clockReadCostUs = 1;
+
+    // --- Entorno y sensores ---
+    Environment environment;
+    HostDht22 dht;
+    HostBmp280 bmp;
+    HostMhz19 co2;
+    uint8_t hdPin = 12; // Entrada HD del MH-Z19C: en bajo 7 s o más, calibración a cero
+    void addI2cDevice(uint8_t address, uint8_t idRegister, uint8_t idValue); // Otro dispositivo en el bus
+
+    // --- Pines y PWM ---
+    void pinMode(uint8_t pin, uint8_t mode);
+    void digitalWrite(uint8_t pin, uint8_t value);
+    int digitalRead(uint8_t pin);
+    void ledcAttach(uint8_t pin, uint8_t channel);
+    void ledcWrite(uint8_t channel, uint32_t duty);
+    uint32_t getPwmDuty(uint8_t pin) const; // Duty del canal unido al pin, 0 si no hay
+
+    // --- Bus I2C (Wire) ---
+    uint8_t i2cWrite(uint8_t address, const std::vector<uint8_t> &bytes, bool stop); // Código de `endTransmission()`
+    size_t i2cRead(uint8_t address, size_t count, std::vector<uint8_t> &bytes);
+    bool isI2cBusStuck() const { return bmp.present && bmp.holdsSda; }
+    uint32_t i2cTransactions = 0;
+
+    // --- UART ---
+    void uartBegin(uint8_t uart);
+    void uartEnd(uint8_t uart);
+    void uartWrite(uint8_t uart, const uint8_t *data, size_t len);
+    int uartAvailable(uint8_t uart);
+    int uartRead(uint8_t uart);
+
+    // --- Consola ---
+    std::vector<ConsoleLine> console;
+    bool echoConsole = false; // Copia la consola a la salida estándar
+    bool consoleContains(const std::string &text, uint64_t sinceUs = 0) const;
+
+    // --- Sensores, vistos desde sus librerías ---
+    bool dhtRead(float &temperature, float &humidity); // Transacción del DHT22
+    bool bmpBegin(uint8_t address, uint8_t chipId);
+    void bmpStartConversion();
+    uint8_t bmpStatus();
+    float bmpReadPressure(); // Pa, o NaN si no responde
+
+private:
+    /**
+     * @struct RxByte
+     * @brief Byte recibido por un UART, disponible a partir de `atUs`.
+     */
+    struct RxByte
+    {
+        uint64_t atUs;
+        uint8_t value;
+    };
+
+    static const uint32_t UART_BYTE_US = 1042;  // 10 bits a 9600 baudios
+    static const uint32_t I2C_BYTE_US = 90;     // 9 bits a 100 kHz
+
+    void mhz19Receive(const uint8_t *frame, uint64_t endUs); // Trama completa recibida por el sensor
+    void consoleWrite(const uint8_t *data, size_t len);
+    int co2Reading() const;
+
+    uint64_t now_us;
+    uint8_t pin_levels[40];
+    uint8_t pin_modes[40];
+    uint8_t pwm_channel_of_pin[40]; // 0xFF = sin canal
+    uint32_t pwm_duty[16];
+    uint64_t hd_low_since_us;       // 0 = HD en alto
+    std::map<uint8_t, std::map<uint8_t, uint8_t>> i2c_devices; // Dirección -> registros de otros dispositivos
+    uint8_t i2c_register;           // Puntero de registro del último dispositivo escrito
+    uint8_t scl_pulses;             // Pulsos de reloj con SDA retenido
+    bool bmp_converting;
+    uint64_t bmp_ready_us;
+    bool uart_open[3];
+    uint64_t uart_tx_free_us;       // Fin de la transmisión en curso del UART2
+    std::vector<uint8_t> mhz19_frame; // Trama en recepción del MH-Z19C
+    std::deque<RxByte> uart_rx;     // Bytes hacia el ESP32 por el UART2
+    std::string console_line;
+};
+
+/**
+ * @brief Placa virtual única del proceso.
+ */
+HostBoard &hostBoard();
+
+#endif // HOST_BOARD_H
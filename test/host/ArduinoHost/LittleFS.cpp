@@ -0,0 +1,112 @@
+/**
+ * @file LittleFS.cpp
+ * @brief Implementación del sistema de archivos en memoria del host.
+ */
+
+#include "LittleFS.h"
+
+fs::LittleFSFS LittleFS;
+
+namespace fs
+{
+
+size_t File::write(const uint8_t *buffer, size_t size)
+{
+    if (!data || !writable)
+    {
+        return 0;
+    }
+    if (pos > data->size())
+    {
+        pos = data->size();
+    }
+    size_t overlap = std::min(size, data->size() - pos);
+    std::copy(buffer, buffer + overlap, data->begin() + pos);
+    data->insert(data->end(), buffer + overlap, buffer + size);
+    pos += size;
+    return size;
+}
+
+int File::read()
+{
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+}
+
+size_t File::read(uint8_t *buffer, size_t size)
+{
+    if (!data || pos >= data->size())
+    {
+        return 0;
+    }
+    size_t count = std::min(size, data->size() - pos);
+    std::copy(data->begin() + pos, data->begin() + pos + count, buffer);
+    pos += count;
+    return count;
+}
+
+bool File::seek(uint32_t position)
+{
+    if (!data || position > data->size())
+    {
+        return false;
+    }
+    pos = position;
+    return true;
+}
+
+/**
+ * @brief Abre un archivo como `fopen()`: "r" exige que exista, "w" lo vacía y "a" escribe al final.
+ */
+File FS::open(const char *path, const char *mode, bool create)
+{
+    (void)create;
+    auto found = files.find(path);
+    if (strcmp(mode, FILE_READ) == 0)
+    {
+        return found != files.end() ? File(found->second, false, 0) : File();
+    }
+    if (found == files.end())
+    {
+        found = files.emplace(path, std::make_shared<std::vector<uint8_t>>()).first;
+    }
+    if (strcmp(mode, FILE_WRITE) == 0)
+    {
+        found->second->clear();
+    }
+    return File(found->second, true, found->second->size());
+}
+
+bool FS::rename(const char *from, const char *to)
+{
+    auto found = files.find(from);
+    if (found == files.end())
+    {
+        return false;
+    }
+    FileData data = found->second;
+    files.erase(found);
+    files[to] = data;
+    return true;
+}
+
+bool LittleFSFS::begin(bool formatOnFail, const char *basePath, uint8_t maxOpenFiles, const char *partitionLabel)
+{
+    (void)formatOnFail;
+    (void)basePath;
+    (void)maxOpenFiles;
+    (void)partitionLabel;
+    return !mountFails;
+}
+
+size_t LittleFSFS::usedBytes()
+{
+    size_t used = 0;
+    for (const auto &file : files)
+    {
+        used += file.second->size();
+    }
+    return used;
+}
+
+} // namespace fs
@@ -0,0 +1,30 @@
+#ifndef HOST_LITTLEFS_H
+#define HOST_LITTLEFS_H
+
+#include "FS.h"
+
+/**
+ * @file LittleFS.h
+ * @brief Partición LittleFS del host, en memoria.
+ * @details `mountFails` simula una partición que no se puede montar.
+ */
+
+namespace fs
+{
+
+class LittleFSFS : public FS
+{
+public:
+    bool begin(bool formatOnFail = false, const char *basePath = "/littlefs", uint8_t maxOpenFiles = 10,
+               const char *partitionLabel = "spiffs");
+    size_t usedBytes();
+    size_t totalBytes() { return 1408 * 1024; }
+
+    bool mountFails = false;
+};
+
+} // namespace fs
+
+extern fs::LittleFSFS LittleFS;
+
+#endif // HOST_LITTLEFS_H
@@ -0,0 +1,114 @@
+/**
+ * @file Preferences.cpp
+ * @brief Implementación de la NVS en memoria del host.
+ */
+
+#include "Preferences.h"
+
+std::map<std::string, Preferences::Namespace> &Preferences::storage()
+{
+    static std::map<std::string, Namespace> nvs;
+    return nvs;
+}
+
+bool Preferences::begin(const char *name, bool readOnly)
+{
+    auto found = storage().find(name);
+    if (found == storage().end())
+    {
+        if (readOnly)
+        {
+            return false; // NOT_FOUND, como `nvs_open()` en solo lectura
+        }
+        found = storage().emplace(name, Namespace()).first;
+    }
+    open_namespace = &found->second;
+    read_only = readOnly;
+    return true;
+}
+
+void Preferences::end()
+{
+    open_namespace = nullptr;
+}
+
+bool Preferences::clear()
+{
+    if (open_namespace == nullptr || read_only)
+    {
+        return false;
+    }
+    open_namespace->clear();
+    return true;
+}
+
+bool Preferences::remove(const char *key)
+{
+    if (open_namespace == nullptr || read_only)
+    {
+        return false;
+    }
+    return open_namespace->erase(key) > 0;
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t len)
+{
+    if (open_namespace == nullptr || read_only)
+    {
+        return 0;
+    }
+    const uint8_t *bytes = (const uint8_t *)value;
+    (*open_namespace)[key].assign(bytes, bytes + len);
+    return len;
+}
+
+size_t Preferences::getBytesLength(const char *key)
+{
+    if (open_namespace == nullptr)
+    {
+        return 0;
+    }
+    auto found = open_namespace->find(key);
+    return found != open_namespace->end() ? found->second.size() : 0;
+}
+
+/**
+ * @return size_t Bytes copiados; 0 si la clave no existe o no cabe en `buffer`.
+ */
+size_t Preferences::getBytes(const char *key, void *buffer, size_t maxLen)
+{
+    size_t len = getBytesLength(key);
+    if (len == 0 || len > maxLen)
+    {
+        return 0;
+    }
+    memcpy(buffer, (*open_namespace)[key].data(), len);
+    return len;
+}
+
+size_t Preferences::putUInt(const char *key, uint32_t value)
+{
+    return putBytes(key, &value, sizeof(value));
+}
+
+uint32_t Preferences::getUInt(const char *key, uint32_t defaultValue)
+{
+    uint32_t value = defaultValue;
+    return getBytesLength(key) == sizeof(value) && getBytes(key, &value, sizeof(value)) ? value : defaultValue;
+}
+
+size_t Preferences::putUChar(const char *key, uint8_t value)
+{
+    return putBytes(key, &value, sizeof(value));
+}
+
+uint8_t Preferences::getUChar(const char *key, uint8_t defaultValue)
+{
+    uint8_t value = defaultValue;
+    return getBytesLength(key) == sizeof(value) && getBytes(key, &value, sizeof(value)) ? value : defaultValue;
+}
+
+void Preferences::clearAll()
+{
+    storage().clear();
+}
@@ -0,0 +1,41 @@
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @file Preferences.h
+ * @brief NVS del host en memoria, con la interfaz de `Preferences` de Arduino-ESP32.
+ * @details Como en el ESP32, abrir en solo lectura un espacio de nombres que
+ * no existe falla. El contenido dura lo que el proceso; `clearAll()` lo borra.
+ */
+
+class Preferences
+{
+public:
+    bool begin(const char *name, bool readOnly = false);
+    void end();
+    bool clear();
+    bool remove(const char *key);
+    size_t putBytes(const char *key, const void *value, size_t len);
+    size_t getBytesLength(const char *key);
+    size_t getBytes(const char *key, void *buffer, size_t maxLen);
+    size_t putUInt(const char *key, uint32_t value);
+    uint32_t getUInt(const char *key, uint32_t defaultValue = 0);
+    size_t putUChar(const char *key, uint8_t value);
+    uint8_t getUChar(const char *key, uint8_t defaultValue = 0);
+
+    static void clearAll(); // Borra la NVS entera (placa recién flasheada)
+
+private:
+    typedef std::map<std::string, std::vector<uint8_t>> Namespace;
+
+    static std::map<std::string, Namespace> &storage();
+    Namespace *open_namespace = nullptr;
+    bool read_only = false;
+};
+
+#endif // HOST_PREFERENCES_H
@@ -0,0 +1,123 @@
+#ifndef HOST_WSTRING_H
+#define HOST_WSTRING_H
+
+#include <stdlib.h>
+#include <string>
+
+/**
+ * @file WString.h
+ * @brief `String` de la capa Arduino del host, sobre `std::string`.
+ * @details Solo implementa lo que usa el firmware, con la semántica del core
+ * de Arduino (índices fuera de rango, `toInt()` de un texto no numérico...).
+ */
+
+class String
+{
+public:
+    String(const char *text = "") : value(text != nullptr ? text : "") {}
+    String(const std::string &text) : value(text) {}
+    String(const String &other) = default;
+    explicit String(char c) : value(1, c) {}
+    explicit String(int number) : value(std::to_string(number)) {}
+    explicit String(unsigned int number) : value(std::to_string(number)) {}
+    explicit String(long number) : value(std::to_string(number)) {}
+    explicit String(unsigned long number) : value(std::to_string(number)) {}
+
+    String &operator=(const String &other) = default;
+
+    const char *c_str() const { return value.c_str(); }
+    unsigned int length() const { return (unsigned int)value.size(); }
+    bool isEmpty() const { return value.empty(); }
+    bool reserve(unsigned int size)
+    {
+        value.reserve(size);
+        return true;
+    }
+
+    char operator[](unsigned int index) const { return index < value.size() ? value[index] : '\0'; }
+    bool operator==(const String &other) const { return value == other.value; }
+    bool operator==(const char *other) const { return value == (other != nullptr ? other : ""); }
+    bool operator!=(const String &other) const { return !(*this == other); }
+    bool operator!=(const char *other) const { return !(*this == other); }
+
+    String &operator+=(const String &other)
+    {
+        value += other.value;
+        return *this;
+    }
+    String &operator+=(const char *other)
+    {
+        value += other;
+        return *this;
+    }
+    String &operator+=(char c)
+    {
+        value += c;
+        return *this;
+    }
+    String operator+(const String &other) const { return String(value + other.value); }
+    String operator+(const char *other) const { return String(value + other); }
+
+    bool startsWith(const String &prefix) const { return value.compare(0, prefix.value.size(), prefix.value) == 0; }
+    bool endsWith(const String &suffix) const
+    {
+        return value.size() >= suffix.value.size() &&
+               value.compare(value.size() - suffix.value.size(), suffix.value.size(), suffix.value) == 0;
+    }
+
+    /** @brief Desde `from` hasta el final; vacío si `from` está fuera del texto. */
+    String substring(unsigned int from) const { return from < value.size() ? String(value.substr(from)) : String(); }
+
+    /** @brief De `from` a `to` (sin incluir); los extremos se intercambian si vienen al revés. */
+    String substring(unsigned int from, unsigned int to) const
+    {
+        if (from > to)
+        {
+            unsigned int swap = from;
+            from = to;
+            to = swap;
+        }
+        if (from >= value.size())
+        {
+            return String();
+        }
+        return String(value.substr(from, to - from));
+    }
+
+    int indexOf(char c, unsigned int from = 0) const { return position(value.find(c, from)); }
+    int indexOf(const String &text, unsigned int from = 0) const { return position(value.find(text.value, from)); }
+
+    /** @brief Entero al principio del texto, 0 si no empieza por un número (como `atol`). */
+    long toInt() const { return atol(value.c_str()); }
+    float toFloat() const { return (float)atof(value.c_str()); }
+
+    void trim()
+    {
+        const char *spaces = " \t\r\n";
+        size_t first = value.find_first_not_of(spaces);
+        if (first == std::string::npos)
+        {
+            value.clear();
+            return;
+        }
+        value = value.substr(first, value.find_last_not_of(spaces) - first + 1);
+    }
+
+    void toUpperCase()
+    {
+        for (char &c : value)
+        {
+            if (c >= 'a' && c <= 'z')
+            {
+                c = (char)(c - 'a' + 'A');
+            }
+        }
+    }
+
+private:
+    static int position(size_t found) { return found == std::string::npos ? -1 : (int)found; }
+
+    std::string value;
+};
+
+#endif // HOST_WSTRING_H
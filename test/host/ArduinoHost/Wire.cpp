@@ -0,0 +1,49 @@
+/**
+ * @file Wire.cpp
+ * @brief Implementación de `TwoWire` sobre el bus I2C de la placa virtual.
+ */
+
+#include "Wire.h"
+#include "HostBoard.h"
+
+TwoWire Wire;
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency)
+{
+    (void)sda;
+    (void)scl;
+    (void)frequency;
+    return true;
+}
+
+bool TwoWire::end()
+{
+    return true;
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    tx_address = address;
+    tx.clear();
+}
+
+/**
+ * @return uint8_t 0 si hubo ACK, 2 sin ACK de la dirección, 5 con el bus bloqueado.
+ */
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+    return hostBoard().i2cWrite(tx_address, tx, sendStop);
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool sendStop)
+{
+    (void)sendStop;
+    rx_index = 0;
+    return (uint8_t)hostBoard().i2cRead(address, quantity, rx);
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+    tx.push_back(data);
+    return 1;
+}
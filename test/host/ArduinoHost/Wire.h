@@ -0,0 +1,40 @@
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <Arduino.h>
+#include <vector>
+
+/**
+ * @file Wire.h
+ * @brief Bus I2C de la placa virtual con la interfaz de `TwoWire`.
+ * @details Cada transacción ocupa el tiempo de sus bytes a 100 kHz en el
+ * reloj virtual. Los dispositivos los modela HostBoard.
+ */
+
+#define SDA 21
+#define SCL 22
+
+class TwoWire : public Stream
+{
+public:
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+    bool end();
+    void beginTransmission(uint8_t address);
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true);
+    size_t write(uint8_t data) override;
+    using Print::write;
+    int available() override { return (int)(rx.size() - rx_index); }
+    int read() override { return rx_index < rx.size() ? rx[rx_index++] : -1; }
+    void setClock(uint32_t frequency) { (void)frequency; }
+
+private:
+    uint8_t tx_address = 0;
+    std::vector<uint8_t> tx;
+    std::vector<uint8_t> rx;
+    size_t rx_index = 0;
+};
+
+extern TwoWire Wire;
+
+#endif // HOST_WIRE_H
@@ -0,0 +1,136 @@
+#ifndef MOCK_SENSOR_DRIVER_H
+#define MOCK_SENSOR_DRIVER_H
+
+#include <Arduino.h>
+#include <string>
+#include "SensorDriver.h"
+
+/**
+ * @file MockSensorDriver.h
+ * @brief Driver de sensor falso para probar `SensorDriver` y `SensorSet` en el host.
+ * @details Cumple la interfaz estática de los drivers reales; la prueba fija
+ * su comportamiento (presencia, tiempo de conversión, validez y valor) y
+ * cada llamada queda en un registro común a todos los drivers falsos, con el
+ * formato "A.start B.start A.read...". El tiempo es el reloj virtual de la
+ * placa del host (`micros()`).
+ */
+
+/**
+ * @brief Registro de llamadas de todos los drivers falsos, separadas por espacios.
+ */
+inline std::string &mockSensorLog()
+{
+    static std::string log;
+    return log;
+}
+
+/**
+ * @class MockSensorDriver
+ * @brief Driver falso de un tipo de sensor.
+ * @tparam Kind Tipo de sensor que simula; decide qué campos de `SensorData` escribe.
+ * @tparam Name Letra que lo identifica en el registro.
+ */
+template <SensorKind Kind, char Name>
+class MockSensorDriver : public SensorDriver<MockSensorDriver<Kind, Name>>
+{
+public:
+    static const SensorKind KIND = Kind;
+    static const unsigned long TIMEOUT_MS = 100;
+    static const uint32_t STUCK_TIMEOUT_MS = 60 * 1000UL; // 1 minuto, para no alargar las pruebas
+
+    // --- Comportamiento, lo fija la prueba ---
+    bool present = true;       // Responde al iniciar, medir y recuperar
+    uint32_t conversionUs = 0; // Desde el inicio de la medida hasta que está lista
+    bool valid = true;         // La lectura es válida
+    float value = 0;           // Valor que escribe en sus campos
+    bool fresh = true;         // La lectura es una conversión nueva (no una repetida)
+
+    // --- Llamadas recibidas ---
+    uint32_t begins = 0;
+    uint32_t starts = 0;
+    uint32_t reads = 0;
+    uint32_t recoveries = 0;
+    uint32_t timeouts = 0;
+
+    bool beginSensor()
+    {
+        log("begin");
+        begins++;
+        return present;
+    }
+
+    bool startSensor()
+    {
+        log("start");
+        starts++;
+        start_us = micros();
+        return present;
+    }
+
+    MeasurementStatus pollSensor()
+    {
+        return micros() - start_us >= conversionUs ? MEASUREMENT_READY : MEASUREMENT_PENDING;
+    }
+
+    bool readSensor(SensorData &data)
+    {
+        log("read");
+        reads++;
+        write(data, value);
+        return valid;
+    }
+
+    void invalidate(SensorData &data)
+    {
+        write(data, -1.0f);
+    }
+
+    int32_t stuckKey(const SensorData &data)
+    {
+        (void)data;
+        return (int32_t)(value * 100.0f);
+    }
+
+    bool isFreshConversion() const { return fresh; }
+
+    bool recoverSensor()
+    {
+        log("recover");
+        recoveries++;
+        return present;
+    }
+
+    void onTimeout()
+    {
+        log("timeout");
+        timeouts++;
+    }
+
+private:
+    void log(const char *call)
+    {
+        std::string &entries = mockSensorLog();
+        entries += (entries.empty() ? "" : " ") + std::string(1, Name) + "." + call;
+    }
+
+    static void write(SensorData &data, float fieldValue)
+    {
+        switch (Kind)
+        {
+        case SENSOR_TEMP_HUMIDITY:
+            data.temperature = fieldValue;
+            data.humidity = fieldValue;
+            break;
+        case SENSOR_PRESSURE:
+            data.pressure = fieldValue;
+            break;
+        case SENSOR_CO2:
+            data.co2 = (int)fieldValue;
+            break;
+        }
+    }
+
+    unsigned long start_us = 0; // Inicio de la medida en curso
+};
+
+#endif // MOCK_SENSOR_DRIVER_H
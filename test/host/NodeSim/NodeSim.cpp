@@ -0,0 +1,917 @@
+/**
+ * @file NodeSim.cpp
+ * @brief Implementación del simulador del nodo: escenarios, invariantes y métricas.
+ */
+
+#include "NodeSim.h"
+
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+#include "BLEManager.h"
+#include "CalibrationManager.h"
+#include "ConfigStore.h"
+#include "HostBoard.h"
+#include "HostGattServer.h"
+#include "SensorManager.h"
+#include "TimeBase.h"
+
+// --- Firmware bajo prueba (ESP_Server.cpp) ---
+void setup();
+void loop();
+extern SensorManager sensorManager;
+extern CalibrationManager calibrationManager;
+extern ConfigStore configStore;
+extern ClockSync clockSync;
+
+/** @brief Nombres de las características en los escenarios, en el orden de `CharacteristicId`. */
+static const char *const CHARACTERISTIC_NAMES[CHARACTERISTIC_COUNT] = {
+    "temperature", "pressure", "humidity", "co2", "calibrate", "state", "cooler", "diagnostics",
+    "history", "inventory", "config", "cal-history", "derived", "alarms", "time-sync"};
+
+/** @brief Nombres de los sensores, en el orden de `SensorKind`. */
+static const char *const SENSOR_NAMES[] = {"dht", "bmp", "co2"};
+
+/** @brief Hora de pared del cliente virtual al arrancar la simulación (ms desde 1970). */
+static const int64_t CLIENT_EPOCH_MS = 1700000000000LL;
+
+/** @brief Límite por defecto de la iteración más larga de `loop()`. */
+static const double DEFAULT_LOOP_LIMIT_MS = 100.0;
+
+/**
+ * @brief Convierte una duración ("500ms", "1.5s", "3min", con signo opcional) a µs.
+ * @return bool `false` si el texto no es una duración.
+ */
+static bool parseDuration(const std::string &text, int64_t &us)
+{
+    char *end = nullptr;
+    double value = strtod(text.c_str(), &end);
+    if (end == text.c_str())
+    {
+        return false;
+    }
+    std::string unit(end);
+    double scale = unit == "ms" ? 1e3 : unit == "s" ? 1e6 : unit == "min" ? 60e6 : -1;
+    if (scale < 0)
+    {
+        return false;
+    }
+    us = (int64_t)llround(value * scale);
+    return true;
+}
+
+/**
+ * @brief Índice de un nombre en una tabla, o -1.
+ */
+static int indexOf(const char *const *names, int count, const std::string &name)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (name == names[i])
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Separa una línea en palabras.
+ */
+static std::vector<std::string> split(const std::string &line)
+{
+    std::vector<std::string> words;
+    std::istringstream stream(line);
+    std::string word;
+    while (stream >> word)
+    {
+        words.push_back(word);
+    }
+    return words;
+}
+
+/**
+ * @brief Texto de una línea a partir de la palabra `index` (incluida).
+ */
+static std::string restFrom(const std::string &line, size_t index)
+{
+    size_t pos = 0;
+    for (size_t i = 0; i < index; i++)
+    {
+        pos = line.find_first_not_of(" \t", pos);
+        pos = line.find_first_of(" \t", pos);
+        if (pos == std::string::npos)
+        {
+            return "";
+        }
+    }
+    pos = line.find_first_not_of(" \t", pos);
+    return pos == std::string::npos ? "" : line.substr(pos);
+}
+
+/**
+ * @brief Hora virtual en segundos con tres decimales, para los mensajes.
+ */
+static std::string timeText(uint64_t us)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "%.3f s", us / 1e6);
+    return text;
+}
+
+std::string SimReport::describe() const
+{
+    char text[256];
+    snprintf(text, sizeof(text),
+             "%s: %u iteraciones, %u muestras; loop máx %.2f ms (media %.3f); adquisición máx %.1f ms (media %.1f); "
+             "desviación del periodo máx %.2f ms; primera muestra %.1f ms",
+             name.c_str(), metrics.loops, metrics.samples, metrics.loopMaxMs, metrics.loopMeanMs, metrics.acquireMaxMs,
+             metrics.acquireMeanMs, metrics.jitterMaxMs, metrics.firstSampleMs);
+    std::string result = text;
+    for (const std::string &failure : failures)
+    {
+        result += "\n  - " + failure;
+    }
+    return result;
+}
+
+/**
+ * @brief Lee un escenario de un archivo.
+ * @param path Ruta del archivo.
+ * @param error Motivo si no se pudo leer o no es válido.
+ */
+bool NodeSim::load(const char *path, std::string &error)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        error = std::string("no se puede abrir ") + path;
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    return parse(text.str(), error);
+}
+
+/**
+ * @brief Analiza el texto de un escenario y valida todas sus acciones.
+ * @details Los errores se detectan aquí, antes de ejecutar nada: un escenario
+ * mal escrito no debe parecer un fallo del firmware.
+ */
+bool NodeSim::parse(const std::string &text, std::string &error)
+{
+    std::istringstream lines(text);
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(lines, line))
+    {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos)
+        {
+            line.erase(comment);
+        }
+        std::vector<std::string> words = split(line);
+        if (words.empty())
+        {
+            continue;
+        }
+        std::string where = "línea " + std::to_string(lineNumber) + ": ";
+        const std::string &directive = words[0];
+        int64_t us;
+        if (directive == "name")
+        {
+            name = restFrom(line, 1);
+        }
+        else if (directive == "duration")
+        {
+            if (words.size() != 2 || !parseDuration(words[1], us) || us <= 0)
+            {
+                error = where + "duración no válida";
+                return false;
+            }
+            duration_us = (uint64_t)us;
+        }
+        else if (directive == "config")
+        {
+            config = restFrom(line, 1);
+        }
+        else if (directive == "env")
+        {
+            for (size_t i = 1; i < words.size(); i++)
+            {
+                if (!isEnvironmentAssignment(words[i]))
+                {
+                    error = where + "asignación de entorno no válida: " + words[i];
+                    return false;
+                }
+            }
+            env_assignments.insert(env_assignments.end(), words.begin() + 1, words.end());
+        }
+        else if (directive == "limit")
+        {
+            static const char *const METRICS[] = {"loop_ms", "acquire_ms", "jitter_ms", "first_sample_ms"};
+            char *end = nullptr;
+            double value = words.size() == 3 ? strtod(words[2].c_str(), &end) : 0;
+            if (words.size() != 3 || indexOf(METRICS, 4, words[1]) < 0 || *end != '\0')
+            {
+                error = where + "límite no válido";
+                return false;
+            }
+            limits.push_back({words[1], value});
+        }
+        else if (directive == "at")
+        {
+            if (words.size() < 3 || !parseDuration(words[1], us) || us < 0)
+            {
+                error = where + "acción sin instante válido";
+                return false;
+            }
+            Action action;
+            action.atUs = (uint64_t)us;
+            action.line = lineNumber;
+            action.words.assign(words.begin() + 2, words.end());
+            const std::string &verb = action.words[0];
+            size_t argc = action.words.size() - 1;
+            bool valid;
+            if (verb == "env")
+            {
+                valid = argc >= 1;
+                for (size_t i = 1; i <= argc; i++)
+                {
+                    valid = valid && isEnvironmentAssignment(action.words[i]);
+                }
+            }
+            else if (verb == "ramp")
+            {
+                valid = argc == 3 && isEnvironmentAssignment(action.words[1] + "=" + action.words[2]) &&
+                        parseDuration(action.words[3], us) && us > 0;
+            }
+            else if (verb == "fault")
+            {
+                static const char *const MODES[] = {"ok", "absent", "corrupt", "frozen", "holds-sda"};
+                valid = argc == 2 && indexOf(SENSOR_NAMES, SENSOR_COUNT, action.words[1]) >= 0 &&
+                        indexOf(MODES, 5, action.words[2]) >= 0;
+            }
+            else if (verb == "connect" || verb == "disconnect")
+            {
+                valid = argc <= 1;
+            }
+            else if (verb == "sync")
+            {
+                valid = argc == 0 || (argc == 1 && parseDuration(action.words[1], us));
+            }
+            else if (verb == "write")
+            {
+                valid = argc >= 2 && indexOf(CHARACTERISTIC_NAMES, CHARACTERISTIC_COUNT, action.words[1]) >= 0;
+                action.rest = restFrom(line, 4);
+            }
+            else if (verb == "read")
+            {
+                valid = argc >= 3 && indexOf(CHARACTERISTIC_NAMES, CHARACTERISTIC_COUNT, action.words[1]) >= 0 &&
+                        action.words[2] == "contains";
+                action.rest = restFrom(line, 5);
+            }
+            else if (verb == "expect" && argc >= 1)
+            {
+                const std::string &what = action.words[1];
+                if (what == "faults" || what == "zero-calibrations")
+                {
+                    valid = argc == 2;
+                }
+                else if (what == "sample")
+                {
+                    valid = argc == 4;
+                }
+                else if (what == "console")
+                {
+                    valid = argc >= 2;
+                    action.rest = restFrom(line, 4);
+                }
+                else if (what == "notification")
+                {
+                    valid = argc >= 4 && indexOf(CHARACTERISTIC_NAMES, CHARACTERISTIC_COUNT, action.words[2]) >= 0 &&
+                            action.words[3] == "contains";
+                    action.rest = restFrom(line, 6);
+                }
+                else
+                {
+                    valid = false;
+                }
+            }
+            else
+            {
+                valid = false;
+            }
+            if (!valid)
+            {
+                error = where + "acción no válida: " + restFrom(line, 2);
+                return false;
+            }
+            actions.push_back(action);
+        }
+        else
+        {
+            error = where + "directiva desconocida: " + directive;
+            return false;
+        }
+    }
+    if (duration_us == 0)
+    {
+        error = "falta la duración";
+        return false;
+    }
+    for (const Action &action : actions)
+    {
+        if (action.atUs > duration_us)
+        {
+            error = "línea " + std::to_string(action.line) + ": acción después del final del escenario";
+            return false;
+        }
+    }
+    std::stable_sort(actions.begin(), actions.end(), [](const Action &a, const Action &b) { return a.atUs < b.atUs; });
+    return true;
+}
+
+/**
+ * @brief Ejecuta el escenario: arranca el firmware y lo hace girar hasta la duración pedida.
+ * @details Solo puede llamarse una vez por proceso (ver `runIsolated()`).
+ */
+SimReport NodeSim::run()
+{
+    HostBoard &board = hostBoard();
+    board.echoConsole = echoConsole;
+    report = SimReport();
+    report.name = name;
+    for (const auto &limit : limits)
+    {
+        if (limit.first == "jitter_ms")
+        {
+            jitter_limit_ms = limit.second;
+        }
+    }
+
+    for (const std::string &assignment : env_assignments)
+    {
+        size_t equals = assignment.find('=');
+        setEnvironment(assignment.substr(0, equals), atof(assignment.substr(equals + 1).c_str()));
+    }
+    if (!config.empty())
+    {
+        // La configuración guardada se escribe con el propio ConfigStore, como
+        // lo haría un arranque anterior.
+        ConfigStore store;
+        store.begin();
+        if (!store.apply(config.c_str()) || !store.commit())
+        {
+            fail(0, "configuración rechazada: " + config);
+        }
+    }
+
+    HostGattServer &gatt = static_cast<HostGattServer &>(gattServer());
+    std::vector<HostGattNotification> received;
+    double loopTotalMs = 0;
+    double acquireTotalMs = 0;
+    size_t next = 0;
+
+    setup();
+    while (board.nowUs() < duration_us)
+    {
+        while (next < actions.size() && actions[next].atUs <= board.nowUs())
+        {
+            const Action &action = actions[next++];
+            if (action.words[0] == "expect" && action.words[1] == "notification")
+            {
+                int id = indexOf(CHARACTERISTIC_NAMES, CHARACTERISTIC_COUNT, action.words[2]);
+                GattUuid uuid = BLEManager::characteristicUuid((CharacteristicId)id);
+                bool found = false;
+                for (const HostGattNotification &notification : received)
+                {
+                    found = found || (gattUuidEquals(notification.uuid, uuid) &&
+                                      notification.value.find(action.rest) != std::string::npos);
+                }
+                if (!found)
+                {
+                    fail(action.line, "ninguna notificación de " + action.words[2] + " contiene \"" + action.rest + "\"");
+                }
+                continue;
+            }
+            execute(action);
+        }
+        applyRamps();
+
+        uint64_t start = board.nowUs();
+        loop();
+        double loopMs = (board.nowUs() - start) / 1000.0;
+        report.metrics.loops++;
+        loopTotalMs += loopMs;
+        report.metrics.loopMaxMs = std::max(report.metrics.loopMaxMs, loopMs);
+
+        if (clockSync.isSynced() || calibrationManager.isCalibrating())
+        {
+            spacing_valid = false; // Muestreo en la rejilla de pared, o suspendido
+        }
+
+        uint64_t monotonic = monotonicMicros();
+        if (monotonic < last_monotonic_us)
+        {
+            fail(0, "la hora monótona retrocedió");
+        }
+        last_monotonic_us = monotonic;
+
+        HostGattNotification notification;
+        while (gatt.popNotification(notification))
+        {
+            received.push_back(notification);
+        }
+        for (; console_seen < board.console.size(); console_seen++)
+        {
+            const ConsoleLine &line = board.console[console_seen];
+            Sample sample;
+            if (sscanf(line.text.c_str(), "Enviando -> Temp: %lf C, Hum: %lf %%, Pres: %lf hPa, CO2: %d ppm (adquisición %lf ms)",
+                       &sample.temperature, &sample.humidity, &sample.pressure, &sample.co2, &sample.acquireMs) == 5)
+            {
+                // La muestra se tomó al empezar la adquisición, no al imprimirla.
+                sample.atUs = line.atUs - (uint64_t)llround(sample.acquireMs * 1000.0);
+                acquireTotalMs += sample.acquireMs;
+                report.metrics.acquireMaxMs = std::max(report.metrics.acquireMaxMs, sample.acquireMs);
+                checkSample(sample);
+                samples.push_back(sample);
+            }
+        }
+        checkFaults();
+    }
+
+    SimMetrics &metrics = report.metrics;
+    metrics.samples = (uint32_t)samples.size();
+    metrics.loopMeanMs = metrics.loops > 0 ? loopTotalMs / metrics.loops : 0;
+    metrics.acquireMeanMs = metrics.samples > 0 ? acquireTotalMs / metrics.samples : 0;
+    metrics.firstSampleMs = samples.empty() ? -1 : samples.front().atUs / 1000.0;
+    bool loopLimited = false;
+    for (const auto &limit : limits)
+    {
+        double value = limit.first == "loop_ms" ? metrics.loopMaxMs : limit.first == "acquire_ms" ? metrics.acquireMaxMs
+                     : limit.first == "jitter_ms" ? metrics.jitterMaxMs : metrics.firstSampleMs;
+        loopLimited = loopLimited || limit.first == "loop_ms";
+        if (value > limit.second || value < 0)
+        {
+            char text[96];
+            snprintf(text, sizeof(text), "%s = %.2f supera el límite %.2f", limit.first.c_str(), value, limit.second);
+            fail(0, text);
+        }
+    }
+    if (!loopLimited && metrics.loopMaxMs > DEFAULT_LOOP_LIMIT_MS)
+    {
+        fail(0, "una iteración de loop() supera el límite por defecto", ": " + std::to_string(metrics.loopMaxMs) + " ms");
+    }
+    return report;
+}
+
+/**
+ * @brief Ejecuta una acción del escenario.
+ */
+void NodeSim::execute(const Action &action)
+{
+    HostBoard &board = hostBoard();
+    HostGattServer &gatt = static_cast<HostGattServer &>(gattServer());
+    const std::vector<std::string> &w = action.words;
+    const std::string &verb = w[0];
+    int64_t us = 0;
+
+    if (verb == "env")
+    {
+        for (size_t i = 1; i < w.size(); i++)
+        {
+            size_t equals = w[i].find('=');
+            std::string key = w[i].substr(0, equals);
+            ramps.erase(std::remove_if(ramps.begin(), ramps.end(), [&](const Ramp &r) { return r.key == key; }), ramps.end());
+            setEnvironment(key, atof(w[i].substr(equals + 1).c_str()));
+        }
+    }
+    else if (verb == "ramp")
+    {
+        parseDuration(w[3], us);
+        ramps.erase(std::remove_if(ramps.begin(), ramps.end(), [&](const Ramp &r) { return r.key == w[1]; }), ramps.end());
+        ramps.push_back({w[1], environmentValue(w[1]), atof(w[2].c_str()), board.nowUs(), board.nowUs() + (uint64_t)us});
+    }
+    else if (verb == "fault")
+    {
+        setFault(indexOf(SENSOR_NAMES, SENSOR_COUNT, w[1]), w[2]);
+    }
+    else if (verb == "connect")
+    {
+        if (!gatt.clientConnect(w.size() > 1 ? (uint16_t)atoi(w[1].c_str()) : 247))
+        {
+            fail(action.line, "el nodo no acepta la conexión");
+        }
+    }
+    else if (verb == "disconnect")
+    {
+        gatt.clientDisconnect();
+    }
+    else if (verb == "sync")
+    {
+        if (w.size() > 1)
+        {
+            parseDuration(w[1], us);
+        }
+        int64_t wallMs = CLIENT_EPOCH_MS + (int64_t)(board.nowUs() / 1000) + us / 1000;
+        if (!gatt.clientWrite(BLEManager::characteristicUuid(CHARACTERISTIC_TIME_SYNC), std::to_string(wallMs)))
+        {
+            fail(action.line, "no se pudo escribir la hora");
+        }
+    }
+    else if (verb == "write")
+    {
+        GattUuid uuid = BLEManager::characteristicUuid((CharacteristicId)indexOf(CHARACTERISTIC_NAMES, CHARACTERISTIC_COUNT, w[1]));
+        if (!gatt.clientWrite(uuid, action.rest))
+        {
+            fail(action.line, "no se pudo escribir en " + w[1]);
+        }
+    }
+    else if (verb == "read")
+    {
+        GattUuid uuid = BLEManager::characteristicUuid((CharacteristicId)indexOf(CHARACTERISTIC_NAMES, CHARACTERISTIC_COUNT, w[1]));
+        std::string value;
+        if (!gatt.clientRead(uuid, value))
+        {
+            fail(action.line, "no se pudo leer " + w[1]);
+        }
+        else if (value.find(action.rest) == std::string::npos)
+        {
+            fail(action.line, w[1] + " vale \"" + value + "\", sin \"" + action.rest + "\"");
+        }
+    }
+    else if (w[1] == "faults")
+    {
+        uint8_t expected = 0;
+        if (w[2] != "none")
+        {
+            std::istringstream list(w[2]);
+            std::string sensor;
+            while (std::getline(list, sensor, ','))
+            {
+                int index = indexOf(SENSOR_NAMES, SENSOR_COUNT, sensor);
+                expected |= index >= 0 ? (1 << index) : 0x80;
+            }
+        }
+        uint8_t mask = sensorManager.getFaultMask();
+        if (mask != expected)
+        {
+            char text[64];
+            snprintf(text, sizeof(text), "máscara de fallos 0x%02X, se esperaba %s", mask, w[2].c_str());
+            fail(action.line, text);
+        }
+    }
+    else if (w[1] == "sample")
+    {
+        if (samples.empty())
+        {
+            fail(action.line, "aún no hay muestras");
+            return;
+        }
+        const Sample &last = samples.back();
+        double value = w[2] == "temp" ? last.temperature : w[2] == "hum" ? last.humidity
+                     : w[2] == "pres" ? last.pressure : w[2] == "co2" ? last.co2 : NAN;
+        double expected = atof(w[3].c_str());
+        if (isnan(value) || fabs(value - expected) > atof(w[4].c_str()))
+        {
+            fail(action.line, "muestra " + w[2] + " = " + std::to_string(value) + ", se esperaba " + w[3] + " ± " + w[4]);
+        }
+    }
+    else if (w[1] == "console")
+    {
+        if (!board.consoleContains(action.rest))
+        {
+            fail(action.line, "la consola no contiene \"" + action.rest + "\"");
+        }
+    }
+    else if (w[1] == "zero-calibrations")
+    {
+        if (board.co2.zeroCalibrations != (uint32_t)atoi(w[2].c_str()))
+        {
+            fail(action.line, std::to_string(board.co2.zeroCalibrations) + " calibraciones a cero, se esperaban " + w[2]);
+        }
+    }
+}
+
+/**
+ * @brief Comprueba las invariantes de una muestra nueva.
+ */
+void NodeSim::checkSample(const Sample &sample)
+{
+    const double values[SENSOR_COUNT][2] = {{sample.temperature, sample.humidity}, {sample.pressure, sample.pressure}, {(double)sample.co2, (double)sample.co2}};
+    const double ranges[SENSOR_COUNT][2][2] = {{{-40, 80}, {0, 100}}, {{300, 1100}, {300, 1100}}, {{0, 10000}, {0, 10000}}};
+    for (int sensor = 0; sensor < SENSOR_COUNT; sensor++)
+    {
+        for (int field = 0; field < 2; field++)
+        {
+            double value = values[sensor][field];
+            if (value == -1)
+            {
+                if (!recentlyFaulted(sensor))
+                {
+                    fail(0, std::string("lectura inválida del sensor ") + SENSOR_NAMES[sensor] + " sin avería");
+                }
+            }
+            else if (value < ranges[sensor][field][0] || value > ranges[sensor][field][1])
+            {
+                fail(0, std::string("lectura fuera de rango del sensor ") + SENSOR_NAMES[sensor], ": " + std::to_string(value));
+            }
+        }
+    }
+
+    // Sin hora de pared, cada muestra llega un periodo después de la anterior.
+    uint32_t period = configStore.get().updateIntervalMs;
+    if (spacing_valid && period == spacing_period_ms)
+    {
+        double deviationMs = (double)(sample.atUs - samples.back().atUs) / 1000.0 - period;
+        report.metrics.jitterMaxMs = std::max(report.metrics.jitterMaxMs, fabs(deviationMs));
+        if (deviationMs < -0.5)
+        {
+            fail(0, "muestra adelantada al periodo", ": " + std::to_string(-deviationMs) + " ms");
+        }
+        else if (deviationMs > jitter_limit_ms)
+        {
+            fail(0, "muestra retrasada respecto al periodo", ": " + std::to_string(deviationMs) + " ms");
+        }
+    }
+    spacing_valid = true;
+    spacing_period_ms = period;
+}
+
+/**
+ * @brief Comprueba que la máscara de fallos del firmware corresponde a las averías inyectadas.
+ */
+void NodeSim::checkFaults()
+{
+    uint64_t now = hostBoard().nowUs();
+    uint8_t mask = sensorManager.getFaultMask();
+    uint64_t detectUs = (uint64_t)FAULT_DETECT_PERIODS * configStore.get().updateIntervalMs * 1000 +
+                        configStore.get().co2TimeoutMs * 1000;
+    for (int sensor = 0; sensor < SENSOR_COUNT; sensor++)
+    {
+        bool faulty = mask & (1 << sensor);
+        if (faulty && !recentlyFaulted(sensor))
+        {
+            fail(0, std::string("sensor ") + SENSOR_NAMES[sensor] + " en fallo sin avería");
+        }
+        if (!fault_active[sensor])
+        {
+            continue;
+        }
+        if (faulty && reported_fault_us[sensor] == 0)
+        {
+            reported_fault_us[sensor] = now;
+        }
+        // Las muestras se suspenden durante la calibración: no hay con qué detectar.
+        if (calibrationManager.isCalibrating())
+        {
+            fault_start_us[sensor] = now;
+        }
+        else if (fault_mode[sensor] != "frozen" && reported_fault_us[sensor] == 0 && now - fault_start_us[sensor] > detectUs)
+        {
+            reported_fault_us[sensor] = now; // Se informa una sola vez
+            fail(0, std::string("avería del sensor ") + SENSOR_NAMES[sensor] + " sin detectar tras " + timeText(detectUs));
+        }
+    }
+}
+
+/**
+ * @brief Avanza las rampas del entorno hasta la hora actual.
+ */
+void NodeSim::applyRamps()
+{
+    uint64_t now = hostBoard().nowUs();
+    for (auto ramp = ramps.begin(); ramp != ramps.end();)
+    {
+        double fraction = now >= ramp->endUs ? 1.0 : (double)(now - ramp->startUs) / (ramp->endUs - ramp->startUs);
+        setEnvironment(ramp->key, ramp->from + (ramp->to - ramp->from) * fraction);
+        ramp = fraction >= 1.0 ? ramps.erase(ramp) : ramp + 1;
+    }
+}
+
+/**
+ * @brief Inyecta (o retira, con "ok") una avería en un sensor de la placa.
+ */
+void NodeSim::setFault(int sensor, const std::string &mode)
+{
+    HostBoard &board = hostBoard();
+    uint64_t now = board.nowUs();
+    bool ok = mode == "ok";
+    switch (sensor)
+    {
+    case SENSOR_TEMP_HUMIDITY:
+        board.dht.connected = ok;
+        break;
+    case SENSOR_PRESSURE:
+        board.bmp.present = ok || mode == "holds-sda";
+        board.bmp.holdsSda = mode == "holds-sda";
+        break;
+    case SENSOR_CO2:
+        board.co2.connected = ok || mode != "absent";
+        board.co2.corrupt = mode == "corrupt";
+        board.co2.frozen = mode == "frozen";
+        board.co2.frozenValue = board.environment.co2 + board.co2.offsetPpm;
+        break;
+    }
+    if (ok && fault_active[sensor])
+    {
+        fault_end_us[sensor] = now;
+    }
+    else if (!ok && !fault_active[sensor])
+    {
+        fault_start_us[sensor] = now;
+        reported_fault_us[sensor] = 0;
+    }
+    fault_active[sensor] = !ok;
+    fault_ever[sensor] = fault_ever[sensor] || !ok;
+    fault_mode[sensor] = mode;
+}
+
+/**
+ * @brief Cambia una magnitud del entorno físico.
+ * @return bool `false` si la magnitud no existe.
+ */
+bool NodeSim::setEnvironment(const std::string &key, double value)
+{
+    Environment &environment = hostBoard().environment;
+    if (key == "temp")
+    {
+        environment.temperature = (float)value;
+    }
+    else if (key == "hum")
+    {
+        environment.humidity = (float)value;
+    }
+    else if (key == "pres")
+    {
+        environment.pressure = (float)value;
+    }
+    else if (key == "co2")
+    {
+        environment.co2 = (int)lround(value);
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Indica si un texto es una asignación "magnitud=valor" válida del entorno.
+ */
+bool NodeSim::isEnvironmentAssignment(const std::string &text)
+{
+    size_t equals = text.find('=');
+    if (equals == std::string::npos || equals + 1 == text.size())
+    {
+        return false;
+    }
+    static const char *const KEYS[] = {"temp", "hum", "pres", "co2"};
+    char *end = nullptr;
+    strtod(text.c_str() + equals + 1, &end);
+    return indexOf(KEYS, 4, text.substr(0, equals)) >= 0 && *end == '\0';
+}
+
+/**
+ * @brief Valor actual de una magnitud del entorno (0 si no existe).
+ */
+double NodeSim::environmentValue(const std::string &key)
+{
+    const Environment &environment = hostBoard().environment;
+    return key == "temp" ? environment.temperature : key == "hum" ? environment.humidity
+         : key == "pres" ? environment.pressure : key == "co2" ? environment.co2 : 0;
+}
+
+/**
+ * @brief Indica si el sensor tiene una avería o la tuvo hace menos de `FAULT_CLEAR_WINDOW_US`.
+ * @details Tras retirar una avería, el firmware puede tardar hasta la espera
+ * máxima entre reintentos en recuperar el sensor.
+ */
+bool NodeSim::recentlyFaulted(int sensor) const
+{
+    return fault_active[sensor] || (fault_ever[sensor] && hostBoard().nowUs() - fault_end_us[sensor] <= FAULT_CLEAR_WINDOW_US);
+}
+
+/**
+ * @brief Anota un fallo con la hora virtual.
+ * @details Una invariante que se incumple en cada muestra se anota solo la
+ * primera vez: `message` identifica el fallo y `detail` lleva los valores.
+ * @param line Línea del escenario, o 0 para las invariantes y los límites.
+ */
+void NodeSim::fail(int line, const std::string &message, const std::string &detail)
+{
+    std::string where = line > 0 ? "línea " + std::to_string(line) + ": " : "";
+    if (failed.insert(where + message).second)
+    {
+        report.failures.push_back("[" + timeText(hostBoard().nowUs()) + "] " + where + message + detail);
+    }
+}
+
+/**
+ * @brief Carga y ejecuta un escenario en un proceso hijo.
+ * @details El hijo devuelve el informe por una tubería, una línea por dato.
+ * Si el escenario no se puede cargar, o el hijo muere (una aserción o un
+ * acceso inválido del firmware), el informe lo recoge como fallo. Con la
+ * variable de entorno `NODE_SIM_ECHO` el hijo copia la consola del firmware.
+ * @param path Ruta del escenario.
+ */
+SimReport NodeSim::runIsolated(const char *path)
+{
+    SimReport report;
+    report.name = path;
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        report.failures.push_back("no se pudo crear la tubería");
+        return report;
+    }
+    fflush(stdout);
+    pid_t child = fork();
+    if (child == 0)
+    {
+        close(fds[0]);
+        NodeSim sim;
+        sim.echoConsole = getenv("NODE_SIM_ECHO") != nullptr;
+        std::string error;
+        SimReport result;
+        result.name = path;
+        if (sim.load(path, error))
+        {
+            result = sim.run();
+        }
+        else
+        {
+            result.failures.push_back("escenario no válido: " + error);
+        }
+        const SimMetrics &m = result.metrics;
+        std::ostringstream out;
+        out << "N " << result.name << "\n";
+        char metrics[256];
+        snprintf(metrics, sizeof(metrics), "M %u %u %.6f %.6f %.6f %.6f %.6f %.6f\n", m.loops, m.samples, m.loopMaxMs,
+                 m.loopMeanMs, m.acquireMaxMs, m.acquireMeanMs, m.jitterMaxMs, m.firstSampleMs);
+        out << metrics;
+        for (const std::string &failure : result.failures)
+        {
+            out << "F " << failure << "\n";
+        }
+        std::string text = out.str();
+        for (size_t written = 0; written < text.size();)
+        {
+            ssize_t n = write(fds[1], text.data() + written, text.size() - written);
+            if (n <= 0)
+            {
+                break;
+            }
+            written += (size_t)n;
+        }
+        close(fds[1]);
+        fflush(stdout);
+        _exit(0);
+    }
+    close(fds[1]);
+    std::string text;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fds[0], buffer, sizeof(buffer))) > 0)
+    {
+        text.append(buffer, (size_t)n);
+    }
+    close(fds[0]);
+    int status = 0;
+    waitpid(child, &status, 0);
+
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        if (line.rfind("N ", 0) == 0)
+        {
+            report.name = line.substr(2);
+        }
+        else if (line.rfind("M ", 0) == 0)
+        {
+            SimMetrics &m = report.metrics;
+            sscanf(line.c_str(), "M %u %u %lf %lf %lf %lf %lf %lf", &m.loops, &m.samples, &m.loopMaxMs, &m.loopMeanMs,
+                   &m.acquireMaxMs, &m.acquireMeanMs, &m.jitterMaxMs, &m.firstSampleMs);
+        }
+        else if (line.rfind("F ", 0) == 0)
+        {
+            report.failures.push_back(line.substr(2));
+        }
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        report.failures.push_back("el firmware terminó de forma anormal (estado " + std::to_string(status) + ")");
+    }
+    return report;
+}
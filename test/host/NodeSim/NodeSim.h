@@ -0,0 +1,176 @@
+#ifndef NODE_SIM_H
+#define NODE_SIM_H
+
+#include <stdint.h>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * @file NodeSim.h
+ * @brief Simulador del nodo: ejecuta `setup()`/`loop()` del firmware frente a
+ * un escenario sobre la placa virtual del host.
+ * @details Un escenario es un archivo de texto con una directiva por línea
+ * (`#` empieza un comentario):
+ *
+ *     name Caída del MH-Z19C
+ *     duration 3min                 # tiempo virtual simulado
+ *     config UPDATE_MS=1000         # configuración guardada antes del arranque
+ *     env temp=22.5 hum=45 pres=1013.2 co2=650
+ *     limit loop_ms 60              # límite de una métrica al terminar
+ *     at 10s fault co2 absent       # acción en un instante
+ *     at 40s expect faults co2
+ *
+ * Acciones (`at <t> <acción>`; los tiempos admiten `ms`, `s` y `min`):
+ * - `env k=v...` y `ramp <k> <valor> <duración>`: entorno físico
+ *   (`temp`, `hum`, `pres`, `co2`).
+ * - `fault <dht|bmp|co2> <ok|absent|corrupt|frozen|holds-sda>`: avería de un sensor.
+ * - `connect [mtu]`, `disconnect`, `write <car> <texto>`,
+ *   `read <car> contains <texto>`, `sync [desfase]`: cliente BLE virtual.
+ *   `<car>` es el nombre de la característica (ver `CHARACTERISTIC_NAMES`).
+ * - `expect faults <none|dht,bmp,co2>`, `expect sample <campo> <valor> <tol>`,
+ *   `expect console <texto>`, `expect notification <car> contains <texto>`,
+ *   `expect zero-calibrations <n>`: comprobaciones.
+ *
+ * Durante toda la ejecución se comprueban además estas invariantes:
+ * - la hora monótona nunca retrocede;
+ * - cada campo de una muestra es -1 o está en su rango físico, y solo es -1
+ *   si ese sensor tiene (o acaba de tener) una avería inyectada;
+ * - sin hora sincronizada, las muestras no se adelantan al periodo ni se
+ *   retrasan más de `limit jitter_ms`;
+ * - un sensor solo se marca en fallo si tiene (o acaba de tener) una avería, y
+ *   una avería que dura se detecta en `FAULT_DETECT_PERIODS` periodos.
+ *
+ * Métricas (todas en tiempo virtual): `loop_ms` (iteración más larga de
+ * `loop()`), `acquire_ms` (ciclo de adquisición más largo), `jitter_ms`
+ * (máxima desviación del periodo de muestreo), `first_sample_ms` y `samples`.
+ */
+
+/**
+ * @struct SimMetrics
+ * @brief Métricas de una ejecución.
+ */
+struct SimMetrics
+{
+    uint32_t loops = 0;
+    uint32_t samples = 0;
+    double loopMaxMs = 0;
+    double loopMeanMs = 0;
+    double acquireMaxMs = 0;
+    double acquireMeanMs = 0;
+    double jitterMaxMs = 0;
+    double firstSampleMs = -1; // -1 si no hubo ninguna muestra
+};
+
+/**
+ * @struct SimReport
+ * @brief Resultado de un escenario: fallos (invariantes, expectativas y límites) y métricas.
+ */
+struct SimReport
+{
+    std::string name;
+    std::vector<std::string> failures;
+    SimMetrics metrics;
+
+    bool passed() const { return failures.empty(); }
+    std::string describe() const; // Resumen en texto, una línea por fallo
+};
+
+/**
+ * @class NodeSim
+ * @brief Carga un escenario y ejecuta el firmware contra él.
+ * @details El firmware usa objetos globales que solo se construyen una vez
+ * por proceso, así que cada escenario debe ejecutarse en un proceso nuevo:
+ * `runIsolated()` lo hace en un proceso hijo.
+ */
+class NodeSim
+{
+public:
+    bool load(const char *path, std::string &error);          // Lee y valida un escenario
+    bool parse(const std::string &text, std::string &error);  // Escenario desde un texto
+    SimReport run();                                          // Ejecuta en este proceso (una vez)
+
+    static SimReport runIsolated(const char *path);          // Carga y ejecuta en un proceso hijo
+
+    bool echoConsole = false; // Copia la consola del firmware a la salida estándar
+
+private:
+    /**
+     * @struct Action
+     * @brief Acción programada del escenario.
+     */
+    struct Action
+    {
+        uint64_t atUs;
+        int line;                       // Línea del archivo, para los mensajes
+        std::vector<std::string> words; // Acción troceada en palabras
+        std::string rest;               // Texto libre tras la característica (write/contains)
+    };
+
+    /**
+     * @struct Ramp
+     * @brief Cambio lineal de una magnitud del entorno.
+     */
+    struct Ramp
+    {
+        std::string key;
+        double from;
+        double to;
+        uint64_t startUs;
+        uint64_t endUs;
+    };
+
+    /**
+     * @struct Sample
+     * @brief Muestra leída de la consola del firmware.
+     */
+    struct Sample
+    {
+        uint64_t atUs;
+        double temperature;
+        double humidity;
+        double pressure;
+        int co2;
+        double acquireMs;
+    };
+
+    static const int SENSOR_COUNT = 3;                  // Índices de `SensorKind`
+    static const uint64_t FAULT_CLEAR_WINDOW_US = 70000000ULL; // Espera máxima de reintento (60 s) y margen
+    static const int FAULT_DETECT_PERIODS = 4;          // Fallos seguidos para el fallo (3) y margen
+
+    void execute(const Action &action);
+    void checkSample(const Sample &sample);
+    void checkFaults();
+    void applyRamps();
+    void setFault(int sensor, const std::string &mode);
+    bool setEnvironment(const std::string &key, double value);
+    static bool isEnvironmentAssignment(const std::string &text);
+    double environmentValue(const std::string &key);
+    bool recentlyFaulted(int sensor) const;
+    void fail(int line, const std::string &message, const std::string &detail = "");
+
+    std::string name;
+    uint64_t duration_us = 0;
+    std::string config;
+    std::vector<std::string> env_assignments;
+    std::vector<Action> actions;
+    std::vector<std::pair<std::string, double>> limits;
+
+    SimReport report;
+    std::set<std::string> failed;   // Fallos ya anotados
+    std::vector<Ramp> ramps;
+    std::vector<Sample> samples;
+    size_t console_seen = 0;        // Líneas de consola ya analizadas
+    uint64_t last_monotonic_us = 0;
+    bool fault_active[SENSOR_COUNT] = {};
+    uint64_t fault_start_us[SENSOR_COUNT] = {};
+    uint64_t fault_end_us[SENSOR_COUNT] = {};
+    bool fault_ever[SENSOR_COUNT] = {};
+    std::string fault_mode[SENSOR_COUNT];
+    uint64_t reported_fault_us[SENSOR_COUNT] = {};  // Primera detección de la avería en curso (0 = aún no)
+    bool spacing_valid = false;     // La muestra anterior sirve de referencia del periodo
+    uint32_t spacing_period_ms = 0;
+    double jitter_limit_ms = 5.0;
+};
+
+#endif // NODE_SIM_H
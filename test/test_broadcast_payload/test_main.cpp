@@ -0,0 +1,183 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del payload de publicidad y del paquete de publicidad completo.
+ */
+
+#include <unity.h>
+#include <string.h>
+#include "BroadcastPayload.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+/** @brief Lectura válida de referencia. */
+static BroadcastReading sampleReading()
+{
+    BroadcastReading reading = {};
+    reading.counter = 200;
+    reading.temperature = -12.34f;
+    reading.humidity = 45.67f;
+    reading.pressure = 1013.2f;
+    reading.co2 = 812;
+    reading.state = 2;
+    reading.fanOn = true;
+    reading.tempValid = true;
+    reading.humValid = true;
+    reading.presValid = true;
+    reading.co2Valid = true;
+    return reading;
+}
+
+void test_round_trip_keeps_values()
+{
+    uint8_t payload[BROADCAST_PAYLOAD_LEN];
+    TEST_ASSERT_EQUAL_UINT(BROADCAST_PAYLOAD_LEN, encodeBroadcastPayload(sampleReading(), payload));
+
+    BroadcastReading decoded;
+    TEST_ASSERT_TRUE(decodeBroadcastPayload(payload, sizeof(payload), decoded));
+    TEST_ASSERT_EQUAL_UINT8(200, decoded.counter);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, -12.34f, decoded.temperature);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, 45.67f, decoded.humidity);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 1013.2f, decoded.pressure);
+    TEST_ASSERT_EQUAL_INT(812, decoded.co2);
+    TEST_ASSERT_EQUAL_UINT8(2, decoded.state);
+    TEST_ASSERT_TRUE(decoded.fanOn);
+    TEST_ASSERT_TRUE(decoded.tempValid && decoded.humValid && decoded.presValid && decoded.co2Valid);
+}
+
+void test_wire_format_is_little_endian()
+{
+    uint8_t payload[BROADCAST_PAYLOAD_LEN];
+    encodeBroadcastPayload(sampleReading(), payload);
+    const uint8_t expected[BROADCAST_PAYLOAD_LEN] = {
+        0xFF, 0xFF, BROADCAST_VERSION, 200,
+        0x2E, 0xFB, // -1234
+        0xD7, 0x11, // 4567
+        0x94, 0x27, // 10132
+        0x2C, 0x03, // 812
+        0x06};
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, payload, BROADCAST_PAYLOAD_LEN);
+}
+
+void test_invalid_fields_use_sentinels()
+{
+    BroadcastReading reading = sampleReading();
+    reading.tempValid = false;
+    reading.humValid = false;
+    reading.pressure = -5.0f;  // Negativo: no cabe en sin signo
+    reading.co2 = 70000;       // No cabe en 16 bits
+    uint8_t payload[BROADCAST_PAYLOAD_LEN];
+    encodeBroadcastPayload(reading, payload);
+
+    BroadcastReading decoded;
+    TEST_ASSERT_TRUE(decodeBroadcastPayload(payload, sizeof(payload), decoded));
+    TEST_ASSERT_FALSE(decoded.tempValid);
+    TEST_ASSERT_FALSE(decoded.humValid);
+    TEST_ASSERT_FALSE(decoded.presValid);
+    TEST_ASSERT_FALSE(decoded.co2Valid);
+}
+
+void test_decode_rejects_foreign_payloads()
+{
+    uint8_t payload[BROADCAST_PAYLOAD_LEN];
+    encodeBroadcastPayload(sampleReading(), payload);
+    BroadcastReading decoded;
+
+    TEST_ASSERT_FALSE(decodeBroadcastPayload(payload, BROADCAST_PAYLOAD_LEN - 1, decoded));
+    payload[2] = BROADCAST_VERSION + 1;
+    TEST_ASSERT_FALSE(decodeBroadcastPayload(payload, sizeof(payload), decoded));
+    payload[2] = BROADCAST_VERSION;
+    payload[0] = 0x4C; // Otro fabricante
+    TEST_ASSERT_FALSE(decodeBroadcastPayload(payload, sizeof(payload), decoded));
+}
+
+void test_advertising_fits_for_every_name_length()
+{
+    uint8_t payload[BROADCAST_PAYLOAD_LEN];
+    encodeBroadcastPayload(sampleReading(), payload);
+    char name[41];
+    for (size_t nameLen = 0; nameLen < sizeof(name); nameLen++)
+    {
+        memset(name, 'N', nameLen);
+        name[nameLen] = '\0';
+        for (int withPayload = 0; withPayload < 2; withPayload++)
+        {
+            uint8_t adv[ADV_DATA_MAX_LEN + 8];
+            memset(adv, 0xAA, sizeof(adv));
+            size_t len = buildAdvertisingData(name, withPayload ? payload : nullptr, withPayload ? sizeof(payload) : 0, adv);
+            TEST_ASSERT_LESS_OR_EQUAL(ADV_DATA_MAX_LEN, len);
+            TEST_ASSERT_EQUAL_HEX8(0xAA, adv[ADV_DATA_MAX_LEN]); // Nada escrito fuera del paquete
+
+            BroadcastReading decoded;
+            TEST_ASSERT_EQUAL(withPayload == 1, parseAdvertisingData(adv, len, decoded));
+        }
+    }
+}
+
+void test_long_name_is_shortened()
+{
+    uint8_t payload[BROADCAST_PAYLOAD_LEN];
+    encodeBroadcastPayload(sampleReading(), payload);
+    const char *name = "Laboratorio-Camara-2"; // 20 caracteres (CONFIG_NAME_MAX)
+    uint8_t adv[ADV_DATA_MAX_LEN];
+    size_t len = buildAdvertisingData(name, payload, sizeof(payload), adv);
+
+    TEST_ASSERT_EQUAL_UINT(ADV_DATA_MAX_LEN, len);
+    TEST_ASSERT_EQUAL_HEX8(ADV_TYPE_FLAGS, adv[1]);
+    TEST_ASSERT_EQUAL_UINT8(1 + 11, adv[3]); // 31 - 3 (flags) - 15 (fabricante) - 2
+    TEST_ASSERT_EQUAL_HEX8(ADV_TYPE_SHORT_NAME, adv[4]);
+    TEST_ASSERT_EQUAL_MEMORY(name, &adv[5], 11);
+    TEST_ASSERT_EQUAL_HEX8(ADV_TYPE_MANUFACTURER, adv[17]);
+}
+
+void test_short_name_is_complete()
+{
+    uint8_t payload[BROADCAST_PAYLOAD_LEN];
+    encodeBroadcastPayload(sampleReading(), payload);
+    uint8_t adv[ADV_DATA_MAX_LEN];
+    size_t len = buildAdvertisingData("ESP32", payload, sizeof(payload), adv);
+
+    TEST_ASSERT_EQUAL_UINT(3 + 7 + 15, len);
+    TEST_ASSERT_EQUAL_HEX8(ADV_TYPE_COMPLETE_NAME, adv[4]);
+    TEST_ASSERT_EQUAL_MEMORY("ESP32", &adv[5], 5);
+
+    // Sin payload, el nombre más largo admitido cabe entero
+    len = buildAdvertisingData("Laboratorio-Camara-2", nullptr, 0, adv);
+    TEST_ASSERT_EQUAL_UINT(3 + 22, len);
+    TEST_ASSERT_EQUAL_HEX8(ADV_TYPE_COMPLETE_NAME, adv[4]);
+}
+
+void test_parse_skips_other_structures()
+{
+    uint8_t payload[BROADCAST_PAYLOAD_LEN];
+    encodeBroadcastPayload(sampleReading(), payload);
+    // Flags, datos de otro fabricante y después los nuestros
+    uint8_t adv[ADV_DATA_MAX_LEN] = {2, ADV_TYPE_FLAGS, ADV_FLAGS, 4, ADV_TYPE_MANUFACTURER, 0x4C, 0x00, 0x01,
+                                     1 + BROADCAST_PAYLOAD_LEN, ADV_TYPE_MANUFACTURER};
+    memcpy(&adv[10], payload, sizeof(payload));
+    size_t len = 10 + sizeof(payload);
+
+    BroadcastReading decoded;
+    TEST_ASSERT_TRUE(parseAdvertisingData(adv, len, decoded));
+    TEST_ASSERT_EQUAL_INT(812, decoded.co2);
+
+    // Estructura truncada: el payload ya no está completo
+    TEST_ASSERT_FALSE(parseAdvertisingData(adv, len - 1, decoded));
+    // Longitud 0: fin de los datos significativos
+    adv[3] = 0;
+    TEST_ASSERT_FALSE(parseAdvertisingData(adv, len, decoded));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_keeps_values);
+    RUN_TEST(test_wire_format_is_little_endian);
+    RUN_TEST(test_invalid_fields_use_sentinels);
+    RUN_TEST(test_decode_rejects_foreign_payloads);
+    RUN_TEST(test_advertising_fits_for_every_name_length);
+    RUN_TEST(test_long_name_is_shortened);
+    RUN_TEST(test_short_name_is_complete);
+    RUN_TEST(test_parse_skips_other_structures);
+    return UNITY_END();
+}
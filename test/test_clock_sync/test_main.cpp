@@ -0,0 +1,240 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del contador extendido y del ajuste de hora frente a un oscilador simulado.
+ * @details El oscilador local se modela con una deriva fija en ppm respecto
+ * al reloj del cliente, y cada punto de sincronización llega con la latencia
+ * variable de una escritura BLE (de 0 a 30 ms, generador determinista).
+ */
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TimeBase.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+/** @brief Hora de pared de referencia: 2026-01-01T00:00:00Z en µs. */
+static const int64_t EPOCH_US = 1767225600LL * 1000000;
+
+/**
+ * @brief Oscilador local con deriva respecto a la hora real.
+ * @details Positivo = el reloj local atrasa, como `ClockSync::getDriftPpm()`.
+ */
+struct Oscillator
+{
+    double driftPpm;
+    uint64_t bootLocalUs; // Lectura local en el instante `EPOCH_US`
+
+    uint64_t localAt(int64_t wallUs) const
+    {
+        double elapsed = (double)(wallUs - EPOCH_US);
+        return bootLocalUs + (uint64_t)llround(elapsed / (1.0 + driftPpm * 1e-6));
+    }
+};
+
+static uint32_t lcgState = 1;
+
+/** @brief Latencia de la escritura BLE, de 0 a 30 ms. */
+static int64_t bleLatencyUs()
+{
+    lcgState = lcgState * 1664525u + 1013904223u;
+    return (int64_t)(lcgState >> 8) % 30000;
+}
+
+/**
+ * @brief Sincroniza cada `intervalUs` durante `points` puntos.
+ * @details El cliente escribe su hora en `wall`; el nodo captura su instante
+ * local al recibirla, una latencia BLE después.
+ * @return int64_t Hora de pared del último punto.
+ */
+static int64_t feedPoints(ClockSync &sync, const Oscillator &osc, int64_t startWall, int64_t intervalUs, int points)
+{
+    int64_t wall = startWall;
+    for (int i = 0; i < points; i++)
+    {
+        wall += intervalUs;
+        sync.addPoint(osc.localAt(wall + bleLatencyUs()), wall);
+    }
+    return wall;
+}
+
+// --- CounterExtender ---
+
+void test_extender_counts_wraps()
+{
+    CounterExtender extender;
+    TEST_ASSERT_EQUAL_UINT64(5, extender.extend(5));
+    TEST_ASSERT_EQUAL_UINT64(0xFFFFFFF0ULL, extender.extend(0xFFFFFFF0u));
+    TEST_ASSERT_EQUAL_UINT64(0x100000003ULL, extender.extend(3));
+    TEST_ASSERT_EQUAL_UINT64(0x100000003ULL, extender.extend(3)); // Misma lectura: no es una vuelta
+    TEST_ASSERT_EQUAL_UINT64(0x1FFFFFFFFULL, extender.extend(0xFFFFFFFFu));
+    TEST_ASSERT_EQUAL_UINT64(0x200000000ULL, extender.extend(0));
+}
+
+void test_extender_is_monotonic_across_many_wraps()
+{
+    // micros() de 32 bits consultado cada ~17 min durante ~3 años
+    CounterExtender extender;
+    uint64_t truth = 0;
+    const uint64_t step = 1000003ULL * 1024;
+    for (int i = 0; i < 100000; i++)
+    {
+        truth += step;
+        uint64_t extended = extender.extend((uint32_t)truth);
+        if (extended != truth)
+        {
+            TEST_ASSERT_EQUAL_UINT64(truth, extended);
+        }
+    }
+    TEST_ASSERT_GREATER_THAN(20000, truth >> 32); // Más de 20000 vueltas
+}
+
+void test_extender_misses_a_wrap_if_polled_too_rarely()
+{
+    // Documentado: hay que consultarlo al menos una vez por vuelta
+    CounterExtender extender;
+    extender.extend(100);
+    TEST_ASSERT_EQUAL_UINT64(200, extender.extend((uint32_t)((1ULL << 32) + 200)));
+}
+
+// --- ClockSync ---
+
+void test_unsynced_returns_minus_one()
+{
+    ClockSync sync;
+    TEST_ASSERT_FALSE(sync.isSynced());
+    TEST_ASSERT_EQUAL_INT64(-1, sync.toWallUs(123456));
+    char text[48];
+    sync.describe(text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("POINTS=0;DRIFT=NA;ERR=NA", text);
+}
+
+void test_single_point_gives_offset_only()
+{
+    ClockSync sync;
+    TEST_ASSERT_TRUE(sync.addPoint(5000000, EPOCH_US));
+    TEST_ASSERT_EQUAL_INT64(EPOCH_US + 1000000, sync.toWallUs(6000000));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, sync.getDriftPpm());
+}
+
+void test_drift_needs_minimum_span()
+{
+    Oscillator osc = {100.0, 1000000};
+    ClockSync sync;
+    // Puntos cada 5 s: 35 s en total, por debajo de MIN_DRIFT_SPAN_US
+    lcgState = 1;
+    feedPoints(sync, osc, EPOCH_US, 5000000, 8);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, sync.getDriftPpm());
+}
+
+void test_estimates_oscillator_drift()
+{
+    const double drifts[] = {-150.0, -20.0, 0.0, 35.0, 250.0};
+    for (double ppm : drifts)
+    {
+        Oscillator osc = {ppm, 7000000};
+        ClockSync sync;
+        lcgState = 12345;
+        int64_t wall = feedPoints(sync, osc, EPOCH_US, 600000000LL, 8); // Cada 10 min
+
+        char message[96];
+        snprintf(message, sizeof(message), "deriva real %+.1f ppm, estimada %+.2f ppm", ppm, sync.getDriftPpm());
+        TEST_MESSAGE(message);
+        // 30 ms de latencia sobre 70 min de puntos: error de la pendiente < ~10 ppm
+        TEST_ASSERT_FLOAT_WITHIN(10.0f, (float)ppm, sync.getDriftPpm());
+
+        // Diez minutos después del último punto el error sigue por debajo de la latencia
+        int64_t later = wall + 600000000LL;
+        int64_t error = sync.toWallUs(osc.localAt(later)) - later;
+        snprintf(message, sizeof(message), "error a los 10 min del último punto: %+lld µs", (long long)error);
+        TEST_MESSAGE(message);
+        TEST_ASSERT_LESS_THAN(40000, llabs(error));
+    }
+}
+
+void test_drift_improves_prediction_over_offset_only()
+{
+    // Con 200 ppm, una hora sin sincronizar son 720 ms de error si no se corrige la deriva
+    Oscillator osc = {200.0, 0};
+    ClockSync sync;
+    lcgState = 99;
+    int64_t wall = feedPoints(sync, osc, EPOCH_US, 600000000LL, 8);
+    int64_t later = wall + 3600000000LL;
+    int64_t corrected = llabs(sync.toWallUs(osc.localAt(later)) - later);
+
+    ClockSync offsetOnly;
+    offsetOnly.addPoint(osc.localAt(wall), wall);
+    int64_t uncorrected = llabs(offsetOnly.toWallUs(osc.localAt(later)) - later);
+
+    TEST_ASSERT_GREATER_THAN(600000, uncorrected);
+    TEST_ASSERT_LESS_THAN(uncorrected / 10, corrected);
+}
+
+void test_drift_is_clamped()
+{
+    Oscillator osc = {2000.0, 0}; // Fuera de especificación para un cristal
+    ClockSync sync;
+    lcgState = 7;
+    feedPoints(sync, osc, EPOCH_US, 600000000LL, 8);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, (float)(ClockSync::MAX_DRIFT * 1e6), sync.getDriftPpm());
+}
+
+void test_client_clock_step_restarts_fit()
+{
+    Oscillator osc = {50.0, 0};
+    ClockSync sync;
+    lcgState = 3;
+    int64_t wall = feedPoints(sync, osc, EPOCH_US, 600000000LL, 8);
+    TEST_ASSERT_EQUAL_UINT8(ClockSync::MAX_POINTS, sync.getPointCount());
+
+    // El cliente adelanta su hora una hora (cambio manual o de zona mal aplicado)
+    int64_t local = osc.localAt(wall + 60000000LL);
+    int64_t stepped = wall + 60000000LL + 3600000000LL;
+    TEST_ASSERT_FALSE(sync.addPoint(local, stepped));
+    TEST_ASSERT_EQUAL_UINT8(1, sync.getPointCount());
+    TEST_ASSERT_INT64_WITHIN(40000, 3600000000LL, sync.getLastErrorUs()); // Más la latencia media
+    TEST_ASSERT_EQUAL_INT64(stepped, sync.toWallUs(local));
+}
+
+void test_precision_after_long_uptime()
+{
+    // El nodo lleva ~5 años encendido: las coordenadas relativas no pierden precisión
+    Oscillator osc = {-40.0, 5ULL * 365 * 24 * 3600 * 1000000};
+    ClockSync sync;
+    lcgState = 11;
+    int64_t wall = feedPoints(sync, osc, EPOCH_US, 600000000LL, 8);
+    TEST_ASSERT_FLOAT_WITHIN(10.0f, -40.0f, sync.getDriftPpm());
+    TEST_ASSERT_LESS_THAN(40000, llabs(sync.toWallUs(osc.localAt(wall)) - wall));
+}
+
+void test_describe_format()
+{
+    ClockSync sync;
+    sync.addPoint(0, EPOCH_US);
+    sync.addPoint(120000000, EPOCH_US + 120000000 - 4000); // 4 ms antes de lo previsto
+    char text[48];
+    size_t len = sync.describe(text, sizeof(text));
+    TEST_ASSERT_EQUAL_UINT(strlen(text), len);
+    TEST_ASSERT_EQUAL_STRING("POINTS=2;DRIFT=-33.3ppm;ERR=-4ms", text);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_extender_counts_wraps);
+    RUN_TEST(test_extender_is_monotonic_across_many_wraps);
+    RUN_TEST(test_extender_misses_a_wrap_if_polled_too_rarely);
+    RUN_TEST(test_unsynced_returns_minus_one);
+    RUN_TEST(test_single_point_gives_offset_only);
+    RUN_TEST(test_drift_needs_minimum_span);
+    RUN_TEST(test_estimates_oscillator_drift);
+    RUN_TEST(test_drift_improves_prediction_over_offset_only);
+    RUN_TEST(test_drift_is_clamped);
+    RUN_TEST(test_client_clock_step_restarts_fit);
+    RUN_TEST(test_precision_after_long_uptime);
+    RUN_TEST(test_describe_format);
+    return UNITY_END();
+}
@@ -0,0 +1,77 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del buzón de comandos entre la tarea BLE y el bucle.
+ */
+
+#include <unity.h>
+#include <string.h>
+#include "CommandMailbox.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static bool post(CommandMailbox<8> &mailbox, const char *text)
+{
+    return mailbox.post((const uint8_t *)text, strlen(text));
+}
+
+void test_empty_mailbox_has_nothing()
+{
+    CommandMailbox<8> mailbox;
+    CommandMailbox<8>::Buffer out;
+    TEST_ASSERT_FALSE(mailbox.take(out));
+}
+
+void test_take_returns_command_once()
+{
+    CommandMailbox<8> mailbox;
+    CommandMailbox<8>::Buffer out;
+    TEST_ASSERT_TRUE(post(mailbox, "AUTO"));
+    TEST_ASSERT_TRUE(mailbox.take(out));
+    TEST_ASSERT_EQUAL_STRING("AUTO", out);
+    TEST_ASSERT_FALSE(mailbox.take(out));
+}
+
+void test_newer_command_replaces_pending()
+{
+    CommandMailbox<8> mailbox;
+    CommandMailbox<8>::Buffer out;
+    post(mailbox, "100");
+    post(mailbox, "ON");
+    TEST_ASSERT_TRUE(mailbox.take(out));
+    TEST_ASSERT_EQUAL_STRING("ON", out); // Sin restos del comando más largo
+}
+
+void test_rejects_empty_and_oversized()
+{
+    CommandMailbox<8> mailbox;
+    CommandMailbox<8>::Buffer out;
+    TEST_ASSERT_FALSE(post(mailbox, ""));
+    TEST_ASSERT_FALSE(post(mailbox, "123456789"));
+    TEST_ASSERT_FALSE(mailbox.take(out));
+
+    TEST_ASSERT_TRUE(post(mailbox, "12345678")); // Justo la capacidad
+    TEST_ASSERT_TRUE(mailbox.take(out));
+    TEST_ASSERT_EQUAL_STRING("12345678", out);
+}
+
+void test_rejected_post_keeps_pending_command()
+{
+    CommandMailbox<8> mailbox;
+    CommandMailbox<8>::Buffer out;
+    post(mailbox, "OFF");
+    TEST_ASSERT_FALSE(post(mailbox, ""));
+    TEST_ASSERT_TRUE(mailbox.take(out));
+    TEST_ASSERT_EQUAL_STRING("OFF", out);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_mailbox_has_nothing);
+    RUN_TEST(test_take_returns_command_once);
+    RUN_TEST(test_newer_command_replaces_pending);
+    RUN_TEST(test_rejects_empty_and_oversized);
+    RUN_TEST(test_rejected_post_keeps_pending_command);
+    return UNITY_END();
+}
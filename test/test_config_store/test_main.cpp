@@ -0,0 +1,294 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas de la configuración persistente (ConfigStore) en el host.
+ * @details En el host el blob se guarda en un archivo en lugar de NVS. Los
+ * blobs de las pruebas se construyen byte a byte con el formato documentado
+ * en ConfigStore.cpp: versión y entradas `clave, longitud, valor`.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "ConfigStore.h"
+
+static const char *STORE_PATH = "test_config_store.bin";
+
+// Claves del esquema 1 (ver CONFIG_FIELDS en ConfigStore.cpp).
+static const uint8_t KEY_UPDATE_MS = 1;
+static const uint8_t KEY_HISTORY_MS = 2;
+static const uint8_t KEY_NAME = 7;
+
+void setUp(void)
+{
+    remove(STORE_PATH);
+}
+
+void tearDown(void)
+{
+    remove(STORE_PATH);
+}
+
+// --- Utilidades ---
+
+/** @brief Todos los campos de una configuración en texto, para compararlas de una vez. */
+static std::string describe(const DeviceConfig &config)
+{
+    char text[256];
+    snprintf(text, sizeof(text), "%lu;%lu;%lu;%lu;%lu;%lu;%lu;%lu;%s", (unsigned long)config.updateIntervalMs,
+             (unsigned long)config.historyIntervalMs, (unsigned long)config.calStabilizationMs,
+             (unsigned long)config.calPulseMs, (unsigned long)config.calBackend, (unsigned long)config.co2TimeoutMs,
+             (unsigned long)config.co2PreheatMs, (unsigned long)config.fanMode, config.deviceName);
+    return text;
+}
+
+static void appendVarint(std::vector<uint8_t> &blob, uint8_t key, uint32_t value)
+{
+    std::vector<uint8_t> bytes;
+    do
+    {
+        uint8_t bits = value & 0x7F;
+        value >>= 7;
+        bytes.push_back(value != 0 ? (bits | 0x80) : bits);
+    } while (value != 0);
+    blob.push_back(key);
+    blob.push_back((uint8_t)bytes.size());
+    blob.insert(blob.end(), bytes.begin(), bytes.end());
+}
+
+static void appendText(std::vector<uint8_t> &blob, uint8_t key, const char *text)
+{
+    blob.push_back(key);
+    blob.push_back((uint8_t)strlen(text));
+    blob.insert(blob.end(), text, text + strlen(text));
+}
+
+static DeviceConfig customConfig()
+{
+    DeviceConfig config;
+    ConfigStore::defaults(config);
+    config.updateIntervalMs = 60000;
+    config.historyIntervalMs = 3600000;
+    config.calStabilizationMs = 0;
+    config.calPulseMs = 1000;
+    config.calBackend = 1;
+    config.co2TimeoutMs = 1000;
+    config.co2PreheatMs = 600000;
+    config.fanMode = 1;
+    strcpy(config.deviceName, "NODO_CAMARA_07");
+    return config;
+}
+
+// --- Serialización ---
+
+void test_serialize_round_trip(void)
+{
+    DeviceConfig original = customConfig();
+    uint8_t blob[CONFIG_MAX_BLOB_SIZE];
+    size_t len = ConfigStore::serialize(original, blob, sizeof(blob));
+    TEST_ASSERT_TRUE(len > 0);
+    TEST_ASSERT_EQUAL_UINT8(CONFIG_SCHEMA_VERSION, blob[0]);
+
+    DeviceConfig loaded;
+    TEST_ASSERT_TRUE(ConfigStore::deserialize(blob, len, loaded));
+    TEST_ASSERT_EQUAL_STRING(describe(original).c_str(), describe(loaded).c_str());
+}
+
+void test_largest_config_fits_in_the_blob(void)
+{
+    DeviceConfig config = customConfig();
+    config.updateIntervalMs = 0xFFFFFFFF; // Varint más largo, aunque no sea un valor válido
+    memset(config.deviceName, 'N', CONFIG_NAME_MAX);
+    config.deviceName[CONFIG_NAME_MAX] = '\0';
+    uint8_t blob[CONFIG_MAX_BLOB_SIZE];
+    TEST_ASSERT_TRUE(ConfigStore::serialize(config, blob, sizeof(blob)) > 0);
+    TEST_ASSERT_EQUAL_UINT32(0, ConfigStore::serialize(config, blob, 10)); // No cabe: no escribe nada útil
+}
+
+void test_truncated_blob_is_rejected(void)
+{
+    DeviceConfig original = customConfig();
+    uint8_t blob[CONFIG_MAX_BLOB_SIZE];
+    size_t len = ConfigStore::serialize(original, blob, sizeof(blob));
+
+    DeviceConfig defaults;
+    ConfigStore::defaults(defaults);
+    DeviceConfig loaded;
+    TEST_ASSERT_FALSE(ConfigStore::deserialize(blob, 0, loaded));
+    TEST_ASSERT_FALSE(ConfigStore::deserialize(blob, len - 1, loaded)); // Corta el nombre, la última entrada
+    TEST_ASSERT_EQUAL_STRING(describe(defaults).c_str(), describe(loaded).c_str());
+    TEST_ASSERT_FALSE(ConfigStore::deserialize(blob, 2, loaded)); // Solo la clave del primer campo
+}
+
+void test_corrupt_blob_is_rejected(void)
+{
+    DeviceConfig defaults;
+    ConfigStore::defaults(defaults);
+    DeviceConfig loaded;
+
+    std::vector<uint8_t> blob = {0}; // Versión 0: NVS borrada o sin escribir
+    appendVarint(blob, KEY_UPDATE_MS, 1000);
+    TEST_ASSERT_FALSE(ConfigStore::deserialize(blob.data(), blob.size(), loaded));
+
+    blob = {CONFIG_SCHEMA_VERSION, KEY_UPDATE_MS, 40, 0x01}; // Longitud más allá del final
+    TEST_ASSERT_FALSE(ConfigStore::deserialize(blob.data(), blob.size(), loaded));
+    TEST_ASSERT_EQUAL_STRING(describe(defaults).c_str(), describe(loaded).c_str());
+}
+
+void test_unterminated_varint_keeps_the_default(void)
+{
+    std::vector<uint8_t> blob = {CONFIG_SCHEMA_VERSION, KEY_UPDATE_MS, 3, 0xFF, 0xFF, 0xFF};
+    appendVarint(blob, KEY_HISTORY_MS, 20000);
+    DeviceConfig loaded;
+    TEST_ASSERT_TRUE(ConfigStore::deserialize(blob.data(), blob.size(), loaded));
+    TEST_ASSERT_EQUAL_UINT32(500, loaded.updateIntervalMs);
+    TEST_ASSERT_EQUAL_UINT32(20000, loaded.historyIntervalMs);
+}
+
+void test_out_of_range_values_keep_their_defaults(void)
+{
+    std::vector<uint8_t> blob = {CONFIG_SCHEMA_VERSION};
+    appendVarint(blob, KEY_UPDATE_MS, 50);          // Mínimo 100 ms
+    appendVarint(blob, KEY_HISTORY_MS, 4000000);    // Máximo 1 h
+    appendText(blob, KEY_NAME, "A;B");              // Separador no permitido
+    appendVarint(blob, 8, 1);                       // CAL_MODE válido
+    DeviceConfig loaded;
+    TEST_ASSERT_TRUE(ConfigStore::deserialize(blob.data(), blob.size(), loaded));
+    TEST_ASSERT_EQUAL_UINT32(500, loaded.updateIntervalMs);
+    TEST_ASSERT_EQUAL_UINT32(10000, loaded.historyIntervalMs);
+    TEST_ASSERT_EQUAL_STRING("SRV_NAME", loaded.deviceName);
+    TEST_ASSERT_EQUAL_UINT32(1, loaded.calBackend);
+}
+
+void test_unknown_keys_are_skipped(void)
+{
+    // Blob de un firmware más nuevo: otra versión y claves que este no conoce.
+    std::vector<uint8_t> blob = {CONFIG_SCHEMA_VERSION + 1};
+    appendVarint(blob, 200, 123456);
+    appendText(blob, 201, "futuro");
+    appendVarint(blob, KEY_UPDATE_MS, 2000);
+    DeviceConfig loaded;
+    TEST_ASSERT_TRUE(ConfigStore::deserialize(blob.data(), blob.size(), loaded));
+    TEST_ASSERT_EQUAL_UINT32(2000, loaded.updateIntervalMs);
+}
+
+void test_older_blob_without_newer_keys_uses_defaults(void)
+{
+    // Blob de un firmware anterior, sin CAL_MODE ni FAN_MODE (añadidos sin cambiar el esquema).
+    std::vector<uint8_t> blob = {1};
+    appendVarint(blob, KEY_UPDATE_MS, 1000);
+    appendVarint(blob, KEY_HISTORY_MS, 30000);
+    appendText(blob, KEY_NAME, "ANTIGUO");
+    DeviceConfig loaded;
+    TEST_ASSERT_TRUE(ConfigStore::deserialize(blob.data(), blob.size(), loaded));
+    TEST_ASSERT_EQUAL_UINT32(1000, loaded.updateIntervalMs);
+    TEST_ASSERT_EQUAL_UINT32(30000, loaded.historyIntervalMs);
+    TEST_ASSERT_EQUAL_STRING("ANTIGUO", loaded.deviceName);
+    TEST_ASSERT_EQUAL_UINT32(0, loaded.calBackend);
+    TEST_ASSERT_EQUAL_UINT32(0, loaded.fanMode);
+    TEST_ASSERT_EQUAL_UINT32(150, loaded.co2TimeoutMs);
+}
+
+// --- Almacén ---
+
+void test_begin_without_saved_config_uses_defaults(void)
+{
+    ConfigStore store;
+    store.setFilePath(STORE_PATH);
+    TEST_ASSERT_FALSE(store.begin());
+    TEST_ASSERT_EQUAL_UINT32(500, store.get().updateIntervalMs);
+}
+
+void test_commit_persists_across_instances(void)
+{
+    ConfigStore store;
+    store.setFilePath(STORE_PATH);
+    TEST_ASSERT_TRUE(store.apply("UPDATE_MS=2000;NAME=CAMARA_2"));
+    TEST_ASSERT_TRUE(store.commit());
+
+    ConfigStore reloaded;
+    reloaded.setFilePath(STORE_PATH);
+    TEST_ASSERT_TRUE(reloaded.begin());
+    TEST_ASSERT_EQUAL_UINT32(2000, reloaded.get().updateIntervalMs);
+    TEST_ASSERT_EQUAL_STRING("CAMARA_2", reloaded.get().deviceName);
+}
+
+void test_set_rejects_invalid_values(void)
+{
+    ConfigStore store;
+    TEST_ASSERT_FALSE(store.set("UPDATE_MS", ""));
+    TEST_ASSERT_FALSE(store.set("UPDATE_MS", "abc"));
+    TEST_ASSERT_FALSE(store.set("UPDATE_MS", "-500"));
+    TEST_ASSERT_FALSE(store.set("UPDATE_MS", "500ms"));
+    TEST_ASSERT_FALSE(store.set("UPDATE_MS", "99"));
+    TEST_ASSERT_FALSE(store.set("UPDATE_MS", "60001"));
+    TEST_ASSERT_FALSE(store.set("NAME", ""));
+    TEST_ASSERT_FALSE(store.set("NAME", "NOMBRE_DE_MAS_DE_20_C"));
+    TEST_ASSERT_FALSE(store.set("NO_EXISTE", "1"));
+    TEST_ASSERT_EQUAL_UINT32(500, store.get().updateIntervalMs);
+    TEST_ASSERT_TRUE(store.set("UPDATE_MS", "60000"));
+    TEST_ASSERT_EQUAL_UINT32(60000, store.get().updateIntervalMs);
+}
+
+void test_apply_is_all_or_nothing(void)
+{
+    ConfigStore store;
+    TEST_ASSERT_FALSE(store.apply("UPDATE_MS=1000;HISTORY_MS=5"));
+    TEST_ASSERT_EQUAL_UINT32(500, store.get().updateIntervalMs);
+    TEST_ASSERT_FALSE(store.apply("UPDATE_MS"));
+    TEST_ASSERT_TRUE(store.apply("UPDATE_MS=1000;HISTORY_MS=5000"));
+    TEST_ASSERT_EQUAL_UINT32(5000, store.get().historyIntervalMs);
+    TEST_ASSERT_TRUE(store.apply("RESET"));
+    TEST_ASSERT_EQUAL_UINT32(500, store.get().updateIntervalMs);
+}
+
+void test_apply_accepts_every_key_at_once(void)
+{
+    // La descripción de la configuración más larga es el comando más largo con todas las claves.
+    ConfigStore source;
+    TEST_ASSERT_TRUE(source.apply("UPDATE_MS=60000;HISTORY_MS=3600000;CAL_STAB_MS=3600000;CAL_PULSE_MS=30000;"
+                                  "CO2_TIMEOUT_MS=1000;CO2_PREHEAT_MS=600000;CAL_MODE=1;FAN_MODE=1"));
+    TEST_ASSERT_TRUE(source.apply("NAME=NNNNNNNNNNNNNNNNNNNN"));
+    char command[CONFIG_COMMAND_MAX_LEN + 1];
+    size_t len = source.describe(command, sizeof(command));
+    TEST_ASSERT_TRUE(len > 128);
+    TEST_ASSERT_TRUE(len < sizeof(command) - 1); // Cabe en el buzón BLE sin truncarse
+
+    ConfigStore store;
+    TEST_ASSERT_TRUE(store.apply(command));
+    TEST_ASSERT_EQUAL_UINT32(3600000, store.get().calStabilizationMs);
+    TEST_ASSERT_EQUAL_STRING("NNNNNNNNNNNNNNNNNNNN", store.get().deviceName);
+}
+
+void test_apply_rejects_commands_longer_than_the_mailbox(void)
+{
+    std::string command = "UPDATE_MS=1000";
+    while (command.size() <= CONFIG_COMMAND_MAX_LEN)
+    {
+        command += ";UPDATE_MS=1000";
+    }
+    ConfigStore store;
+    TEST_ASSERT_FALSE(store.apply(command.c_str()));
+    TEST_ASSERT_EQUAL_UINT32(500, store.get().updateIntervalMs);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_serialize_round_trip);
+    RUN_TEST(test_largest_config_fits_in_the_blob);
+    RUN_TEST(test_truncated_blob_is_rejected);
+    RUN_TEST(test_corrupt_blob_is_rejected);
+    RUN_TEST(test_unterminated_varint_keeps_the_default);
+    RUN_TEST(test_out_of_range_values_keep_their_defaults);
+    RUN_TEST(test_unknown_keys_are_skipped);
+    RUN_TEST(test_older_blob_without_newer_keys_uses_defaults);
+    RUN_TEST(test_begin_without_saved_config_uses_defaults);
+    RUN_TEST(test_commit_persists_across_instances);
+    RUN_TEST(test_set_rejects_invalid_values);
+    RUN_TEST(test_apply_is_all_or_nothing);
+    RUN_TEST(test_apply_accepts_every_key_at_once);
+    RUN_TEST(test_apply_rejects_commands_longer_than_the_mailbox);
+    return UNITY_END();
+}
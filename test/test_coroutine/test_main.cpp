@@ -0,0 +1,331 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas de las corrutinas sin pila y de su planificador con un reloj virtual.
+ * @details Cada flujo de prueba anota en una traza qué paso ejecutó y en qué
+ * instante; el "bucle principal" avanza la rueda y llama al planificador
+ * igual que ESP_Server.cpp.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "Coroutine.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+/**
+ * @struct Trace
+ * @brief Pasos ejecutados por un flujo y el instante de cada uno.
+ */
+struct Trace
+{
+    char steps[32];
+    uint32_t times[32];
+    uint8_t count;
+
+    Trace() : count(0) { steps[0] = '\0'; }
+
+    void add(char step, uint32_t now)
+    {
+        if (count < sizeof(steps) - 1)
+        {
+            times[count] = now;
+            steps[count++] = step;
+            steps[count] = '\0';
+        }
+    }
+};
+
+/**
+ * @class Sequence
+ * @brief Flujo con un paso de cada tipo: delay, yield, await y fin.
+ */
+class Sequence
+{
+public:
+    Sequence() : co(body, this), ready(false), loops(0) {}
+
+    static void body(void *context) { static_cast<Sequence *>(context)->step(); }
+
+    void step()
+    {
+        CO_BEGIN(co);
+        trace.add('a', co.now());
+        CO_DELAY(co, 100);
+        trace.add('b', co.now());
+        CO_YIELD(co);
+        trace.add('c', co.now());
+        CO_AWAIT(co, ready);
+        trace.add('d', co.now());
+        for (loops = 0; loops < 3; loops++) // El marco vive en miembros, no en locales
+        {
+            CO_DELAY(co, 10);
+            trace.add('0' + loops, co.now());
+        }
+        CO_END(co);
+        trace.add('z', co.now());
+    }
+
+    Coroutine co;
+    Trace trace;
+    bool ready;
+    uint8_t loops;
+};
+
+/** @brief Bucle principal simulado: avanza la rueda y reanuda los flujos cada `stepMs`. */
+static void runUntil(TimerWheel &wheel, CoroutineScheduler &scheduler, uint32_t &now, uint32_t until,
+                     uint32_t stepMs = 1)
+{
+    while (now < until)
+    {
+        now += stepMs;
+        wheel.advance(now);
+        scheduler.run(now);
+    }
+}
+
+void test_flow_runs_each_step_in_order()
+{
+    TimerWheel wheel;
+    CoroutineScheduler scheduler(wheel);
+    Sequence flow;
+    TEST_ASSERT_TRUE(scheduler.add(flow.co));
+    uint32_t now = 0;
+
+    runUntil(wheel, scheduler, now, 50);
+    TEST_ASSERT_EQUAL_STRING("", flow.trace.steps); // Sin start() no se ejecuta
+
+    flow.co.start(now);
+    runUntil(wheel, scheduler, now, 51);
+    TEST_ASSERT_EQUAL_STRING("a", flow.trace.steps);
+    TEST_ASSERT_EQUAL_UINT32(51, flow.trace.times[0]);
+
+    runUntil(wheel, scheduler, now, 150);
+    TEST_ASSERT_EQUAL_STRING("a", flow.trace.steps);
+    runUntil(wheel, scheduler, now, 151);
+    TEST_ASSERT_EQUAL_STRING("b", flow.trace.steps + 1); // Exactamente 100 ms después
+    TEST_ASSERT_EQUAL_UINT32(151, flow.trace.times[1]);
+
+    runUntil(wheel, scheduler, now, 152);
+    TEST_ASSERT_EQUAL_STRING("abc", flow.trace.steps); // El yield cede una sola pasada
+
+    runUntil(wheel, scheduler, now, 500);
+    TEST_ASSERT_EQUAL_STRING("abc", flow.trace.steps);
+    flow.ready = true;
+    runUntil(wheel, scheduler, now, 501);
+    TEST_ASSERT_EQUAL_STRING("abcd", flow.trace.steps);
+
+    runUntil(wheel, scheduler, now, 600);
+    TEST_ASSERT_EQUAL_STRING("abcd012z", flow.trace.steps);
+    TEST_ASSERT_EQUAL_UINT32(511, flow.trace.times[4]);
+    TEST_ASSERT_EQUAL_UINT32(531, flow.trace.times[6]);
+    TEST_ASSERT_FALSE(flow.co.isRunning());
+    TEST_ASSERT_EQUAL_UINT16(0, wheel.getActiveCount());
+}
+
+void test_sleeping_flow_costs_no_resumes()
+{
+    TimerWheel wheel;
+    CoroutineScheduler scheduler(wheel);
+    Sequence flow;
+    scheduler.add(flow.co);
+    uint32_t now = 0;
+    flow.co.start(now);
+    runUntil(wheel, scheduler, now, 1);
+    TEST_ASSERT_FALSE(flow.co.isReady());
+    TEST_ASSERT_FALSE(scheduler.hasReadyFlows());
+    uint32_t before = scheduler.getResumeCount();
+    runUntil(wheel, scheduler, now, 100);
+    TEST_ASSERT_EQUAL_UINT32(before, scheduler.getResumeCount());
+
+    // En CO_AWAIT sí se reanuda en cada pasada
+    runUntil(wheel, scheduler, now, 102);
+    TEST_ASSERT_TRUE(scheduler.hasReadyFlows());
+    before = scheduler.getResumeCount();
+    runUntil(wheel, scheduler, now, 112);
+    TEST_ASSERT_EQUAL_UINT32(before + 10, scheduler.getResumeCount());
+}
+
+void test_delay_is_exact_with_coarse_loop()
+{
+    // Vueltas del bucle de 7 ms: el flujo se reanuda en la primera vuelta tras el plazo
+    TimerWheel wheel;
+    CoroutineScheduler scheduler(wheel);
+    Sequence flow;
+    scheduler.add(flow.co);
+    uint32_t now = 0;
+    flow.co.start(now);
+    runUntil(wheel, scheduler, now, 7, 7);
+    runUntil(wheel, scheduler, now, 112, 7);
+    TEST_ASSERT_EQUAL_STRING("ab", flow.trace.steps);
+    TEST_ASSERT_EQUAL_UINT32(112, flow.trace.times[1]); // Primera vuelta >= 107
+}
+
+void test_stop_cancels_pending_delay()
+{
+    TimerWheel wheel;
+    CoroutineScheduler scheduler(wheel);
+    Sequence flow;
+    scheduler.add(flow.co);
+    uint32_t now = 0;
+    flow.co.start(now);
+    runUntil(wheel, scheduler, now, 10);
+    TEST_ASSERT_EQUAL_UINT16(1, wheel.getActiveCount());
+
+    flow.co.stop();
+    TEST_ASSERT_FALSE(flow.co.isRunning());
+    TEST_ASSERT_EQUAL_UINT16(0, wheel.getActiveCount());
+    runUntil(wheel, scheduler, now, 500);
+    TEST_ASSERT_EQUAL_STRING("a", flow.trace.steps);
+}
+
+void test_restart_begins_from_the_top()
+{
+    TimerWheel wheel;
+    CoroutineScheduler scheduler(wheel);
+    Sequence flow;
+    scheduler.add(flow.co);
+    uint32_t now = 0;
+    flow.co.start(now);
+    runUntil(wheel, scheduler, now, 152); // Tras el yield, esperando `ready`
+    TEST_ASSERT_EQUAL_STRING("abc", flow.trace.steps);
+
+    flow.co.start(now);
+    runUntil(wheel, scheduler, now, 153);
+    TEST_ASSERT_EQUAL_STRING("abca", flow.trace.steps);
+    TEST_ASSERT_EQUAL_UINT16(1, wheel.getActiveCount()); // Solo el delay nuevo
+}
+
+void test_flows_interleave()
+{
+    TimerWheel wheel;
+    CoroutineScheduler scheduler(wheel);
+    Sequence first;
+    Sequence second;
+    scheduler.add(first.co);
+    scheduler.add(second.co);
+    first.ready = true;
+    second.ready = true;
+    uint32_t now = 0;
+    first.co.start(now);
+    runUntil(wheel, scheduler, now, 40);
+    second.co.start(now);
+    runUntil(wheel, scheduler, now, 400);
+    TEST_ASSERT_EQUAL_STRING("abcd012z", first.trace.steps);
+    TEST_ASSERT_EQUAL_STRING("abcd012z", second.trace.steps);
+    TEST_ASSERT_EQUAL_UINT32(first.trace.times[7] + 40, second.trace.times[7]);
+}
+
+void test_scheduler_capacity()
+{
+    TimerWheel wheel;
+    CoroutineScheduler scheduler(wheel);
+    Sequence flows[CoroutineScheduler::MAX_COROUTINES + 1];
+    for (uint8_t i = 0; i < CoroutineScheduler::MAX_COROUTINES; i++)
+    {
+        TEST_ASSERT_TRUE(scheduler.add(flows[i].co));
+    }
+    TEST_ASSERT_FALSE(scheduler.add(flows[CoroutineScheduler::MAX_COROUTINES].co));
+}
+
+void test_delay_without_scheduler_yields()
+{
+    Sequence flow;
+    flow.co.start(0);
+    flow.co.resume(0);
+    TEST_ASSERT_EQUAL_STRING("a", flow.trace.steps);
+    TEST_ASSERT_TRUE(flow.co.isReady()); // Sin rueda, el delay es un yield
+    flow.co.resume(1);
+    TEST_ASSERT_EQUAL_STRING("ab", flow.trace.steps);
+}
+
+/**
+ * @class Stabilization
+ * @brief Flujo con la forma del de calibración: espera larga con un registro
+ * periódico y una espera final a que termine el backend.
+ */
+class Stabilization
+{
+public:
+    static const uint32_t TOTAL_MS = 20UL * 60 * 1000;
+    static const uint32_t LOG_MS = 60UL * 1000;
+
+    Stabilization() : co(body, this), start_ms(0), logs(0), done(false), finished_at(0) {}
+
+    static void body(void *context) { static_cast<Stabilization *>(context)->step(); }
+
+    uint32_t remaining() const
+    {
+        uint32_t elapsed = co.now() - start_ms;
+        return elapsed >= TOTAL_MS ? 0 : TOTAL_MS - elapsed;
+    }
+
+    void step()
+    {
+        CO_BEGIN(co);
+        start_ms = co.now();
+        while (remaining() > 0)
+        {
+            CO_DELAY(co, remaining() < LOG_MS ? remaining() : LOG_MS);
+            logs++;
+        }
+        CO_AWAIT(co, done);
+        finished_at = co.now();
+        CO_END(co);
+    }
+
+    Coroutine co;
+    uint32_t start_ms;
+    uint32_t logs;
+    bool done;
+    uint32_t finished_at;
+};
+
+void test_long_flow_in_simulated_loop()
+{
+    TimerWheel wheel;
+    CoroutineScheduler scheduler(wheel);
+    Stabilization flow;
+    scheduler.add(flow.co);
+    uint32_t now = 0xFFFF0000u; // Cruza la vuelta de millis()
+    wheel.reset(now);
+    flow.co.start(now);
+    uint32_t begin = now;
+
+    for (uint32_t elapsed = 0; elapsed < Stabilization::TOTAL_MS + 5000; elapsed += 10)
+    {
+        now = begin + elapsed;
+        if (elapsed == Stabilization::TOTAL_MS + 2000)
+        {
+            flow.done = true;
+        }
+        wheel.advance(now);
+        scheduler.run(now);
+    }
+    TEST_ASSERT_EQUAL_UINT32(20, flow.logs);
+    TEST_ASSERT_EQUAL_UINT32(Stabilization::TOTAL_MS + 2000, flow.finished_at - begin);
+    TEST_ASSERT_FALSE(flow.co.isRunning());
+
+    char message[64];
+    snprintf(message, sizeof(message), "%u reanudaciones en %u vueltas del bucle", scheduler.getResumeCount(),
+             (Stabilization::TOTAL_MS + 5000) / 10);
+    TEST_MESSAGE(message);
+    // 20 despertares, el inicio y las ~200 pasadas del CO_AWAIT final
+    TEST_ASSERT_LESS_THAN(250, scheduler.getResumeCount());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_flow_runs_each_step_in_order);
+    RUN_TEST(test_sleeping_flow_costs_no_resumes);
+    RUN_TEST(test_delay_is_exact_with_coarse_loop);
+    RUN_TEST(test_stop_cancels_pending_delay);
+    RUN_TEST(test_restart_begins_from_the_top);
+    RUN_TEST(test_flows_interleave);
+    RUN_TEST(test_scheduler_capacity);
+    RUN_TEST(test_delay_without_scheduler_yields);
+    RUN_TEST(test_long_flow_in_simulated_loop);
+    return UNITY_END();
+}
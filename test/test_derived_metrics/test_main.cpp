@@ -0,0 +1,268 @@
+/**
+ * @file test_main.cpp
+ * @brief Precisión y coste de las magnitudes derivadas frente a `<math.h>`.
+ * @details Las aproximaciones de `log2` y `exp2` se comparan con las de la
+ * biblioteca en doble precisión, y cada magnitud con su fórmula evaluada en
+ * doble. Las cotas son las de la documentación de DerivedMetrics con margen
+ * para el redondeo de los floats intermedios.
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "DerivedMetrics.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static SensorData sample(float temperature, float humidity, float pressure, int co2)
+{
+    SensorData data = {temperature, humidity, pressure, co2, 0, -1};
+    return data;
+}
+
+// --- Referencias en doble precisión ---
+
+static double referenceDewPoint(double t, double rh)
+{
+    double gamma = log(rh / 100.0) + 17.62 * t / (243.12 + t);
+    return 243.12 * gamma / (17.62 - gamma);
+}
+
+static double referenceAbsoluteHumidity(double t, double rh)
+{
+    double vapour = rh / 100.0 * 6.112 * exp(17.62 * t / (243.12 + t));
+    return 216.7 * vapour / (273.15 + t);
+}
+
+static double referenceAltitude(double p)
+{
+    return 44330.0 * (1.0 - pow(p / 1013.25, 0.190295));
+}
+
+// --- Aproximaciones ---
+
+void test_fast_log2_accuracy()
+{
+    double maxError = 0;
+    float worst = 0;
+    for (float x = 1e-30f; x < 1e30f; x *= 1.0137f)
+    {
+        double error = fabs(DerivedMetrics::fastLog2(x) - log2((double)x)) / fmax(1.0, fabs(log2((double)x)));
+        if (error > maxError)
+        {
+            maxError = error;
+            worst = x;
+        }
+    }
+    // Entorno de 1, donde el resultado tiende a 0 y cuenta el error absoluto
+    for (float x = 0.5f; x < 2.0f; x += 1.0f / 4096)
+    {
+        maxError = fmax(maxError, fabs(DerivedMetrics::fastLog2(x) - log2((double)x)));
+    }
+    char message[80];
+    snprintf(message, sizeof(message), "log2: error máximo %.2e (x = %g)", maxError, worst);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_LESS_THAN(3e-7, maxError);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, DerivedMetrics::fastLog2(1.0f));
+}
+
+void test_fast_exp2_accuracy()
+{
+    double maxError = 0;
+    for (float x = -120.0f; x < 120.0f; x += 0.00731f)
+    {
+        double reference = exp2((double)x);
+        maxError = fmax(maxError, fabs(DerivedMetrics::fastExp2(x) - reference) / reference);
+    }
+    char message[64];
+    snprintf(message, sizeof(message), "exp2: error relativo máximo %.2e", maxError);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_LESS_THAN(5e-7, maxError);
+}
+
+void test_fast_exp2_saturates()
+{
+    TEST_ASSERT_EQUAL_FLOAT(exp2f(-126.0f), DerivedMetrics::fastExp2(-1000.0f));
+    TEST_ASSERT_EQUAL_FLOAT(exp2f(127.0f), DerivedMetrics::fastExp2(1000.0f));
+    TEST_ASSERT_FALSE(isinf(DerivedMetrics::fastExp2(1000.0f)));
+}
+
+// --- Magnitudes ---
+
+void test_humidity_metrics_match_reference()
+{
+    double maxDewError = 0;
+    double maxAhError = 0;
+    for (float t = -40.0f; t <= 85.0f; t += 0.7f)
+    {
+        for (float rh = 1.0f; rh <= 100.0f; rh += 1.3f)
+        {
+            DerivedMetrics metrics;
+            const DerivedData &derived = metrics.update(sample(t, rh, -1, -1));
+            TEST_ASSERT_TRUE(derived.valid & DERIVED_DEW_POINT);
+            TEST_ASSERT_TRUE(derived.valid & DERIVED_ABSOLUTE_HUMIDITY);
+            maxDewError = fmax(maxDewError, fabs(derived.dewPoint - referenceDewPoint(t, rh)));
+            double ah = referenceAbsoluteHumidity(t, rh);
+            maxAhError = fmax(maxAhError, fabs(derived.absoluteHumidity - ah) / ah);
+        }
+    }
+    char message[96];
+    snprintf(message, sizeof(message), "rocío: error máximo %.2e °C, humedad absoluta: %.2e relativo", maxDewError,
+             maxAhError);
+    TEST_MESSAGE(message);
+    // Resolución del DHT22: 0.1 °C y 0.1 %
+    TEST_ASSERT_LESS_THAN(1e-3, maxDewError);
+    TEST_ASSERT_LESS_THAN(1e-5, maxAhError);
+}
+
+void test_altitude_matches_reference()
+{
+    double maxError = 0;
+    for (float p = 300.0f; p <= 1100.0f; p += 0.37f)
+    {
+        DerivedMetrics metrics;
+        const DerivedData &derived = metrics.update(sample(-1, -1, p, -1));
+        TEST_ASSERT_TRUE(derived.valid & DERIVED_ALTITUDE);
+        maxError = fmax(maxError, fabs(derived.altitude - referenceAltitude(p)));
+    }
+    char message[64];
+    snprintf(message, sizeof(message), "altitud: error máximo %.3f m", maxError);
+    TEST_MESSAGE(message);
+    // El BMP280 resuelve ~0.16 Pa, unos 1.3 cm: basta con quedar por debajo del decímetro
+    TEST_ASSERT_LESS_THAN(0.1, maxError);
+
+    DerivedMetrics metrics;
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, metrics.update(sample(-1, -1, DerivedMetrics::SEA_LEVEL_HPA, -1)).altitude);
+}
+
+void test_co2_compensation()
+{
+    DerivedMetrics metrics;
+    TEST_ASSERT_EQUAL_INT(600, metrics.update(sample(-1, -1, 1013.25f, 600)).co2Compensated);
+    TEST_ASSERT_EQUAL_INT(760, metrics.update(sample(-1, -1, 800.0f, 600)).co2Compensated); // 759.94
+    TEST_ASSERT_EQUAL_INT(507, metrics.update(sample(-1, -1, 1200.0f, 600)).co2Compensated); // 506.63, redondeado
+}
+
+void test_invalid_inputs_clear_fields()
+{
+    DerivedMetrics metrics;
+    metrics.update(sample(20.0f, 50.0f, 1000.0f, 500));
+    TEST_ASSERT_EQUAL_UINT8(DERIVED_DEW_POINT | DERIVED_ABSOLUTE_HUMIDITY | DERIVED_CO2_COMPENSATED | DERIVED_ALTITUDE,
+                            metrics.get().valid);
+
+    // Fallo del DHT22 (ambas a -1): solo caen las magnitudes de humedad
+    metrics.update(sample(-1, -1, 1000.0f, 500));
+    TEST_ASSERT_EQUAL_UINT8(DERIVED_CO2_COMPENSATED | DERIVED_ALTITUDE, metrics.get().valid);
+
+    // Fallo del BMP280: caen el CO2 compensado y la altitud
+    metrics.update(sample(20.0f, 50.0f, -1, 500));
+    TEST_ASSERT_EQUAL_UINT8(DERIVED_DEW_POINT | DERIVED_ABSOLUTE_HUMIDITY, metrics.get().valid);
+
+    // Humedad fuera de rango
+    metrics.update(sample(20.0f, 0.0f, -1, -1));
+    TEST_ASSERT_EQUAL_UINT8(0, metrics.get().valid);
+
+    char text[64];
+    metrics.describe(text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("DEW=NA;AH=NA;CO2C=NA;ALT=NA", text);
+}
+
+void test_stable_inputs_skip_computation()
+{
+    DerivedMetrics metrics;
+    metrics.update(sample(20.0f, 50.0f, 1000.0f, 500));
+    uint32_t computed = metrics.getComputeCount();
+    TEST_ASSERT_EQUAL_UINT32(3, computed);
+
+    metrics.update(sample(20.0f, 50.0f, 1000.0f, 500));
+    TEST_ASSERT_EQUAL_UINT32(computed, metrics.getComputeCount());
+
+    metrics.update(sample(20.0f, 50.0f, 1000.0f, 510)); // Solo el grupo del CO2
+    TEST_ASSERT_EQUAL_UINT32(computed + 1, metrics.getComputeCount());
+    metrics.update(sample(20.0f, 50.0f, 1001.0f, 510)); // CO2 y altitud
+    TEST_ASSERT_EQUAL_UINT32(computed + 3, metrics.getComputeCount());
+}
+
+void test_describe_format()
+{
+    DerivedMetrics metrics;
+    metrics.update(sample(20.0f, 50.0f, 1013.25f, 500));
+    char text[64];
+    size_t len = metrics.describe(text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("DEW=9.26;AH=8.62;CO2C=500;ALT=0.0", text);
+    TEST_ASSERT_EQUAL_UINT(strlen(text), len);
+
+    char small[8];
+    TEST_ASSERT_EQUAL_UINT(sizeof(small) - 1, metrics.describe(small, sizeof(small)));
+    TEST_ASSERT_EQUAL_STRING("DEW=9.2", small);
+}
+
+// --- Coste ---
+
+/** @brief Evita que el compilador descarte el cálculo de la referencia. */
+static volatile float sink;
+
+void test_benchmark_per_sample_cost()
+{
+    typedef std::chrono::steady_clock Clock;
+    const int samples = 200000;
+
+    // Cada muestra cambia todas las entradas, el peor caso de `update()`
+    DerivedMetrics metrics;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < samples; i++)
+    {
+        float k = (float)(i % 1000);
+        metrics.update(sample(15.0f + k * 0.01f, 40.0f + k * 0.02f, 990.0f + k * 0.03f, 400 + (i % 1000)));
+    }
+    double fastNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / samples;
+    sink = metrics.get().altitude;
+
+    // Las mismas fórmulas con logf/expf/powf
+    start = Clock::now();
+    for (int i = 0; i < samples; i++)
+    {
+        float k = (float)(i % 1000);
+        float t = 15.0f + k * 0.01f, rh = 40.0f + k * 0.02f, p = 990.0f + k * 0.03f;
+        float magnus = 17.62f * t / (243.12f + t);
+        float gamma = logf(rh / 100.0f) + magnus;
+        float dew = 243.12f * gamma / (17.62f - gamma);
+        float ah = 216.7f * rh / 100.0f * 6.112f * expf(magnus) / (273.15f + t);
+        float co2 = (400 + (i % 1000)) * 1013.25f / p;
+        float alt = 44330.0f * (1.0f - powf(p / 1013.25f, 0.190295f));
+        sink = dew + ah + co2 + alt;
+    }
+    double libmNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / samples;
+
+    // Muestras estables: solo las comparaciones de las entradas
+    start = Clock::now();
+    SensorData stable = sample(20.0f, 50.0f, 1000.0f, 500);
+    for (int i = 0; i < samples; i++)
+    {
+        metrics.update(stable);
+    }
+    double stableNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / samples;
+    sink = metrics.get().dewPoint;
+
+    printf("Coste por muestra (host): aproximaciones %.1f ns, <math.h> %.1f ns, entradas estables %.1f ns\n", fastNs,
+           libmNs, stableNs);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fast_log2_accuracy);
+    RUN_TEST(test_fast_exp2_accuracy);
+    RUN_TEST(test_fast_exp2_saturates);
+    RUN_TEST(test_humidity_metrics_match_reference);
+    RUN_TEST(test_altitude_matches_reference);
+    RUN_TEST(test_co2_compensation);
+    RUN_TEST(test_invalid_inputs_clear_fields);
+    RUN_TEST(test_stable_inputs_skip_computation);
+    RUN_TEST(test_describe_format);
+    RUN_TEST(test_benchmark_per_sample_cost);
+    return UNITY_END();
+}
@@ -0,0 +1,198 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del controlador PI del ventilador y de sus comandos.
+ * @details La sintonía es la de SensorManager (consigna de 28.00 °C); el lazo
+ * cerrado se prueba contra un modelo térmico de primer orden de la cámara.
+ */
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include "FanController.h"
+
+/** @brief Misma sintonía que `FAN_CONFIG` en SensorManager.cpp. */
+static const FanControllerConfig CONFIG = {2800, 100, 3 << 16, 6554, 250, FAN_DUTY_MAX, 2000};
+
+static FanController fan;
+
+void setUp(void)
+{
+    fan = FanController();
+    fan.configure(CONFIG);
+}
+
+void tearDown(void) {}
+
+void test_stays_off_below_setpoint()
+{
+    TEST_ASSERT_EQUAL_UINT16(0, fan.update(2500, 1000));
+    TEST_ASSERT_EQUAL_UINT16(0, fan.update(2800, 1000)); // En la consigna todavía no arranca
+    TEST_ASSERT_FALSE(fan.isRunning());
+}
+
+void test_unconfigured_controller_never_runs()
+{
+    FanController idle;
+    TEST_ASSERT_EQUAL_UINT16(0, idle.update(INT32_MAX - 1, 1000));
+    TEST_ASSERT_FALSE(idle.isRunning());
+}
+
+void test_spin_up_then_run_duty()
+{
+    // 0.10 °C por encima: la salida PI es pequeña, pero arranca a plena potencia
+    TEST_ASSERT_EQUAL_UINT16(FAN_DUTY_MAX, fan.update(2810, 500));
+    TEST_ASSERT_TRUE(fan.isRunning());
+    TEST_ASSERT_EQUAL_UINT32(1500, fan.getSpinUpRemainingMs());
+    TEST_ASSERT_EQUAL_UINT16(CONFIG.minDuty, fan.getRunDuty());
+
+    TEST_ASSERT_EQUAL_UINT16(FAN_DUTY_MAX, fan.update(2810, 1000));
+    TEST_ASSERT_EQUAL_UINT16(FAN_DUTY_MAX, fan.update(2810, 1000)); // El paso que termina el arranque
+    TEST_ASSERT_EQUAL_UINT32(0, fan.getSpinUpRemainingMs());
+    TEST_ASSERT_EQUAL_UINT16(CONFIG.minDuty, fan.update(2810, 1000));
+}
+
+void test_proportional_term()
+{
+    fan.update(2900, CONFIG.spinUpMs); // Termina el arranque en un paso
+    // 1.00 °C de error: 300 de proporcional más lo integrado en ese paso
+    uint16_t duty = fan.update(2900, 0);
+    TEST_ASSERT_UINT_WITHIN(1, 300 + (uint16_t)((6554LL * 100 * 2000 / 1000) >> 16), duty);
+}
+
+void test_hysteresis_band()
+{
+    fan.update(2810, CONFIG.spinUpMs);
+    TEST_ASSERT_TRUE(fan.isRunning());
+
+    // Dentro de la banda [2700, 2800] sigue girando al mínimo
+    TEST_ASSERT_EQUAL_UINT16(CONFIG.minDuty, fan.update(2750, 1000));
+    TEST_ASSERT_EQUAL_UINT16(CONFIG.minDuty, fan.update(2700, 1000));
+    TEST_ASSERT_TRUE(fan.isRunning());
+
+    // Por debajo de la banda se apaga y no vuelve hasta pasar la consigna
+    TEST_ASSERT_EQUAL_UINT16(0, fan.update(2699, 1000));
+    TEST_ASSERT_FALSE(fan.isRunning());
+    TEST_ASSERT_EQUAL_UINT16(0, fan.update(2790, 1000));
+    TEST_ASSERT_FALSE(fan.isRunning());
+    TEST_ASSERT_EQUAL_UINT16(FAN_DUTY_MAX, fan.update(2801, 1000)); // Nuevo arranque
+    TEST_ASSERT_EQUAL_UINT32(CONFIG.spinUpMs - 1000, fan.getSpinUpRemainingMs());
+}
+
+void test_anti_windup_releases_quickly()
+{
+    // Diez minutos saturado al máximo: 5 °C de error dan 1500 de proporcional
+    for (int i = 0; i < 600; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT16(FAN_DUTY_MAX, fan.update(3300, 1000));
+    }
+    // El integrador no siguió acumulando: al caer por debajo de la consigna el
+    // duty deja de estar saturado en el primer paso
+    uint16_t duty = fan.update(2790, 1000);
+    TEST_ASSERT_LESS_THAN(FAN_DUTY_MAX, duty);
+    TEST_ASSERT_GREATER_OR_EQUAL(CONFIG.minDuty, duty);
+}
+
+void test_integral_is_scaled_by_elapsed_time()
+{
+    FanController other;
+    other.configure(CONFIG);
+    fan.update(2850, CONFIG.spinUpMs);
+    other.update(2850, CONFIG.spinUpMs);
+
+    for (int i = 0; i < 10; i++)
+    {
+        fan.update(2850, 100);
+    }
+    other.update(2850, 1000);
+    TEST_ASSERT_UINT_WITHIN(1, other.getDuty(), fan.getDuty());
+}
+
+void test_configure_keeps_running_state()
+{
+    fan.update(2900, CONFIG.spinUpMs);
+    uint16_t before = fan.update(2900, 1000);
+
+    FanControllerConfig softer = CONFIG;
+    softer.kp = 1 << 16;
+    fan.configure(softer);
+    TEST_ASSERT_TRUE(fan.isRunning());
+    TEST_ASSERT_LESS_THAN(before, fan.update(2900, 0));
+}
+
+void test_closed_loop_settles_at_setpoint()
+{
+    // Cámara que sin ventilador tiende a 45 °C y con el ventilador al máximo a
+    // ~25.8 °C: para mantener 28 °C hace falta ~57 % de duty, por encima del mínimo
+    double temp = 25.0;
+    int transitionsLastHour = 0;
+    bool wasRunning = false;
+    double maxError = 0;
+    const int steps = 3 * 3600;
+    for (int t = 0; t < steps; t++)
+    {
+        int32_t measurement = (int32_t)lround(temp * 100.0);
+        uint16_t duty = fan.update(measurement, 1000);
+        temp += (45.0 - temp) / 600.0 - (duty / (double)FAN_DUTY_MAX) * (temp - 22.0) / 120.0;
+
+        if (t >= steps - 3600)
+        {
+            transitionsLastHour += fan.isRunning() != wasRunning ? 1 : 0;
+            maxError = fmax(maxError, fabs(temp - 28.0));
+        }
+        wasRunning = fan.isRunning();
+    }
+    char message[64];
+    snprintf(message, sizeof(message), "error máximo %.3f °C", maxError);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_INT(0, transitionsLastHour);
+    TEST_ASSERT_TRUE(fan.isRunning());
+    TEST_ASSERT_LESS_THAN(0.1, maxError);
+}
+
+void test_parse_fan_commands()
+{
+    FanCommand command;
+    TEST_ASSERT_TRUE(parseFanCommand("AUTO", command));
+    TEST_ASSERT_TRUE(command.automatic);
+
+    TEST_ASSERT_TRUE(parseFanCommand("ON", command));
+    TEST_ASSERT_FALSE(command.automatic);
+    TEST_ASSERT_EQUAL_UINT16(FAN_DUTY_MAX, command.duty);
+    TEST_ASSERT_TRUE(parseFanCommand("OFF", command));
+    TEST_ASSERT_EQUAL_UINT16(0, command.duty);
+
+    TEST_ASSERT_TRUE(parseFanCommand("0", command));
+    TEST_ASSERT_EQUAL_UINT16(0, command.duty);
+    TEST_ASSERT_TRUE(parseFanCommand("50", command));
+    TEST_ASSERT_EQUAL_UINT16(512, command.duty);
+    TEST_ASSERT_TRUE(parseFanCommand("100", command));
+    TEST_ASSERT_EQUAL_UINT16(FAN_DUTY_MAX, command.duty);
+}
+
+void test_parse_rejects_invalid_commands()
+{
+    const char *invalid[] = {"", "TOGGLE", "on", "AUTO ", " 50", "101", "1000", "5x", "-1", "OFFF"};
+    for (const char *text : invalid)
+    {
+        FanCommand command = {true, 123};
+        TEST_ASSERT_FALSE_MESSAGE(parseFanCommand(text, command), text);
+        TEST_ASSERT_TRUE(command.automatic && command.duty == 123); // Sin modificar
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_stays_off_below_setpoint);
+    RUN_TEST(test_unconfigured_controller_never_runs);
+    RUN_TEST(test_spin_up_then_run_duty);
+    RUN_TEST(test_proportional_term);
+    RUN_TEST(test_hysteresis_band);
+    RUN_TEST(test_anti_windup_releases_quickly);
+    RUN_TEST(test_integral_is_scaled_by_elapsed_time);
+    RUN_TEST(test_configure_keeps_running_state);
+    RUN_TEST(test_closed_loop_settles_at_setpoint);
+    RUN_TEST(test_parse_fan_commands);
+    RUN_TEST(test_parse_rejects_invalid_commands);
+    return UNITY_END();
+}
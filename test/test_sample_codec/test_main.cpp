@@ -0,0 +1,383 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas y medidas del códec del historial (SampleCodec).
+ * @details Las trazas imitan lo que registra el nodo: resolución de 0.1 °C y
+ * 0.1 % del DHT22, ruido de ±0.1 hPa del BMP280 y escalones de CO2 al abrir
+ * la cámara. Con `SAMPLE_TRACE=<archivo>` se mide además una traza grabada,
+ * en CSV con una muestra por línea: temperatura (°C), humedad (%), presión
+ * (hPa) y CO2 (ppm).
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "SampleCodec.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --- Trazas ---
+
+/** @brief Generador congruencial: las trazas son iguales en cada ejecución. */
+static uint32_t rngState = 1;
+static int32_t randomInt(int32_t range)
+{
+    rngState = rngState * 1664525u + 1013904223u;
+    return (int32_t)((rngState >> 8) % (uint32_t)(2 * range + 1)) - range;
+}
+
+static HistorySample makeSample(float temp, float hum, float pres, int co2)
+{
+    HistorySample sample;
+    sample.fields[FIELD_TEMPERATURE] = (int32_t)lroundf(temp * 100.0f);
+    sample.fields[FIELD_HUMIDITY] = (int32_t)lroundf(hum * 100.0f);
+    sample.fields[FIELD_PRESSURE] = (int32_t)lroundf(pres * 10.0f);
+    sample.fields[FIELD_CO2] = co2;
+    return sample;
+}
+
+/** @brief Cámara estable: los sensores oscilan en su último dígito. */
+static std::vector<HistorySample> stableTrace(size_t count)
+{
+    rngState = 1;
+    std::vector<HistorySample> trace;
+    for (size_t i = 0; i < count; i++)
+    {
+        trace.push_back(makeSample(25.0f + 0.1f * randomInt(1), 50.0f + 0.1f * randomInt(1),
+                                   1013.2f + 0.1f * randomInt(1), 600 + randomInt(3)));
+    }
+    return trace;
+}
+
+/** @brief Rampa de calentamiento: variación constante, deltas-de-delta nulos. */
+static std::vector<HistorySample> rampTrace(size_t count)
+{
+    std::vector<HistorySample> trace;
+    for (size_t i = 0; i < count; i++)
+    {
+        HistorySample sample;
+        sample.fields[FIELD_TEMPERATURE] = 2000 + 5 * (int32_t)i;
+        sample.fields[FIELD_HUMIDITY] = 6000 - 2 * (int32_t)i;
+        sample.fields[FIELD_PRESSURE] = 10132;
+        sample.fields[FIELD_CO2] = 400 + (int32_t)i;
+        trace.push_back(sample);
+    }
+    return trace;
+}
+
+/** @brief Aperturas de la cámara: escalón de CO2 y humedad con decaimiento. */
+static std::vector<HistorySample> transientTrace(size_t count)
+{
+    rngState = 7;
+    std::vector<HistorySample> trace;
+    float co2 = 450.0f;
+    float hum = 45.0f;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (i % 500 == 250)
+        {
+            co2 = 1500.0f;
+            hum = 70.0f;
+        }
+        co2 += (450.0f - co2) * 0.02f;
+        hum += (45.0f - hum) * 0.05f;
+        trace.push_back(makeSample(22.0f + 0.1f * randomInt(1), roundf(hum * 10.0f) / 10.0f,
+                                   1009.0f + 0.1f * randomInt(2), (int)co2 + randomInt(5)));
+    }
+    return trace;
+}
+
+/** @brief Lee una traza grabada en CSV; vacía si no se indicó o no existe. */
+static std::vector<HistorySample> recordedTrace(const char *path)
+{
+    std::vector<HistorySample> trace;
+    FILE *file = path != nullptr ? fopen(path, "r") : nullptr;
+    if (file == nullptr)
+    {
+        return trace;
+    }
+    char line[128];
+    while (fgets(line, sizeof(line), file) != nullptr)
+    {
+        float temp, hum, pres;
+        int co2;
+        if (sscanf(line, "%f,%f,%f,%d", &temp, &hum, &pres, &co2) == 4)
+        {
+            trace.push_back(makeSample(temp, hum, pres, co2));
+        }
+    }
+    fclose(file);
+    return trace;
+}
+
+// --- Flujo de bloques ---
+
+/** @brief Comprime una traza en bloques consecutivos, como HistoryLog. */
+static std::vector<uint8_t> encodeStream(const std::vector<HistorySample> &trace, size_t *blocks = nullptr)
+{
+    std::vector<uint8_t> stream;
+    SampleBlockEncoder encoder;
+    uint8_t block[CODEC_MAX_BLOCK_SIZE];
+    size_t blockCount = 0;
+    for (size_t i = 0; i <= trace.size(); i++)
+    {
+        bool last = i == trace.size();
+        if (last || !encoder.append(trace[i]))
+        {
+            size_t len = encoder.finalize(block, sizeof(block));
+            stream.insert(stream.end(), block, block + len);
+            blockCount += len > 0 ? 1 : 0;
+            encoder.reset();
+            if (!last)
+            {
+                encoder.append(trace[i]);
+            }
+        }
+    }
+    if (blocks != nullptr)
+    {
+        *blocks = blockCount;
+    }
+    return stream;
+}
+
+/**
+ * @brief Decodifica un flujo, resincronizando en el siguiente bloque válido.
+ * @param skipped Bytes descartados por corrupción.
+ */
+static std::vector<HistorySample> decodeStream(const std::vector<uint8_t> &stream, size_t *skipped = nullptr)
+{
+    std::vector<HistorySample> samples;
+    HistorySample block[CODEC_MAX_BLOCK_SAMPLES];
+    size_t offset = 0;
+    size_t lost = 0;
+    while (offset < stream.size())
+    {
+        size_t count = 0;
+        size_t used = decodeSampleBlock(&stream[offset], stream.size() - offset, block, CODEC_MAX_BLOCK_SAMPLES, &count);
+        if (used == 0)
+        {
+            size_t next = offset + 1 + findSampleBlock(&stream[offset + 1], stream.size() - offset - 1);
+            lost += next - offset;
+            offset = next;
+            continue;
+        }
+        samples.insert(samples.end(), block, block + count);
+        offset += used;
+    }
+    if (skipped != nullptr)
+    {
+        *skipped = lost;
+    }
+    return samples;
+}
+
+static void assertSameSamples(const std::vector<HistorySample> &expected, const std::vector<HistorySample> &actual)
+{
+    TEST_ASSERT_EQUAL_UINT(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        TEST_ASSERT_EQUAL_MEMORY(expected[i].fields, actual[i].fields, sizeof(expected[i].fields));
+    }
+}
+
+// --- Pruebas ---
+
+void test_round_trip_on_traces()
+{
+    const std::vector<HistorySample> traces[] = {stableTrace(3000), rampTrace(3000), transientTrace(3000)};
+    for (const std::vector<HistorySample> &trace : traces)
+    {
+        size_t skipped = 1;
+        assertSameSamples(trace, decodeStream(encodeStream(trace), &skipped));
+        TEST_ASSERT_EQUAL_UINT(0, skipped);
+    }
+}
+
+void test_round_trip_extreme_values()
+{
+    // Saltos de extremo a extremo: los deltas-de-delta no caben en 32 bits
+    std::vector<HistorySample> trace;
+    const int32_t values[] = {INT32_MAX, INT32_MIN, INT32_MAX, 0, -1, INT32_MIN, INT32_MIN, 1};
+    for (int32_t value : values)
+    {
+        HistorySample sample;
+        for (int i = 0; i < SAMPLE_FIELD_COUNT; i++)
+        {
+            sample.fields[i] = i % 2 == 0 ? value : -(value / 2);
+        }
+        trace.push_back(sample);
+    }
+    assertSameSamples(trace, decodeStream(encodeStream(trace)));
+}
+
+void test_block_limits()
+{
+    SampleBlockEncoder encoder;
+    uint8_t block[CODEC_MAX_BLOCK_SIZE];
+    TEST_ASSERT_EQUAL_UINT(0, encoder.finalize(block, sizeof(block))); // Bloque vacío
+
+    std::vector<HistorySample> trace = stableTrace(CODEC_MAX_BLOCK_SAMPLES + 1);
+    for (uint8_t i = 0; i < CODEC_MAX_BLOCK_SAMPLES; i++)
+    {
+        TEST_ASSERT_TRUE(encoder.append(trace[i]));
+    }
+    TEST_ASSERT_TRUE(encoder.isFull());
+    TEST_ASSERT_FALSE(encoder.append(trace[CODEC_MAX_BLOCK_SAMPLES]));
+    TEST_ASSERT_EQUAL_UINT8(CODEC_MAX_BLOCK_SAMPLES, encoder.count());
+
+    size_t len = encoder.finalize(block, sizeof(block));
+    TEST_ASSERT_GREATER_THAN(0, len);
+    TEST_ASSERT_EQUAL_UINT(0, encoder.finalize(block, len - 1)); // No cabe
+
+    // Sin sitio para todas las muestras, el decodificador rechaza el bloque
+    HistorySample out[CODEC_MAX_BLOCK_SAMPLES];
+    size_t count = 0;
+    TEST_ASSERT_EQUAL_UINT(0, decodeSampleBlock(block, len, out, CODEC_MAX_BLOCK_SAMPLES - 1, &count));
+    TEST_ASSERT_EQUAL_UINT(len, decodeSampleBlock(block, len, out, CODEC_MAX_BLOCK_SAMPLES, &count));
+}
+
+void test_finalize_keeps_block_open()
+{
+    std::vector<HistorySample> trace = stableTrace(10);
+    SampleBlockEncoder encoder;
+    uint8_t block[CODEC_MAX_BLOCK_SIZE];
+    HistorySample out[CODEC_MAX_BLOCK_SAMPLES];
+    size_t count = 0;
+
+    for (size_t i = 0; i < 5; i++)
+    {
+        encoder.append(trace[i]);
+    }
+    size_t len = encoder.finalize(block, sizeof(block));
+    TEST_ASSERT_EQUAL_UINT(len, decodeSampleBlock(block, len, out, CODEC_MAX_BLOCK_SAMPLES, &count));
+    TEST_ASSERT_EQUAL_UINT(5, count);
+
+    for (size_t i = 5; i < 10; i++)
+    {
+        encoder.append(trace[i]);
+    }
+    len = encoder.finalize(block, sizeof(block));
+    decodeSampleBlock(block, len, out, CODEC_MAX_BLOCK_SAMPLES, &count);
+    TEST_ASSERT_EQUAL_UINT(10, count);
+    assertSameSamples(trace, std::vector<HistorySample>(out, out + count));
+}
+
+void test_truncated_block_is_rejected()
+{
+    std::vector<HistorySample> trace = transientTrace(CODEC_MAX_BLOCK_SAMPLES);
+    std::vector<uint8_t> stream = encodeStream(trace);
+    HistorySample out[CODEC_MAX_BLOCK_SAMPLES];
+    for (size_t len = 0; len < stream.size(); len++)
+    {
+        size_t count = 0;
+        TEST_ASSERT_EQUAL_UINT(0, decodeSampleBlock(stream.data(), len, out, CODEC_MAX_BLOCK_SAMPLES, &count));
+        TEST_ASSERT_EQUAL_UINT(len, findSampleBlock(stream.data(), len));
+    }
+}
+
+void test_corrupt_block_resyncs_on_next_keyframe()
+{
+    std::vector<HistorySample> trace = transientTrace(4 * CODEC_MAX_BLOCK_SAMPLES);
+    size_t blocks = 0;
+    std::vector<uint8_t> stream = encodeStream(trace, &blocks);
+    TEST_ASSERT_EQUAL_UINT(4, blocks);
+
+    // Localiza el segundo bloque y corrompe un byte de su payload
+    HistorySample out[CODEC_MAX_BLOCK_SAMPLES];
+    size_t count = 0;
+    size_t second = decodeSampleBlock(stream.data(), stream.size(), out, CODEC_MAX_BLOCK_SAMPLES, &count);
+    size_t secondLen = decodeSampleBlock(&stream[second], stream.size() - second, out, CODEC_MAX_BLOCK_SAMPLES, &count);
+    TEST_ASSERT_GREATER_THAN(0, secondLen);
+    stream[second + CODEC_HEADER_SIZE + 3] ^= 0x10;
+
+    size_t skipped = 0;
+    std::vector<HistorySample> decoded = decodeStream(stream, &skipped);
+    TEST_ASSERT_EQUAL_UINT(secondLen, skipped);
+
+    // Se pierden solo las muestras del bloque dañado
+    std::vector<HistorySample> expected(trace.begin(), trace.begin() + CODEC_MAX_BLOCK_SAMPLES);
+    expected.insert(expected.end(), trace.begin() + 2 * CODEC_MAX_BLOCK_SAMPLES, trace.end());
+    assertSameSamples(expected, decoded);
+}
+
+void test_resync_after_garbage_prefix()
+{
+    std::vector<HistorySample> trace = stableTrace(2 * CODEC_MAX_BLOCK_SAMPLES);
+    std::vector<uint8_t> stream = encodeStream(trace);
+    // Basura con marcas de bloque falsas, como un flujo cortado a medias
+    const uint8_t garbage[] = {CODEC_BLOCK_MAGIC, 3, 0xFF, 0x01, CODEC_BLOCK_MAGIC, CODEC_BLOCK_MAGIC, 0x00, 0x42};
+    stream.insert(stream.begin(), garbage, garbage + sizeof(garbage));
+
+    TEST_ASSERT_EQUAL_UINT(sizeof(garbage), findSampleBlock(stream.data(), stream.size()));
+    size_t skipped = 0;
+    assertSameSamples(trace, decodeStream(stream, &skipped));
+    TEST_ASSERT_EQUAL_UINT(sizeof(garbage), skipped);
+}
+
+// --- Medidas ---
+
+/** @brief Comprime y descomprime una traza e imprime la tasa y el rendimiento. */
+static void benchmarkTrace(const char *name, const std::vector<HistorySample> &trace)
+{
+    typedef std::chrono::steady_clock Clock;
+    const int rounds = 20;
+    double rawBytes = (double)trace.size() * sizeof(HistorySample);
+
+    std::vector<uint8_t> stream;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < rounds; i++)
+    {
+        stream = encodeStream(trace);
+    }
+    double encodeSeconds = std::chrono::duration<double>(Clock::now() - start).count() / rounds;
+
+    std::vector<HistorySample> decoded;
+    start = Clock::now();
+    for (int i = 0; i < rounds; i++)
+    {
+        decoded = decodeStream(stream);
+    }
+    double decodeSeconds = std::chrono::duration<double>(Clock::now() - start).count() / rounds;
+
+    assertSameSamples(trace, decoded);
+    printf("%-12s %6zu muestras  %7zu B -> %6zu B  ratio %5.2f  %4.2f B/muestra  codif. %7.1f MB/s  decodif. %7.1f MB/s\n",
+           name, trace.size(), (size_t)rawBytes, stream.size(), rawBytes / stream.size(),
+           (double)stream.size() / trace.size(), rawBytes / encodeSeconds / 1e6, rawBytes / decodeSeconds / 1e6);
+}
+
+void test_benchmark_compression()
+{
+    benchmarkTrace("estable", stableTrace(20000));
+    benchmarkTrace("rampa", rampTrace(20000));
+    benchmarkTrace("aperturas", transientTrace(20000));
+
+    const char *path = getenv("SAMPLE_TRACE");
+    std::vector<HistorySample> recorded = recordedTrace(path);
+    if (!recorded.empty())
+    {
+        benchmarkTrace("grabada", recorded);
+    }
+    else if (path != nullptr)
+    {
+        TEST_FAIL_MESSAGE("SAMPLE_TRACE no tiene muestras");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_on_traces);
+    RUN_TEST(test_round_trip_extreme_values);
+    RUN_TEST(test_block_limits);
+    RUN_TEST(test_finalize_keeps_block_open);
+    RUN_TEST(test_truncated_block_is_rejected);
+    RUN_TEST(test_corrupt_block_resyncs_on_next_keyframe);
+    RUN_TEST(test_resync_after_garbage_prefix);
+    RUN_TEST(test_benchmark_compression);
+    return UNITY_END();
+}
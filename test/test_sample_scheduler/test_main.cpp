@@ -0,0 +1,361 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del muestreo alineado y simulación de varios nodos con deriva.
+ * @details La simulación avanza el tiempo real en pasos de 1 ms (la vuelta
+ * del bucle principal). Cada nodo tiene su propio oscilador con deriva y
+ * desfase de arranque, recibe la hora del cliente cada 10 minutos con la
+ * latencia de una escritura BLE y muestrea con `SampleScheduler` igual que
+ * `loop()`. Se comprueba que todos los nodos toman las mismas muestras de la
+ * rejilla, sin huecos ni duplicados, y que un retroceso de la hora del
+ * cliente no los deja sin muestrear.
+ */
+
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "TimeBase.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+/** @brief Hora de pared de referencia: 2026-01-01T00:00:00Z en µs. */
+static const int64_t EPOCH_US = 1767225600LL * 1000000;
+static const int64_t SECOND_US = 1000000;
+static const int64_t MINUTE_US = 60 * SECOND_US;
+
+static uint32_t lcgState = 1;
+
+/** @brief Número pseudoaleatorio determinista en [0, range). */
+static int64_t randomBelow(int64_t range)
+{
+    lcgState = lcgState * 1664525u + 1013904223u;
+    return (int64_t)(lcgState >> 8) % range;
+}
+
+/**
+ * @struct SimNode
+ * @brief Un nodo simulado: oscilador, sincronización y muestreo como en `loop()`.
+ */
+struct SimNode
+{
+    double driftPpm;      // Positivo = el reloj local atrasa
+    uint64_t bootLocalUs; // Lectura local en el instante real `EPOCH_US`
+    ClockSync sync;
+    SampleScheduler scheduler;
+
+    // Escritura de sincronización en vuelo
+    bool syncInFlight;
+    int64_t syncArrivalUs; // Instante real en que llega al nodo
+    int64_t syncWallUs;    // Hora del cliente que lleva
+
+    std::vector<int64_t> grid;       // Instante de la rejilla de cada muestra alineada
+    std::vector<int64_t> trueTimeUs; // Instante real en que se tomó
+    uint32_t resets;
+    int64_t lastResetUs; // Instante real del último reinicio de la sincronización
+
+    SimNode(double ppm, uint64_t boot)
+        : driftPpm(ppm), bootLocalUs(boot), syncInFlight(false), syncArrivalUs(0), syncWallUs(0), resets(0),
+          lastResetUs(-1)
+    {
+    }
+
+    uint64_t localAt(int64_t trueUs) const
+    {
+        double elapsed = (double)(trueUs - EPOCH_US);
+        return bootLocalUs + (uint64_t)llround(elapsed / (1.0 + driftPpm * 1e-6));
+    }
+
+    /** @brief Una vuelta del bucle principal en el instante real `trueUs`. */
+    void step(int64_t trueUs)
+    {
+        uint64_t now = localAt(trueUs);
+        if (syncInFlight && trueUs >= syncArrivalUs)
+        {
+            syncInFlight = false;
+            if (!sync.addPoint(now, syncWallUs))
+            {
+                scheduler.resetGrid(); // Como ESP_Server.cpp
+                resets++;
+                lastResetUs = trueUs;
+            }
+        }
+        if (scheduler.poll(now, sync))
+        {
+            int64_t wall = sync.toWallUs(now);
+            scheduler.recordSample(wall);
+            if (scheduler.hasPhaseError())
+            {
+                grid.push_back(wall - scheduler.getPhaseErrorUs());
+                trueTimeUs.push_back(trueUs);
+            }
+        }
+    }
+};
+
+/**
+ * @brief Simula los nodos entre `from` y `to` (tiempo real).
+ * @param clientOffsetUs Hora del cliente menos la hora real.
+ */
+static void simulate(std::vector<SimNode> &nodes, int64_t from, int64_t to, int64_t clientOffsetUs,
+                     int64_t syncEveryUs = 10 * MINUTE_US)
+{
+    for (int64_t t = from; t < to; t += 1000)
+    {
+        if ((t - EPOCH_US) % syncEveryUs == 0)
+        {
+            for (SimNode &node : nodes)
+            {
+                node.syncInFlight = true;
+                node.syncArrivalUs = t + randomBelow(30000); // Latencia BLE de 0 a 30 ms
+                node.syncWallUs = t + clientOffsetUs;
+            }
+        }
+        for (SimNode &node : nodes)
+        {
+            node.step(t);
+        }
+    }
+}
+
+/** @brief Índice de la primera muestra de `node` con instante de rejilla >= `fromGrid`. */
+static size_t firstSampleFrom(const SimNode &node, int64_t fromGrid)
+{
+    size_t i = 0;
+    while (i < node.grid.size() && node.grid[i] < fromGrid)
+    {
+        i++;
+    }
+    return i;
+}
+
+// --- Pruebas unitarias ---
+
+void test_free_running_without_sync()
+{
+    ClockSync sync;
+    SampleScheduler scheduler;
+    scheduler.setPeriodUs(5 * SECOND_US);
+    TEST_ASSERT_TRUE(scheduler.poll(1000, sync)); // La primera muestra es inmediata
+    scheduler.recordSample(-1);
+    TEST_ASSERT_FALSE(scheduler.hasPhaseError());
+    TEST_ASSERT_FALSE(scheduler.poll(1000 + 5 * SECOND_US - 1, sync));
+    TEST_ASSERT_TRUE(scheduler.poll(1000 + 5 * SECOND_US, sync));
+}
+
+void test_aligns_to_wall_grid()
+{
+    ClockSync sync;
+    sync.addPoint(10 * SECOND_US, EPOCH_US + 1234567); // Hora de pared a mitad de periodo
+    SampleScheduler scheduler;
+    scheduler.setPeriodUs(5 * SECOND_US);
+
+    // Siguiente múltiplo de 5 s: EPOCH + 5 s, es decir local 10 s + 3.765433 s
+    uint64_t due = 10 * SECOND_US + 5 * SECOND_US - 1234567;
+    TEST_ASSERT_FALSE(scheduler.poll(due - 1, sync));
+    TEST_ASSERT_TRUE(scheduler.poll(due, sync));
+    scheduler.recordSample(sync.toWallUs(due));
+    TEST_ASSERT_TRUE(scheduler.hasPhaseError());
+    TEST_ASSERT_EQUAL_INT64(0, scheduler.getPhaseErrorUs());
+    TEST_ASSERT_FALSE(scheduler.poll(due + 5 * SECOND_US - 1, sync));
+    TEST_ASSERT_TRUE(scheduler.poll(due + 5 * SECOND_US, sync));
+}
+
+void test_missed_instants_are_skipped()
+{
+    ClockSync sync;
+    sync.addPoint(0, EPOCH_US);
+    SampleScheduler scheduler;
+    scheduler.setPeriodUs(SECOND_US);
+    TEST_ASSERT_FALSE(scheduler.poll(SECOND_US / 2, sync)); // Fija la rejilla en EPOCH + 1 s
+    TEST_ASSERT_TRUE(scheduler.poll(SECOND_US, sync));
+
+    // Calibración de 3.5 s: una sola muestra al volver, en el siguiente instante
+    TEST_ASSERT_FALSE(scheduler.poll(SECOND_US * 9 / 2, sync));
+    TEST_ASSERT_TRUE(scheduler.poll(5 * SECOND_US, sync));
+    TEST_ASSERT_FALSE(scheduler.poll(5 * SECOND_US + 1, sync));
+}
+
+void test_backward_step_reanchors_without_reset()
+{
+    ClockSync sync;
+    sync.addPoint(0, EPOCH_US);
+    SampleScheduler scheduler;
+    scheduler.setPeriodUs(SECOND_US);
+    TEST_ASSERT_FALSE(scheduler.poll(SECOND_US / 2, sync)); // Fija la rejilla en EPOCH + 1 s
+    TEST_ASSERT_TRUE(scheduler.poll(SECOND_US, sync));
+
+    // El cliente retrocede una hora; aunque nadie llame a resetGrid(), la
+    // rejilla se vuelve a fijar en vez de esperar a recuperar la hora
+    sync.addPoint(SECOND_US + 500000, EPOCH_US - 3600 * SECOND_US);
+    TEST_ASSERT_FALSE(scheduler.poll(SECOND_US + 500001, sync));
+    TEST_ASSERT_TRUE(scheduler.poll(2 * SECOND_US + 500000, sync));
+    scheduler.recordSample(sync.toWallUs(2 * SECOND_US + 500000));
+    TEST_ASSERT_EQUAL_INT64(0, scheduler.getPhaseErrorUs());
+}
+
+void test_small_backward_step_does_not_duplicate()
+{
+    ClockSync sync;
+    sync.addPoint(0, EPOCH_US);
+    SampleScheduler scheduler;
+    scheduler.setPeriodUs(SECOND_US);
+    TEST_ASSERT_FALSE(scheduler.poll(SECOND_US / 2, sync)); // Fija la rejilla en EPOCH + 1 s
+    TEST_ASSERT_TRUE(scheduler.poll(SECOND_US, sync));
+
+    // Retroceso de 0.4 s (menos de un periodo): el ajuste lo reparte entre los
+    // dos puntos y se espera al instante siguiente, EPOCH + 2 s
+    sync.addPoint(SECOND_US + 100000, EPOCH_US + SECOND_US - 300000);
+    int64_t offset = sync.toWallUs(0) - EPOCH_US;
+    TEST_ASSERT_LESS_THAN(0, offset);
+    uint64_t due = (uint64_t)(2 * SECOND_US - offset);
+    TEST_ASSERT_FALSE(scheduler.poll(SECOND_US + 100000, sync));
+    TEST_ASSERT_FALSE(scheduler.poll(due - 1, sync));
+    TEST_ASSERT_TRUE(scheduler.poll(due, sync));
+}
+
+void test_reset_grid_and_period_change()
+{
+    ClockSync sync;
+    sync.addPoint(0, EPOCH_US);
+    SampleScheduler scheduler;
+    scheduler.setPeriodUs(SECOND_US);
+    TEST_ASSERT_FALSE(scheduler.poll(SECOND_US / 2, sync)); // Fija la rejilla en EPOCH + 1 s
+    TEST_ASSERT_TRUE(scheduler.poll(SECOND_US, sync));
+
+    scheduler.resetGrid();
+    scheduler.recordSample(EPOCH_US + SECOND_US);
+    TEST_ASSERT_FALSE(scheduler.hasPhaseError()); // La muestra ya no tiene instante de rejilla
+
+    scheduler.setPeriodUs(10 * SECOND_US);
+    TEST_ASSERT_FALSE(scheduler.poll(9 * SECOND_US, sync));
+    TEST_ASSERT_TRUE(scheduler.poll(10 * SECOND_US, sync));
+}
+
+void test_describe_format()
+{
+    SampleScheduler scheduler;
+    char text[24];
+    scheduler.describe(text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("PHASE=NA", text);
+
+    ClockSync sync;
+    sync.addPoint(0, EPOCH_US);
+    scheduler.setPeriodUs(SECOND_US);
+    scheduler.poll(SECOND_US / 2, sync);
+    scheduler.poll(SECOND_US, sync);
+    scheduler.recordSample(EPOCH_US + SECOND_US + 1200);
+    size_t len = scheduler.describe(text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("PHASE=+1.2ms", text);
+    TEST_ASSERT_EQUAL_UINT(strlen(text), len);
+}
+
+// --- Simulación de varios nodos ---
+
+void test_nodes_with_drift_sample_the_same_instants()
+{
+    lcgState = 2024;
+    std::vector<SimNode> nodes;
+    nodes.emplace_back(-80.0, 3 * SECOND_US);
+    nodes.emplace_back(-10.0, 917 * SECOND_US);
+    nodes.emplace_back(45.0, 12 * 3600 * SECOND_US);
+    nodes.emplace_back(120.0, 5 * 24 * 3600 * SECOND_US + 333333);
+    for (SimNode &node : nodes)
+    {
+        node.scheduler.setPeriodUs(5 * SECOND_US);
+    }
+
+    const int64_t end = EPOCH_US + 2 * 3600 * SECOND_US;
+    simulate(nodes, EPOCH_US, end, 0);
+
+    // Tras la primera hora la deriva ya está estimada en todos los nodos
+    const int64_t settled = EPOCH_US + 3600 * SECOND_US;
+    const size_t expected = (size_t)((end - settled) / (5 * SECOND_US)) - 1;
+    int64_t maxTrueError = 0;
+    for (size_t n = 0; n < nodes.size(); n++)
+    {
+        const SimNode &node = nodes[n];
+        size_t first = firstSampleFrom(node, settled);
+        TEST_ASSERT_GREATER_OR_EQUAL(expected, node.grid.size() - first);
+        for (size_t i = first; i < node.grid.size(); i++)
+        {
+            // Mismo instante de la rejilla en todos los nodos, sin huecos ni duplicados
+            TEST_ASSERT_EQUAL_INT64(settled + (int64_t)(i - first) * 5 * SECOND_US, node.grid[i]);
+            maxTrueError = llabs(node.trueTimeUs[i] - node.grid[i]) > maxTrueError
+                               ? llabs(node.trueTimeUs[i] - node.grid[i])
+                               : maxTrueError;
+        }
+        TEST_ASSERT_EQUAL_UINT32(0, node.resets);
+        char message[64];
+        snprintf(message, sizeof(message), "nodo %u: deriva real %+.0f ppm, estimada %+.1f ppm", (unsigned)n,
+                 node.driftPpm, node.sync.getDriftPpm());
+        TEST_MESSAGE(message);
+    }
+
+    char message[80];
+    snprintf(message, sizeof(message), "error máximo respecto a la rejilla real: %.1f ms", maxTrueError / 1000.0);
+    TEST_MESSAGE(message);
+    // Latencia BLE (hasta 30 ms) más la vuelta del bucle (1 ms)
+    TEST_ASSERT_LESS_THAN(35000, maxTrueError);
+}
+
+void test_nodes_recover_from_client_stepping_back()
+{
+    lcgState = 77;
+    std::vector<SimNode> nodes;
+    nodes.emplace_back(-30.0, 0);
+    nodes.emplace_back(60.0, 42 * SECOND_US);
+    for (SimNode &node : nodes)
+    {
+        node.scheduler.setPeriodUs(5 * SECOND_US);
+    }
+
+    const int64_t stepAt = EPOCH_US + 3600 * SECOND_US;
+    simulate(nodes, EPOCH_US, stepAt, 0);
+
+    // El cliente corrige su hora una hora hacia atrás y sincroniza de inmediato
+    simulate(nodes, stepAt, stepAt + 10 * MINUTE_US, -3600 * SECOND_US);
+
+    for (SimNode &node : nodes)
+    {
+        TEST_ASSERT_EQUAL_UINT32(1, node.resets);
+        // Primera muestra con la hora nueva: como mucho un periodo (más una vuelta del bucle) después
+        size_t i = 0;
+        while (i < node.trueTimeUs.size() && node.trueTimeUs[i] <= node.lastResetUs)
+        {
+            i++;
+        }
+        TEST_ASSERT_TRUE(i < node.trueTimeUs.size());
+        TEST_ASSERT_LESS_OR_EQUAL(node.lastResetUs + 5 * SECOND_US + 1000, node.trueTimeUs[i]);
+        TEST_ASSERT_LESS_THAN(stepAt - 3600 * SECOND_US + 10 * SECOND_US, node.grid[i]);
+
+        // A partir de ahí, una muestra por periodo en la rejilla nueva
+        for (size_t k = i + 1; k < node.grid.size(); k++)
+        {
+            TEST_ASSERT_EQUAL_INT64(node.grid[k - 1] + 5 * SECOND_US, node.grid[k]);
+        }
+    }
+    // Los dos nodos comparten la rejilla nueva (el último instante puede caer a un lado u otro del final)
+    const int64_t middle = stepAt - 3600 * SECOND_US + 5 * MINUTE_US;
+    for (SimNode &node : nodes)
+    {
+        TEST_ASSERT_EQUAL_INT64(middle, node.grid[firstSampleFrom(node, middle)]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_free_running_without_sync);
+    RUN_TEST(test_aligns_to_wall_grid);
+    RUN_TEST(test_missed_instants_are_skipped);
+    RUN_TEST(test_backward_step_reanchors_without_reset);
+    RUN_TEST(test_small_backward_step_does_not_duplicate);
+    RUN_TEST(test_reset_grid_and_period_change);
+    RUN_TEST(test_describe_format);
+    RUN_TEST(test_nodes_with_drift_sample_the_same_instants);
+    RUN_TEST(test_nodes_recover_from_client_stepping_back);
+    return UNITY_END();
+}
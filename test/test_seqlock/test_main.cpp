@@ -0,0 +1,168 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del seqlock con un escritor y varios lectores concurrentes.
+ * @details Cada registro publicado es coherente por construcción (todas sus
+ * palabras se derivan del mismo contador), así que un lector que vea una
+ * mezcla de dos escrituras lo detecta. Los hilos del host sustituyen a la
+ * tarea del sensor y a la tarea de la pila BLE.
+ */
+
+#include <unity.h>
+#include <atomic>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+#include "Seqlock.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+/** @brief Registro de prueba del tamaño de una instantánea de muestras. */
+struct Record
+{
+    uint32_t counter;
+    uint32_t words[14];
+    uint32_t check; // counter ^ 0xA5A5A5A5
+};
+
+static Record makeRecord(uint32_t counter)
+{
+    Record record;
+    record.counter = counter;
+    for (uint32_t i = 0; i < 14; i++)
+    {
+        record.words[i] = counter * 2654435761u + i;
+    }
+    record.check = counter ^ 0xA5A5A5A5u;
+    return record;
+}
+
+static bool isCoherent(const Record &record)
+{
+    if (record.check != (record.counter ^ 0xA5A5A5A5u))
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < 14; i++)
+    {
+        if (record.words[i] != record.counter * 2654435761u + i)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_initial_value_is_zero()
+{
+    Seqlock<Record> lock;
+    Record record = makeRecord(7);
+    TEST_ASSERT_TRUE(lock.read(record));
+    TEST_ASSERT_EQUAL_UINT32(0, record.counter);
+    TEST_ASSERT_EQUAL_UINT32(0, lock.getWriteCount());
+}
+
+void test_single_thread_round_trip()
+{
+    Seqlock<Record> lock;
+    for (uint32_t n = 1; n <= 100; n++)
+    {
+        lock.write(makeRecord(n));
+        Record record;
+        TEST_ASSERT_TRUE(lock.read(record));
+        TEST_ASSERT_EQUAL_UINT32(n, record.counter);
+        TEST_ASSERT_TRUE(isCoherent(record));
+    }
+    TEST_ASSERT_EQUAL_UINT32(100, lock.getWriteCount());
+}
+
+void test_failed_read_leaves_destination()
+{
+    Seqlock<Record> lock;
+    Record record = makeRecord(3);
+    TEST_ASSERT_FALSE(lock.read(record, 0));
+    TEST_ASSERT_EQUAL_UINT32(3, record.counter);
+}
+
+void test_concurrent_readers_never_see_torn_records()
+{
+    static Seqlock<Record> lock;
+    const uint32_t writes = 2000000;
+    const int readers = 3;
+    std::atomic<bool> done(false);
+    std::atomic<uint32_t> torn(0);
+    std::atomic<uint32_t> backwards(0);
+    std::vector<uint32_t> successes(readers, 0);
+    std::vector<uint32_t> failures(readers, 0);
+
+    // El registro inicial (todo ceros) no sigue el patrón: se publica el 0 antes
+    lock.write(makeRecord(0));
+
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; r++)
+    {
+        threads.emplace_back([&, r]() {
+            uint32_t last = 0;
+            while (!done.load(std::memory_order_acquire))
+            {
+                Record record;
+                if (!lock.read(record))
+                {
+                    failures[r]++;
+                    continue;
+                }
+                successes[r]++;
+                if (!isCoherent(record))
+                {
+                    torn++;
+                }
+                if (record.counter < last)
+                {
+                    backwards++; // Un solo escritor: el contador nunca retrocede
+                }
+                last = record.counter;
+            }
+        });
+    }
+
+    for (uint32_t n = 1; n < writes; n++)
+    {
+        lock.write(makeRecord(n));
+    }
+    done.store(true, std::memory_order_release);
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    uint32_t totalSuccesses = 0;
+    uint32_t totalFailures = 0;
+    for (int r = 0; r < readers; r++)
+    {
+        totalSuccesses += successes[r];
+        totalFailures += failures[r];
+    }
+    char message[96];
+    snprintf(message, sizeof(message), "%u escrituras, %u lecturas coherentes, %u lecturas agotadas", writes,
+             totalSuccesses, totalFailures);
+    TEST_MESSAGE(message);
+
+    TEST_ASSERT_EQUAL_UINT32(0, torn.load());
+    TEST_ASSERT_EQUAL_UINT32(0, backwards.load());
+    TEST_ASSERT_GREATER_THAN(0, totalSuccesses);
+    TEST_ASSERT_EQUAL_UINT32(writes, lock.getWriteCount());
+
+    Record record;
+    TEST_ASSERT_TRUE(lock.read(record));
+    TEST_ASSERT_EQUAL_UINT32(writes - 1, record.counter);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_initial_value_is_zero);
+    RUN_TEST(test_single_thread_round_trip);
+    RUN_TEST(test_failed_read_leaves_destination);
+    RUN_TEST(test_concurrent_readers_never_see_torn_records);
+    return UNITY_END();
+}
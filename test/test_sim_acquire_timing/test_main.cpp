@@ -0,0 +1,144 @@
+/**
+ * @file test_main.cpp
+ * @brief Duración del ciclo de adquisición (`SensorSet::acquire()`) con los
+ * drivers reales sobre la placa virtual del host.
+ * @details La placa virtual cobra el tiempo de cada transacción (DHT22 ~5 ms,
+ * conversión del BMP280 37.5 ms, tramas del MH-Z19C a 9600 baudios), así que
+ * las duraciones medidas son las del hardware salvo el coste de la CPU. Al
+ * solaparse las medidas, el ciclo completo debe durar lo que el sensor más
+ * lento y no la suma de todos. Cada prueba imprime los tiempos medidos.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include "HostBoard.h"
+#include "BoardConfig.h"
+#include "MockSensorDriver.h"
+
+typedef Dht22Driver<25> Dht;
+typedef Bmp280Driver<0x76> Bmp;
+typedef MhZ19cDriver<16, 17> Co2;
+
+static const uint32_t OVERHEAD_US = 3000; // Transacciones I2C y comprobaciones entre medidas
+
+void setUp(void)
+{
+    hostBoard().dht.connected = true;
+    hostBoard().bmp.present = true;
+    hostBoard().co2.connected = true;
+}
+
+void tearDown(void) {}
+
+/**
+ * @brief Adquiere una muestra tras dejar pasar la caché de 2 s de la librería DHT.
+ * @return unsigned long Duración del ciclo en microsegundos.
+ */
+template <typename Set>
+static unsigned long timedAcquire(Set &sensors)
+{
+    hostBoard().advance(2500000);
+    SensorData data;
+    sensors.acquire(data);
+    return sensors.lastAcquireMicros();
+}
+
+/**
+ * @brief Duración de un ciclo con un único driver.
+ */
+template <typename Driver>
+static unsigned long aloneMicros()
+{
+    SensorSet<Driver> sensors;
+    sensors.begin();
+    return timedAcquire(sensors);
+}
+
+void test_cycle_lasts_as_long_as_the_slowest_mock_sensor(void)
+{
+    typedef SensorSet<MockSensorDriver<SENSOR_TEMP_HUMIDITY, 'T'>, MockSensorDriver<SENSOR_PRESSURE, 'P'>,
+                      MockSensorDriver<SENSOR_CO2, 'C'>> Mocks;
+    Mocks sensors;
+    sensors.get<SENSOR_TEMP_HUMIDITY>().conversionUs = 30000;
+    sensors.get<SENSOR_PRESSURE>().conversionUs = 10000;
+    sensors.get<SENSOR_CO2>().conversionUs = 20000;
+    sensors.begin();
+
+    unsigned long cycleUs = timedAcquire(sensors);
+    printf("Drivers falsos de 30, 10 y 20 ms: ciclo de %.2f ms\n", cycleUs / 1000.0);
+    TEST_ASSERT_UINT32_WITHIN(500, 30000, cycleUs);
+}
+
+void test_board_cycle_lasts_as_long_as_the_slowest_sensor(void)
+{
+    unsigned long dhtUs = aloneMicros<Dht>();
+    unsigned long bmpUs = aloneMicros<Bmp>();
+    unsigned long co2Us = aloneMicros<Co2>();
+    unsigned long slowestUs = max(dhtUs, max(bmpUs, co2Us));
+    unsigned long sumUs = dhtUs + bmpUs + co2Us;
+
+    BoardSensors sensors;
+    sensors.begin();
+    unsigned long cycleUs = timedAcquire(sensors);
+    printf("DHT22 %.2f ms, BMP280 %.2f ms, MH-Z19C %.2f ms (suma %.2f ms): ciclo de %.2f ms\n",
+           dhtUs / 1000.0, bmpUs / 1000.0, co2Us / 1000.0, sumUs / 1000.0, cycleUs / 1000.0);
+
+    TEST_ASSERT_GREATER_OR_EQUAL(slowestUs, cycleUs);
+    TEST_ASSERT_LESS_OR_EQUAL(slowestUs + OVERHEAD_US, cycleUs);
+    TEST_ASSERT_LESS_THAN(sumUs - OVERHEAD_US, cycleUs);
+}
+
+void test_board_cycle_is_stable_across_samples(void)
+{
+    BoardSensors sensors;
+    sensors.begin();
+
+    unsigned long minUs = ~0UL;
+    unsigned long maxUs = 0;
+    double totalUs = 0;
+    const int CYCLES = 50;
+    for (int i = 0; i < CYCLES; i++)
+    {
+        unsigned long cycleUs = timedAcquire(sensors);
+        minUs = min(minUs, cycleUs);
+        maxUs = max(maxUs, cycleUs);
+        totalUs += cycleUs;
+    }
+    printf("%d ciclos: mínimo %.2f ms, media %.2f ms, máximo %.2f ms\n",
+           CYCLES, minUs / 1000.0, totalUs / CYCLES / 1000.0, maxUs / 1000.0);
+    TEST_ASSERT_LESS_OR_EQUAL(hostBoard().bmp.conversionUs + OVERHEAD_US, maxUs);
+    TEST_ASSERT_LESS_OR_EQUAL(1000, maxUs - minUs);
+}
+
+void test_a_timeout_replaces_the_slowest_sensor_instead_of_adding_to_it(void)
+{
+    BoardSensors sensors;
+    sensors.begin();
+    unsigned long healthyUs = timedAcquire(sensors);
+
+    hostBoard().co2.connected = false;
+    unsigned long timeoutUs = timedAcquire(sensors);
+    printf("Ciclo normal %.2f ms; con el MH-Z19C sin responder %.2f ms\n", healthyUs / 1000.0, timeoutUs / 1000.0);
+    // El timeout del MH-Z19C (150 ms) cubre la conversión del BMP280.
+    TEST_ASSERT_GREATER_THAN(Co2::TIMEOUT_MS * 1000, timeoutUs);
+    TEST_ASSERT_LESS_OR_EQUAL(Co2::TIMEOUT_MS * 1000 + OVERHEAD_US, timeoutUs);
+
+    // En fallo y esperando reintento, el ciclo vuelve a durar lo del BMP280.
+    timedAcquire(sensors);
+    timedAcquire(sensors); // Tercer fallo: entra en fallo con el reintento vencido
+    timedAcquire(sensors); // Reintento, otra vez con timeout
+    SensorData data;
+    sensors.acquire(data); // Antes del siguiente reintento, a 1 s
+    TEST_ASSERT_TRUE(sensors.faultMask() & (1 << SENSOR_CO2));
+    TEST_ASSERT_UINT32_WITHIN(OVERHEAD_US, healthyUs, sensors.lastAcquireMicros());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_cycle_lasts_as_long_as_the_slowest_mock_sensor);
+    RUN_TEST(test_board_cycle_lasts_as_long_as_the_slowest_sensor);
+    RUN_TEST(test_board_cycle_is_stable_across_samples);
+    RUN_TEST(test_a_timeout_replaces_the_slowest_sensor_instead_of_adding_to_it);
+    return UNITY_END();
+}
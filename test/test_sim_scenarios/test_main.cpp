@@ -0,0 +1,99 @@
+/**
+ * @file test_main.cpp
+ * @brief Escenarios del nodo completo en el simulador del host (`pio test -e sim`).
+ * @details Cada prueba ejecuta `setup()`/`loop()` del firmware frente a un
+ * escenario de test/scenarios, en un proceso hijo (ver NodeSim). Además de
+ * las comprobaciones del escenario, fallan las invariantes del simulador y
+ * los límites de las métricas; el resumen de métricas se imprime siempre.
+ * Con `NODE_SIM_ECHO=1` se ve la consola del firmware.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string>
+#include "NodeSim.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+/**
+ * @brief Ejecuta un escenario y falla con su primer fallo.
+ * @param file Nombre del archivo en `SIM_SCENARIO_DIR`.
+ */
+static void runScenario(const char *file)
+{
+    std::string path = std::string(SIM_SCENARIO_DIR) + "/" + file;
+    SimReport report = NodeSim::runIsolated(path.c_str());
+    printf("%s\n", report.describe().c_str());
+    TEST_ASSERT_TRUE_MESSAGE(report.passed(), report.passed() ? "" : report.failures.front().c_str());
+}
+
+void test_boot_and_steady_sampling(void)
+{
+    runScenario("boot_steady.txt");
+}
+
+void test_ble_client_config_and_time_sync(void)
+{
+    runScenario("ble_client.txt");
+}
+
+void test_config_saved_in_nvs(void)
+{
+    runScenario("config_from_nvs.txt");
+}
+
+void test_co2_sensor_fault_and_recovery(void)
+{
+    runScenario("co2_fault.txt");
+}
+
+void test_i2c_bus_faults(void)
+{
+    runScenario("i2c_faults.txt");
+}
+
+void test_zero_calibration(void)
+{
+    runScenario("calibration.txt");
+}
+
+void test_stable_chamber_is_not_a_frozen_sensor(void)
+{
+    runScenario("stable_chamber.txt");
+}
+
+void test_frozen_co2_sensor_is_detected(void)
+{
+    runScenario("co2_frozen.txt");
+}
+
+/**
+ * @brief Un escenario mal escrito se rechaza antes de arrancar el firmware.
+ */
+void test_invalid_scenario_is_rejected(void)
+{
+    std::string error;
+    TEST_ASSERT_FALSE(NodeSim().parse("duration 10s\nat 1s fault lcd absent\n", error));
+    TEST_ASSERT_TRUE(error.find("línea 2") != std::string::npos);
+    TEST_ASSERT_FALSE(NodeSim().parse("at 1s connect\n", error)); // Sin duración
+    TEST_ASSERT_FALSE(NodeSim().parse("duration 10s\nat 11s disconnect\n", error));
+    TEST_ASSERT_FALSE(NodeSim().parse("duration 10s\nenv temp=calor\n", error));
+    TEST_ASSERT_FALSE(NodeSim().parse("duration 10s\nat 1s read config 500\n", error)); // Falta `contains`
+    TEST_ASSERT_TRUE(NodeSim().parse("duration 10s\nat 1s read config contains UPDATE_MS=500\n", error));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_boot_and_steady_sampling);
+    RUN_TEST(test_ble_client_config_and_time_sync);
+    RUN_TEST(test_config_saved_in_nvs);
+    RUN_TEST(test_co2_sensor_fault_and_recovery);
+    RUN_TEST(test_i2c_bus_faults);
+    RUN_TEST(test_zero_calibration);
+    RUN_TEST(test_stable_chamber_is_not_a_frozen_sensor);
+    RUN_TEST(test_frozen_co2_sensor_is_detected);
+    RUN_TEST(test_invalid_scenario_is_rejected);
+    return UNITY_END();
+}
@@ -0,0 +1,271 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas del modelo de salud de los drivers (`SensorDriver`) con un driver falso.
+ * @details Recorren la máquina de estados de cada sensor: fallos seguidos
+ * hasta el fallo, reintentos con espera exponencial, recuperación y detección
+ * de valores congelados por tiempo. Cada ciclo de muestreo avanza el reloj
+ * virtual de la placa del host hasta el periodo indicado.
+ */
+
+#include <unity.h>
+#include <vector>
+#include "HostBoard.h"
+#include "MockSensorDriver.h"
+
+typedef MockSensorDriver<SENSOR_CO2, 'C'> MockCo2;
+typedef SensorSet<MockCo2> Sensors;
+
+static const uint32_t PERIOD_MS = 500;
+
+void setUp(void)
+{
+    mockSensorLog().clear();
+}
+
+void tearDown(void) {}
+
+/**
+ * @brief Adquiere una muestra y espera al inicio del periodo siguiente.
+ * @return SensorData La muestra adquirida.
+ */
+static SensorData cycle(Sensors &sensors, uint32_t periodMs = PERIOD_MS)
+{
+    uint64_t start = hostBoard().nowUs();
+    SensorData data;
+    sensors.acquire(data);
+    uint64_t next = start + (uint64_t)periodMs * 1000;
+    if (hostBoard().nowUs() < next)
+    {
+        hostBoard().advance(next - hostBoard().nowUs());
+    }
+    return data;
+}
+
+/**
+ * @brief Ejecuta ciclos durante `ms` milisegundos de tiempo virtual.
+ */
+static void runFor(Sensors &sensors, uint32_t ms, uint32_t periodMs = PERIOD_MS)
+{
+    for (uint32_t elapsed = 0; elapsed < ms; elapsed += periodMs)
+    {
+        cycle(sensors, periodMs);
+    }
+}
+
+void test_three_consecutive_failures_mark_the_sensor_faulty(void)
+{
+    Sensors sensors;
+    sensors.begin();
+    sensors.get<SENSOR_CO2>().valid = false;
+    uint64_t since = hostBoard().nowUs();
+
+    cycle(sensors);
+    cycle(sensors);
+    TEST_ASSERT_FALSE(sensors.allValid());
+    TEST_ASSERT_EQUAL_UINT8(0, sensors.faultMask());
+
+    SensorData data = cycle(sensors);
+    TEST_ASSERT_EQUAL_UINT8(1 << SENSOR_CO2, sensors.faultMask());
+    TEST_ASSERT_EQUAL_INT(-1, data.co2);
+    TEST_ASSERT_TRUE(hostBoard().consoleContains("Sensor 2 en fallo (fallos consecutivos).", since));
+}
+
+void test_a_valid_reading_resets_the_failure_count(void)
+{
+    Sensors sensors;
+    sensors.begin();
+    MockCo2 &co2 = sensors.get<SENSOR_CO2>();
+
+    co2.valid = false;
+    cycle(sensors);
+    cycle(sensors);
+    co2.valid = true;
+    cycle(sensors);
+    co2.valid = false;
+    cycle(sensors);
+    cycle(sensors);
+    TEST_ASSERT_EQUAL_UINT8(0, sensors.faultMask());
+}
+
+void test_recovery_attempts_back_off_exponentially(void)
+{
+    Sensors sensors;
+    MockCo2 &co2 = sensors.get<SENSOR_CO2>();
+    co2.present = false;
+    sensors.begin(); // En fallo, con el primer reintento ya vencido
+
+    std::vector<uint64_t> attempts;
+    for (uint32_t elapsed = 0; elapsed < 200000; elapsed += 100)
+    {
+        uint32_t before = co2.recoveries;
+        uint64_t start = hostBoard().nowUs();
+        cycle(sensors, 100);
+        if (co2.recoveries != before)
+        {
+            attempts.push_back(start);
+        }
+    }
+
+    const uint32_t expectedGapsMs[] = {1000, 2000, 4000, 8000, 16000, 32000, 60000, 60000};
+    TEST_ASSERT_EQUAL_UINT32(9, attempts.size());
+    for (size_t i = 0; i < 8; i++)
+    {
+        uint32_t gapMs = (uint32_t)((attempts[i + 1] - attempts[i]) / 1000);
+        TEST_ASSERT_UINT32_WITHIN(100, expectedGapsMs[i], gapMs);
+    }
+    // Entre reintentos no se intenta medir.
+    TEST_ASSERT_EQUAL_UINT32(co2.recoveries, co2.starts);
+}
+
+void test_a_hung_sensor_does_not_add_its_timeout_to_every_cycle(void)
+{
+    Sensors sensors;
+    MockCo2 &co2 = sensors.get<SENSOR_CO2>();
+    co2.conversionUs = 10 * 1000000; // Nunca termina dentro del timeout
+    sensors.begin();
+
+    for (int i = 0; i < 3; i++)
+    {
+        cycle(sensors);
+        TEST_ASSERT_GREATER_OR_EQUAL(MockCo2::TIMEOUT_MS * 1000, sensors.lastAcquireMicros());
+    }
+    TEST_ASSERT_EQUAL_UINT8(1 << SENSOR_CO2, sensors.faultMask());
+    TEST_ASSERT_EQUAL_UINT32(3, co2.timeouts);
+
+    // Ciclos entre reintentos: el sensor en fallo no se espera.
+    cycle(sensors); // Reintento inmediato, que también agota el timeout
+    cycle(sensors);
+    TEST_ASSERT_LESS_THAN(1000, sensors.lastAcquireMicros());
+    TEST_ASSERT_EQUAL_UINT32(4, co2.timeouts);
+}
+
+void test_a_valid_reading_clears_the_fault_and_restarts_the_backoff(void)
+{
+    Sensors sensors;
+    MockCo2 &co2 = sensors.get<SENSOR_CO2>();
+    co2.present = false;
+    sensors.begin();
+    runFor(sensors, 10000); // Reintentos a 0, 1, 3 y 7 s; el siguiente a los 15 s
+    TEST_ASSERT_EQUAL_UINT32(4, co2.recoveries);
+
+    uint64_t since = hostBoard().nowUs();
+    co2.present = true;
+    co2.value = 640;
+    runFor(sensors, 6000);
+    TEST_ASSERT_EQUAL_UINT8(0, sensors.faultMask());
+    TEST_ASSERT_TRUE(hostBoard().consoleContains("Sensor 2 recuperado.", since));
+    TEST_ASSERT_EQUAL_INT(640, cycle(sensors).co2);
+
+    // Un fallo nuevo empieza otra vez con la espera mínima.
+    co2.present = false;
+    runFor(sensors, 1500); // 3 fallos, el fallo y su reintento inmediato
+    uint32_t before = co2.recoveries;
+    runFor(sensors, 1000);
+    TEST_ASSERT_EQUAL_UINT32(before + 1, co2.recoveries);
+}
+
+void test_identical_values_freeze_only_after_the_timeout(void)
+{
+    Sensors sensors;
+    MockCo2 &co2 = sensors.get<SENSOR_CO2>();
+    co2.value = 700;
+    sensors.begin();
+    uint64_t since = hostBoard().nowUs();
+
+    runFor(sensors, MockCo2::STUCK_TIMEOUT_MS); // Última lectura a los 59.5 s
+    TEST_ASSERT_EQUAL_UINT8(0, sensors.faultMask());
+
+    SensorData data = cycle(sensors); // A los 60 s
+    TEST_ASSERT_EQUAL_UINT8(1 << SENSOR_CO2, sensors.faultMask());
+    TEST_ASSERT_EQUAL_INT(-1, data.co2);
+    TEST_ASSERT_TRUE(hostBoard().consoleContains("Sensor 2 en fallo (valor congelado).", since));
+}
+
+void test_a_slowly_changing_value_is_not_frozen(void)
+{
+    Sensors sensors;
+    MockCo2 &co2 = sensors.get<SENSOR_CO2>();
+    co2.value = 700;
+    sensors.begin();
+
+    // Cambia justo antes de cumplir la ventana, durante varias ventanas.
+    for (int i = 0; i < 5; i++)
+    {
+        runFor(sensors, MockCo2::STUCK_TIMEOUT_MS - 5000);
+        co2.value += 1;
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, sensors.faultMask());
+}
+
+void test_slow_sampling_needs_enough_fresh_conversions(void)
+{
+    Sensors sensors;
+    MockCo2 &co2 = sensors.get<SENSOR_CO2>();
+    co2.value = 700;
+    sensors.begin();
+
+    // Con un periodo de 20 s la ventana se cumple con pocas conversiones.
+    for (int i = 0; i < 9; i++)
+    {
+        cycle(sensors, 20000);
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, sensors.faultMask());
+    cycle(sensors, 20000); // Décima conversión idéntica, tras 180 s
+    TEST_ASSERT_EQUAL_UINT8(1 << SENSOR_CO2, sensors.faultMask());
+}
+
+void test_repeated_cached_readings_do_not_count_as_conversions(void)
+{
+    Sensors sensors;
+    MockCo2 &co2 = sensors.get<SENSOR_CO2>();
+    co2.value = 700;
+    sensors.begin();
+
+    // Solo una lectura de cada 40 (una cada 20 s) es una conversión nueva.
+    for (int i = 0; i < 9 * 40; i++)
+    {
+        co2.fresh = i % 40 == 0;
+        cycle(sensors);
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, sensors.faultMask()); // 180 s, pero solo 9 conversiones
+    co2.fresh = true;
+    cycle(sensors); // Décima conversión
+    TEST_ASSERT_EQUAL_UINT8(1 << SENSOR_CO2, sensors.faultMask());
+}
+
+void test_a_frozen_sensor_stays_faulty_until_its_value_changes(void)
+{
+    Sensors sensors;
+    MockCo2 &co2 = sensors.get<SENSOR_CO2>();
+    co2.value = 700;
+    sensors.begin();
+    runFor(sensors, MockCo2::STUCK_TIMEOUT_MS + PERIOD_MS);
+    TEST_ASSERT_EQUAL_UINT8(1 << SENSOR_CO2, sensors.faultMask());
+
+    // Los reintentos responden, pero con el mismo valor.
+    uint32_t before = co2.recoveries;
+    runFor(sensors, 3 * 60 * 1000);
+    TEST_ASSERT_TRUE(co2.recoveries > before);
+    TEST_ASSERT_EQUAL_UINT8(1 << SENSOR_CO2, sensors.faultMask());
+
+    co2.value = 720;
+    runFor(sensors, 60000 + PERIOD_MS); // Como mucho la espera máxima entre reintentos
+    TEST_ASSERT_EQUAL_UINT8(0, sensors.faultMask());
+    TEST_ASSERT_EQUAL_INT(720, cycle(sensors).co2);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_three_consecutive_failures_mark_the_sensor_faulty);
+    RUN_TEST(test_a_valid_reading_resets_the_failure_count);
+    RUN_TEST(test_recovery_attempts_back_off_exponentially);
+    RUN_TEST(test_a_hung_sensor_does_not_add_its_timeout_to_every_cycle);
+    RUN_TEST(test_a_valid_reading_clears_the_fault_and_restarts_the_backoff);
+    RUN_TEST(test_identical_values_freeze_only_after_the_timeout);
+    RUN_TEST(test_a_slowly_changing_value_is_not_frozen);
+    RUN_TEST(test_slow_sampling_needs_enough_fresh_conversions);
+    RUN_TEST(test_repeated_cached_readings_do_not_count_as_conversions);
+    RUN_TEST(test_a_frozen_sensor_stays_faulty_until_its_value_changes);
+    return UNITY_END();
+}
@@ -0,0 +1,161 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas de la composición estática de drivers (`SensorSet`) con drivers falsos.
+ * @details Comprueban el reparto de las llamadas por las expresiones de
+ * plegado (orden, una lectura por medida, campos de cada driver) y la
+ * búsqueda de drivers por tipo en tiempo de compilación. El reloj es el
+ * virtual de la placa del host.
+ */
+
+#include <unity.h>
+#include <type_traits>
+#include "HostBoard.h"
+#include "MockSensorDriver.h"
+
+typedef MockSensorDriver<SENSOR_TEMP_HUMIDITY, 'T'> MockTemp;
+typedef MockSensorDriver<SENSOR_PRESSURE, 'P'> MockPressure;
+typedef MockSensorDriver<SENSOR_CO2, 'C'> MockCo2;
+
+typedef SensorSet<MockTemp, MockPressure, MockCo2> FullSet;
+typedef SensorSet<MockTemp, MockCo2> SetWithoutPressure; // Como una placa sin BMP280
+
+// Sin funciones virtuales: ni los drivers ni el conjunto llevan vtable.
+static_assert(!std::is_polymorphic<MockTemp>::value, "Los drivers no deben tener funciones virtuales");
+static_assert(!std::is_polymorphic<FullSet>::value, "SensorSet no debe tener funciones virtuales");
+
+// La búsqueda por tipo se resuelve al compilar.
+static_assert(FullSet::contains<SENSOR_PRESSURE>(), "FullSet tiene sensor de presión");
+static_assert(!SetWithoutPressure::contains<SENSOR_PRESSURE>(), "SetWithoutPressure no tiene sensor de presión");
+static_assert(std::is_same<std::remove_reference_t<decltype(std::declval<FullSet &>().get<SENSOR_CO2>())>, MockCo2>::value,
+              "get<SENSOR_CO2>() devuelve el driver de CO2");
+
+void setUp(void)
+{
+    mockSensorLog().clear();
+}
+
+void tearDown(void) {}
+
+void test_begin_initializes_every_driver_in_order(void)
+{
+    FullSet sensors;
+    sensors.begin();
+    TEST_ASSERT_EQUAL_STRING("T.begin P.begin C.begin", mockSensorLog().c_str());
+}
+
+void test_acquire_starts_every_measurement_before_collecting(void)
+{
+    FullSet sensors;
+    sensors.begin();
+    mockSensorLog().clear();
+
+    SensorData data;
+    sensors.acquire(data);
+    TEST_ASSERT_EQUAL_STRING("T.start P.start C.start T.read P.read C.read", mockSensorLog().c_str());
+}
+
+void test_results_are_collected_as_each_measurement_completes(void)
+{
+    FullSet sensors;
+    sensors.get<SENSOR_TEMP_HUMIDITY>().conversionUs = 30000;
+    sensors.get<SENSOR_PRESSURE>().conversionUs = 10000;
+    sensors.get<SENSOR_CO2>().conversionUs = 20000;
+    sensors.begin();
+    mockSensorLog().clear();
+
+    SensorData data;
+    sensors.acquire(data);
+    TEST_ASSERT_EQUAL_STRING("T.start P.start C.start P.read C.read T.read", mockSensorLog().c_str());
+    // Cada driver se lee una sola vez aunque se le pregunte en cada pasada.
+    TEST_ASSERT_EQUAL_UINT32(1, sensors.get<SENSOR_TEMP_HUMIDITY>().reads);
+    TEST_ASSERT_EQUAL_UINT32(1, sensors.get<SENSOR_PRESSURE>().reads);
+    TEST_ASSERT_EQUAL_UINT32(1, sensors.get<SENSOR_CO2>().reads);
+}
+
+void test_each_driver_fills_only_its_fields(void)
+{
+    SetWithoutPressure sensors;
+    sensors.get<SENSOR_TEMP_HUMIDITY>().value = 21.5f;
+    sensors.get<SENSOR_CO2>().value = 612;
+    sensors.begin();
+
+    SensorData data;
+    data.pressure = 1013.0f; // Valor de una muestra anterior
+    sensors.acquire(data);
+    TEST_ASSERT_EQUAL_FLOAT(21.5f, data.temperature);
+    TEST_ASSERT_EQUAL_FLOAT(21.5f, data.humidity);
+    TEST_ASSERT_EQUAL_INT(612, data.co2);
+    TEST_ASSERT_EQUAL_FLOAT(-1.0f, data.pressure); // Sin driver en esta placa
+}
+
+void test_failed_read_invalidates_only_its_driver_fields(void)
+{
+    FullSet sensors;
+    sensors.get<SENSOR_TEMP_HUMIDITY>().value = 20.0f;
+    sensors.get<SENSOR_PRESSURE>().value = 1000.0f;
+    sensors.get<SENSOR_PRESSURE>().valid = false;
+    sensors.get<SENSOR_CO2>().value = 500;
+    sensors.begin();
+
+    SensorData data;
+    sensors.acquire(data);
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, data.temperature);
+    TEST_ASSERT_EQUAL_FLOAT(-1.0f, data.pressure);
+    TEST_ASSERT_EQUAL_INT(500, data.co2);
+    TEST_ASSERT_FALSE(sensors.allValid());
+    TEST_ASSERT_EQUAL_UINT8(0, sensors.faultMask()); // Un solo fallo aún no es una avería
+}
+
+void test_fault_mask_has_one_bit_per_sensor_kind(void)
+{
+    FullSet sensors;
+    sensors.get<SENSOR_PRESSURE>().present = false;
+    sensors.get<SENSOR_CO2>().present = false;
+    sensors.begin(); // Los que no responden al iniciar quedan en fallo
+    TEST_ASSERT_EQUAL_UINT8((1 << SENSOR_PRESSURE) | (1 << SENSOR_CO2), sensors.faultMask());
+
+    SetWithoutPressure reduced;
+    reduced.get<SENSOR_CO2>().present = false;
+    reduced.begin();
+    TEST_ASSERT_EQUAL_UINT8(1 << SENSOR_CO2, reduced.faultMask()); // El bit sigue al tipo, no a la posición
+}
+
+void test_with_calls_only_drivers_present_on_the_board(void)
+{
+    SetWithoutPressure sensors;
+    int calls = 0;
+    sensors.with<SENSOR_CO2>([&calls](MockCo2 &driver) { calls += driver.KIND == SENSOR_CO2 ? 1 : 100; });
+    sensors.with<SENSOR_PRESSURE>([&calls](auto &driver) { calls += 1000; });
+    TEST_ASSERT_EQUAL_INT(1, calls);
+}
+
+void test_one_recovery_per_cycle(void)
+{
+    FullSet sensors;
+    sensors.get<SENSOR_TEMP_HUMIDITY>().present = false;
+    sensors.get<SENSOR_PRESSURE>().present = false;
+    sensors.begin(); // Ambos en fallo, con el reintento ya vencido
+    mockSensorLog().clear();
+
+    SensorData data;
+    sensors.acquire(data);
+    TEST_ASSERT_EQUAL_UINT32(1, sensors.get<SENSOR_TEMP_HUMIDITY>().recoveries);
+    TEST_ASSERT_EQUAL_UINT32(0, sensors.get<SENSOR_PRESSURE>().recoveries); // Espera al ciclo siguiente
+
+    sensors.acquire(data);
+    TEST_ASSERT_EQUAL_UINT32(1, sensors.get<SENSOR_PRESSURE>().recoveries);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_begin_initializes_every_driver_in_order);
+    RUN_TEST(test_acquire_starts_every_measurement_before_collecting);
+    RUN_TEST(test_results_are_collected_as_each_measurement_completes);
+    RUN_TEST(test_each_driver_fills_only_its_fields);
+    RUN_TEST(test_failed_read_invalidates_only_its_driver_fields);
+    RUN_TEST(test_fault_mask_has_one_bit_per_sensor_kind);
+    RUN_TEST(test_with_calls_only_drivers_present_on_the_board);
+    RUN_TEST(test_one_recovery_per_cycle);
+    return UNITY_END();
+}
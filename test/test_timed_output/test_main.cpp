@@ -0,0 +1,283 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas de las salidas temporizadas con el temporizador falso del host.
+ * @details El reloj es el virtual de `TimeBase` (`setMonotonicMicros()`) y el
+ * "bucle principal" llama a `TimedOutput::runHostTimers()` como ESP_Server.cpp;
+ * cada escritura en el hardware queda en un registro global con la salida, el
+ * valor y el reloj del momento.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include "TimeBase.h"
+#include "TimedOutput.h"
+
+/**
+ * @struct Write
+ * @brief Escritura recibida por un pin simulado.
+ */
+struct Write
+{
+    char pin;
+    uint16_t value;
+    uint64_t atUs;
+};
+
+static Write writes[64];
+static uint8_t writeCount = 0;
+
+/** @brief Pin simulado: anota la escritura con el reloj virtual. */
+static void recordWrite(void *context, uint16_t value)
+{
+    if (writeCount < sizeof(writes) / sizeof(writes[0]))
+    {
+        writes[writeCount++] = {*static_cast<const char *>(context), value, monotonicMicros()};
+    }
+}
+
+static const char PIN_A = 'A';
+static const char PIN_B = 'B';
+
+void setUp(void)
+{
+    writeCount = 0;
+    setMonotonicMicros(1000000);
+    TimedOutput::setHostLatencyUs(0);
+}
+
+void tearDown(void) {}
+
+/** @brief Bucle principal simulado: avanza el reloj y da los flancos vencidos. */
+static void runUntil(uint64_t untilUs, uint64_t stepUs)
+{
+    uint64_t now = monotonicMicros();
+    while (now < untilUs)
+    {
+        now += stepUs;
+        setMonotonicMicros(now);
+        TimedOutput::runHostTimers(now);
+    }
+}
+
+void test_set_writes_only_on_change()
+{
+    TimedOutput output("A", recordWrite, (void *)&PIN_A);
+    output.set(0); // La primera escritura siempre llega al hardware
+    output.set(0);
+    output.set(1);
+    output.set(1);
+    TEST_ASSERT_EQUAL_UINT8(2, writeCount);
+    TEST_ASSERT_EQUAL_UINT16(1, output.getValue());
+
+    OutputEdge edge;
+    TEST_ASSERT_TRUE(output.popEdge(edge));
+    TEST_ASSERT_FALSE(edge.scheduled);
+    TEST_ASSERT_EQUAL_UINT64(1000000, edge.requestedUs);
+    TEST_ASSERT_EQUAL_UINT64(edge.requestedUs, edge.actualUs);
+    TEST_ASSERT_TRUE(output.popEdge(edge));
+    TEST_ASSERT_EQUAL_UINT16(0, edge.previous);
+    TEST_ASSERT_EQUAL_UINT16(1, edge.value);
+    TEST_ASSERT_FALSE(output.popEdge(edge));
+}
+
+void test_set_at_fires_at_requested_time()
+{
+    TimedOutput output("A", recordWrite, (void *)&PIN_A);
+    TEST_ASSERT_TRUE(output.begin());
+    TEST_ASSERT_TRUE(output.setAt(7, 1005000));
+    TEST_ASSERT_TRUE(output.isPending());
+
+    runUntil(1004999, 1);
+    TEST_ASSERT_EQUAL_UINT8(0, writeCount);
+    runUntil(1005000, 1);
+    TEST_ASSERT_EQUAL_UINT8(1, writeCount);
+    TEST_ASSERT_EQUAL_UINT64(1005000, writes[0].atUs);
+    TEST_ASSERT_FALSE(output.isPending());
+
+    OutputEdge edge;
+    TEST_ASSERT_TRUE(output.popEdge(edge));
+    TEST_ASSERT_TRUE(edge.scheduled);
+    TEST_ASSERT_EQUAL_UINT64(1005000, edge.requestedUs);
+    TEST_ASSERT_EQUAL_UINT64(1005000, edge.actualUs);
+    TEST_ASSERT_EQUAL_INT64(0, output.getMaxLatenessUs());
+}
+
+void test_set_at_in_the_past_fires_on_next_run()
+{
+    TimedOutput output("A", recordWrite, (void *)&PIN_A);
+    output.setAt(3, 500000);
+    TimedOutput::runHostTimers(monotonicMicros());
+    TEST_ASSERT_EQUAL_UINT16(3, output.getValue());
+    TEST_ASSERT_FALSE(output.isPending());
+}
+
+void test_new_edge_replaces_pending_one()
+{
+    TimedOutput output("A", recordWrite, (void *)&PIN_A);
+    output.setAt(1, 1010000);
+    output.setAt(2, 1020000); // Sustituye al primero: el 1 no se escribe nunca
+    runUntil(1030000, 1000);
+    TEST_ASSERT_EQUAL_UINT8(1, writeCount);
+    TEST_ASSERT_EQUAL_UINT16(2, writes[0].value);
+    TEST_ASSERT_EQUAL_UINT64(1020000, writes[0].atUs);
+
+    output.setAt(5, 1040000);
+    output.set(4); // Un flanco inmediato también descarta el pendiente
+    runUntil(1050000, 1000);
+    TEST_ASSERT_EQUAL_UINT8(2, writeCount);
+    TEST_ASSERT_EQUAL_UINT16(4, output.getValue());
+
+    output.setAt(6, 1060000);
+    output.cancel();
+    TEST_ASSERT_FALSE(output.isPending());
+    runUntil(1070000, 1000);
+    TEST_ASSERT_EQUAL_UINT8(2, writeCount);
+}
+
+void test_pulse_duration_survives_a_stalled_loop()
+{
+    // El bucle se queda 800 ms en una espera: el pulso de 200 ms no se alarga
+    TimedOutput output("HD", recordWrite, (void *)&PIN_A);
+    output.set(1);
+    uint64_t start = monotonicMicros();
+    TEST_ASSERT_TRUE(output.pulse(0, 1, 200000));
+    runUntil(start + 800000, 800000);
+
+    TEST_ASSERT_EQUAL_UINT16(1, output.getValue());
+    OutputEdge begin;
+    OutputEdge end;
+    output.popEdge(begin); // El set(1) inicial
+    TEST_ASSERT_TRUE(output.popEdge(begin));
+    TEST_ASSERT_TRUE(output.popEdge(end));
+    TEST_ASSERT_EQUAL_UINT16(0, begin.value);
+    TEST_ASSERT_EQUAL_UINT16(1, end.value);
+    TEST_ASSERT_TRUE(end.scheduled);
+    TEST_ASSERT_EQUAL_UINT64(200000, end.actualUs - begin.actualUs);
+}
+
+void test_host_latency_is_reported()
+{
+    TimedOutput output("A", recordWrite, (void *)&PIN_A);
+    TimedOutput::setHostLatencyUs(150);
+    output.setAt(1, 1001000);
+    output.setAt(0, 1002000);
+    runUntil(1003000, 100);
+    output.setAt(1, 1004000);
+    runUntil(1005000, 100);
+    TimedOutput::setHostLatencyUs(40);
+    output.setAt(0, 1006000);
+    runUntil(1007000, 100);
+
+    OutputEdge edge;
+    TEST_ASSERT_TRUE(output.popEdge(edge));
+    TEST_ASSERT_EQUAL_UINT64(1002000, edge.requestedUs);
+    TEST_ASSERT_EQUAL_UINT64(1002150, edge.actualUs);
+    TEST_ASSERT_EQUAL_INT64(150, output.getMaxLatenessUs()); // El máximo no baja con flancos más puntuales
+}
+
+void test_outputs_fire_in_requested_order()
+{
+    TimedOutput first("A", recordWrite, (void *)&PIN_A);
+    TimedOutput second("B", recordWrite, (void *)&PIN_B);
+    second.setAt(1, 1003000);
+    first.setAt(1, 1002000);
+    TimedOutput::runHostTimers(1010000); // Los dos vencidos en la misma pasada
+    TEST_ASSERT_EQUAL_UINT8(2, writeCount);
+    TEST_ASSERT_EQUAL_INT('A', writes[0].pin);
+    TEST_ASSERT_EQUAL_INT('B', writes[1].pin);
+}
+
+void test_edge_log_drops_oldest_when_full()
+{
+    TimedOutput output("A", recordWrite, (void *)&PIN_A);
+    for (uint16_t i = 1; i <= TimedOutput::EDGE_LOG_SIZE + 3; i++)
+    {
+        output.set(i);
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, output.getDroppedEdges());
+    OutputEdge edge;
+    for (uint16_t i = 4; i <= TimedOutput::EDGE_LOG_SIZE + 3; i++)
+    {
+        TEST_ASSERT_TRUE(output.popEdge(edge));
+        TEST_ASSERT_EQUAL_UINT16(i, edge.value);
+    }
+    TEST_ASSERT_FALSE(output.popEdge(edge));
+}
+
+void test_destroyed_output_leaves_host_timer()
+{
+    TimedOutput survivor("A", recordWrite, (void *)&PIN_A);
+    {
+        TimedOutput temporary("B", recordWrite, (void *)&PIN_B);
+        temporary.setAt(1, 1001000);
+    }
+    survivor.setAt(1, 1002000);
+    TimedOutput::runHostTimers(1010000);
+    TEST_ASSERT_EQUAL_UINT8(1, writeCount);
+    TEST_ASSERT_EQUAL_INT('A', writes[0].pin);
+}
+
+void test_periodic_pulses_keep_their_width()
+{
+    // Pulsos de 30 ms cada 250 ms con vueltas del bucle irregulares, de 1 a 41 ms
+    TimedOutput output("HD", recordWrite, (void *)&PIN_A);
+    output.set(1);
+    TimedOutput::setHostLatencyUs(60);
+    uint32_t lcgState = 5;
+    uint64_t nextPulse = monotonicMicros();
+    uint64_t end = monotonicMicros() + 2000000;
+    uint8_t pulses = 0;
+    uint8_t checked = 0;
+    uint64_t fallUs = 0;
+    OutputEdge edge;
+    output.popEdge(edge); // El set(1) inicial
+    while (monotonicMicros() < end)
+    {
+        if (monotonicMicros() >= nextPulse)
+        {
+            output.pulse(0, 1, 30000);
+            nextPulse += 250000;
+            pulses++;
+        }
+        lcgState = lcgState * 1664525u + 1013904223u;
+        uint64_t now = monotonicMicros() + 1000 + (lcgState >> 8) % 40000;
+        setMonotonicMicros(now);
+        TimedOutput::runHostTimers(now);
+
+        while (output.popEdge(edge)) // El registro lo vacía el bucle en cada vuelta
+        {
+            if (edge.value == 0)
+            {
+                fallUs = edge.actualUs;
+            }
+            else
+            {
+                TEST_ASSERT_TRUE(edge.scheduled);
+                TEST_ASSERT_EQUAL_UINT64(30000 + 60, edge.actualUs - fallUs);
+                checked++;
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, output.getDroppedEdges());
+
+    char message[64];
+    snprintf(message, sizeof(message), "%u pulsos, %u completos", pulses, checked);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_GREATER_OR_EQUAL(pulses - 1, checked); // El último puede quedar a medias
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_set_writes_only_on_change);
+    RUN_TEST(test_set_at_fires_at_requested_time);
+    RUN_TEST(test_set_at_in_the_past_fires_on_next_run);
+    RUN_TEST(test_new_edge_replaces_pending_one);
+    RUN_TEST(test_pulse_duration_survives_a_stalled_loop);
+    RUN_TEST(test_host_latency_is_reported);
+    RUN_TEST(test_outputs_fire_in_requested_order);
+    RUN_TEST(test_edge_log_drops_oldest_when_full);
+    RUN_TEST(test_destroyed_output_leaves_host_timer);
+    RUN_TEST(test_periodic_pulses_keep_their_width);
+    return UNITY_END();
+}
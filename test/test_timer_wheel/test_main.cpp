@@ -0,0 +1,376 @@
+/**
+ * @file test_main.cpp
+ * @brief Pruebas de la rueda jerárquica de temporizadores con un reloj virtual.
+ * @details Además de los casos básicos, se arman miles de temporizadores con
+ * plazos aleatorios (generador determinista) y se comprueba que cada uno
+ * vence exactamente en su tick, también a través de la vuelta de los 32 bits
+ * de `millis()`.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <vector>
+#include "TimerWheel.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static uint32_t lcgState = 1;
+
+/** @brief Número pseudoaleatorio determinista en [0, range). */
+static uint32_t randomBelow(uint32_t range)
+{
+    lcgState = lcgState * 1664525u + 1013904223u;
+    return (lcgState >> 8) % range;
+}
+
+/**
+ * @struct Probe
+ * @brief Temporizador de prueba que anota cuándo vence.
+ */
+struct Probe
+{
+    TimerWheel *wheel;
+    Timer timer;
+    uint32_t expected; // Próximo vencimiento esperado
+    uint32_t period;
+    uint32_t fired;
+    uint32_t late;     // Vencimientos fuera de su tick
+
+    Probe() : wheel(nullptr), timer(onFire, this), expected(0), period(0), fired(0), late(0) {}
+
+    static void onFire(void *context)
+    {
+        Probe *probe = (Probe *)context;
+        if (probe->wheel->nowMs() != probe->expected)
+        {
+            probe->late++;
+        }
+        probe->fired++;
+        probe->expected += probe->period;
+    }
+};
+
+static void arm(TimerWheel &wheel, Probe &probe, uint32_t delay, uint32_t period = 0)
+{
+    probe.wheel = &wheel;
+    probe.expected = wheel.nowMs() + (delay == 0 ? 1 : delay);
+    probe.period = period;
+    wheel.start(probe.timer, delay, period);
+}
+
+// --- Casos básicos ---
+
+void test_one_shot_fires_once_on_its_tick()
+{
+    TimerWheel wheel;
+    wheel.reset(1000);
+    Probe probe;
+    arm(wheel, probe, 25);
+    TEST_ASSERT_TRUE(probe.timer.isActive());
+    TEST_ASSERT_EQUAL_UINT16(1, wheel.getActiveCount());
+
+    wheel.advance(1024);
+    TEST_ASSERT_EQUAL_UINT32(0, probe.fired);
+    wheel.advance(1025);
+    TEST_ASSERT_EQUAL_UINT32(1, probe.fired);
+    TEST_ASSERT_EQUAL_UINT32(0, probe.late);
+    TEST_ASSERT_FALSE(probe.timer.isActive());
+    TEST_ASSERT_EQUAL_UINT16(0, wheel.getActiveCount());
+
+    wheel.advance(5000);
+    TEST_ASSERT_EQUAL_UINT32(1, probe.fired);
+}
+
+void test_zero_delay_fires_next_tick()
+{
+    TimerWheel wheel;
+    Probe probe;
+    arm(wheel, probe, 0);
+    wheel.advance(0);
+    TEST_ASSERT_EQUAL_UINT32(0, probe.fired);
+    wheel.advance(1);
+    TEST_ASSERT_EQUAL_UINT32(1, probe.fired);
+}
+
+void test_periodic_does_not_drift()
+{
+    TimerWheel wheel;
+    Probe probe;
+    arm(wheel, probe, 7, 100);
+    // Avances irregulares, como las vueltas del bucle principal
+    for (uint32_t now = 0; now < 100000; now += 1 + randomBelow(37))
+    {
+        wheel.advance(now);
+    }
+    wheel.advance(100007);
+    TEST_ASSERT_EQUAL_UINT32(1001, probe.fired);
+    TEST_ASSERT_EQUAL_UINT32(0, probe.late);
+    TEST_ASSERT_TRUE(probe.timer.isActive());
+}
+
+void test_cancel_and_restart()
+{
+    TimerWheel wheel;
+    Probe probe;
+    arm(wheel, probe, 10);
+    wheel.cancel(probe.timer);
+    wheel.cancel(probe.timer); // Cancelar dos veces no hace nada
+    TEST_ASSERT_EQUAL_UINT16(0, wheel.getActiveCount());
+    wheel.advance(100);
+    TEST_ASSERT_EQUAL_UINT32(0, probe.fired);
+
+    arm(wheel, probe, 50);
+    arm(wheel, probe, 5000); // Rearmar un temporizador activo lo reprograma
+    TEST_ASSERT_EQUAL_UINT16(1, wheel.getActiveCount());
+    wheel.advance(5099);
+    TEST_ASSERT_EQUAL_UINT32(0, probe.fired);
+    wheel.advance(5100);
+    TEST_ASSERT_EQUAL_UINT32(1, probe.fired);
+    TEST_ASSERT_EQUAL_UINT32(0, probe.late);
+}
+
+void test_every_level_fires_exactly()
+{
+    // Un plazo en cada nivel y en sus bordes
+    const uint32_t delays[] = {1, 63, 64, 65, 4095, 4096, 4097, 262143, 262144, 262145, 3600000,
+                               TimerWheel::MAX_DELAY_MS};
+    const size_t count = sizeof(delays) / sizeof(delays[0]);
+    TimerWheel wheel;
+    wheel.reset(12345);
+    Probe probes[count];
+    for (size_t i = 0; i < count; i++)
+    {
+        arm(wheel, probes[i], delays[i]);
+    }
+    for (uint32_t now = 12345; now <= 12345 + TimerWheel::MAX_DELAY_MS; now += 997)
+    {
+        wheel.advance(now);
+    }
+    wheel.advance(12345 + TimerWheel::MAX_DELAY_MS);
+    for (size_t i = 0; i < count; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, probes[i].fired, "no venció");
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, probes[i].late, "venció fuera de su tick");
+    }
+}
+
+void test_delay_is_clamped()
+{
+    TimerWheel wheel;
+    Probe probe;
+    wheel.start(probe.timer, TimerWheel::MAX_DELAY_MS + 1000);
+    probe.wheel = &wheel;
+    probe.expected = TimerWheel::MAX_DELAY_MS;
+    wheel.advance(TimerWheel::MAX_DELAY_MS);
+    TEST_ASSERT_EQUAL_UINT32(1, probe.fired);
+    TEST_ASSERT_EQUAL_UINT32(0, probe.late);
+}
+
+void test_survives_millis_wraparound()
+{
+    TimerWheel wheel;
+    wheel.reset(0xFFFFFF00u);
+    Probe shortProbe;
+    Probe longProbe;
+    arm(wheel, shortProbe, 0x200);         // Vence después de la vuelta
+    arm(wheel, longProbe, 90000, 90000);   // Periódico a través de la vuelta
+    for (uint32_t step = 0; step < 400000; step += 13)
+    {
+        wheel.advance(0xFFFFFF00u + step);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, shortProbe.fired);
+    TEST_ASSERT_EQUAL_UINT32(4, longProbe.fired);
+    TEST_ASSERT_EQUAL_UINT32(0, shortProbe.late + longProbe.late);
+}
+
+// --- Callbacks que modifican la rueda ---
+
+struct Chain
+{
+    TimerWheel *wheel;
+    Timer self;
+    Timer *victim;
+    uint32_t fired;
+
+    Chain() : wheel(nullptr), self(onFire, this), victim(nullptr), fired(0) {}
+
+    static void onFire(void *context)
+    {
+        Chain *chain = (Chain *)context;
+        chain->fired++;
+        if (chain->victim != nullptr)
+        {
+            chain->wheel->cancel(*chain->victim);
+        }
+        if (chain->fired < 3)
+        {
+            chain->wheel->start(chain->self, 10); // Se rearma desde su propio callback
+        }
+    }
+};
+
+void test_callbacks_can_rearm_and_cancel()
+{
+    TimerWheel wheel;
+    Chain chain;
+    chain.wheel = &wheel;
+    Probe sameTick;
+    arm(wheel, sameTick, 5);
+    wheel.start(chain.self, 5); // Mismo tick, detrás de `sameTick` en la ranura
+    chain.victim = &sameTick.timer; // Ya habrá vencido al cancelarlo: no pasa nada
+
+    wheel.advance(5);
+    TEST_ASSERT_EQUAL_UINT32(1, sameTick.fired);
+    TEST_ASSERT_EQUAL_UINT32(1, chain.fired);
+    TEST_ASSERT_TRUE(chain.self.isActive());
+
+    wheel.advance(14);
+    TEST_ASSERT_EQUAL_UINT32(1, chain.fired);
+    wheel.advance(15);
+    TEST_ASSERT_EQUAL_UINT32(2, chain.fired);
+    wheel.advance(100);
+    TEST_ASSERT_EQUAL_UINT32(3, chain.fired);
+    TEST_ASSERT_EQUAL_UINT16(0, wheel.getActiveCount());
+}
+
+struct Canceller
+{
+    TimerWheel *wheel;
+    Timer self;
+    Timer *victim;
+
+    Canceller() : wheel(nullptr), self(onFire, this), victim(nullptr) {}
+
+    static void onFire(void *context)
+    {
+        Canceller *canceller = (Canceller *)context;
+        canceller->wheel->cancel(*canceller->victim);
+    }
+};
+
+void test_cancel_pending_timer_of_same_tick()
+{
+    TimerWheel wheel;
+    Canceller canceller;
+    canceller.wheel = &wheel;
+    Probe victim;
+    wheel.start(canceller.self, 20); // Primero en la ranura
+    arm(wheel, victim, 20);          // Detrás, todavía sin ejecutar al cancelarlo
+    canceller.victim = &victim.timer;
+    wheel.advance(20);
+    TEST_ASSERT_EQUAL_UINT32(0, victim.fired);
+    TEST_ASSERT_FALSE(victim.timer.isActive());
+    TEST_ASSERT_EQUAL_UINT16(0, wheel.getActiveCount());
+}
+
+// --- Próximo vencimiento ---
+
+void test_next_expiry_is_a_lower_bound()
+{
+    TimerWheel wheel;
+    uint32_t expiry;
+    TEST_ASSERT_FALSE(wheel.nextExpiryMs(expiry));
+
+    wheel.reset(500);
+    Probe nearProbe;
+    arm(wheel, nearProbe, 30);
+    TEST_ASSERT_TRUE(wheel.nextExpiryMs(expiry));
+    TEST_ASSERT_EQUAL_UINT32(530, expiry); // Exacta en el nivel 0
+
+    Probe farProbe;
+    wheel.cancel(nearProbe.timer);
+    arm(wheel, farProbe, 100000);
+    // Quien duerme hasta la cota despierta antes de tiempo pero nunca tarde
+    uint32_t wakeups = 0;
+    while (farProbe.fired == 0)
+    {
+        TEST_ASSERT_TRUE(wheel.nextExpiryMs(expiry));
+        TEST_ASSERT_LESS_OR_EQUAL(farProbe.expected, expiry);
+        TEST_ASSERT_GREATER_THAN(wheel.nowMs(), expiry);
+        wheel.advance(expiry);
+        wakeups++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, farProbe.late);
+    char message[48];
+    snprintf(message, sizeof(message), "100 s de plazo: %u despertares", wakeups);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_LESS_THAN(200, wakeups);
+}
+
+// --- Carga ---
+
+void test_thousands_of_random_timers()
+{
+    const size_t count = 5000;
+    std::vector<Probe> probes(count);
+    TimerWheel wheel;
+    lcgState = 42;
+    wheel.reset(0x7FFFF000u);
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t delay = 1 + randomBelow(i % 3 == 0 ? 600000 : 5000);
+        uint32_t period = i % 4 == 0 ? 1 + randomBelow(20000) : 0;
+        arm(wheel, probes[i], delay, period);
+    }
+    TEST_ASSERT_EQUAL_UINT16(count, wheel.getActiveCount());
+
+    uint32_t start = wheel.nowMs();
+    uint32_t cancelled = 0;
+    for (uint32_t now = start; now - start < 700000; now += 1 + randomBelow(50))
+    {
+        wheel.advance(now);
+        if (randomBelow(100) == 0)
+        {
+            Probe &probe = probes[randomBelow(count)];
+            if (probe.timer.isActive() && probe.period == 0)
+            {
+                wheel.cancel(probe.timer);
+                cancelled++;
+            }
+        }
+    }
+
+    uint32_t late = 0;
+    uint32_t missing = 0;
+    uint32_t periodicActive = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        late += probes[i].late;
+        if (probes[i].period > 0)
+        {
+            periodicActive += probes[i].timer.isActive() ? 1 : 0;
+        }
+        else if (probes[i].fired == 0 && probes[i].expected - start <= 700000 - 50)
+        {
+            missing++; // Debía haber vencido y no se canceló
+        }
+        if (probes[i].period == 0)
+        {
+            TEST_ASSERT_LESS_OR_EQUAL(1, probes[i].fired);
+        }
+    }
+    char message[80];
+    snprintf(message, sizeof(message), "%u cancelados, %u periódicos activos", cancelled, periodicActive);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_UINT32(0, late);
+    TEST_ASSERT_LESS_OR_EQUAL(cancelled, missing); // Solo faltan los cancelados
+    TEST_ASSERT_EQUAL_UINT16(periodicActive, wheel.getActiveCount());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_one_shot_fires_once_on_its_tick);
+    RUN_TEST(test_zero_delay_fires_next_tick);
+    RUN_TEST(test_periodic_does_not_drift);
+    RUN_TEST(test_cancel_and_restart);
+    RUN_TEST(test_every_level_fires_exactly);
+    RUN_TEST(test_delay_is_clamped);
+    RUN_TEST(test_survives_millis_wraparound);
+    RUN_TEST(test_callbacks_can_rearm_and_cancel);
+    RUN_TEST(test_cancel_pending_timer_of_same_tick);
+    RUN_TEST(test_next_expiry_is_a_lower_bound);
+    RUN_TEST(test_thousands_of_random_timers);
+    return UNITY_END();
+}